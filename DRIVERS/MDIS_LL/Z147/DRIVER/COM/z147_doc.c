@@ -73,6 +73,18 @@
 	including the sync words 0x247 (SUB_FRAME_1), 0x5B8 (SUB_FRAME_2),
 	0xA47 (SUB_FRAME_3), 0xDB8(SUB_FRAME_4), to identify the subframes.
 
+	With #Z147_RX_SYNC_CFG 0 (no synchronization) the core starts from the
+	first edge and does not know the frame position, the driver finds it
+	from the received words: a sync word followed by the next ones at
+	subframe distance up to a whole frame aligns the frames. Afterwards
+	every sync slot is checked: a missed sync word lowers a confidence of
+	8, a found one raises it again, at 0 the alignment is lost (counted
+	like a lost synchronization of the core, with the error signal).
+	While the confidence is not full the search goes on, a frame found
+	at another position after a word slip realigns the frames at once,
+	without a reset of the core. #Z147_RX_SLIP_CNT counts these
+	realignments. Words received before the first alignment are dropped.
+
 
     \n \subsection RxInterrupts Interrupt and Signal
     
@@ -80,6 +92,63 @@
     using M_setstat() #Z147_SET_SIGNAL to the application when data is received. 
 	The signal can be uninstalled using #Z147_CLR_SIGNAL.
 
+	#Z147_RX_FRAME_CNT returns the number of frames received since M_open().
+	It changes when the frame returned by M_getblock() changes, so several
+	devices can share one signal: after the signal, a device has a new frame
+	if its count has changed.
+
+	With #Z147_RX_CHANGE_ONLY the driver compares every word with the same
+	word of the previous frame while it drains the FIFO and sends the signal
+	only for frames with a changed word. Such frames are counted by
+	#Z147_RX_CHANGE_CNT, so a reader polls this count instead of
+	#Z147_RX_FRAME_CNT. The block getstat #Z147_BLK_RX_CHANGES returns the
+	changed subframes and slots (16 per subframe) of the last changed
+	frame (Z147_CHANGES). The first frame after enabling the mode, a data
+	rate change or a new synchronization is reported with all slots changed.
+
+	Applications waiting for a few words only set a watch list with the
+	block setstat #Z147_BLK_RX_WATCH (up to #Z147_WATCH_MAX Z147_WATCH
+	entries, size 0 clears it). Each watch checks the masked word at a
+	frame position ((subframe-1) * words per subframe + word) when it is
+	drained from the FIFO:
+	- #Z147_WATCH_EQUAL fires when the word becomes equal to lo,
+	- #Z147_WATCH_CHANGE fires when the word changes,
+	- #Z147_WATCH_RANGE fires when the word leaves lo..hi,
+	- #Z147_WATCH_RATE fires when the word changes by more than lo
+	  from one frame to the next.
+
+	The events are queued (#Z147_TRIG_QUEUE) and the signal set with
+	#Z147_SET_TRIG_SIGNAL is sent once per interrupt with new events. The
+	block getstat #Z147_BLK_RX_TRIG returns and removes the queued
+	Z147_TRIG_EVENT entries (watch index, position, value, previous value
+	and frame count). #Z147_RX_TRIG_CNT counts all events, a difference to
+	the events read shows events lost on a full queue. A data rate or sync
+	mode change clears the watch list.
+
+	The block setstat #Z147_BLK_RX_CAPTURE (Z147_CAPTURE) starts the pre/post
+	trigger capture: the driver allocates two regions of the given number of
+	frames and copies every received frame into the history of one of them.
+	The triggers selected in trigMask are lost synchronization
+	(#Z147_CAPT_SYNC), other line errors (#Z147_CAPT_ERR), watch events
+	(#Z147_CAPT_WATCH) and #Z147_RX_CAPT_TRIG (#Z147_CAPT_USER). After the
+	post frames following the trigger frame the region is frozen with the
+	pre frames before it, the trigger signal is sent and the capture
+	continues in the other region. #Z147_RX_CAPT_SIZE returns the size of
+	the frozen capture, the block getstat #Z147_BLK_RX_CAPTURE returns it
+	(Z147_CAPT_HDR followed by the frames) and releases the region.
+	Triggers while a capture is not read yet are counted in the lost field
+	of the next one. Frames 0 or a data rate or sync mode change stop the
+	capture and free its memory (2 * frames * frame size).
+
+	With #Z147_RX_DEFERRED set to 1 the interrupt routine only reads the
+	status register, masks the interrupts of the core and sets an OSS alarm.
+	The alarm routine, running after the interrupt at the next system tick,
+	drains and acknowledges the FIFO, swaps the buffers, sends the signals
+	and enables the interrupts again. The time with interrupts off no longer
+	grows with the trigger level, at the cost of one system tick of latency:
+	the FIFO (2047 words) has to take the words of the trigger level plus
+	one tick.
+
 
  	\n \subsection RxSetget Driver Configuration 
 	The driver can be configured using M_setstat(), using following options:
@@ -105,7 +174,31 @@
     <tr><td>   </td><td> -  0b011   </td>    <td>: Reserved (Full synchronization shall be used)</td></tr>
 
     </table>
-	
+
+	If the data rate of the recorder is not known, #Z147_RX_RATE_DETECT
+	finds it. An OSS alarm probes the rates with part synchronization,
+	two sync words in order lock the core within two subframes (2 s at
+	every rate), so a wrong rate is left after 2.5 s instead of waiting
+	for the full synchronization. The current rate is probed first, then
+	512, 256, 1024, 64, 128, 2048, 4096 and 8192 words/s, over and over
+	until one locks. The locked rate is committed with the sync mode set
+	before (the core synchronizes once more in this mode) and
+	#Z147_RX_DETECT_MS returns the time from the start of the probes to
+	the lock, 0 while probing. All 8 rates take at most 20 s.
+	- #Z147_DETECT_ONCE detects the rate once and turns to
+	  #Z147_DETECT_OFF.
+	- #Z147_DETECT_FOLLOW watches the synchronization afterwards. When it
+	  is lost for 5 s, e.g. because the transmitter changed its rate, the
+	  probes start again. Set while in sync, it only watches.
+	- #Z147_RX_DATA_RATE or #Z147_RX_SYNC_CFG switch the detection off.
+
+	While the detection is on, the frame buffers of the highest rate
+	(2 * 64 KB) stay allocated, the alarm routine does not allocate.
+	The probes change the frame size: the detection is refused with
+	ERR_LL_DEV_BUSY while watches or a capture are set, and so are they
+	while the detection is on. M_getblock() returns ERR_LL_DEV_NOTRDY
+	for a frame read across a restart of the receiver.
+
    
     \n \subsection RxDefault Default values
     M_open() and M_close() configures the Receive driver as follows: 
@@ -170,6 +263,12 @@
  	#Z247_SET_SIGNAL to the application, when a transmission request is completed.
 	The signal can be uninstalled using #Z247_CLR_SIGNAL.
 
+	The signal assigned with #Z247_SET_FRAME_SIGNAL is sent whenever the driver
+	starts a new frame (the next or the repeated last one) and counts it in
+	#Z247_TX_FRAME_CNT. From then on the user buffer is free: data written
+	with M_setblock() after the signal goes out as the next frame, so an
+	application that writes once per signal never overwrites a pending frame.
+
 	\n \subsection TxSetget Driver Configuration 
 	The driver can be configured using M_setstat(), using following options:
 	
@@ -224,6 +323,252 @@
     \n \section TxCodes Driver specific Getstat/Setstat codes
     see \ref tx_getstat_setstat_codes "section about Getstat/Setstat codes"
 
+    \n \section HostSim Host Simulator
+    The tool Z147_SIM builds both low-level drivers on a Linux host without
+    MDIS and hardware. The OSS, DESC, DBG libraries and the MACCESS macros
+    are replaced by host versions, every register access of the drivers goes
+    to a model of the 16Z147/16Z247 register map (see z147_sim.h).
+
+    The model moves one word per word time (1/8192 s at the highest rate),
+    fills the FIFOs, acquires synchronization according to the sync mode and
+    calls the ISR of the driver while its interrupt is pending. A transmitter
+    can be connected to a receiver, faults (bit errors, word slips, corrupted
+    sync words, line gaps) can be injected on the receive line.
+
+    \code
+    cd TOOLS/Z147_SIM/COM
+    make check
+    \endcode
+
+    z147_sim checks every received frame for all data rates and reports the
+    number of interrupts per frame and register accesses per interrupt.
+
+    z147_isr_bench (make bench) measures Z147_Irq() and Z247_Irq() for every
+    data rate and trigger level and prints ns per word, ns per interrupt,
+    register accesses per interrupt and the p50/p99/max ISR duration as CSV.
+    Option -m=<ns> fails if the cost per word exceeds the given limit.
+    Option -w measures the receive driver with #Z147_RX_DEFERRED, the work
+    columns give the duration of the deferred processing. make check runs
+    z147_sim in both modes, the simulated OSS alarms fire in simulation time.
+
+    The simulator also provides M_open() and the other MDIS API functions,
+    so MDIS tools run unchanged against simulated devices. A device name
+    containing "tx" opens a transmitter, it is connected to the receiver of
+    the same name with "rx". The environment variable Z147SIM_SPEED speeds up
+    the simulation (UOS_Delay() and UOS_MsecTimerGet() follow it).
+
+    \n \section Loopback Loopback Test
+    z147_loopback_test sets #Z247_LOOPBACK and sends one frame per frame time
+    with a sequence number and a PRBS-15 pattern in every sub frame. For each
+    data rate and sync mode it reports bit and word error rate, lost and
+    repeated frames, sync losses, the write-to-read latency (p50/p99/max) and
+    the received words per second:
+
+    \code
+    z147_loopback_test arinc717_rx_1 arinc717_tx_1 -t=600 -n=0
+    \endcode
+
+    On the host, make loopback runs it against the simulator.
+
+    \n \section Jitter Frame Period and Jitter
+    z147_jitter_test time stamps every receive signal with microsecond
+    resolution (the signal handler only takes the time and wakes up a reader
+    thread). Per data rate it prints the period statistics against the
+    nominal 4 s frame time, a deviation histogram, the Allan deviation and
+    the drift of the received rate; -o=<file> exports all time stamps as CSV.
+
+    \n \section RxRuntime Receive Runtime of the Tools
+    z147_example and the receive tools (rate, timing and sync test) use the
+    user library z147_rt (z147_rt.h). Its signal handler only takes a time
+    stamp and wakes up a reader thread, which reads every frame into a
+    preallocated buffer and queues it for the main thread. Checking and
+    printing happen in the main thread, a slow console costs queued frames
+    (Z147RT_STATS.dropped) but never delays the next M_getblock().
+
+    \n \section Recorder Flight Data Recorder
+    z147_recorder records every frame of up to 8 receivers into segment
+    files (format see z147_rec.h). Each record carries the UTC and monotonic
+    receive time, the driver frame count, the sync state and the number of
+    frames lost before it. A writer thread writes large aligned blocks with
+    O_DIRECT, rotates the segment files and deletes the oldest ones to stay
+    within the disk limit:
+
+    \code
+    z147_recorder -r=7 -o=/data -s=64 -d=4096 arinc717_rx_1 arinc717_rx_2
+    \endcode
+
+    The status lines and the final report show the write latency, the queue
+    depth of the writer and all lost or dropped frames.
+
+    \n \section Replay Replay
+    z147_replay sends one channel of a recording with a transmitter at the
+    original timing. The segment files are memory mapped and read ahead of
+    the playback position. The next frame is written after each
+    #Z247_SET_FRAME_SIGNAL, so the transmitter paces the replay; gaps in the
+    recording repeat the last frame. -x=<n> plays n times faster by sending
+    every n-th frame, -m=1 sends all frames back to back. The timing error
+    of every frame against its recorded time stamp is reported (-o=<file>
+    for CSV):
+
+    \code
+    z147_replay -c=0 arinc717_tx_1 /data/z147rec_*.z147
+    \endcode
+
+    \n \section FrameFile Indexed Frame Files
+    A frame file (z147_frm.h) holds the frames of one channel with the
+    data rate, sync and receive mode in its header and a time stamp and
+    status flags per frame. All frames have the same size, a footer holds a
+    sparse time index and a superframe index. The z147_frm library maps the
+    file and seeks to a time (Z147FRM_SeekTime()) or superframe
+    (Z147FRM_SeekSuperframe()) with a binary search, without reading the
+    rest of the file. Superframes are taken from a counter word (-w) or
+    are 16 frames each. z147_frm_index converts a recording and lists
+    frames from a given position:
+
+    \code
+    z147_frm_index -c=0 -w=1,1,0xf flight.z147f /data/z147rec_*.z147
+    z147_frm_index -q -t=2220 -n=16 flight.z147f
+    \endcode
+
+    \n \section Compression Frame Compression
+    The z147_cmp library compresses frames for storage. Each word is XORed
+    with the same slot of the previous frame, unchanged runs are coded in
+    one byte and changed words are packed to 12 bit (16 bit if more bits
+    are set). Every 64th frame (configurable) is a key frame that does not
+    depend on older frames, so decoding can start there. One codec state
+    (Z147CMP_CTX) is used per channel. z147_cmp_bench reports compression
+    ratio and encode/decode throughput for a frame file or synthetic data:
+
+    \code
+    z147_cmp_bench flight.z147f
+    z147_cmp_bench -r=7 -n=512
+    \endcode
+
+    \n \section Packed Packed Frames
+    ARINC 717 words have 12 bit. With #Z147_RX_PACKED (receiver) and
+    #Z247_TX_PACKED (transmitter) set, M_getblock() / M_setblock() use a
+    packed format with 2 words in 3 bytes (little endian, Z147_PACKED_SIZE())
+    instead of one u_int16 per word, which saves a quarter of the copy and
+    storage bandwidth. The drivers pack and unpack with plain C code. In user
+    space the z147_pack library converts between both formats with SSE2 or
+    AVX2 kernels selected at run time (scalar code on other CPUs).
+    z147_recorder -P records packed frames, z147_replay and z147_frm_index
+    unpack them. z147_pack_bench checks the kernels and reports their
+    throughput for all data rates:
+
+    \code
+    z147_recorder -P -r=7 -o=/data arinc717_rx_1
+    z147_pack_bench
+    \endcode
+
+    \n \section FrameMap Frame Maps
+    A frame map (z147_map.h) lists the parameters of a frame layout by
+    subframe, word, ARINC bit range, encoding (BNR, BCD, discrete, packed
+    binary over up to 4 adjacent words), scaling and frame of the
+    superframe. Z147MAP_Load() compiles it into a decoding plan with one
+    instruction per parameter and subframe, grouped by encoding and sorted
+    by word offset. Z147MAP_Decode() applies the plan to a frame as read by
+    M_getblock() and returns the engineering values in one pass; the cost
+    depends on the number of parameters, not on the frame size.
+    z147_decode prints the values of a frame file or a receiver (-l) as
+    CSV, -b measures the decoding time:
+
+    \code
+    z147_decode -p=ALTITUDE a320.map flight.z147f
+    z147_decode -l a320.map arinc717_rx_1
+    \endcode
+
+    A word has 4096 values, so Z147MAP_LutBuild() can replace the bit
+    arithmetic of single word parameters by value tables of 32 KB, shared
+    by parameters with the same bits and scaling. z147_decode -L=<n> limits
+    the tables, with -b it compares both decodings. For a layout fixed at
+    build time, z147_decode -g=<file.c> writes the parameters and tables as
+    C source; the program passes them to Z147MAP_Build() and
+    Z147MAP_LutBuild() and computes nothing at start-up.
+
+    For bulk decoding, Z147MAP_Column() collects one word slot of many
+    frames and Z147MAP_Convert() converts the columns of an instruction
+    with SSE2 or AVX2 kernels (selected at run time), incl. parameters over
+    adjacent words. The results are identical to Z147MAP_Decode().
+    z147_conv_bench compares the kernels per encoding with the scalar
+    code.
+
+    \n \section Superframes Superframes
+    An ARINC 717 superframe is 16 frames, numbered by a counter word. The
+    superframe assembler (z147_sf.h) is configured with the subframe, word
+    and bits of the counter. The application reads each frame with
+    M_getblock() straight into the buffer of Z147SF_Slot(), and
+    Z147SF_Push() then moves it to its position in the superframe without
+    copying it. The counter difference between frames shows lost frames
+    and repeated frames (which are dropped). A finished superframe is
+    passed to a notify function or queued for Z147SF_Get() and belongs to
+    the application until Z147SF_Put(). z147_superframe prints the
+    superframes of a frame file or a receiver:
+
+    \code
+    z147_superframe -l -r=4 -c=1,1,0x00f arinc717_rx_1
+    \endcode
+
+    \n \section Extraction Offline Extraction
+    z147_extract decodes the parameters of a frame map from many frame
+    files in parallel and writes one time and one value column per
+    parameter (\<param\>.ts, \<param\>.val) in time order. The files are
+    split into chunks at superframe starts; worker threads with their own
+    chunk deques steal from each other when they run dry, and the main
+    thread writes the chunks in order. At most -w chunks are in memory, so
+    the memory does not grow with the recording size. Compare the
+    throughput with -b (no output) to see whether the disk or the CPU
+    limits:
+
+    \code
+    z147_extract -o=out -p=ALTITUDE,TAT a320.map flight_*.z147f
+    \endcode
+
+    Every column holds two open files, select the parameters with -p for
+    large maps or raise the file limit.
+
+    \n \section ColumnStore Column Store
+    With -s (or -z compressed) z147_extract writes one column file per
+    parameter (z147_col.h) instead. A column file holds pages of samples
+    and a zone map with the time and value range of every page, so a
+    query of one parameter and one time span reads only the pages it
+    needs. Compressed pages code the times as delta of delta and the
+    values XORed with the previous one; both shrink to a few bytes for a
+    slowly changing parameter sampled at a fixed rate. z147_col_query
+    prints a range of a column and the pages read:
+
+    \code
+    z147_extract -z -o=store a320.map flight_*.z147f
+    z147_col_query -f=1457000000000000000 -t=1457000060000000000 -min=30000 store/ALTITUDE.z147c
+    \endcode
+
+    The writer also builds summaries (count, min, max, sum) per second,
+    minute and hour. Z147COL_Aggregate() answers min, max and mean of a
+    time window from the coarsest summaries that fit and decodes only the
+    partial seconds at the window edges, so a window over the whole flight
+    costs about as much as one over a minute. z147_col_query -a prints the
+    aggregates per window:
+
+    \code
+    z147_col_query -a=60 store/ALTITUDE.z147c
+    \endcode
+
+    \n \section RawAlign Raw Dump Alignment
+    Dumps taken in raw mode or by a line analyzer hold 16 bit words
+    without frame position. z147_raw_align searches the sync words with
+    SSE2/AVX2 compares (z147_align.h), detects the data rate from eight
+    sync words in order at the subframe distance of one of the rates and
+    writes the aligned frames to a frame file. When the sync words get
+    lost (slipped or inserted word, garbage) the search starts again and
+    the skipped frames show up as lost frames in the file:
+
+    \code
+    z147_raw_align -t=1457000000 capture.raw capture.z147f
+    \endcode
+
+    Without frame file only the alignment is reported; -k selects the
+    search kernel to compare the throughput.
+
     \n \section Documents Overview of all Documents
 
     \subsection z147_example  Simple example for using the driver
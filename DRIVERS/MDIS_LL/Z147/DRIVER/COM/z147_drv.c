@@ -105,14 +105,76 @@
 #define Z147_RX_TRIG_LVL_256   	    6    /**< Set trigger level to 256 words. */
 #define Z147_RX_TRIG_LVL_512        7    /**< Set trigger level to 512 words. */
 
+#define NO_WATCH					0xFFFFFFFF	/**< Watch position of an empty list. */
+#define RX_WORK_MSEC				1	 /**< Delay of the deferred processing (next tick). */
+#define EXIT_WAIT_US				2000 /**< Max. wait for a running ISR in Z147_Exit(). */
+#define EXIT_POLL_US				10	 /**< Poll interval of this wait. */
+#define HOLD_CALL					1	 /**< rxHold owner: a setstat (RxHold()). */
+#define HOLD_WORK					2	 /**< rxHold owner: RxWork(). */
+#define HOLD_DETECT					3	 /**< rxHold owner: DetectWork(). */
+#define SW_SYNC_CAND				4	 /**< Sync word candidates of the software synchronizer. */
+#define SW_SYNC_LOCK				4	 /**< Sync words in order to lock (one frame). */
+#define SW_SYNC_CONF				8	 /**< Confidence after the lock, sync slots missed to lose it. */
+#define MAX_BUFF_SIZE				65536 /**< Frame buffer bytes at 8192 words/s. */
+#define DETECT_POLL_MS				100	 /**< Poll interval of the rate detection. */
+#define DETECT_PROBE_MS				2500 /**< Time per probed rate, two sync words (2 s) plus margin. */
+#define DETECT_HOLD_MS				5000 /**< Follow mode: sync lost this long starts a detection. */
+#define DETECT_SYNC_CFG				1	 /**< Sync mode of the probes (partial synchronization). */
+#define DETECT_RATES				8	 /**< Number of data rates. */
+
 #define USER_DATA_NOT_UPDATED 		0	 /**< User buffer is not updated. */
-#define USER_DATA_UPDATED  			1	 /**< User buffer is updated.
+#define USER_DATA_UPDATED  			1	 /**< User buffer is updated. */
 
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
-/** low-level handle */
+typedef struct LL_HANDLE LL_HANDLE;	/**< low-level handle, defined below */
+
+/* include files which need LL_HANDLE */
+#include <MEN/ll_entry.h>       /* low-level driver jump table */
+#include <MEN/z147_drv.h>        /* Z147 driver header file      */
+
+/** watched word (Z147_WATCH) and its state */
+typedef struct {
+	u_int16					pos;			/**< Word in the frame. */
+	u_int16					type;			/**< Z147_WATCH_xx */
+	u_int16					mask;			/**< Bits watched. */
+	u_int16					lo;				/**< Value, lower limit or max. change. */
+	u_int16					hi;				/**< Upper limit. */
+	u_int16					idx;			/**< Index in the list set. */
+	u_int16					last;			/**< Masked value of the previous frame. */
+	u_int8					valid;			/**< Flag to indicate that last is valid. */
+	u_int8					in;				/**< Flag to indicate equal / in range. */
+} WATCH;
+
+/** trigger event (Z147_TRIG_EVENT) */
 typedef struct {
+	u_int32					frameCnt;		/**< Frame count. */
+	u_int16					watch;			/**< Watch index. */
+	u_int16					pos;			/**< Word in the frame. */
+	u_int16					value;			/**< Masked value. */
+	u_int16					prev;			/**< Previous masked value. */
+} TRIG_EVENT;
+
+/** frozen capture */
+typedef struct {
+	u_int32					capture;		/**< Number of the capture. */
+	u_int32					source;			/**< Trigger source. */
+	u_int32					trigFrame;		/**< Frame count of the trigger frame. */
+	u_int32					first;			/**< Region slot of the first frame. */
+	u_int32					frames;			/**< Frames. */
+	u_int32					lost;			/**< Triggers lost before. */
+} CAPT_SNAP;
+
+/** sync word candidate of the software synchronizer */
+typedef struct {
+	u_int32					next;			/**< Word count of its next sync word. */
+	u_int16					sub;			/**< Subframe of its next sync word (0..3). */
+	u_int16					cnt;			/**< Sync words found in order, 0 = unused. */
+} SW_CAND;
+
+/** low-level handle */
+struct LL_HANDLE {
 	/* general */
 	int32                   memAlloc;       /**< size allocated for the handle */
 	OSS_HANDLE              *osHdl;         /**< oss handle        */
@@ -133,6 +195,9 @@ typedef struct {
 
 	/* Buffer for user frame. */
 	u_int16*				usrBuffer;		 /**< Buffer for user data. */
+	u_int32					buffAlloc;		 /**< Usable bytes per buffer. */
+	u_int32					ringGot;		 /**< Bytes allocated for drvRingBuffer. */
+	u_int32					usrGot;			 /**< Bytes allocated for usrBuffer. */
 	volatile u_int32 		usrBuffSize;	 /**< User buffer size. */
 	u_int8					isUsrDataUpdated;/**< Flag to indicate whether the user has updated data. */
 
@@ -147,17 +212,82 @@ typedef struct {
 
 	u_int8					isDrvSync;		/**< Flag to indicate whether the driver is in sync with FPGA. */
 	u_int8					disableRx;		/**< Flag to indicate whether the driver is disabled by user. */
-	u_int8					isRxIrqExit;	/**< Flag to indicate whether the driver exited from IRQ routine. */
+	volatile u_int8			isrBusy;		/**< Flag: Z147_Irq() is running. */
+	volatile u_int8			workBusy;		/**< Flag: RxWork() is running. */
+	volatile u_int8			rxHold;			/**< Owner of the RX hold (HOLD_xx), 0 = free. */
+	volatile u_int32		rxCfgGen;		/**< Frame size changes, odd while changing. */
 	u_int64					rxIrqCnt;		/**< Receive interrupt count. */
+	volatile u_int32		rxFrameCnt;		/**< Receive complete frame count. */
+	u_int8					rxPacked;		/**< Flag to indicate packed 12 bit output of BlockRead. */
 	u_int64					rxOverrunErrCnt;	/**< Receive overrun error count. */
 	u_int64					rxStreamIntErrCnt;  /**< Receive stream interrupt error count. */
 	u_int64					rxLostSyncErrCnt;	/**< Receive lost sync error count. */
-} LL_HANDLE;
 
-
-/* include files which need LL_HANDLE */
-#include <MEN/ll_entry.h>       /* low-level driver jump table */
-#include <MEN/z147_drv.h>        /* Z147 driver header file      */
+	/* change detection (Z147_RX_CHANGE_ONLY) */
+	u_int8					rxChangeOnly;	/**< Flag to signal changed frames only. */
+	u_int8					rxChangeAll;	/**< Flag to report all slots, no previous frame. */
+	u_int8					rxSlotShift;	/**< Words per change slot (log2). */
+	u_int32					rxSlotMask[2];	/**< Changed slots of the current frame. */
+	volatile u_int32		rxChangeCnt;	/**< Changed frame count. */
+	u_int32					rxChgFrameCnt;	/**< Frame count of the last changed frame. */
+	u_int32					rxChgSlotMask[2];	/**< Changed slots of the last changed frame. */
+
+	/* watch triggers (Z147_BLK_RX_WATCH) */
+	OSS_SIG_HANDLE          *trigSig;		/**< Trigger signal. */
+	WATCH					watch[Z147_WATCH_MAX];	/**< Watches sorted by position. */
+	u_int32					watchNum;		/**< Number of watches. */
+	u_int32					watchIdx;		/**< Next watch to check. */
+	u_int32					watchPos;		/**< Its position or NO_WATCH. */
+	TRIG_EVENT				trig[Z147_TRIG_QUEUE];	/**< Trigger event queue. */
+	volatile u_int32		trigHead;		/**< Events queued. */
+	volatile u_int32		trigTail;		/**< Events read. */
+	u_int32					trigCnt;		/**< Trigger event count. */
+	u_int8					trigPending;	/**< Flag to send the trigger signal. */
+
+	/* pre/post trigger capture (Z147_BLK_RX_CAPTURE) */
+	u_int16					*capt[2];		/**< History regions. */
+	u_int32					captSize[2];	/**< Bytes allocated per region. */
+	u_int32					captFrames;		/**< Frames per region, 0 = off. */
+	u_int32					captPre;		/**< Frames before the trigger frame. */
+	u_int32					captPost;		/**< Frames after the trigger frame. */
+	u_int32					captMask;		/**< Trigger sources. */
+	u_int32					captAct;		/**< Region written. */
+	u_int32					captWr;			/**< Frames written to it. */
+	u_int32					captLeft;		/**< Frames to the freeze, 0 = no trigger. */
+	u_int32					captSource;		/**< Source of the pending trigger. */
+	u_int32					captTrigFrame;	/**< Trigger frame of the pending trigger. */
+	u_int32					captCnt;		/**< Captures frozen. */
+	u_int32					captLost;		/**< Triggers lost since the last one. */
+	u_int8					captReady;		/**< Flag: captSnap waits for the reader. */
+	CAPT_SNAP				captSnap;		/**< Frozen capture, region captAct^1. */
+
+	/* deferred receive processing (Z147_RX_DEFERRED) */
+	OSS_ALARM_HANDLE		*rxAlarm;		/**< Alarm running RxWork(), NULL = off. */
+	u_int32					rxWorkStat;		/**< Status register of the masked IRQ. */
+	volatile u_int8			rxWorkPending;	/**< Flag: RxWork() has to process it. */
+
+	/* software frame synchronizer (Z147_RX_SYNC_CFG 0) */
+	u_int8					swSync;			/**< Flag: raw mode, the driver aligns the frames. */
+	u_int8					swConf;			/**< Confidence of the alignment, 0 = hunting. */
+	u_int32					swWordCnt;		/**< Words scanned. */
+	SW_CAND					swCand[SW_SYNC_CAND];	/**< Sync word candidates. */
+	u_int32					swCandNext;		/**< Candidate replaced next. */
+	volatile u_int32		swSlipCnt;		/**< Realignments after a slip. */
+
+	/* automatic data rate detection (Z147_RX_RATE_DETECT) */
+	OSS_ALARM_HANDLE		*detAlarm;		/**< Alarm running DetectWork(). */
+	volatile u_int8			detBusy;		/**< Flag: DetectWork() is running. */
+	u_int8					detMode;		/**< Z147_DETECT_xx */
+	u_int8					detRun;			/**< Flag: rates are probed. */
+	u_int8					detSyncCfg;		/**< Sync mode set again after the detection. */
+	u_int8					detOrder[DETECT_RATES];	/**< Rates in probe order. */
+	u_int32					detIdx;			/**< Probed rate in detOrder. */
+	u_int32					detPeriodMs;	/**< Alarm period. */
+	u_int32					detProbeMs;		/**< Time of the probe. */
+	u_int32					detElapsedMs;	/**< Time of the detection. */
+	u_int32					detLostMs;		/**< Follow mode: time without sync. */
+	volatile u_int32		detTimeMs;		/**< Duration of the last detection. */
+};
 
 /*-----------------------------------------+
 |  PROTOTYPES                              |
@@ -184,6 +314,33 @@ static int32 Cleanup(LL_HANDLE *llHdl, int32 retCode);
 static void  ConfigureDefault( LL_HANDLE *llHdl );
 static int SetDataRate(LL_HANDLE *llHdl, u_int8 rxSpeed);
 static void RegStatus(LL_HANDLE *llHdl);
+static void Pack12(const u_int16 *src, u_int8 *dst, u_int32 words);
+static int32 FrameChanged(LL_HANDLE *llHdl);
+static int32 HoldTake(LL_HANDLE *llHdl, u_int8 owner);
+static int32 RxHold(LL_HANDLE *llHdl);
+static int32 RxQuiesce(LL_HANDLE *llHdl);
+static void RxRelease(LL_HANDLE *llHdl);
+static int32 SetWatch(LL_HANDLE *llHdl, M_SG_BLOCK *blk);
+static void NextWatch(LL_HANDLE *llHdl);
+static void Watch(LL_HANDLE *llHdl, u_int16 word);
+static int32 SetCapture(LL_HANDLE *llHdl, M_SG_BLOCK *blk);
+static int32 GetCapture(LL_HANDLE *llHdl, M_SG_BLOCK *blk);
+static void FreeCapture(LL_HANDLE *llHdl);
+static void CaptureFrame(LL_HANDLE *llHdl);
+static void CaptureTrigger(LL_HANDLE *llHdl, u_int32 source);
+static int32 RxProcess(LL_HANDLE *llHdl, u_int32 statReg);
+static void RxWork(void *arg);
+static int32 SetDeferred(LL_HANDLE *llHdl, int32 on);
+static void RxAlign(LL_HANDLE *llHdl, u_int32 pos);
+static void SwSyncReset(LL_HANDLE *llHdl);
+static int32 SwSync(LL_HANDLE *llHdl, u_int16 word);
+static int32 RxBuffers(LL_HANDLE *llHdl, u_int32 size);
+static void RxRestart(LL_HANDLE *llHdl, u_int8 rate, u_int8 syncCfg);
+static int32 SetDetect(LL_HANDLE *llHdl, int32 mode);
+static u_int8 DetectStart(LL_HANDLE *llHdl);
+static void DetectRestart(LL_HANDLE *llHdl, u_int8 rate, u_int8 syncCfg);
+static int32 DetectInSync(LL_HANDLE *llHdl);
+static void DetectWork(void *arg);
 
 /****************************** Z147_GetEntry ********************************/
 /** Initialize driver's jump table
@@ -279,9 +436,15 @@ static int32 Z147_Init(
 	llHdl->drvRingBuffer  = NULL;
 	llHdl->usrBuffer      = NULL;
 	llHdl->rxIrqCnt       = 0;
+	llHdl->rxFrameCnt     = 0;
+	llHdl->rxPacked       = 0;
 	llHdl->rxOverrunErrCnt = 0;
 	llHdl->rxStreamIntErrCnt  = 0;
 	llHdl->rxLostSyncErrCnt = 0;
+	llHdl->rxChangeOnly   = 0;
+	llHdl->rxChangeCnt    = 0;
+	llHdl->watchNum       = 0;
+	llHdl->watchPos       = NO_WATCH;
 	/*------------------------------+
 	|  init id function table       |
 	+------------------------------*/
@@ -337,7 +500,9 @@ static int32 Z147_Init(
 /** De-initialize hardware and clean up memory
  *
  *  The function deinitializes all channels by setting them as inputs.
- *  The interrupt is disabled.
+ *  The interrupt is disabled and the data in the FIFO is discarded. An ISR
+ *  or alarm routine running on another CPU is waited for up to
+ *  EXIT_WAIT_US, ERR_LL_DEV_BUSY is returned if it does not finish.
  *
  *  \param llHdlP     \IN  pointer to low-level driver handle
  *
@@ -350,19 +515,35 @@ static int32 Z147_Exit(
 
 	LL_HANDLE *llHdl = *llHdlP;
 	int32 error = 0;
-	int timeoutCnt = 20;
-	while(llHdl->isRxIrqExit != 0){
-		if(timeoutCnt > 0){
-			/* Else wait for some time and check again */
-			timeoutCnt--;
-			OSS_Delay(OSH, 100);
-		}else{
-			/* Exit the loop and return. */
-			return ERR_LL_DEV_BUSY;
-		}
-	}
-	/* reset the default interrupts */
+	u_int32 statReg, waitUs;
+
+	/* no interrupt enables the core again */
+	llHdl->disableRx = 1;
 	MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
+
+	/* drop a pending deferred processing, its data is discarded */
+	if(llHdl->rxAlarm){
+		OSS_AlarmClear(OSH, llHdl->rxAlarm);
+		llHdl->rxWorkPending = 0;
+	}
+	/* no more rate probes */
+	if(llHdl->detAlarm){
+		OSS_AlarmClear(OSH, llHdl->detAlarm);
+		llHdl->detRun = 0;
+	}
+
+	/* discard the received data */
+	statReg = MREAD_D32(llHdl->ma, Z147_STAT_REG);
+	MWRITE_D16(llHdl->ma, Z147_RX_RXA_OFFSET,
+			   (statReg >> (Z147_RX_RXC_OFFSET * 8)) & 0xFFFF);
+
+	/* an ISR or alarm routine running on another CPU finishes quickly */
+	for(waitUs = 0; (llHdl->isrBusy || llHdl->workBusy || llHdl->detBusy) &&
+			waitUs < EXIT_WAIT_US; waitUs += EXIT_POLL_US){
+		OSS_MikroDelay(OSH, EXIT_POLL_US);
+	}
+	if(llHdl->isrBusy || llHdl->workBusy || llHdl->detBusy)
+		return ERR_LL_DEV_BUSY;
 	IDBGWRT_2((DBH, ">>> LL - Z147_Exit: Register status in the Exit\n"));
 	RegStatus(llHdl);
 	DBGWRT_1((DBH, "Z147_Exit\n"));
@@ -523,6 +704,69 @@ static int32 Z147_SetStat(
 		error = OSS_SigRemove(OSH, &llHdl->rxErrorSig);
 		break;
 
+		/*--------------------------+
+		|  register trigger signal  |
+		+--------------------------*/
+	case Z147_SET_TRIG_SIGNAL:
+		/* signal already installed ? */
+		if (llHdl->trigSig) {
+			error = ERR_OSS_SIG_SET;
+			break;
+		}
+		error = OSS_SigCreate(OSH, value, &llHdl->trigSig);
+		break;
+		/*----------------------------+
+		|  unregister trigger signal  |
+		+----------------------------*/
+	case Z147_CLR_TRIG_SIGNAL:
+		/* signal already installed ? */
+		if (llHdl->trigSig == NULL) {
+			error = ERR_OSS_SIG_CLR;
+			break;
+		}
+		error = OSS_SigRemove(OSH, &llHdl->trigSig);
+		break;
+
+		/*---------------------------+
+		|  Watch list                |
+		+---------------------------*/
+	case Z147_BLK_RX_WATCH:
+		error = SetWatch(llHdl, (M_SG_BLOCK*)value32_or_64);
+		break;
+
+		/*---------------------------+
+		|  Capture                   |
+		+---------------------------*/
+	case Z147_BLK_RX_CAPTURE:
+		error = SetCapture(llHdl, (M_SG_BLOCK*)value32_or_64);
+		break;
+	case Z147_RX_CAPT_TRIG:
+		if(llHdl->captFrames == 0){
+			error = ERR_LL_ILL_PARAM;
+			break;
+		}
+		/* the ISR triggers the capture too */
+		if((error = RxHold(llHdl)) != ERR_SUCCESS)
+			break;
+		if(llHdl->captFrames)
+			CaptureTrigger(llHdl, Z147_CAPT_USER);
+		RxRelease(llHdl);
+		break;
+
+		/*---------------------------+
+		|  Deferred processing       |
+		+---------------------------*/
+	case Z147_RX_DEFERRED:
+		error = SetDeferred(llHdl, value);
+		break;
+
+		/*---------------------------+
+		|  Rate detection            |
+		+---------------------------*/
+	case Z147_RX_RATE_DETECT:
+		error = SetDetect(llHdl, value);
+		break;
+
 		/*--------------------------------------------+
 		|  Receive line status interrupt status       |
 		+---------------------------------------------*/
@@ -542,14 +786,20 @@ static int32 Z147_SetStat(
 		+-------------------------*/
 	case Z147_RX_DATA_RATE:
 		if((value >= 0) && (value <= Z147_RX_DATA_RATE_MASK)){
+			/* a rate set by the user ends the detection */
+			if((error = SetDetect(llHdl, Z147_DETECT_OFF)) != ERR_SUCCESS)
+				break;
+			/* the buffers and the capture are replaced */
+			if((error = RxHold(llHdl)) != ERR_SUCCESS)
+				break;
 			MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 1);
-			/* Disable the interrupt. */
-			MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
 			llHdl->disableRx = 1;
+			/* the reset discards the words of a deferred processing */
+			llHdl->rxWorkPending = 0;
 			error = SetDataRate(llHdl, (u_int8)value);
-			/* Disable the interrupt. */
-			MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, Z147_RX_IER_DEFAULT);
 			MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 0);
+			/* Enable the interrupt. */
+			RxRelease(llHdl);
 
 		}else{
 			error = ERR_LL_ILL_PARAM;
@@ -578,19 +828,17 @@ static int32 Z147_SetStat(
 		+-----------------*/
 	case Z147_RX_SYNC_CFG:
 		if((value >= 0) && (value < Z147_RX_SYNC_MASK)){
-			MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 1);
-			/* Disable the interrupt. */
-			MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
-			llHdl->disableRx = 1;
+			if((error = SetDetect(llHdl, Z147_DETECT_OFF)) != ERR_SUCCESS)
+				break;
+			/* the ISR and RxWork() use the software sync state */
+			if((error = RxHold(llHdl)) != ERR_SUCCESS)
+				break;
+			/* the core starts again at its rate, without sync words the driver aligns the frames */
 			regData = MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET);
-
-			regData = regData & (~Z147_RX_DATA_RATE_MASK);
-			regData |= (value  & Z147_RX_DATA_RATE_MASK);
-			/* Set the sync mode.  */
-			MWRITE_D8(llHdl->ma, Z147_RX_LCR_OFFSET, regData);
+			RxRestart(llHdl, (regData & Z147_RX_DATA_RATE_MASK) >>
+					  Z147_RX_DATA_RATE_OFFSET, (u_int8)value);
 			/* Enable the interrupt. */
-			MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, Z147_RX_IER_DEFAULT);
-			MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 0);
+			RxRelease(llHdl);
 
 		}else{
 			error = ERR_LL_ILL_PARAM;
@@ -621,6 +869,24 @@ static int32 Z147_SetStat(
 
 		break;
 
+		/*---------------------------+
+		|  Packed 12 bit frames      |
+		+---------------------------*/
+	case Z147_RX_PACKED:
+		llHdl->rxPacked = (value != 0) ? 1 : 0;
+		break;
+
+		/*---------------------------+
+		|  Signal changed frames     |
+		+---------------------------*/
+	case Z147_RX_CHANGE_ONLY:
+		/* the next frame has no previous one to compare with */
+		llHdl->rxSlotMask[0] = 0;
+		llHdl->rxSlotMask[1] = 0;
+		llHdl->rxChangeAll = 1;
+		llHdl->rxChangeOnly = (value != 0) ? 1 : 0;
+		break;
+
 		/*--------------------------+
 		|  (unknown)                |
 		+--------------------------*/
@@ -710,7 +976,10 @@ static int32 Z147_GetStat(
 		|  RX data length           |
 		+--------------------------*/
 	case Z147_RX_DATA_LEN:
-		*valueP = (INT32_OR_64)llHdl->usrBuffSize * 2;
+		if(llHdl->rxPacked)
+			*valueP = (INT32_OR_64)Z147_PACKED_SIZE(llHdl->usrBuffSize);
+		else
+			*valueP = (INT32_OR_64)llHdl->usrBuffSize * 2;
 		break;
 
 		/*--------------------------------------------+
@@ -772,6 +1041,128 @@ static int32 Z147_GetStat(
 		*valueP = (INT32_OR_64)((regData & Z147_RX_MODE_MASK) >> Z147_RX_MODE_OFFSET);
 		break;
 
+		/*------------------------+
+		|  Received frame count   |
+		+------------------------*/
+	case Z147_RX_FRAME_CNT:
+		*valueP = (INT32_OR_64)llHdl->rxFrameCnt;
+		break;
+
+		/*---------------------------+
+		|  Packed 12 bit frames      |
+		+---------------------------*/
+	case Z147_RX_PACKED:
+		*valueP = (INT32_OR_64)llHdl->rxPacked;
+		break;
+
+		/*---------------------------+
+		|  Signal changed frames     |
+		+---------------------------*/
+	case Z147_RX_CHANGE_ONLY:
+		*valueP = (INT32_OR_64)llHdl->rxChangeOnly;
+		break;
+
+		/*---------------------------+
+		|  Changed frame count       |
+		+---------------------------*/
+	case Z147_RX_CHANGE_CNT:
+		*valueP = (INT32_OR_64)llHdl->rxChangeCnt;
+		break;
+
+		/*---------------------------+
+		|  Changes of last frame     |
+		+---------------------------*/
+	case Z147_BLK_RX_CHANGES:
+	{
+		M_SG_BLOCK *blk = (M_SG_BLOCK*)value32_or_64P;
+		Z147_CHANGES *chg = (Z147_CHANGES*)blk->data;
+		u_int32 i;
+
+		if(blk->size < (int32)sizeof(Z147_CHANGES)){
+			error = ERR_MBUF_USERBUF;
+			break;
+		}
+		chg->frameCnt    = llHdl->rxChgFrameCnt;
+		chg->changeCnt   = llHdl->rxChangeCnt;
+		chg->slotMask[0] = llHdl->rxChgSlotMask[0];
+		chg->slotMask[1] = llHdl->rxChgSlotMask[1];
+		/* 16 slots per subframe */
+		chg->subMask = 0;
+		for(i = 0; i < 4; i++){
+			if((chg->slotMask[i / 2] >> ((i % 2) * 16)) & 0xFFFF)
+				chg->subMask |= 1 << i;
+		}
+		blk->size = sizeof(Z147_CHANGES);
+		break;
+	}
+
+		/*---------------------------+
+		|  Trigger event count       |
+		+---------------------------*/
+	case Z147_RX_TRIG_CNT:
+		*valueP = (INT32_OR_64)llHdl->trigCnt;
+		break;
+
+		/*---------------------------+
+		|  Software sync slips       |
+		+---------------------------*/
+	case Z147_RX_SLIP_CNT:
+		*valueP = (INT32_OR_64)llHdl->swSlipCnt;
+		break;
+
+		/*---------------------------+
+		|  Deferred processing       |
+		+---------------------------*/
+	case Z147_RX_DEFERRED:
+		*valueP = llHdl->rxAlarm != NULL;
+		break;
+
+		/*---------------------------+
+		|  Capture                   |
+		+---------------------------*/
+	case Z147_RX_CAPT_SIZE:
+		*valueP = llHdl->captReady ? (INT32_OR_64)(sizeof(Z147_CAPT_HDR) +
+				  llHdl->captSnap.frames * llHdl->drvRingSize * 2) : 0;
+		break;
+	case Z147_BLK_RX_CAPTURE:
+		error = GetCapture(llHdl, (M_SG_BLOCK*)value32_or_64P);
+		break;
+
+		/*---------------------------+
+		|  Rate detection            |
+		+---------------------------*/
+	case Z147_RX_RATE_DETECT:
+		*valueP = (INT32_OR_64)llHdl->detMode;
+		break;
+	case Z147_RX_DETECT_MS:
+		*valueP = llHdl->detRun ? 0 : (INT32_OR_64)llHdl->detTimeMs;
+		break;
+
+		/*---------------------------+
+		|  Queued trigger events     |
+		+---------------------------*/
+	case Z147_BLK_RX_TRIG:
+	{
+		M_SG_BLOCK *blk = (M_SG_BLOCK*)value32_or_64P;
+		Z147_TRIG_EVENT *ev = (Z147_TRIG_EVENT*)blk->data;
+		TRIG_EVENT *t;
+		int32 n = 0;
+
+		while(llHdl->trigTail != llHdl->trigHead &&
+			  (n + 1) * (int32)sizeof(Z147_TRIG_EVENT) <= blk->size){
+			t = &llHdl->trig[llHdl->trigTail % Z147_TRIG_QUEUE];
+			ev[n].frameCnt = t->frameCnt;
+			ev[n].watch    = t->watch;
+			ev[n].pos      = t->pos;
+			ev[n].value    = t->value;
+			ev[n].prev     = t->prev;
+			llHdl->trigTail++;
+			n++;
+		}
+		blk->size = n * sizeof(Z147_TRIG_EVENT);
+		break;
+	}
+
 		/*--------------------------+
 		|  (unknown)                |
 		+--------------------------*/
@@ -792,6 +1183,9 @@ static int32 Z147_GetStat(
  *  \param size        \IN  data buffer size
  *  \param nbrRdBytesP \OUT number of read bytes
  *
+ *  With #Z147_RX_PACKED the frame is returned packed
+ *  (Z147_PACKED_SIZE() bytes).
+ *
  *  \return            \c 0 on success or error code
  */
 static int32 Z147_BlockRead(
@@ -803,21 +1197,40 @@ static int32 Z147_BlockRead(
 )
 {
 	int32 result = 0;
-	u_int32 dataLenByte = llHdl->usrBuffSize * 2;
+	u_int32 gen, words, dataLenByte, minLenByte;
 
 	DBGWRT_1((DBH, ">>> LL - Z147_BlockRead: ch=%d, size=%d\n",ch,size));
 
+	/* the rate detection may restart the receiver while the frame is read */
+	gen = llHdl->rxCfgGen;
+	words = llHdl->usrBuffSize;
+	dataLenByte = words * 2;
+	minLenByte = llHdl->subFrameSize * 8;
+
+	if(llHdl->rxPacked){
+		dataLenByte = Z147_PACKED_SIZE(words);
+		minLenByte = Z147_PACKED_SIZE(llHdl->subFrameSize * 4);
+	}
+
 	if((nbrRdBytesP != NULL) && (buf != NULL)){
 
 		/* Check whether the driver is in sync. */
-		if(llHdl->isDrvSync != 0 ){
+		if(llHdl->isDrvSync != 0 && (gen & 1) == 0){
 			/* Check user buffer length */
-			if((size >= (int32)dataLenByte) && (size >= (int32)(llHdl->subFrameSize * 8))){
+			if((size >= (int32)dataLenByte) && (size >= (int32)minLenByte)){
 
-				OSS_MemCopy(OSH, dataLenByte, (char*)llHdl->usrBuffer, (char*)buf);
+				if(llHdl->rxPacked)
+					Pack12(llHdl->usrBuffer, (u_int8*)buf, words);
+				else
+					OSS_MemCopy(OSH, dataLenByte, (char*)llHdl->usrBuffer, (char*)buf);
 
 				*nbrRdBytesP = dataLenByte;
 				IDBGWRT_1((DBH, ">>> LL - Z147_BlockRead: Data length byte = %d\n", dataLenByte));
+				/* restarted meanwhile, the frame is mixed */
+				if(llHdl->rxCfgGen != gen){
+					*nbrRdBytesP = 0;
+					result = ERR_LL_DEV_NOTRDY;
+				}
 
 			}else{
 				IDBGWRT_1((DBH, ">>> LL - Z147_BlockRead: User buffer is not sufficient user size = %d and needed driver size = %d.\n",size,  dataLenByte));
@@ -881,6 +1294,9 @@ static int32 Z147_BlockWrite(
  *  If the driver can detect the interrupt's cause it returns
  *  LL_IRQ_DEVICE or LL_IRQ_DEV_NOT, otherwise LL_IRQ_UNKNOWN.
  *
+ *  With #Z147_RX_DEFERRED the routine only masks the interrupts and saves
+ *  the status register, RxProcess() runs later from an OSS alarm.
+ *
  *  \param llHdl       \IN  low-level handle
  *  \return LL_IRQ_DEVICE   irq caused by device
  *          LL_IRQ_DEV_NOT  irq not caused by device
@@ -890,12 +1306,9 @@ static int32 Z147_Irq(LL_HANDLE *llHdl){
 	int32 result = LL_IRQ_DEV_NOT;
 	u_int32 statReg = 0;
 	u_int8 lsrStatus = 0;
-	u_int32 dataLen = 0;
-	u_int16 i = 0;
-	u_int8 subFrameNum = 0;
-	u_int16 subFramePtr = 0;
-	u_int16* tmpBuffPtr = NULL;
+	u_int32 realMsec;
 
+	llHdl->isrBusy = 1;
 	statReg = MREAD_D32(llHdl->ma, Z147_STAT_REG);
 	lsrStatus = (statReg >> (Z147_LSR_OFFSET * 8)) & 0xFF;
 
@@ -907,113 +1320,21 @@ static int32 Z147_Irq(LL_HANDLE *llHdl){
 		/* disable all IRQs */
 		MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
 
-		/* Call routine according to the interrupt. */
-		if((statReg & Z147_RX_LINE_STAT_IRQ) != 0){
-			/* An error is detected so discard all the received data. */
-
-			/* Read the RXC to get the received data length. */
-			dataLen = ((statReg >> (Z147_RX_RXC_OFFSET * 8)) &  0xFFFF);
-
-			IDBGWRT_1((DBH, ">>> LL - Z147_Irq with RX line error: dataLen %08x\n", dataLen));
-
-			/* Acknowledge the received data, which will lead to discard. */
-			MWRITE_D16(llHdl->ma, Z147_RX_RXA_OFFSET, dataLen);
-			if((lsrStatus & Z147_LSR_OE_MASK) == Z147_LSR_OE_MASK){
-				llHdl->rxOverrunErrCnt++;
-				DBGWRT_1((DBH, ">>> Z147_IRQ: Overrun error count = %llu\n",llHdl->rxOverrunErrCnt));
-			}
-			if((lsrStatus & Z147_LSR_SE_MASK) == Z147_LSR_SE_MASK){
-				llHdl->rxStreamIntErrCnt++;
-				DBGWRT_1((DBH, ">>> Z147_IRQ: Stream interruption error count = %llu\n",llHdl->rxStreamIntErrCnt));
-			}
-			if((lsrStatus & Z147_LSR_LSE_MASK) == Z147_LSR_LSE_MASK){
-				llHdl->rxLostSyncErrCnt++;
-				DBGWRT_1((DBH, ">>> Z147_IRQ: Lost synchronization error count = %llu\n",llHdl->rxLostSyncErrCnt));
-			}
-			/* Clear the errors */
-			MWRITE_D8(llHdl->ma, Z147_LSR_REG_OFFSET, Z147_LSR_RESET_VAL);
-
-			IDBGWRT_2((DBH, ">>> LL - Z147_Irq: Register Status after error interrupt:\n"));
-			RegStatus(llHdl);
-			/* if requested send signal to application */
-			if (llHdl->rxErrorSig){
-				OSS_SigSend(OSH, llHdl->rxErrorSig);
-			}
-			result = LL_IRQ_DEVICE ;
-		}else if (statReg & Z147_RX_DATA_AVAIL_IRQ){
-			llHdl->rxIrqCnt++;
-			DBGWRT_1((DBH, ">>> Z147_IRQ: Interrupt count = %llu\n",llHdl->rxIrqCnt));
-			IDBGWRT_3((DBH, ">>> LL - Z147_Irq: status register = %08x\n", statReg));
-			IDBGWRT_3((DBH, ">>> LL - Z147_Irq: SUB_PTR status = %d\n", MREAD_D16(llHdl->ma, Z147_RX_SUB_PTR_OFFSET)));
-			IDBGWRT_3((DBH, ">>> LL - Z147_Irq: LSR status = %08x\n", lsrStatus));
-			if(llHdl->isDrvSync == 0){
-				/* Calculate the frame position. */
-				subFrameNum = ((lsrStatus & Z147_LSR_RXSUB_MASK) >> Z147_LSR_RXSUB_OFFSET);
-				subFramePtr = MREAD_D16(llHdl->ma, Z147_RX_SUB_PTR_OFFSET);
-
-				/* Sub frame number is considered n-1. */
-				llHdl->drvRingSyncPos = ((subFrameNum  * llHdl->subFrameSize) + subFramePtr);
-				llHdl->drvRingHead = llHdl->drvRingSyncPos;
-
-				llHdl->isDrvSync = 1;
-
-				IDBGWRT_2((DBH, ">>> LL - Z147_Irq subFrameNum: %d\n", subFrameNum));
-				IDBGWRT_2((DBH, ">>> LL - Z147_Irq subFramePtr: %d\n", subFramePtr));
-				IDBGWRT_2((DBH, ">>> LL - Z147_Irq buffLocation: %d\n", llHdl->drvRingSyncPos));
-			}
-			/* Read the RXC to get the received data length. */
-			dataLen = ((statReg >> (Z147_RX_RXC_OFFSET * 8)) &  0xFFFF);
-			//IDBGWRT_1((DBH, ">>> LL - Z147_Irq: Data length = %d\n", dataLen));
-
-			/* Store data in the driver buffer. */
-			for(i=0; i<dataLen; i++){
-				/* Add word to the ring buffer */
-				llHdl->drvRingBuffer[llHdl->drvRingHead] = MREAD_D16(llHdl->ma, (Z147_RX_FIFO_START_ADDR + (i * 2)));
-				IDBGWRT_3((DBH, ">>> LL - Z147_Irq: Rx Data word-%d = 0x%x\n", llHdl->drvRingHead, llHdl->drvRingBuffer[llHdl->drvRingHead]));
-
-				/* Update the head pointer. */
-				llHdl->drvRingHead = (llHdl->drvRingHead + 1) % llHdl->drvRingSize;
-
-				/* If the sync position is reached then copy the data to the user buffer. */
-				if(llHdl->drvRingHead == llHdl->drvRingSyncPos){
-
-					/* Set the indication of the new data. */
-					llHdl->isUsrDataUpdated = USER_DATA_NOT_UPDATED;
-					tmpBuffPtr = llHdl->drvRingBuffer;
-					llHdl->drvRingBuffer = llHdl->usrBuffer;
-					llHdl->usrBuffer = tmpBuffPtr;
-					/* Set the indication of the new data. */
-					llHdl->isUsrDataUpdated = USER_DATA_UPDATED;
-
-					/* FIFO is empty now send signal to the application. */
-					/* if requested send signal to application */
-					if (llHdl->rxDataSig){
-						OSS_SigSend(OSH, llHdl->rxDataSig);
-					}
-				}
-
-				/* Check whether the buffer is full. */
-				if (llHdl->drvRingHead == llHdl->drvRingSize)	{
-					/* Start from the beginning. */
-					llHdl->drvRingHead = 0;
-				}
-			}
-			/* Acknowledge the data. */
-			MWRITE_D16(llHdl->ma, Z147_RX_RXA_OFFSET, dataLen);
-
-			result = LL_IRQ_DEVICE ;
-
-		}
-		if(llHdl->disableRx == 0){
-			/* Enable the default interrupts */
-			MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, Z147_RX_IER_DEFAULT);
+		if(llHdl->rxHold){
+			/* the FIFO is drained after RxRelease() */
+			result = LL_IRQ_DEVICE;
+		}else if(llHdl->rxAlarm){
+			/* the worker drains the FIFO, the IRQ stays masked until then */
+			llHdl->rxWorkStat = statReg;
+			llHdl->rxWorkPending = 1;
+			OSS_AlarmSet(OSH, llHdl->rxAlarm, RX_WORK_MSEC, 0, &realMsec);
+			result = LL_IRQ_DEVICE;
 		}else{
-			/* Set the flag to indicate the the IRQ is exited safely. */
-			llHdl->isRxIrqExit = 1;
+			result = RxProcess(llHdl, statReg);
 		}
-
 	}/* Else don't care about the interrupts and data */
 
+	llHdl->isrBusy = 0;
 	return result;
 }
 
@@ -1128,7 +1449,8 @@ static int32 Z147_Info(
 	{
 		u_int32 *lockModeP = va_arg(argptr, u_int32*);
 
-		*lockModeP = LL_LOCK_NONE;
+		/* the setstats changing the receiver exclude the readers */
+		*lockModeP = LL_LOCK_CALL;
 		break;
 	}
 	/*-------------------------------+
@@ -1175,6 +1497,24 @@ static int32 Cleanup(
 	if (llHdl->descHdl)
 		DESC_Exit(&llHdl->descHdl);
 
+	/* remove the alarm of the deferred processing */
+	if (llHdl->rxAlarm) {
+		OSS_AlarmClear(llHdl->osHdl, llHdl->rxAlarm);
+		OSS_AlarmRemove(llHdl->osHdl, &llHdl->rxAlarm);
+	}
+	if (llHdl->detAlarm) {
+		OSS_AlarmClear(llHdl->osHdl, llHdl->detAlarm);
+		OSS_AlarmRemove(llHdl->osHdl, &llHdl->detAlarm);
+	}
+
+	/* remove signals */
+	if (llHdl->rxDataSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->rxDataSig);
+	if (llHdl->rxErrorSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->rxErrorSig);
+	if (llHdl->trigSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->trigSig);
+
 	/* clean up debug */
 	DBGEXIT((&DBH));
 
@@ -1182,11 +1522,12 @@ static int32 Cleanup(
 	|  free memory                  |
 	+------------------------------*/
 	if(llHdl->usrBuffer != NULL){
-		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->usrBuffer, llHdl->usrBuffSize *2);
+		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->usrBuffer, llHdl->usrGot);
 	}
-	if(llHdl->usrBuffer != NULL){
-		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->drvRingBuffer, llHdl->drvRingSize * 2);
+	if(llHdl->drvRingBuffer != NULL){
+		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->drvRingBuffer, llHdl->ringGot);
 	}
+	FreeCapture(llHdl);
 
 	/* Doesn't need to clear the rest of the configuration */
 
@@ -1245,10 +1586,11 @@ int SetDataRate( LL_HANDLE *llHdl, u_int8 rxSpeed){
 
 	int result = 0;
 	int buffSize = 0;
-	int gotsize = 0;
 	int trigLevel = 0;
 	u_int8 regData = 0;
 
+	/* odd while the frame size changes, see Z147_BlockRead() */
+	llHdl->rxCfgGen++;
 	switch(rxSpeed){
 	case Z147_RX_DATA_RATE_64:
 		llHdl->subFrameSize = 64;
@@ -1297,52 +1639,39 @@ int SetDataRate( LL_HANDLE *llHdl, u_int8 rxSpeed){
 		buffSize = 512;
 		break;
 	}
-	/* Delete the allocated memory. */
-	if(llHdl->usrBuffer != NULL){
-		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->usrBuffer, llHdl->usrBuffSize *2);
-		llHdl->usrBuffer = NULL;
-	}
-	if(llHdl->drvRingBuffer != NULL){
-		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->drvRingBuffer, llHdl->drvRingSize * 2);
-		llHdl->drvRingBuffer = NULL;
-	}
-
-	/* Allocate memory to user buffer */
-	if ((llHdl->drvRingBuffer = (u_int16*)OSS_MemGet(
-			OSH, buffSize, &gotsize)) == NULL)
-	{
-		llHdl->drvRingBuffer = NULL;
-		result = ERR_OSS_MEM_ALLOC;
-	}else{
-
-		/* Allocate memory to driver ring buffer */
-		if ((llHdl->usrBuffer = (u_int16*)OSS_MemGet(
-				OSH, buffSize, &gotsize)) == NULL)
-		{
-			llHdl->usrBuffer = NULL;
-			result = ERR_OSS_MEM_ALLOC;
-		}else{
-			llHdl->usrBuffSize = buffSize/2;
-			llHdl->drvRingSize = buffSize/2;
-
-			regData = MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET);
-
-			regData = regData & (~Z147_RX_DATA_RATE_MASK);
-			regData |= ((rxSpeed << Z147_RX_DATA_RATE_OFFSET) & Z147_RX_DATA_RATE_MASK);
-			/* Set the Data Rate  */
-			MWRITE_D8(llHdl->ma, Z147_RX_LCR_OFFSET, regData);
+	/* Get the user buffer and the driver ring buffer. */
+	if((result = RxBuffers(llHdl, buffSize)) == 0){
+		llHdl->usrBuffSize = buffSize/2;
+		llHdl->drvRingSize = buffSize/2;
 
-			/* Configure RX FCR */
-			MWRITE_D8(llHdl->ma, Z147_RX_FCR_OFFSET, trigLevel);
+		regData = MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET);
 
-			llHdl->isDrvSync = 0;
-			llHdl->disableRx = 0;
-			llHdl->drvRingHead = 0;
-			llHdl->drvRingSyncPos = 0;
-			llHdl->isRxIrqExit = 0;
-			llHdl->isUsrDataUpdated = 0;
-		}
+		regData = regData & (~Z147_RX_DATA_RATE_MASK);
+		regData |= ((rxSpeed << Z147_RX_DATA_RATE_OFFSET) & Z147_RX_DATA_RATE_MASK);
+		/* Set the Data Rate  */
+		MWRITE_D8(llHdl->ma, Z147_RX_LCR_OFFSET, regData);
+
+		/* Configure RX FCR */
+		MWRITE_D8(llHdl->ma, Z147_RX_FCR_OFFSET, trigLevel);
+
+		llHdl->isDrvSync = 0;
+		llHdl->disableRx = 0;
+		llHdl->drvRingHead = 0;
+		llHdl->drvRingSyncPos = 0;
+		llHdl->isUsrDataUpdated = 0;
+		/* 16 change slots per sub frame */
+		llHdl->rxSlotShift = rxSpeed + 2;
+		llHdl->rxChangeAll = 1;
+		llHdl->rxSlotMask[0] = 0;
+		llHdl->rxSlotMask[1] = 0;
+		/* the watch positions belong to the old frame size */
+		llHdl->watchNum = 0;
+		llHdl->watchPos = NO_WATCH;
+		/* so do the captured frames */
+		FreeCapture(llHdl);
+		SwSyncReset(llHdl);
 	}
+	llHdl->rxCfgGen++;
 
 	return result;
 }
@@ -1367,3 +1696,1129 @@ void RegStatus(LL_HANDLE *llHdl){
 
 	DBGWRT_2((DBH, " \n"));
 }
+
+/**********************************************************************/
+/** Pack 12 bit words, 2 words in 3 bytes (see Z147_RX_PACKED).
+ *
+ *  Bits 12..15 of the words are dropped.
+ *
+ *  \param src        \IN  words
+ *  \param dst        \OUT packed words, Z147_PACKED_SIZE(words) bytes
+ *  \param words      \IN  number of words
+ */
+static void Pack12(const u_int16 *src, u_int8 *dst, u_int32 words){
+	u_int32 i;
+
+	for(i = 0; i + 1 < words; i += 2){
+		*dst++ = (u_int8)src[i];
+		*dst++ = (u_int8)(((src[i] >> 8) & 0x0F) | (src[i+1] << 4));
+		*dst++ = (u_int8)(src[i+1] >> 4);
+	}
+	if(i < words){
+		*dst++ = (u_int8)src[i];
+		*dst   = (u_int8)((src[i] >> 8) & 0x0F);
+	}
+}
+
+/**********************************************************************/
+/** Finish the change detection of a received frame (Z147_RX_CHANGE_ONLY).
+ *
+ *  A changed frame is counted and its slots are kept for
+ *  Z147_BLK_RX_CHANGES.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \return           1 if any word changed, else 0
+ */
+static int32 FrameChanged(LL_HANDLE *llHdl){
+
+	if(llHdl->rxChangeAll){
+		llHdl->rxSlotMask[0] = 0xFFFFFFFF;
+		llHdl->rxSlotMask[1] = 0xFFFFFFFF;
+		llHdl->rxChangeAll = 0;
+	}
+	if((llHdl->rxSlotMask[0] | llHdl->rxSlotMask[1]) == 0)
+		return 0;
+
+	llHdl->rxChgFrameCnt = llHdl->rxFrameCnt;
+	llHdl->rxChgSlotMask[0] = llHdl->rxSlotMask[0];
+	llHdl->rxChgSlotMask[1] = llHdl->rxSlotMask[1];
+	llHdl->rxSlotMask[0] = 0;
+	llHdl->rxSlotMask[1] = 0;
+	llHdl->rxChangeCnt++;
+	return 1;
+}
+
+/**********************************************************************/
+/** Take the hold of the receive processing.
+ *
+ *  Test and set under OSS_IrqMaskR(), so two routines never both own
+ *  the hold, and the ISR sees rxHold set when it runs afterwards.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param owner      \IN  HOLD_xx
+ *  \return           1 if taken, 0 if held by another routine
+ */
+static int32 HoldTake(LL_HANDLE *llHdl, u_int8 owner){
+
+	OSS_IRQ_STATE irqState;
+	int32 taken = 0;
+
+	irqState = OSS_IrqMaskR(OSH, llHdl->irqHdl);
+	if(llHdl->rxHold == 0){
+		llHdl->rxHold = owner;
+		taken = 1;
+	}
+	OSS_IrqRestore(OSH, llHdl->irqHdl, irqState);
+	return taken;
+}
+
+/**********************************************************************/
+/** Stop the receive processing while its state is changed.
+ *
+ *  A hold of RxWork() or DetectWork() is waited for, then the interrupt
+ *  is masked and a running ISR waited for, each up to EXIT_WAIT_US like
+ *  in Z147_Exit(). Until RxRelease(), the ISR and RxWork() leave the
+ *  FIFO alone and DetectWork() skips its poll. Readers are kept off by
+ *  the lock mode (LL_LOCK_CALL).
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \return           \c 0 on success or ERR_LL_DEV_BUSY
+ */
+static int32 RxHold(LL_HANDLE *llHdl){
+
+	u_int32 waitUs;
+
+	for(waitUs = 0; !HoldTake(llHdl, HOLD_CALL); waitUs += EXIT_POLL_US){
+		if(waitUs >= EXIT_WAIT_US)
+			return ERR_LL_DEV_BUSY;
+		OSS_MikroDelay(OSH, EXIT_POLL_US);
+	}
+	if(RxQuiesce(llHdl) != ERR_SUCCESS){
+		RxRelease(llHdl);
+		return ERR_LL_DEV_BUSY;
+	}
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Mask the interrupt and wait for a running ISR.
+ *
+ *  Called with the hold taken, so the ISR does not enable the interrupt
+ *  again and RxWork() does not process.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \return           \c 0 on success or ERR_LL_DEV_BUSY
+ */
+static int32 RxQuiesce(LL_HANDLE *llHdl){
+
+	u_int32 waitUs;
+
+	MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
+	for(waitUs = 0; llHdl->isrBusy && waitUs < EXIT_WAIT_US;
+			waitUs += EXIT_POLL_US){
+		OSS_MikroDelay(OSH, EXIT_POLL_US);
+	}
+	if(llHdl->isrBusy)
+		return ERR_LL_DEV_BUSY;
+	/* an ISR finished before the hold may have enabled it again */
+	MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, 0);
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Release the hold taken by HoldTake() or RxHold().
+ *
+ *  A deferred processing left pending meanwhile is started, else the
+ *  interrupt is enabled again.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void RxRelease(LL_HANDLE *llHdl){
+
+	OSS_IRQ_STATE irqState;
+	u_int32 realMsec;
+
+	irqState = OSS_IrqMaskR(OSH, llHdl->irqHdl);
+	llHdl->rxHold = 0;
+	OSS_IrqRestore(OSH, llHdl->irqHdl, irqState);
+
+	if(llHdl->rxWorkPending && llHdl->rxAlarm){
+		/* the interrupt is enabled again by RxWork() */
+		OSS_AlarmSet(OSH, llHdl->rxAlarm, RX_WORK_MSEC, 0, &realMsec);
+	}else if(llHdl->disableRx == 0){
+		MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, Z147_RX_IER_DEFAULT);
+	}
+}
+
+/**********************************************************************/
+/** Set the watch list (Z147_BLK_RX_WATCH).
+ *
+ *  The watches are sorted by position, so the ISR compares every word
+ *  with the position of the next watch only. The state of all watches
+ *  and the event queue are reset.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param blk        \IN  Z147_WATCH[], size 0 clears the list
+ *  \return           \c 0 on success or error code
+ */
+static int32 SetWatch(LL_HANDLE *llHdl, M_SG_BLOCK *blk){
+
+	Z147_WATCH *src = (Z147_WATCH*)blk->data;
+	WATCH w;
+	u_int32 num, i, k;
+	int32 error;
+
+	num = blk->size / sizeof(Z147_WATCH);
+	if(blk->size % sizeof(Z147_WATCH) || num > Z147_WATCH_MAX)
+		return ERR_LL_ILL_PARAM;
+	for(i = 0; i < num; i++){
+		if(src[i].type > Z147_WATCH_RATE || src[i].pos >= llHdl->drvRingSize)
+			return ERR_LL_ILL_PARAM;
+	}
+	/* the rate detection changes the frame size */
+	if(num && (llHdl->detMode != Z147_DETECT_OFF || llHdl->detRun))
+		return ERR_LL_DEV_BUSY;
+
+	/* the ISR walks the list */
+	if((error = RxHold(llHdl)) != ERR_SUCCESS)
+		return error;
+	llHdl->watchPos = NO_WATCH;
+	for(i = 0; i < num; i++){
+		w.pos   = src[i].pos;
+		w.type  = src[i].type;
+		w.mask  = src[i].mask;
+		w.lo    = src[i].lo;
+		w.hi    = src[i].hi;
+		w.idx   = (u_int16)i;
+		w.last  = 0;
+		w.valid = 0;
+		/* a range is left, an equal value is reached */
+		w.in    = (w.type == Z147_WATCH_RANGE) ? 1 : 0;
+		for(k = i; k > 0 && llHdl->watch[k-1].pos > w.pos; k--)
+			llHdl->watch[k] = llHdl->watch[k-1];
+		llHdl->watch[k] = w;
+	}
+	llHdl->watchNum = num;
+	llHdl->trigTail = llHdl->trigHead;
+	NextWatch(llHdl);
+	RxRelease(llHdl);
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Find the first watch at or after the ring head.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void NextWatch(LL_HANDLE *llHdl){
+
+	u_int32 i;
+
+	if(llHdl->watchNum == 0){
+		llHdl->watchPos = NO_WATCH;
+		return;
+	}
+	for(i = 0; i < llHdl->watchNum; i++){
+		if(llHdl->watch[i].pos >= llHdl->drvRingHead)
+			break;
+	}
+	llHdl->watchIdx = (i < llHdl->watchNum) ? i : 0;
+	llHdl->watchPos = llHdl->watch[llHdl->watchIdx].pos;
+}
+
+/**********************************************************************/
+/** Check the watches of a received word and queue their events.
+ *
+ *  Called by the ISR for the word at watchPos.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param word       \IN  received word
+ */
+static void Watch(LL_HANDLE *llHdl, u_int16 word){
+
+	WATCH *w;
+	TRIG_EVENT *t;
+	u_int16 v, diff;
+	u_int8 in, fire;
+
+	do{
+		w = &llHdl->watch[llHdl->watchIdx];
+		v = word & w->mask;
+		fire = 0;
+		switch(w->type){
+		case Z147_WATCH_EQUAL:
+			in = (v == w->lo);
+			fire = in && !w->in;
+			w->in = in;
+			break;
+		case Z147_WATCH_CHANGE:
+			fire = w->valid && v != w->last;
+			break;
+		case Z147_WATCH_RANGE:
+			in = (v >= w->lo && v <= w->hi);
+			fire = !in && w->in;
+			w->in = in;
+			break;
+		default:
+			diff = (v > w->last) ? v - w->last : w->last - v;
+			fire = w->valid && diff > w->lo;
+			break;
+		}
+
+		if(fire){
+			llHdl->trigCnt++;
+			/* the oldest events are kept, the count shows the lost ones */
+			if(llHdl->trigHead - llHdl->trigTail < Z147_TRIG_QUEUE){
+				t = &llHdl->trig[llHdl->trigHead % Z147_TRIG_QUEUE];
+				t->frameCnt = llHdl->rxFrameCnt;
+				t->watch    = w->idx;
+				t->pos      = w->pos;
+				t->value    = v;
+				t->prev     = w->last;
+				llHdl->trigHead++;
+			}
+			llHdl->trigPending = 1;
+			if(llHdl->captFrames){
+				CaptureTrigger(llHdl, Z147_CAPT_WATCH);
+			}
+		}
+		w->last  = v;
+		w->valid = 1;
+
+		if(++llHdl->watchIdx == llHdl->watchNum)
+			llHdl->watchIdx = 0;
+	}while(llHdl->watchIdx != 0 &&
+		   llHdl->watch[llHdl->watchIdx].pos == w->pos);
+
+	llHdl->watchPos = llHdl->watch[llHdl->watchIdx].pos;
+}
+
+/**********************************************************************/
+/** Configure the pre/post trigger capture (Z147_BLK_RX_CAPTURE).
+ *
+ *  Allocates two history regions of cfg->frames frames. The frames are
+ *  written to one region; pre + 1 + post frames around a trigger are
+ *  frozen in it while the capture continues in the other one. A frozen
+ *  capture not read yet is dropped.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param blk        \IN  Z147_CAPTURE, frames 0 disables the capture
+ *  \return           \c 0 on success or error code
+ */
+static int32 SetCapture(LL_HANDLE *llHdl, M_SG_BLOCK *blk){
+
+	Z147_CAPTURE *cfg = (Z147_CAPTURE*)blk->data;
+	u_int16 *region[2] = { NULL, NULL };
+	u_int32 gotsize[2] = { 0, 0 };
+	u_int32 size, i;
+	int32 error;
+
+	if(blk->size < (int32)sizeof(Z147_CAPTURE))
+		return ERR_LL_ILL_PARAM;
+	if(cfg->frames && (cfg->pre + 1 + cfg->post > cfg->frames ||
+					   cfg->pre >= cfg->frames))
+		return ERR_LL_ILL_PARAM;
+	if(cfg->frames && llHdl->drvRingBuffer == NULL)
+		return ERR_LL_DEV_NOTRDY;
+	/* the rate detection changes the frame size */
+	if(cfg->frames && (llHdl->detMode != Z147_DETECT_OFF || llHdl->detRun))
+		return ERR_LL_DEV_BUSY;
+
+	size = cfg->frames * llHdl->drvRingSize * 2;
+	for(i = 0; i < 2 && cfg->frames; i++){
+		if((region[i] = (u_int16*)OSS_MemGet(OSH, size, &gotsize[i])) == NULL){
+			if(i)
+				OSS_MemFree(OSH, (int8*)region[0], gotsize[0]);
+			return ERR_OSS_MEM_ALLOC;
+		}
+	}
+
+	/* the ISR may write the regions */
+	if((error = RxHold(llHdl)) != ERR_SUCCESS){
+		for(i = 0; i < 2 && cfg->frames; i++)
+			OSS_MemFree(OSH, (int8*)region[i], gotsize[i]);
+		return error;
+	}
+	FreeCapture(llHdl);
+	if(cfg->frames == 0){
+		RxRelease(llHdl);
+		return ERR_SUCCESS;
+	}
+
+	for(i = 0; i < 2; i++){
+		llHdl->capt[i]     = region[i];
+		llHdl->captSize[i] = gotsize[i];
+	}
+	llHdl->captPre    = cfg->pre;
+	llHdl->captPost   = cfg->post;
+	llHdl->captMask   = cfg->trigMask;
+	llHdl->captAct    = 0;
+	llHdl->captWr     = 0;
+	llHdl->captLeft   = 0;
+	llHdl->captCnt    = 0;
+	llHdl->captLost   = 0;
+	llHdl->captReady  = 0;
+	llHdl->captFrames = cfg->frames;
+	RxRelease(llHdl);
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Read and release the frozen capture (Z147_BLK_RX_CAPTURE).
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param blk        \IN  buffer of Z147_RX_CAPT_SIZE bytes
+ *                    \OUT Z147_CAPT_HDR followed by the frames,
+ *                         size 0 if no capture is frozen
+ *  \return           \c 0 on success or error code
+ */
+static int32 GetCapture(LL_HANDLE *llHdl, M_SG_BLOCK *blk){
+
+	Z147_CAPT_HDR *hdr = (Z147_CAPT_HDR*)blk->data;
+	CAPT_SNAP *snap = &llHdl->captSnap;
+	u_int16 *region, *dst;
+	u_int32 frameBytes = llHdl->drvRingSize * 2;
+	u_int32 i;
+
+	if(!llHdl->captReady){
+		blk->size = 0;
+		return ERR_SUCCESS;
+	}
+	if(blk->size < (int32)(sizeof(Z147_CAPT_HDR) + snap->frames * frameBytes))
+		return ERR_MBUF_USERBUF;
+
+	hdr->capture    = snap->capture;
+	hdr->source     = snap->source;
+	hdr->trigFrame  = snap->trigFrame;
+	/* the last frame is the last post trigger frame */
+	hdr->firstFrame = snap->trigFrame + llHdl->captPost + 1 - snap->frames;
+	hdr->frames     = snap->frames;
+	hdr->frameWords = llHdl->drvRingSize;
+	hdr->lost       = snap->lost;
+	hdr->resv       = 0;
+
+	/* the frozen region is not written until it is released */
+	region = llHdl->capt[llHdl->captAct ^ 1];
+	dst = (u_int16*)(hdr + 1);
+	for(i = 0; i < snap->frames; i++){
+		OSS_MemCopy(OSH, frameBytes,
+					(char*)(region + ((snap->first + i) % llHdl->captFrames) *
+							llHdl->drvRingSize),
+					(char*)(dst + i * llHdl->drvRingSize));
+	}
+	blk->size = sizeof(Z147_CAPT_HDR) + snap->frames * frameBytes;
+	llHdl->captReady = 0;
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Stop the capture and free its regions.
+ *
+ *  The caller stops the receive processing first (RxHold()).
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void FreeCapture(LL_HANDLE *llHdl){
+
+	u_int32 i;
+
+	llHdl->captFrames = 0;
+	llHdl->captReady  = 0;
+	for(i = 0; i < 2; i++){
+		if(llHdl->capt[i] != NULL){
+			OSS_MemFree(OSH, (int8*)llHdl->capt[i], llHdl->captSize[i]);
+			llHdl->capt[i] = NULL;
+		}
+	}
+}
+
+/**********************************************************************/
+/** Add the frame just received to the history.
+ *
+ *  Called by the ISR with the frame in the user buffer. Freezes the
+ *  region when the post trigger frames are complete.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void CaptureFrame(LL_HANDLE *llHdl){
+
+	CAPT_SNAP *snap = &llHdl->captSnap;
+	u_int32 num;
+
+	OSS_MemCopy(OSH, llHdl->drvRingSize * 2, (char*)llHdl->usrBuffer,
+				(char*)(llHdl->capt[llHdl->captAct] +
+						(llHdl->captWr % llHdl->captFrames) *
+						llHdl->drvRingSize));
+	llHdl->captWr++;
+
+	if(llHdl->captLeft == 0 || --llHdl->captLeft != 0)
+		return;
+
+	/* post window complete, the previous capture may still be read */
+	if(llHdl->captReady){
+		llHdl->captLost++;
+		return;
+	}
+	num = llHdl->captPre + 1 + llHdl->captPost;
+	if(num > llHdl->captWr)
+		num = llHdl->captWr;
+	snap->capture   = ++llHdl->captCnt;
+	snap->source    = llHdl->captSource;
+	snap->trigFrame = llHdl->captTrigFrame;
+	snap->first     = (llHdl->captWr - num) % llHdl->captFrames;
+	snap->frames    = num;
+	snap->lost      = llHdl->captLost;
+	llHdl->captLost = 0;
+	llHdl->captReady = 1;
+
+	/* continue in the other region */
+	llHdl->captAct ^= 1;
+	llHdl->captWr = 0;
+	llHdl->trigPending = 1;
+}
+
+/**********************************************************************/
+/** Trigger a capture.
+ *
+ *  The trigger frame is the frame received at the moment, triggers
+ *  during the post window of a capture belong to it.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param source     \IN  Z147_CAPT_xx
+ */
+static void CaptureTrigger(LL_HANDLE *llHdl, u_int32 source){
+
+	if(!(llHdl->captMask & source) || llHdl->captLeft)
+		return;
+	llHdl->captSource    = source;
+	llHdl->captTrigFrame = llHdl->rxFrameCnt + 1;
+	llHdl->captLeft      = llHdl->captPost + 1;
+}
+
+/**********************************************************************/
+/** Process a receive interrupt.
+ *
+ *  Handles the line errors or drains and acknowledges the FIFO, then
+ *  enables the interrupts again. Called by the ISR or, deferred, by
+ *  RxWork() with the status register read by the ISR.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param statReg    \IN  status register at the interrupt
+ *  \return           LL_IRQ_DEVICE
+ */
+static int32 RxProcess(LL_HANDLE *llHdl, u_int32 statReg){
+
+	int32 result = LL_IRQ_DEV_NOT;
+	u_int8 lsrStatus = (statReg >> (Z147_LSR_OFFSET * 8)) & 0xFF;
+	u_int32 dataLen = 0;
+	u_int16 i = 0;
+	u_int8 subFrameNum = 0;
+	u_int16 subFramePtr = 0;
+	u_int16* tmpBuffPtr = NULL;
+	u_int16 word = 0;
+	u_int32 slot = 0;
+
+	/* Call routine according to the interrupt. */
+	if((statReg & Z147_RX_LINE_STAT_IRQ) != 0){
+		/* An error is detected so discard all the received data. */
+
+		/* Read the RXC to get the received data length. */
+		dataLen = ((statReg >> (Z147_RX_RXC_OFFSET * 8)) &  0xFFFF);
+
+		IDBGWRT_1((DBH, ">>> LL - Z147_Irq with RX line error: dataLen %08x\n", dataLen));
+
+		/* Acknowledge the received data, which will lead to discard. */
+		MWRITE_D16(llHdl->ma, Z147_RX_RXA_OFFSET, dataLen);
+		if((lsrStatus & Z147_LSR_OE_MASK) == Z147_LSR_OE_MASK){
+			llHdl->rxOverrunErrCnt++;
+			DBGWRT_1((DBH, ">>> Z147_IRQ: Overrun error count = %llu\n",llHdl->rxOverrunErrCnt));
+		}
+		if((lsrStatus & Z147_LSR_SE_MASK) == Z147_LSR_SE_MASK){
+			llHdl->rxStreamIntErrCnt++;
+			DBGWRT_1((DBH, ">>> Z147_IRQ: Stream interruption error count = %llu\n",llHdl->rxStreamIntErrCnt));
+		}
+		if((lsrStatus & Z147_LSR_LSE_MASK) == Z147_LSR_LSE_MASK){
+			llHdl->rxLostSyncErrCnt++;
+			DBGWRT_1((DBH, ">>> Z147_IRQ: Lost synchronization error count = %llu\n",llHdl->rxLostSyncErrCnt));
+		}
+		if(llHdl->captFrames){
+			CaptureTrigger(llHdl, (lsrStatus & Z147_LSR_LSE_MASK) ?
+						   Z147_CAPT_SYNC : Z147_CAPT_ERR);
+		}
+		/* Clear the errors */
+		MWRITE_D8(llHdl->ma, Z147_LSR_REG_OFFSET, Z147_LSR_RESET_VAL);
+
+		IDBGWRT_2((DBH, ">>> LL - Z147_Irq: Register Status after error interrupt:\n"));
+		RegStatus(llHdl);
+		/* if requested send signal to application */
+		if (llHdl->rxErrorSig){
+			OSS_SigSend(OSH, llHdl->rxErrorSig);
+		}
+		result = LL_IRQ_DEVICE ;
+	}else if (statReg & Z147_RX_DATA_AVAIL_IRQ){
+		llHdl->rxIrqCnt++;
+		DBGWRT_1((DBH, ">>> Z147_IRQ: Interrupt count = %llu\n",llHdl->rxIrqCnt));
+		IDBGWRT_3((DBH, ">>> LL - Z147_Irq: status register = %08x\n", statReg));
+		IDBGWRT_3((DBH, ">>> LL - Z147_Irq: SUB_PTR status = %d\n", MREAD_D16(llHdl->ma, Z147_RX_SUB_PTR_OFFSET)));
+		IDBGWRT_3((DBH, ">>> LL - Z147_Irq: LSR status = %08x\n", lsrStatus));
+		if(llHdl->isDrvSync == 0 && llHdl->swSync == 0){
+			/* Calculate the frame position. */
+			subFrameNum = ((lsrStatus & Z147_LSR_RXSUB_MASK) >> Z147_LSR_RXSUB_OFFSET);
+			subFramePtr = MREAD_D16(llHdl->ma, Z147_RX_SUB_PTR_OFFSET);
+
+			/* Sub frame number is considered n-1. */
+			RxAlign(llHdl, (subFrameNum  * llHdl->subFrameSize) + subFramePtr);
+
+			IDBGWRT_2((DBH, ">>> LL - Z147_Irq subFrameNum: %d\n", subFrameNum));
+			IDBGWRT_2((DBH, ">>> LL - Z147_Irq subFramePtr: %d\n", subFramePtr));
+			IDBGWRT_2((DBH, ">>> LL - Z147_Irq buffLocation: %d\n", llHdl->drvRingSyncPos));
+		}
+		/* Read the RXC to get the received data length. */
+		dataLen = ((statReg >> (Z147_RX_RXC_OFFSET * 8)) &  0xFFFF);
+		//IDBGWRT_1((DBH, ">>> LL - Z147_Irq: Data length = %d\n", dataLen));
+
+		/* Store data in the driver buffer. */
+		for(i=0; i<dataLen; i++){
+			/* Add word to the ring buffer */
+			word = MREAD_D16(llHdl->ma, (Z147_RX_FIFO_START_ADDR + (i * 2)));
+			/* raw mode: words without a frame position are dropped */
+			if(llHdl->swSync && SwSync(llHdl, word) == 0){
+				continue;
+			}
+			llHdl->drvRingBuffer[llHdl->drvRingHead] = word;
+
+			/* The user buffer holds the previous frame at the same position. */
+			if(llHdl->rxChangeOnly && word != llHdl->usrBuffer[llHdl->drvRingHead]){
+				slot = llHdl->drvRingHead >> llHdl->rxSlotShift;
+				llHdl->rxSlotMask[slot >> 5] |= 1 << (slot & 31);
+			}
+			if(llHdl->drvRingHead == llHdl->watchPos){
+				Watch(llHdl, word);
+			}
+			IDBGWRT_3((DBH, ">>> LL - Z147_Irq: Rx Data word-%d = 0x%x\n", llHdl->drvRingHead, llHdl->drvRingBuffer[llHdl->drvRingHead]));
+
+			/* Update the head pointer. */
+			llHdl->drvRingHead = (llHdl->drvRingHead + 1) % llHdl->drvRingSize;
+
+			/* If the sync position is reached then copy the data to the user buffer. */
+			if(llHdl->drvRingHead == llHdl->drvRingSyncPos){
+
+				/* Set the indication of the new data. */
+				llHdl->isUsrDataUpdated = USER_DATA_NOT_UPDATED;
+				tmpBuffPtr = llHdl->drvRingBuffer;
+				llHdl->drvRingBuffer = llHdl->usrBuffer;
+				llHdl->usrBuffer = tmpBuffPtr;
+				/* Set the indication of the new data. */
+				llHdl->isUsrDataUpdated = USER_DATA_UPDATED;
+				llHdl->rxFrameCnt++;
+				if(llHdl->captFrames){
+					CaptureFrame(llHdl);
+				}
+
+				/* FIFO is empty now send signal to the application. */
+				/* if requested send signal to application, with
+				   Z147_RX_CHANGE_ONLY only if any word changed */
+				if ((llHdl->rxChangeOnly == 0 || FrameChanged(llHdl)) &&
+					llHdl->rxDataSig){
+					OSS_SigSend(OSH, llHdl->rxDataSig);
+				}
+			}
+
+			/* Check whether the buffer is full. */
+			if (llHdl->drvRingHead == llHdl->drvRingSize)	{
+				/* Start from the beginning. */
+				llHdl->drvRingHead = 0;
+			}
+		}
+		/* Acknowledge the data. */
+		MWRITE_D16(llHdl->ma, Z147_RX_RXA_OFFSET, dataLen);
+
+		/* one trigger signal for all events of the IRQ */
+		if(llHdl->trigPending){
+			llHdl->trigPending = 0;
+			if(llHdl->trigSig){
+				OSS_SigSend(OSH, llHdl->trigSig);
+			}
+		}
+
+		result = LL_IRQ_DEVICE ;
+
+	}
+	if(llHdl->disableRx == 0 && llHdl->rxHold == 0){
+		/* Enable the default interrupts */
+		MWRITE_D8(llHdl->ma, Z147_RX_IER_OFFSET, Z147_RX_IER_DEFAULT);
+	}
+
+	return result;
+}
+
+/**********************************************************************/
+/** Deferred receive processing (OSS alarm of #Z147_RX_DEFERRED).
+ *
+ *  \param arg        \IN  low-level handle
+ */
+static void RxWork(void *arg){
+
+	LL_HANDLE *llHdl = (LL_HANDLE*)arg;
+
+	llHdl->workBusy = 1;
+	/* held by another routine, its RxRelease() sets the alarm again */
+	if(llHdl->rxWorkPending && HoldTake(llHdl, HOLD_WORK)){
+		llHdl->rxWorkPending = 0;
+		RxProcess(llHdl, llHdl->rxWorkStat);
+		RxRelease(llHdl);
+	}
+	llHdl->workBusy = 0;
+}
+
+/**********************************************************************/
+/** Switch the deferred receive processing on or off.
+ *
+ *  Switched off, the interrupt is masked and a running ISR or RxWork()
+ *  waited for before the alarm is removed. A pending deferred processing
+ *  is done at once, so the interrupts are not left masked.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param on         \IN  0 = in the ISR, else deferred
+ *  \return           \c 0 on success or error code
+ */
+static int32 SetDeferred(LL_HANDLE *llHdl, int32 on){
+
+	int32 error = ERR_SUCCESS;
+
+	if(on && llHdl->rxAlarm == NULL){
+		error = OSS_AlarmCreate(OSH, RxWork, llHdl, &llHdl->rxAlarm);
+	}else if(!on && llHdl->rxAlarm != NULL){
+		if((error = RxHold(llHdl)) != ERR_SUCCESS)
+			return error;
+		OSS_AlarmClear(OSH, llHdl->rxAlarm);
+		OSS_AlarmRemove(OSH, &llHdl->rxAlarm);
+		llHdl->rxAlarm = NULL;
+		if(llHdl->rxWorkPending){
+			llHdl->rxWorkPending = 0;
+			RxProcess(llHdl, llHdl->rxWorkStat);
+		}
+		RxRelease(llHdl);
+	}
+	return error;
+}
+
+/**********************************************************************/
+/** Start the frame at a frame position.
+ *
+ *  The next word received is stored at pos, a frame is complete when
+ *  the head reaches pos again.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param pos        \IN  frame position of the next word
+ */
+static void RxAlign(LL_HANDLE *llHdl, u_int32 pos){
+
+	llHdl->drvRingSyncPos = pos;
+	llHdl->drvRingHead = pos;
+	llHdl->isDrvSync = 1;
+	llHdl->rxChangeAll = 1;
+	NextWatch(llHdl);
+}
+
+/**********************************************************************/
+/** Restart the sync word search of the software synchronizer.
+ *
+ *  \param llHdl      \IN  low-level handle
+ */
+static void SwSyncReset(LL_HANDLE *llHdl){
+
+	u_int32 i;
+
+	llHdl->swConf = 0;
+	for(i=0; i<SW_SYNC_CAND; i++){
+		llHdl->swCand[i].cnt = 0;
+	}
+}
+
+/**********************************************************************/
+/** Software frame synchronizer of the raw mode (Z147_RX_SYNC_CFG 0).
+ *
+ *  Without synchronization the core passes the words from the first edge
+ *  on, so LSR/SUB_PTR do not tell the frame position. It is found from the
+ *  drained words instead:
+ *  - A sync word starts a candidate expecting the next sync word
+ *    subFrameSize words later. After SW_SYNC_LOCK sync words in order the
+ *    frame is aligned to the candidate.
+ *  - Aligned, the sync slot of every subframe is checked. A match raises
+ *    the confidence up to SW_SYNC_CONF, a miss lowers it, at 0 the
+ *    alignment is lost and the words are dropped until the next lock.
+ *  - Below SW_SYNC_CONF the search goes on, a lock at another position
+ *    (a word slipped) realigns the frame without a core reset.
+ *
+ *  Only words ending in 0x47 or 0xB8 are compared with the sync words,
+ *  a data word costs a few instructions.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param word       \IN  word drained from the FIFO
+ *  \return           1 = store the word at drvRingHead, 0 = drop it
+ */
+static int32 SwSync(LL_HANDLE *llHdl, u_int16 word){
+
+	static const u_int16 syncWord[4] = {
+		Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+		Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+	};
+	u_int32 sfs = llHdl->subFrameSize;
+	u_int32 n = ++llHdl->swWordCnt;
+	SW_CAND *cand = NULL;
+	int32 sub = -1;
+	int32 found = 0;
+	u_int32 i;
+
+	word &= 0x0FFF;
+	if((word & 0xFF) == 0x47 || (word & 0xFF) == 0xB8){
+		for(i=0; i<4; i++){
+			if(word == syncWord[i]){
+				sub = i;
+			}
+		}
+	}
+
+	/* aligned: check the sync slot of the subframe */
+	if(llHdl->swConf && (llHdl->drvRingHead & (sfs - 1)) == 0){
+		if(sub == (int32)(llHdl->drvRingHead / sfs)){
+			if(llHdl->swConf < SW_SYNC_CONF){
+				llHdl->swConf++;
+			}
+		}else if(--llHdl->swConf == 0){
+			llHdl->isDrvSync = 0;
+			llHdl->rxLostSyncErrCnt++;
+			IDBGWRT_1((DBH, ">>> LL - Z147_Irq: software sync lost\n"));
+			if(llHdl->captFrames){
+				CaptureTrigger(llHdl, Z147_CAPT_SYNC);
+			}
+			if (llHdl->rxErrorSig){
+				OSS_SigSend(OSH, llHdl->rxErrorSig);
+			}
+		}
+	}
+	if(llHdl->swConf == SW_SYNC_CONF){
+		return 1;
+	}
+
+	/* search: check the candidates expecting their sync word now */
+	for(i=0; i<SW_SYNC_CAND; i++){
+		cand = &llHdl->swCand[i];
+		if(cand->cnt == 0 || cand->next != n){
+			continue;
+		}
+		if(sub != (int32)cand->sub){
+			cand->cnt = 0;
+			continue;
+		}
+		found = 1;
+		if(++cand->cnt < SW_SYNC_LOCK){
+			cand->next += sfs;
+			cand->sub = (cand->sub + 1) & 0x3;
+			continue;
+		}
+
+		/* locked, realign if the position moved */
+		if(llHdl->swConf == 0 || llHdl->drvRingHead != sub * sfs){
+			if(llHdl->swConf){
+				llHdl->swSlipCnt++;
+				IDBGWRT_1((DBH, ">>> LL - Z147_Irq: software sync slip %d -> %d\n",
+						   llHdl->drvRingHead, sub * sfs));
+			}
+			RxAlign(llHdl, sub * sfs);
+		}
+		SwSyncReset(llHdl);
+		llHdl->swConf = SW_SYNC_CONF;
+		return 1;
+	}
+
+	/* a sync word of no candidate starts a new one */
+	if(sub >= 0 && !found){
+		cand = &llHdl->swCand[llHdl->swCandNext];
+		llHdl->swCandNext = (llHdl->swCandNext + 1) % SW_SYNC_CAND;
+		cand->next = n + sfs;
+		cand->sub = (u_int16)((sub + 1) & 0x3);
+		cand->cnt = 1;
+	}
+	return llHdl->swConf != 0;
+}
+
+/**********************************************************************/
+/** Provide the frame buffers.
+ *
+ *  Buffers of at least size bytes are kept, so the rate detection, which
+ *  gets them for the highest rate beforehand, switches the rate in its
+ *  alarm routine without allocating. New buffers replace the old ones
+ *  only when both could be allocated.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param size       \IN  bytes per buffer
+ *  \return           \c 0 on success or error code
+ */
+static int32 RxBuffers(LL_HANDLE *llHdl, u_int32 size){
+
+	u_int16 *ring = NULL;
+	u_int16 *usr = NULL;
+	u_int32 ringGot = 0;
+	u_int32 usrGot = 0;
+
+	if(llHdl->usrBuffer != NULL && llHdl->drvRingBuffer != NULL &&
+	   llHdl->buffAlloc >= size){
+		return ERR_SUCCESS;
+	}
+	if((ring = (u_int16*)OSS_MemGet(OSH, size, &ringGot)) == NULL){
+		return ERR_OSS_MEM_ALLOC;
+	}
+	if((usr = (u_int16*)OSS_MemGet(OSH, size, &usrGot)) == NULL){
+		OSS_MemFree(OSH, (int8*)ring, ringGot);
+		return ERR_OSS_MEM_ALLOC;
+	}
+	/* the frames received so far go on in the new buffers */
+	if(llHdl->usrBuffer != NULL){
+		OSS_MemCopy(OSH, llHdl->buffAlloc, (char*)llHdl->usrBuffer, (char*)usr);
+		OSS_MemFree(OSH, (int8*)llHdl->usrBuffer, llHdl->usrGot);
+	}
+	if(llHdl->drvRingBuffer != NULL){
+		OSS_MemCopy(OSH, llHdl->buffAlloc, (char*)llHdl->drvRingBuffer, (char*)ring);
+		OSS_MemFree(OSH, (int8*)llHdl->drvRingBuffer, llHdl->ringGot);
+	}
+	llHdl->drvRingBuffer = ring;
+	llHdl->usrBuffer = usr;
+	llHdl->ringGot = ringGot;
+	llHdl->usrGot = usrGot;
+	llHdl->buffAlloc = size;
+	return ERR_SUCCESS;
+}
+
+/**********************************************************************/
+/** Restart the receiver with a data rate and sync mode.
+ *
+ *  Same sequence as the Z147_RX_SYNC_CFG and Z147_RX_DATA_RATE setstats,
+ *  the FIFO content and a pending deferred processing are discarded.
+ *  Called with the receive processing held, RxRelease() enables the
+ *  interrupt again.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \param syncCfg    \IN  Z147_RX_SYNC_CFG value
+ */
+static void RxRestart(LL_HANDLE *llHdl, u_int8 rate, u_int8 syncCfg){
+
+	u_int8 regData = 0;
+
+	MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 1);
+	llHdl->disableRx = 1;
+	llHdl->rxWorkPending = 0;
+
+	regData = MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET);
+	regData = regData & (~Z147_RX_SYNC_MASK);
+	regData |= (syncCfg & Z147_RX_SYNC_MASK);
+	MWRITE_D8(llHdl->ma, Z147_RX_LCR_OFFSET, regData);
+	llHdl->swSync = (syncCfg == 0);
+	SetDataRate(llHdl, rate);
+	MWRITE_D8(llHdl->ma, Z147_RX_RST_OFFSET, 0);
+}
+
+/**********************************************************************/
+/** Set the automatic data rate detection (Z147_RX_RATE_DETECT).
+ *
+ *  Switched on, the buffers for the highest rate are allocated and the
+ *  probes start, unless the follow mode is set while the receiver is in
+ *  sync. Switched off during the probes, the probed rate stays with the
+ *  sync mode of the user. The probes change the frame size, so the
+ *  detection is refused while watches or a capture are set.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param mode       \IN  Z147_DETECT_xx
+ *  \return           \c 0 on success or error code
+ */
+static int32 SetDetect(LL_HANDLE *llHdl, int32 mode){
+
+	int32 error = ERR_SUCCESS;
+	u_int32 realMsec = 0;
+
+	if(mode < Z147_DETECT_OFF || mode > Z147_DETECT_FOLLOW){
+		return ERR_LL_ILL_PARAM;
+	}
+
+	if(mode != Z147_DETECT_OFF && (llHdl->watchNum || llHdl->captFrames)){
+		return ERR_LL_DEV_BUSY;
+	}
+	if(mode == Z147_DETECT_OFF && llHdl->detAlarm == NULL){
+		llHdl->detMode = Z147_DETECT_OFF;
+		return ERR_SUCCESS;
+	}
+	/* DetectWork() may be changing the receiver */
+	if((error = RxHold(llHdl)) != ERR_SUCCESS){
+		return error;
+	}
+
+	if(mode == Z147_DETECT_OFF){
+		OSS_AlarmClear(OSH, llHdl->detAlarm);
+		OSS_AlarmRemove(OSH, &llHdl->detAlarm);
+		llHdl->detAlarm = NULL;
+		if(llHdl->detRun){
+			llHdl->detRun = 0;
+			RxRestart(llHdl, llHdl->detOrder[llHdl->detIdx],
+					  llHdl->detSyncCfg);
+		}
+		llHdl->detMode = Z147_DETECT_OFF;
+		RxRelease(llHdl);
+		return ERR_SUCCESS;
+	}
+
+	/* no allocation in the alarm routine */
+	error = RxBuffers(llHdl, MAX_BUFF_SIZE);
+	if(error == ERR_SUCCESS && llHdl->detAlarm == NULL){
+		error = OSS_AlarmCreate(OSH, DetectWork, llHdl, &llHdl->detAlarm);
+	}
+	if(error != ERR_SUCCESS){
+		RxRelease(llHdl);
+		return error;
+	}
+
+	llHdl->detMode = (u_int8)mode;
+	if(llHdl->detRun == 0){
+		llHdl->detSyncCfg = MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET) &
+			Z147_RX_SYNC_MASK;
+		llHdl->detLostMs = 0;
+		if(mode == Z147_DETECT_ONCE || DetectInSync(llHdl) == 0){
+			RxRestart(llHdl, DetectStart(llHdl), DETECT_SYNC_CFG);
+		}
+	}
+	OSS_AlarmSet(OSH, llHdl->detAlarm, DETECT_POLL_MS, 1, &realMsec);
+	llHdl->detPeriodMs = realMsec ? realMsec : DETECT_POLL_MS;
+	RxRelease(llHdl);
+	return error;
+}
+
+/**********************************************************************/
+/** Start the probes of the rate detection.
+ *
+ *  The current rate is probed first, then the rates of the usual
+ *  recorders (512, 256, 1024, 64, 128 words/s), then the high ones.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \return           rate of the first probe, the caller restarts with it
+ */
+static u_int8 DetectStart(LL_HANDLE *llHdl){
+
+	static const u_int8 order[DETECT_RATES] = {
+		Z147_RX_DATA_RATE_512, Z147_RX_DATA_RATE_256,
+		Z147_RX_DATA_RATE_1024, Z147_RX_DATA_RATE_64,
+		Z147_RX_DATA_RATE_128, Z147_RX_DATA_RATE_2048,
+		Z147_RX_DATA_RATE_4096, Z147_RX_DATA_RATE_8192
+	};
+	u_int8 rate = (MREAD_D8(llHdl->ma, Z147_RX_LCR_OFFSET) &
+				   Z147_RX_DATA_RATE_MASK) >> Z147_RX_DATA_RATE_OFFSET;
+	u_int32 i, n = 0;
+
+	llHdl->detOrder[n++] = rate;
+	for(i=0; i<DETECT_RATES; i++){
+		if(order[i] != rate){
+			llHdl->detOrder[n++] = order[i];
+		}
+	}
+	llHdl->detIdx = 0;
+	llHdl->detProbeMs = 0;
+	llHdl->detElapsedMs = 0;
+	llHdl->detTimeMs = 0;
+	llHdl->detRun = 1;
+	DBGWRT_1((DBH, "LL - Z147: rate detection started\n"));
+	return rate;
+}
+
+/**********************************************************************/
+/** Restart the receiver from DetectWork().
+ *
+ *  Called with the hold of DetectWork(), the ISR is waited for like in
+ *  RxHold(). A reader notices the restart by rxCfgGen; the buffers are
+ *  not reallocated, they are large enough for every rate.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \param syncCfg    \IN  Z147_RX_SYNC_CFG value
+ */
+static void DetectRestart(LL_HANDLE *llHdl, u_int8 rate, u_int8 syncCfg){
+
+	if(RxQuiesce(llHdl) == ERR_SUCCESS){
+		RxRestart(llHdl, rate, syncCfg);
+	}
+}
+
+/**********************************************************************/
+/** Check the synchronization of the core and, in raw mode, the driver.
+ *
+ *  \param llHdl      \IN  low-level handle
+ *  \return           1 if in sync
+ */
+static int32 DetectInSync(LL_HANDLE *llHdl){
+
+	u_int8 lsrStatus = MREAD_D8(llHdl->ma, Z147_LSR_REG_OFFSET);
+
+	return (lsrStatus & Z147_LSR_INSYNC_MASK) == Z147_LSR_INSYNC_MASK &&
+		(llHdl->swSync == 0 || llHdl->swConf != 0);
+}
+
+/**********************************************************************/
+/** Rate detection (OSS alarm of #Z147_RX_RATE_DETECT).
+ *
+ *  A probe sets a rate with partial synchronization, two sync words in
+ *  order at the right rate lock the core within two subframes (2 s at
+ *  any rate). Without lock after DETECT_PROBE_MS the next rate of the
+ *  order is probed, round and round. The locked rate is committed with
+ *  the sync mode of the user. In follow mode the sync is watched
+ *  afterwards, lost for DETECT_HOLD_MS (longer than a full
+ *  synchronization) the probes start again.
+ *
+ *  \param arg        \IN  low-level handle
+ */
+static void DetectWork(void *arg){
+
+	LL_HANDLE *llHdl = (LL_HANDLE*)arg;
+	u_int8 lsrStatus = 0;
+	u_int8 rate = 0;
+
+	llHdl->detBusy = 1;
+	/* a setstat changes the receiver, the next poll goes on */
+	if(!HoldTake(llHdl, HOLD_DETECT)){
+		llHdl->detBusy = 0;
+		return;
+	}
+	if(llHdl->detRun){
+		llHdl->detElapsedMs += llHdl->detPeriodMs;
+		llHdl->detProbeMs += llHdl->detPeriodMs;
+		lsrStatus = MREAD_D8(llHdl->ma, Z147_LSR_REG_OFFSET);
+		rate = llHdl->detOrder[llHdl->detIdx];
+
+		if((lsrStatus & Z147_LSR_INSYNC_MASK) == Z147_LSR_INSYNC_MASK){
+			/* locked: commit the rate */
+			llHdl->detRun = 0;
+			llHdl->detLostMs = 0;
+			llHdl->detTimeMs = llHdl->detElapsedMs;
+			if(llHdl->detSyncCfg != DETECT_SYNC_CFG){
+				DetectRestart(llHdl, rate, llHdl->detSyncCfg);
+			}
+			if(llHdl->detMode == Z147_DETECT_ONCE){
+				llHdl->detMode = Z147_DETECT_OFF;
+				OSS_AlarmClear(OSH, llHdl->detAlarm);
+			}
+			DBGWRT_1((DBH, "LL - Z147: rate %d detected in %d ms\n",
+					  rate, llHdl->detTimeMs));
+		}else if(llHdl->detProbeMs >= DETECT_PROBE_MS){
+			llHdl->detIdx = (llHdl->detIdx + 1) % DETECT_RATES;
+			llHdl->detProbeMs = 0;
+			DetectRestart(llHdl, llHdl->detOrder[llHdl->detIdx],
+						  DETECT_SYNC_CFG);
+		}
+	}else if(llHdl->detMode == Z147_DETECT_FOLLOW){
+		if(DetectInSync(llHdl)){
+			llHdl->detLostMs = 0;
+		}else if((llHdl->detLostMs += llHdl->detPeriodMs) >= DETECT_HOLD_MS){
+			DetectRestart(llHdl, DetectStart(llHdl), DETECT_SYNC_CFG);
+		}
+	}
+	RxRelease(llHdl);
+	llHdl->detBusy = 0;
+}
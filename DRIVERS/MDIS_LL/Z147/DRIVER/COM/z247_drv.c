@@ -109,6 +109,9 @@
 #define Z247_TX_TRIG_LVL_128  	 5    /**< Set trigger level to 128 words. */
 #define Z247_TX_TRIG_LVL_256   	 6    /**< Set trigger level to 256 words. */
 #define Z247_TX_TRIG_LVL_512     7    /**< Set trigger level to 512 words. */
+
+#define EXIT_WAIT_US             2000 /**< Max. wait for a running ISR in Z247_Exit(). */
+#define EXIT_POLL_US             10   /**< Poll interval of this wait. */
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
@@ -127,6 +130,7 @@ typedef struct {
 
 	OSS_SIG_HANDLE          *portChangeSig; /**< signal for port change */
 	OSS_SIG_HANDLE          *tlsErrorSig;   /**< signal for transmitter line status. */
+	OSS_SIG_HANDLE          *frameSig;      /**< signal on frame start. */
 
 	/* toggle mode */
 	OSS_ALARM_HANDLE        *alarmHdl;      /**< alarm handle               */
@@ -145,8 +149,10 @@ typedef struct {
 
 	u_int32					writeBlockSize;
 	u_int8 					disableTx;
-	u_int8					isTxIrqExit;
+	volatile u_int8			isrBusy;		/**< Flag: Z247_Irq() is running. */
 	u_int32 				txFrameCnt;
+	volatile u_int32		txFrameStartCnt; /**< Frames started since open. */
+	u_int8					txPacked;		/**< BlockWrite takes packed 12 bit words. */
 } LL_HANDLE;
 
 /* include files which need LL_HANDLE */
@@ -181,6 +187,7 @@ static int HwWrite(LL_HANDLE    *llHdl);
 static int SetDataRate(LL_HANDLE *llHdl, u_int8 txSpeed);
 static void RegStatus(LL_HANDLE *llHdl );
 static u_int16 ReadFromBuffer( LL_HANDLE *llHdl);
+static void Unpack12(const u_int8 *src, u_int16 *dst, u_int32 words);
 
 
 /****************************** Z247_GetEntry ********************************/
@@ -282,6 +289,8 @@ static int32 Z247_Init(
 	llHdl->disableTx = 0;
 	llHdl->drvRingDataCnt = 0;
 	llHdl->txFrameCnt = 0;
+	llHdl->txFrameStartCnt = 0;
+	llHdl->txPacked = 0;
 	llHdl->writeBlockSize = 0;
 	/*------------------------------+
 	|  prepare debugging            |
@@ -328,7 +337,8 @@ static int32 Z247_Init(
 /** De-initialize hardware and clean up memory
  *
  *  The function deinitializes all channels by setting them as inputs.
- *  The interrupt is disabERR_SUCCESSled.
+ *  The interrupt is disabled. An ISR running on another CPU is waited for
+ *  up to EXIT_WAIT_US, ERR_LL_DEV_BUSY is returned if it does not finish.
  *
  *  \param llHdlP     \IN  pointer to low-level driver handle
  *
@@ -340,21 +350,19 @@ static int32 Z247_Exit(
 {
 	LL_HANDLE *llHdl = *llHdlP;
 	int32 error = 0;
+	u_int32 waitUs;
 
+	/* Disable the interrupt, no ISR enables it again */
+	llHdl->disableTx = 1;
+	MWRITE_D8(llHdl->ma, Z247_TX_IER_OFFSET, 0);
 
-	int timeoutCnt = 20;
-	while(llHdl->isTxIrqExit != 0){
-		if(timeoutCnt > 0){
-			/* Else wait for some time and check again */
-			timeoutCnt--;
-			OSS_Delay(OSH, 100);
-		}else{
-			/* Exit the loop and return. */
-			return ERR_LL_DEV_BUSY;
-		}
+	/* an ISR running on another CPU finishes quickly */
+	for(waitUs = 0; llHdl->isrBusy && waitUs < EXIT_WAIT_US;
+			waitUs += EXIT_POLL_US){
+		OSS_MikroDelay(OSH, EXIT_POLL_US);
 	}
-	/* Disable the interrupt */
-	MWRITE_D8(llHdl->ma, Z247_TX_IER_OFFSET, 0);
+	if(llHdl->isrBusy)
+		return ERR_LL_DEV_BUSY;
 	DBGWRT_2((DBH, "Z247_Exit\n"));
 	IDBGWRT_2((DBH, ">>> LL - Z247_Exit: Register status in Exit before CleanUp\n"));
 		RegStatus(llHdl);
@@ -508,6 +516,30 @@ static int32 Z247_SetStat(
 		}
 		error = OSS_SigRemove(OSH, &llHdl->tlsErrorSig);
 		break;
+
+		/*--------------------------+
+		|  register frame signal    |
+		+--------------------------*/
+	case Z247_SET_FRAME_SIGNAL:
+		/* signal already installed ? */
+		if (llHdl->frameSig) {
+			error = ERR_OSS_SIG_SET;
+			break;
+		}
+		error = OSS_SigCreate(OSH, value, &llHdl->frameSig);
+		break;
+
+		/*--------------------------+
+		|  unregister frame signal  |
+		+--------------------------*/
+	case Z247_CLR_FRAME_SIGNAL:
+		/* signal already installed ? */
+		if (llHdl->frameSig == NULL) {
+			error = ERR_OSS_SIG_CLR;
+			break;
+		}
+		error = OSS_SigRemove(OSH, &llHdl->frameSig);
+		break;
 		/*--------------------------+
 		|  Interrupt enable            |
 		+--------------------------*/
@@ -564,6 +596,13 @@ static int32 Z247_SetStat(
 		llHdl->disableTx = 1;
 		break;
 
+		/*---------------------------+
+		|  Packed 12 bit frames      |
+		+---------------------------*/
+	case Z247_TX_PACKED:
+		llHdl->txPacked = (value != 0) ? 1 : 0;
+		break;
+
 		/*--------------------------+
 		|  (unknown)                |
 		+--------------------------*/
@@ -678,6 +717,20 @@ static int32 Z247_GetStat(
 		*value64P = (MREAD_D8(llHdl->ma, Z247_TX_FCR_OFFSET) & Z247_TX_FCR_MASK);
 		break;
 
+		/*------------------------+
+		|  Started frame count    |
+		+------------------------*/
+	case Z247_TX_FRAME_CNT:
+		*valueP = (int32)llHdl->txFrameStartCnt;
+		break;
+
+		/*---------------------------+
+		|  Packed 12 bit frames      |
+		+---------------------------*/
+	case Z247_TX_PACKED:
+		*valueP = (int32)llHdl->txPacked;
+		break;
+
 		/*--------------------------+
 		|  (unknown)                |
 		+--------------------------*/
@@ -727,6 +780,9 @@ static int32 Z247_BlockRead(
  *  \param size        \IN  data buffer size
  *  \param nbrWrBytesP \OUT number of written bytes
  *
+ *  With #Z247_TX_PACKED the frame must be given packed
+ *  (Z247_PACKED_SIZE() bytes).
+ *
  *  \return            \c 0 on success or error code
  */
 static int32 Z247_BlockWrite(
@@ -738,17 +794,21 @@ static int32 Z247_BlockWrite(
 )
 {
 	int32 result = ERR_SUCCESS;
-	u_int32 llDataLen = size/2;
+	u_int32 llDataLen = llHdl->usrBufferSize * 2;
 	u_int16 * userBuf = (u_int16*)buf;
 
 	DBGWRT_2((DBH, ">>> LL - LL - Z247_BlockWrite: size=%d \n",size));
 
 	/* Check for user buffer size */
 	if((size != 0) && (buf != NULL)){
-		if(llDataLen == llHdl->usrBufferSize){
+		if(llHdl->txPacked)
+			llDataLen = Z247_PACKED_SIZE(llHdl->usrBufferSize);
+		if((u_int32)size == llDataLen){
 			/* Copy data from user space to kernel space (ring buffer). */
-
-			OSS_MemCopy(OSH, size, (char*)userBuf, (char*)llHdl->usrBuffer);
+			if(llHdl->txPacked)
+				Unpack12((u_int8*)buf, llHdl->usrBuffer, llHdl->usrBufferSize);
+			else
+				OSS_MemCopy(OSH, size, (char*)userBuf, (char*)llHdl->usrBuffer);
 			/* Set the indication of the new data. */
 			llHdl->isUsrDataUpdated = USER_DATA_UPDATED;
 			/* Configure the interrupts */
@@ -791,6 +851,8 @@ static int32 Z247_Irq(
 	int32 result = 0;
 	u_int32 irqReq = 0;
 
+	llHdl->isrBusy = 1;
+
 	/* interrupt caused by TX ? */
 	irqReq = MREAD_D8(llHdl->ma, Z247_IIR_STAT);
 
@@ -819,8 +881,6 @@ static int32 Z247_Irq(
 		if(llHdl->disableTx == 0){
 			/* Enable the queue space interrupt. */
 			MWRITE_D8(llHdl->ma, Z247_TX_IER_OFFSET, Z247_TX_IER_DEFAULT);
-		}else{
-			llHdl->isTxIrqExit = 1;
 		}
 
 		IDBGWRT_2((DBH, ">>> LL - Z247_Irq: Status after HwWrite:\n"));
@@ -830,6 +890,7 @@ static int32 Z247_Irq(
 		result = LL_IRQ_DEV_NOT;
 	}
 
+	llHdl->isrBusy = 0;
 	return result;
 
 }
@@ -992,6 +1053,14 @@ static int32 Cleanup(
 	if (llHdl->descHdl)
 		retCode = DESC_Exit(&llHdl->descHdl);
 
+	/* remove signals */
+	if (llHdl->portChangeSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->portChangeSig);
+	if (llHdl->tlsErrorSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->tlsErrorSig);
+	if (llHdl->frameSig)
+		OSS_SigRemove(llHdl->osHdl, &llHdl->frameSig);
+
 	/* clean up debug */
 	DBGEXIT((&DBH));
 
@@ -1003,7 +1072,7 @@ static int32 Cleanup(
 		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->usrBuffer, llHdl->usrBufferSize *2);
 		llHdl->usrBuffer = NULL;
 	}
-	if(llHdl->usrBuffer != NULL){
+	if(llHdl->drvRingBuffer != NULL){
 		OSS_MemFree(llHdl->osHdl, (int8*)llHdl->drvRingBuffer, llHdl->drvRingSize * 2);
 		llHdl->drvRingBuffer = NULL;
 	}
@@ -1097,7 +1166,7 @@ int SetDataRate( LL_HANDLE *llHdl, u_int8 txSpeed){
 	int result = 0;
 	int buffSize = 0;
 	int trigLevel = 0;
-	int gotsize = 0;
+	u_int32 gotsize = 0;
 	u_int8 regData = 0;
 
 	switch(txSpeed){
@@ -1190,7 +1259,6 @@ int SetDataRate( LL_HANDLE *llHdl, u_int8 txSpeed){
 			/* Set the user data flag. */
 			llHdl->isUsrDataUpdated = USER_DATA_NOT_UPDATED;
 			llHdl->disableTx = 0;
-			llHdl->isTxIrqExit = 0;
 			llHdl->drvRingDataCnt = 0;
 			llHdl->txFrameCnt = 0;
 		}
@@ -1227,6 +1295,12 @@ u_int16 ReadFromBuffer( LL_HANDLE *llHdl){
 		llHdl->drvRingTail = 0;
 		llHdl->isUsrDataUpdated = USER_DATA_NOT_UPDATED;
 		llHdl->txFrameCnt++;
+		llHdl->txFrameStartCnt++;
+
+		/* the user buffer is free for the next frame */
+		if (llHdl->frameSig){
+			OSS_SigSend(OSH, llHdl->frameSig);
+		}
 
 	}
 
@@ -1260,3 +1334,21 @@ void RegStatus(LL_HANDLE *llHdl ){
 	DBGWRT_2((DBH, " >>  LL - Z247_drv status: RST = 0x%x\n", MREAD_D8(llHdl->ma, Z247_TX_RST_OFFSET)));
 	DBGWRT_2((DBH, " \n"));
 }
+
+/**********************************************************************/
+/** Unpack 12 bit words, 2 words in 3 bytes (see Z247_TX_PACKED).
+ *
+ *  \param src        \IN  packed words, Z247_PACKED_SIZE(words) bytes
+ *  \param dst        \OUT words
+ *  \param words      \IN  number of words
+ */
+static void Unpack12(const u_int8 *src, u_int16 *dst, u_int32 words){
+	u_int32 i;
+
+	for(i = 0; i + 1 < words; i += 2, src += 3){
+		dst[i]   = (u_int16)(src[0] | ((src[1] & 0x0F) << 8));
+		dst[i+1] = (u_int16)((src[1] >> 4) | (src[2] << 4));
+	}
+	if(i < words)
+		dst[i] = (u_int16)(src[0] | ((src[1] & 0x0F) << 8));
+}
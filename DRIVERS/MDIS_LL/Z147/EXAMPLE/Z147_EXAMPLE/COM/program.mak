@@ -18,8 +18,11 @@ MAK_NAME=z147_example
 
 MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/mdis_api$(LIB_SUFFIX)	\
 			$(LIB_PREFIX)$(MEN_LIB_DIR)/usr_oss$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_rt$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/pthread$(LIB_SUFFIX)	\
 
 MAK_INCL=$(MEN_INC_DIR)/z147_drv.h	\
+         $(MEN_INC_DIR)/z147_rt.h	\
          $(MEN_INC_DIR)/men_typs.h	\
          $(MEN_INC_DIR)/mdis_api.h	\
          $(MEN_INC_DIR)/usr_oss.h	\
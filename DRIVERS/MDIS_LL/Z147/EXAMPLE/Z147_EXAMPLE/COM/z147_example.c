@@ -11,7 +11,11 @@
  *
  *       \brief  Simple example program for the Z147 driver
  *
- *     Required: libraries: mdis_api, usr_oss
+ *               Received frames are fetched by the reader thread of the
+ *               z147_rt runtime and checked and printed by the main thread,
+ *               the signal handler does no work.
+ *
+ *     Required: libraries: mdis_api, usr_oss, z147_rt, pthread
  *     \switches (none)
  */
 /*-------------------------------[ History ]--------------------------------
@@ -31,16 +35,17 @@
 #include <MEN/usr_oss.h>
 #include <MEN/z147_drv.h>
 #include <MEN/z247_drv.h>
+#include <MEN/z147_rt.h>
 
 /*--------------------------------------+
 |   DEFINES                             |
 +--------------------------------------*/
 #define MAX_DATA_LEN 	32768
+#define RT_SLOTS		4
 
 /*--------------------------------------+
 |   GLOBALS                             |
 +--------------------------------------*/
-static int G_sigCount = 0;
 MDIS_PATH G_rxPath;
 int G_errors = 0;
 u_int32 G_dataLen = 0;
@@ -50,7 +55,8 @@ u_int32 G_rxFrameCnt = 0;
 |   PROTOTYPES                          |
 +--------------------------------------*/
 static void PrintError(char *info);
-static void __MAPILIB SignalHandler( u_int32 sig );
+static void CheckFrame( Z147RT_FRAME *frm );
+static void DrainFrames( u_int32 msec );
 
 /********************************* main ************************************/
 /** Program main function
@@ -62,19 +68,13 @@ static void __MAPILIB SignalHandler( u_int32 sig );
  */
 int main(int argc, char *argv[])
 {
-	int32 irqCount;
 	char *rxDevice;
 	char *txDevice;
 	int32 result = 0;
 	int32 isSync = 0;
 	u_int32 i = 0;
-	int j = 0;
 	int k = 0;
 	int dataRate = 0;
-	int testType = 0;
-	u_int32 data = 0;
-	u_int16 *txBuf = NULL;
-	u_int16 *rxBuf = NULL;
 	u_int16 txDataArray[MAX_DATA_LEN];
 	u_int8 txDataByte = 0;
 	u_int32 txFrameCnt = 0;
@@ -108,12 +108,10 @@ int main(int argc, char *argv[])
 	/*--------------------+
     |  config             |
     +--------------------*/
-	UOS_SigInit( SignalHandler );
-	UOS_SigInstall( UOS_SIG_USR1 );
-	
-	result = M_setstat(G_rxPath, Z147_SET_SIGNAL, UOS_SIG_USR1);
+	result = Z147RT_Start(G_rxPath, RT_SLOTS, MAX_DATA_LEN);
 	if(result != 0){
-		G_errors++;
+		printf("Starting the reader failed: %s\n", M_errstring(result));
+		return(1);
 	}
 	
 	result = M_setstat(txPath, Z247_TX_DATA_RATE, dataRate);
@@ -132,7 +130,7 @@ int main(int argc, char *argv[])
 		printf("\n");
 		printf("################### Test Run-%d ################\n", k+1);
 		printf("----------------- Transmit -----------------\n");
-		printf("User data length = %d and dataptr = 0x%x\n", G_dataLen, txDataArray);
+		printf("User data length = %d and dataptr = %p\n", G_dataLen, (void*)txDataArray);
 		
 		txDataByte = 0;
 		
@@ -156,7 +154,7 @@ int main(int argc, char *argv[])
 		printf("--------------------------------\n");
 		printf("\n");
 
-		UOS_Delay( 4000);
+		DrainFrames(4000);
 
 		while(1){
 			result = M_getstat(G_rxPath, Z147_RX_IN_SYNC, &isSync);
@@ -173,10 +171,10 @@ int main(int argc, char *argv[])
 				printf("Is rx in sync = %d\n", isSync);
 				break;
 			}else{
-				UOS_Delay(100);
+				DrainFrames(100);
 			}
 		}
-		printf("G_sigCount = %d\n", G_sigCount);
+		printf("Signal count = %u\n", Z147RT_Stats()->sigs);
 		txFrameCnt++;
 	}
 	
@@ -184,6 +182,8 @@ int main(int argc, char *argv[])
 	if(result != 0){
 		G_errors++;
 	}
+	DrainFrames(0);
+	Z147RT_Stop();
 	result = M_setstat(G_rxPath, Z147_DISABLE_RX, 1);
 	if(result != 0){
 		G_errors++;
@@ -221,58 +221,70 @@ static void PrintError(char *info)
 	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
 }
 
-/****************************** SignalHandler ******************************/
-/** Signal handler
+/********************************* CheckFrame ******************************/
+/** Check and print a received frame
  *
- *  \param  sig    \IN   received signal
+ *  \param  frm    \IN   frame from the reader thread
  */
-static void __MAPILIB SignalHandler( u_int32 sig )
+static void CheckFrame( Z147RT_FRAME *frm )
 {
-	int32 result=0;
-	int32 i=0;
+	int32 result = frm->len;
 	int32 j=0;
 	u_int8 rxDataByte = 0;
-	u_int16 rxDataArray[MAX_DATA_LEN];
+	u_int16 *rxDataArray = frm->data;
 
-	if( sig == UOS_SIG_USR1 ) {
-		++G_sigCount;
-		
-		result = M_getblock( G_rxPath, (u_int8*)rxDataArray, (G_dataLen *2) );
-		if(result < 0){
-			G_errors++;
-		}
-		if(result > 0){
-			printf("----------------- Receive -----------------\n");
-			printf("Receiving = %d bytes data\n", result);
-			rxDataByte = 0;
-			
-			/* Add 4 sync words and ignore them in check. */
-			for(j=0;j<(result/2);j++){
-				if((rxDataArray[j] != Z147_ARINC717_SUB_1_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_2_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_3_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_4_SYNC))
-				{
-					if(rxDataArray[j] != (rxDataByte)){
-						printf("Expected 0x%x but received rxDataArray[%d] = 0x%x\n",
-							(rxDataByte), j, rxDataArray[j]);
-						G_errors++;
-					}
-					if((j<10) || (j>((result/2) - 5))){
-						printf(" [%d]0x%x",j, rxDataArray[j]);
-					}
-					rxDataByte++;
+	if(result < 0){
+		G_errors++;
+	}
+	if(result > 0){
+		printf("----------------- Receive -----------------\n");
+		printf("Receiving = %d bytes data\n", result);
+		rxDataByte = 0;
+
+		/* Add 4 sync words and ignore them in check. */
+		for(j=0;j<(result/2);j++){
+			if((rxDataArray[j] != Z147_ARINC717_SUB_1_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_2_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_3_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_4_SYNC))
+			{
+				if(rxDataArray[j] != (rxDataByte)){
+					printf("Expected 0x%x but received rxDataArray[%d] = 0x%x\n",
+						(rxDataByte), j, rxDataArray[j]);
+					G_errors++;
+				}
+				if((j<10) || (j>((result/2) - 5))){
+					printf(" [%d]0x%x",j, rxDataArray[j]);
 				}
-				/* Reset the buffer. */
-				rxDataArray[j] = 0;
+				rxDataByte++;
 			}
-			
-			printf("\n");
-			printf("Received %d bytes successfully\n", result);
-			printf("--------------------------------\n");
-			G_rxFrameCnt++;
-		}else{
-			printf("Read failed with the result = %d\n", result);
 		}
+
+		printf("\n");
+		printf("Received %d bytes successfully\n", result);
+		printf("--------------------------------\n");
+		G_rxFrameCnt++;
+	}else{
+		printf("Read failed with the result = %d\n", result);
 	}
 }
+
+/********************************* DrainFrames *****************************/
+/** Wait and check all frames received in the meantime
+ *
+ *  \param  msec   \IN   wait time in ms (0 = only pending frames)
+ */
+static void DrainFrames( u_int32 msec )
+{
+	u_int32 start = UOS_MsecTimerGet();
+	u_int32 spent = 0;
+	Z147RT_FRAME *frm;
+
+	do{
+		if((frm = Z147RT_Get(spent < msec ? msec - spent : 0)) != NULL){
+			CheckFrame(frm);
+			Z147RT_Put(frm);
+		}
+		spent = UOS_MsecTimerGet() - start;
+	}while(spent < msec || frm != NULL);
+}
@@ -0,0 +1,27 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 frame codec benchmark
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_cmp_bench
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_cmp$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_frm$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_drv.h	\
+         $(MEN_INC_DIR)/z147_cmp.h	\
+         $(MEN_INC_DIR)/z147_frm.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+
+MAK_INP1=z147_cmp_bench$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
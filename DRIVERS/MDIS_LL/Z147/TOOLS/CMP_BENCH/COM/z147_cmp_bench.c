@@ -0,0 +1,319 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_CMP_BENCH                   ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_cmp_bench.c
+ *       \author Apatil
+ *
+ *       \brief  Compression ratio and speed of the Z147 frame codec
+ *
+ *               Encodes the frames of an indexed frame file (z147_frm.h)
+ *               or of a synthetic recording with the z147_cmp codec,
+ *               decodes and compares them and reports the compression
+ *               ratio and the encode and decode throughput in MB/s of
+ *               uncompressed frame data. Random access is checked by
+ *               decoding random frames from their preceding key frame.
+ *
+ *               The synthetic recording has the sync words and a mix of
+ *               constant slots (70%), slowly changing slots (20%, one step
+ *               every 16 frames) and noisy slots (10%, random low 4 bits).
+ *
+ *     Required: libraries: z147_cmp, z147_frm
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_cmp_bench.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_cmp.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MIN_TIME_NS         500000000LL     /**< min. time per measurement */
+#define RANDOM_CHECKS       1000            /**< random access checks */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static u_int32 G_seed = 1;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static u_int16 *LoadFrames( char *name, u_int32 *numP, u_int32 *wordsP );
+static u_int16 *MakeFrames( u_int32 rate, u_int32 num );
+static u_int32 Rand( void );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *file = NULL;
+	u_int16 *frames, *dec = NULL;
+	u_int8 *cod = NULL;
+	u_int32 *off = NULL;
+	u_int32 rate = Z147_RX_DATA_RATE_8192, num = 256, block = 0, words;
+	u_int32 i, f, key, rounds, maxSize;
+	u_int64 raw, codBytes = 0;
+	int64 t0, encNs, decNs;
+	Z147CMP_CTX enc, dcx;
+	int32 n, errors = 0, argi;
+	double encMBs, decMBs;
+
+	for(argi=1; argi<argc; argi++){
+		if(strncmp(argv[argi], "-r=", 3) == 0){
+			rate = (u_int32)atoi(argv[argi] + 3);
+		}else if(strncmp(argv[argi], "-n=", 3) == 0){
+			num = (u_int32)atoi(argv[argi] + 3);
+		}else if(strncmp(argv[argi], "-k=", 3) == 0){
+			block = (u_int32)atoi(argv[argi] + 3);
+		}else if(argv[argi][0] != '-' && file == NULL){
+			file = argv[argi];
+		}else{
+			break;
+		}
+	}
+	if(argi < argc || rate > 7 || num == 0){
+		printf("Syntax: z147_cmp_bench [<opts>] [<frmFile>]\n");
+		printf("Function: compression ratio and speed of the frame codec\n");
+		printf("Options (without frame file):\n");
+		printf("    -r=<rate>  data rate 0..7 (64..8192 words/s)  [7]\n");
+		printf("    -n=<n>     synthetic frames                    [256]\n");
+		printf("Options:\n");
+		printf("    -k=<n>     frames per key frame                [%u]\n",
+			   Z147CMP_BLOCK_FRAMES);
+		return(1);
+	}
+
+	if(file)
+		frames = LoadFrames(file, &num, &words);
+	else{
+		frames = MakeFrames(rate, num);
+		words  = Z147FRM_FRAME_WORDS(rate);
+	}
+	if(frames == NULL)
+		return(1);
+
+	maxSize = Z147CMP_MAX_SIZE(words);
+	raw = (u_int64)num * words * 2;
+	cod = (u_int8*)malloc((size_t)num * maxSize);
+	off = (u_int32*)malloc((num + 1) * sizeof(u_int32));
+	dec = (u_int16*)malloc(words * sizeof(u_int16));
+	if(cod == NULL || off == NULL || dec == NULL ||
+	   Z147CMP_Init(&enc, words, block) != 0 ||
+	   Z147CMP_Init(&dcx, words, block) != 0){
+		printf("*** can't allocate buffers\n");
+		return(1);
+	}
+
+	/*--------------------+
+	|  encode             |
+	+--------------------*/
+	t0 = NowNs();
+	rounds = 0;
+	do{
+		Z147CMP_Reset(&enc);
+		off[0] = 0;
+		for(f=0; f<num; f++){
+			n = Z147CMP_Encode(&enc, frames + (size_t)f * words,
+							   cod + off[f], maxSize);
+			if(n < 0){
+				printf("*** encode error at frame %u\n", f);
+				return(1);
+			}
+			off[f+1] = off[f] + (u_int32)n;
+		}
+		rounds++;
+	}while((encNs = NowNs() - t0) < MIN_TIME_NS);
+	encNs /= rounds;
+	codBytes = off[num];
+
+	/*--------------------+
+	|  decode and check   |
+	+--------------------*/
+	Z147CMP_Reset(&dcx);
+	for(f=0; f<num; f++){
+		n = Z147CMP_Decode(&dcx, cod + off[f], off[num] - off[f], dec);
+		if(n != (int32)(off[f+1] - off[f]) ||
+		   memcmp(dec, frames + (size_t)f * words, words * 2) != 0){
+			printf("*** frame %u decoded wrong\n", f);
+			errors++;
+			break;
+		}
+	}
+
+	t0 = NowNs();
+	rounds = 0;
+	do{
+		Z147CMP_Reset(&dcx);
+		for(f=0; f<num; f++)
+			Z147CMP_Decode(&dcx, cod + off[f], off[f+1] - off[f], dec);
+		rounds++;
+	}while((decNs = NowNs() - t0) < MIN_TIME_NS);
+	decNs /= rounds;
+
+	/*--------------------+
+	|  random access      |
+	+--------------------*/
+	for(i=0; i<RANDOM_CHECKS && errors == 0; i++){
+		f = Rand() % num;
+		key = f - f % dcx.blockFrames;
+		Z147CMP_Reset(&dcx);
+		for( ; key<=f; key++){
+			if(Z147CMP_Decode(&dcx, cod + off[key], off[key+1] - off[key],
+							  key == f ? dec : NULL) < 0)
+				break;
+		}
+		if(key <= f || memcmp(dec, frames + (size_t)f * words, words * 2)){
+			printf("*** random access to frame %u failed\n", f);
+			errors++;
+		}
+	}
+
+	encMBs = (double)raw / (double)encNs * 1e3;
+	decMBs = (double)raw / (double)decNs * 1e3;
+	printf("frames        %u x %u words (%s)\n", num, words,
+		   file ? file : "synthetic");
+	printf("raw           %llu bytes\n", (unsigned long long)raw);
+	printf("coded         %llu bytes, ratio %.1f:1, %.2f bits/word\n",
+		   (unsigned long long)codBytes, (double)raw / (double)codBytes,
+		   (double)codBytes * 8.0 / ((double)num * words));
+	printf("encode        %.0f MB/s (%.0f channels at 8192 words/s)\n",
+		   encMBs, encMBs * 1e6 / (8192.0 * 2));
+	printf("decode        %.0f MB/s\n", decMBs);
+	printf("random access %s\n", errors ? "FAILED" : "ok");
+
+	Z147CMP_Exit(&enc);
+	Z147CMP_Exit(&dcx);
+	free(frames);
+	free(cod);
+	free(off);
+	free(dec);
+	return(errors ? 1 : 0);
+}
+
+/********************************* LoadFrames ******************************/
+/** Copy the frames of a frame file
+ *
+ *  \param name       \IN  frame file
+ *  \param numP       \OUT frames
+ *  \param wordsP     \OUT words per frame
+ *
+ *  \return	          frames or NULL on error
+ */
+static u_int16 *LoadFrames( char *name, u_int32 *numP, u_int32 *wordsP )
+{
+	Z147FRM_FILE *fp;
+	u_int16 *buf;
+	u_int32 f, words;
+
+	if((fp = Z147FRM_Open(name)) == NULL){
+		printf("*** can't open %s: %s\n", name,
+			   errno == EINVAL ? "not a frame file" : strerror(errno));
+		return NULL;
+	}
+	words = fp->hdr->frameWords;
+	if(fp->frames == 0 ||
+	   (buf = (u_int16*)malloc((size_t)fp->frames * words * 2)) == NULL){
+		printf("*** %s: no frames or out of memory\n", name);
+		Z147FRM_Close(fp);
+		return NULL;
+	}
+	for(f=0; f<fp->frames; f++)
+		memcpy(buf + (size_t)f * words, Z147FRM_DATA(Z147FRM_Frame(fp, f)),
+			   words * 2);
+
+	*numP   = fp->frames;
+	*wordsP = words;
+	Z147FRM_Close(fp);
+	return buf;
+}
+
+/********************************* MakeFrames ******************************/
+/** Build a synthetic recording
+ *
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \param num        \IN  frames
+ *
+ *  \return	          frames or NULL on error
+ */
+static u_int16 *MakeFrames( u_int32 rate, u_int32 num )
+{
+	static const u_int16 sync[4] = {
+		Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+		Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC };
+	u_int32 sfs = 64u << rate, words = 4 * sfs, f, w, r;
+	u_int16 *buf, *frm, *prev;
+	u_int8 *type;
+
+	buf  = (u_int16*)malloc((size_t)num * words * 2);
+	type = (u_int8*)malloc(words);
+	if(buf == NULL || type == NULL){
+		printf("*** can't allocate buffers\n");
+		free(buf);
+		free(type);
+		return NULL;
+	}
+
+	for(w=0; w<words; w++){
+		r = Rand() % 10;
+		type[w] = r < 7 ? 0 : r < 9 ? 1 : 2;
+		buf[w]  = (u_int16)(Rand() & 0xfff);
+	}
+	for(f=0; f<num; f++){
+		frm  = buf + (size_t)f * words;
+		prev = f ? frm - words : frm;
+		for(w=0; w<words; w++){
+			if(w % sfs == 0)
+				frm[w] = sync[w / sfs];
+			else if(type[w] == 1)
+				frm[w] = (u_int16)((prev[w] + ((f + w) % 16 == 0)) & 0xfff);
+			else if(type[w] == 2)
+				frm[w] = (u_int16)((prev[w] & 0xff0) | (Rand() & 0xf));
+			else
+				frm[w] = prev[w];
+		}
+	}
+	free(type);
+	return buf;
+}
+
+/********************************* Rand ************************************/
+/** Pseudo random number (LCG, reproducible) */
+static u_int32 Rand( void )
+{
+	G_seed = G_seed * 1103515245 + 12345;
+	return G_seed >> 8;
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
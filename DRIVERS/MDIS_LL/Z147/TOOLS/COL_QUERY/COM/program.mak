@@ -0,0 +1,24 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 column store query tool
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_col_query
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_col$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_col.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+
+MAK_INP1=z147_col_query$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
@@ -0,0 +1,225 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_COL_QUERY                   ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_col_query.c
+ *       \author Apatil
+ *
+ *       \brief  Query a column of the parameter column store
+ *
+ *               Prints the samples of a column file (z147_col.h) within a
+ *               time and value range as CSV:
+ *
+ *               time_ns,value
+ *
+ *               Only the pages whose zone map entry overlaps both ranges
+ *               are read. With -a the time range is split into windows
+ *               and the aggregate of every window with samples is printed
+ *               instead:
+ *
+ *               start_ns,samples,min,max,mean
+ *
+ *               The aggregates come from the summaries of the file, only
+ *               the partial seconds at the window edges are decoded. The
+ *               summary line reports the pages and summaries read, the
+ *               query time and the compression of the file.
+ *
+ *     Required: libraries: z147_col
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_col_query.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <stdint.h>
+#include <time.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_col.h>
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static int G_quiet;                         /**< summary only */
+static u_int32 G_num;                       /**< max. samples (0 = all) */
+static u_int32 G_printed;                   /**< samples printed */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int64 Windows( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+					  int64 window );
+static int32 Visit( void *arg, int64 tsNs, double value );
+static double NowMs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *name = NULL;
+	int64 fromNs = INT64_MIN, toNs = INT64_MAX, window = 0, found;
+	double min = -DBL_MAX, max = DBL_MAX, ms;
+	Z147COL_FILE *col;
+	const Z147COL_HDR *hdr;
+	int i;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-f=", 3) == 0){
+			fromNs = strtoll(argv[i] + 3, NULL, 0);
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			toNs = strtoll(argv[i] + 3, NULL, 0);
+		}else if(strncmp(argv[i], "-min=", 5) == 0){
+			min = strtod(argv[i] + 5, NULL);
+		}else if(strncmp(argv[i], "-max=", 5) == 0){
+			max = strtod(argv[i] + 5, NULL);
+		}else if(strncmp(argv[i], "-a=", 3) == 0){
+			window = (int64)(strtod(argv[i] + 3, NULL) * 1e9);
+			if(window <= 0)
+				break;
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			G_num = (u_int32)atoi(argv[i] + 3);
+		}else if(strcmp(argv[i], "-q") == 0){
+			G_quiet = 1;
+		}else if(argv[i][0] != '-' && name == NULL){
+			name = argv[i];
+		}else{
+			break;
+		}
+	}
+
+	if(i < argc || name == NULL ||
+	   (window && (min != -DBL_MAX || max != DBL_MAX))){
+		printf("Syntax: z147_col_query [<opts>] <colFile>\n");
+		printf("Function: print the samples of a column file in a time "
+			   "and value range\n");
+		printf("          or their min, max and mean per time window\n");
+		printf("Options:\n");
+		printf("    -f=<ns>     first time (UTC ns)           [first]\n");
+		printf("    -t=<ns>     last time (UTC ns)            [last]\n");
+		printf("    -min=<v>    smallest value                [any]\n");
+		printf("    -max=<v>    largest value                 [any]\n");
+		printf("    -a=<s>      aggregate per window of <s> seconds "
+			   "(not with -min/-max)\n");
+		printf("    -n=<n>      max. samples/windows (0=all)  [0]\n");
+		printf("    -q          print the summary only\n");
+		return(1);
+	}
+
+	if((col = Z147COL_Open(name)) == NULL){
+		printf("*** can't open %s: %s\n", name,
+			   errno == EINVAL ? "not a column file" : strerror(errno));
+		return(1);
+	}
+	hdr = col->hdr;
+
+	ms = NowMs();
+	if(window){
+		if(!G_quiet)
+			printf("start_ns,samples,min,max,mean\n");
+		found = Windows(col, fromNs, toNs, window);
+	}else{
+		if(!G_quiet)
+			printf("time_ns,%s\n", hdr->name);
+		found = Z147COL_Query(col, fromNs, toNs, min, max, Visit, NULL);
+	}
+	ms = NowMs() - ms;
+	if(found < 0){
+		printf("*** can't read %s: %s\n", name, strerror(errno));
+		Z147COL_Close(col);
+		return(1);
+	}
+
+	printf("# %s: %lld of %llu samples, %u of %u pages and %u summaries "
+		   "read in %.3f ms, %llu of %llu bytes (%.1f%%)\n", hdr->name,
+		   (long long)found, (unsigned long long)hdr->samples,
+		   col->pagesRead, hdr->pages, col->sumsRead, ms,
+		   (unsigned long long)col->size,
+		   (unsigned long long)(hdr->rawBytes + Z147COL_HDR_SIZE),
+		   100.0 * (double)col->size /
+		   (double)(hdr->rawBytes + Z147COL_HDR_SIZE));
+
+	Z147COL_Close(col);
+	return(0);
+}
+
+/********************************* Windows *********************************/
+/** Print the aggregates of the windows of a time range
+ *
+ *  \param col        \IN  column file
+ *  \param fromNs     \IN  first time
+ *  \param toNs       \IN  last time
+ *  \param window     \IN  window length in ns
+ *
+ *  \return	          samples aggregated or -1 on error
+ */
+static int64 Windows( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+					  int64 window )
+{
+	Z147COL_AGG agg;
+	int64 start, found = 0;
+
+	if(fromNs < col->hdr->firstNs)
+		fromNs = col->hdr->firstNs;
+	if(toNs > col->hdr->lastNs)
+		toNs = col->hdr->lastNs;
+
+	/* windows aligned to multiples of their length */
+	for(start = fromNs - fromNs % window; start <= toNs; start += window){
+		if(Z147COL_Aggregate(col, start < fromNs ? fromNs : start,
+							 start + window - 1 < toNs ?
+							 start + window - 1 : toNs, &agg) < 0)
+			return -1;
+		if(agg.num == 0)
+			continue;
+		found += (int64)agg.num;
+		if(!G_quiet)
+			printf("%lld,%llu,%.9g,%.9g,%.9g\n", (long long)start,
+				   (unsigned long long)agg.num, agg.min, agg.max,
+				   agg.sum / (double)agg.num);
+		if(G_num != 0 && ++G_printed >= G_num)
+			break;
+	}
+	return found;
+}
+
+/********************************* Visit ***********************************/
+/** Print a sample of the query
+ *
+ *  \param arg        \IN  unused
+ *  \param tsNs       \IN  time
+ *  \param value      \IN  value
+ *
+ *  \return	          0 or 1 to stop after -n samples
+ */
+static int32 Visit( void *arg, int64 tsNs, double value )
+{
+	if(!G_quiet)
+		printf("%lld,%.9g\n", (long long)tsNs, value);
+	return (G_num != 0 && ++G_printed >= G_num);
+}
+
+/********************************* NowMs ***********************************/
+/** Monotonic time in ms */
+static double NowMs( void )
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (double)t.tv_sec * 1e3 + (double)t.tv_nsec / 1e6;
+}
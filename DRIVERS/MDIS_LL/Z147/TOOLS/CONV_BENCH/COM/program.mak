@@ -0,0 +1,24 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 column conversion benchmark
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_conv_bench
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_map$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_map.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+
+MAK_INP1=z147_conv_bench$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
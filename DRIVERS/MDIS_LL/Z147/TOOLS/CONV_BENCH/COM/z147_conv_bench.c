@@ -0,0 +1,217 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_CONV_BENCH                  ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_conv_bench.c
+ *       \author Apatil
+ *
+ *       \brief  Throughput of the column conversion kernels
+ *
+ *               Converts columns of random 12 bit words with every
+ *               conversion kernel of the z147_map library supported by
+ *               the CPU, checks the results against the scalar kernel and
+ *               reports the throughput in million samples per second per
+ *               encoding, incl. parameters over 2 adjacent words. The
+ *               columns stay in the cache.
+ *
+ *               Output is a table, with -c CSV:
+ *
+ *               enc,kernel,samples,msps
+ *
+ *     Required: libraries: z147_map
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_conv_bench.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_map.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define SAMPLES             4096        /**< samples per column */
+#define MIN_TIME_NS         100000000LL /**< min. time per measurement */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** test case */
+typedef struct {
+	const char *name;
+	u_int8  enc;
+	u_int8  words;
+	u_int8  msb;
+	u_int8  lsb;
+	double  res;
+	double  ofs;
+} CONV_CASE;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static const CONV_CASE G_case[] = {
+	{ "bnr",    Z147MAP_ENC_BNR,  1, 12, 1, 0.25,    0.0   },
+	{ "bnr24",  Z147MAP_ENC_BNR,  2, 12, 1, 1.0/256, 0.0   },
+	{ "bnr9",   Z147MAP_ENC_BNR,  1, 11, 3, 0.5,     -40.0 },
+	{ "bcd",    Z147MAP_ENC_BCD,  1, 12, 1, 1.0,     0.0   },
+	{ "bcd24",  Z147MAP_ENC_BCD,  2, 12, 1, 0.1,     0.0   },
+	{ "dis",    Z147MAP_ENC_DIS,  1, 4,  1, 1.0,     0.0   },
+	{ "pack24", Z147MAP_ENC_PACK, 2, 12, 1, 2.0,     0.0   },
+};
+#define NUM_CASES   (sizeof(G_case) / sizeof(G_case[0]))
+
+static u_int16 G_col[2][SAMPLES];
+static double  G_ref[SAMPLES];
+static double  G_out[SAMPLES];
+static volatile double G_sink;      /**< keeps results alive */
+static int     G_csv;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void MakeInsn( const CONV_CASE *c, Z147MAP_INSN *in );
+static double Measure( const Z147MAP_INSN *in );
+static void Report( const char *enc, const char *kernel, double msps );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	const u_int16 *col[2] = { G_col[0], G_col[1] };
+	Z147MAP_INSN in;
+	u_int32 c, i, n;
+	int32 k, errors = 0;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "-c") != 0)){
+		printf("Syntax: z147_conv_bench [-c]\n");
+		printf("Function: throughput of the column conversion kernels\n");
+		printf("Options:\n");
+		printf("    -c         CSV output\n");
+		return(1);
+	}
+	G_csv = argc == 2;
+
+	srand(1);
+	for(i=0; i<SAMPLES; i++){
+		G_col[0][i] = (u_int16)(rand() & 0xfff);
+		G_col[1][i] = (u_int16)(rand() & 0xfff);
+	}
+
+	if(G_csv)
+		printf("enc,kernel,samples,msps\n");
+	else
+		printf("%-8s %-7s %10s %8s\n", "enc", "kernel", "Msamples/s",
+			   "speedup");
+
+	for(c=0; c<NUM_CASES; c++){
+		MakeInsn(&G_case[c], &in);
+
+		Z147MAP_ConvSelect(Z147MAP_KRN_SCALAR);
+		Z147MAP_Convert(&in, col, SAMPLES, G_ref);
+
+		for(k=0; k<Z147MAP_KRN_NUM; k++){
+			if(Z147MAP_ConvSelect(k) < 0)
+				continue;
+
+			/* odd sizes exercise the tails of the kernels */
+			for(n=SAMPLES-17; n<=SAMPLES; n++){
+				memset(G_out, 0, sizeof(G_out));
+				Z147MAP_Convert(&in, col, n, G_out);
+				if(memcmp(G_out, G_ref, n * sizeof(double)) != 0){
+					printf("*** %s/%s: wrong result for %u samples\n",
+						   G_case[c].name, Z147MAP_ConvName(k), n);
+					errors++;
+					break;
+				}
+			}
+			Report(G_case[c].name, Z147MAP_ConvName(k), Measure(&in));
+		}
+	}
+
+	if(!G_csv)
+		printf("%s\n", errors ? "Test Result : FAILED" :
+			   "Test Result : PASSED");
+	return(errors ? 1 : 0);
+}
+
+/********************************* MakeInsn ********************************/
+/** Instruction of a test case */
+static void MakeInsn( const CONV_CASE *c, Z147MAP_INSN *in )
+{
+	memset(in, 0, sizeof(*in));
+	in->enc   = c->enc;
+	in->words = c->words;
+	in->shift = (u_int8)(c->lsb - 1);
+	in->bits  = (u_int8)(c->msb - c->lsb + 1);
+	in->mask  = (u_int16)((1u << in->bits) - 1);
+	in->sf    = Z147MAP_SF_ANY;
+	in->res   = c->res;
+	in->ofs   = c->ofs;
+}
+
+/********************************* Measure *********************************/
+/** Throughput of the selected kernel
+ *
+ *  \param in         \IN  instruction
+ *
+ *  \return	          million samples per second
+ */
+static double Measure( const Z147MAP_INSN *in )
+{
+	const u_int16 *col[2] = { G_col[0], G_col[1] };
+	u_int64 rounds = 0;
+	int64 t0, t;
+
+	t0 = NowNs();
+	do{
+		Z147MAP_Convert(in, col, SAMPLES, G_out);
+		G_sink += G_out[rounds % SAMPLES];
+		rounds++;
+	}while((t = NowNs() - t0) < MIN_TIME_NS);
+
+	return (double)rounds * SAMPLES / (double)t * 1e3;
+}
+
+/********************************* Report **********************************/
+/** Print one result, the speedup refers to the last scalar result */
+static void Report( const char *enc, const char *kernel, double msps )
+{
+	static double scalar = 1.0;
+
+	if(strcmp(kernel, "scalar") == 0)
+		scalar = msps;
+	if(G_csv)
+		printf("%s,%s,%u,%.0f\n", enc, kernel, SAMPLES, msps);
+	else
+		printf("%-8s %-7s %10.0f %7.1fx\n", enc, kernel, msps,
+			   msps / scalar);
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -0,0 +1,31 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 parameter decoder
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_decode
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_map$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_frm$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/mdis_api$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/usr_oss$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_drv.h	\
+         $(MEN_INC_DIR)/z147_frm.h	\
+         $(MEN_INC_DIR)/z147_map.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/mdis_api.h	\
+         $(MEN_INC_DIR)/usr_oss.h	\
+
+MAK_INP1=z147_decode$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
@@ -0,0 +1,496 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_DECODE                      ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_decode.c
+ *       \author Apatil
+ *
+ *       \brief  Decode parameters of Z147 frames with a frame map
+ *
+ *               Compiles a frame map (format see z147_map.h) and decodes
+ *               the parameters of the frames of an indexed frame file
+ *               (z147_frm.h) or, with -l, of the frames read from a
+ *               receiver. The values are printed as CSV:
+ *
+ *               time_s,frame,param,raw,value
+ *
+ *               The frame of the superframe is taken from the counter
+ *               word of the map, else from the counter word of the frame
+ *               file, else from the frame number.
+ *
+ *               With -L single word parameters are decoded with value
+ *               tables (Z147MAP_LutBuild()), -g writes the parameters and
+ *               tables as C source for a program with a static layout.
+ *
+ *               With -b the frames of the file are decoded repeatedly
+ *               without output and the decoding time per frame and per
+ *               value is reported. With -L also the arithmetic decoding is
+ *               measured and both are checked for identical values.
+ *
+ *     Required: libraries: z147_map, z147_frm, mdis_api, usr_oss
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_decode.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_map.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define POLL_TIME           10              /**< receiver poll time in ms */
+#define MIN_TIME_NS         500000000LL     /**< min. benchmark time */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static volatile int G_sigInt;               /**< Ctrl-C */
+static int32 G_only = -1;                   /**< printed parameter or -1 */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 DecodeFile( Z147MAP_PLAN *plan, char *name, double tSec,
+						 u_int32 num, int bench, int32 lut );
+static int64 Bench( Z147MAP_PLAN *plan, Z147FRM_FILE *fp, u_int32 first,
+					u_int32 end, Z147MAP_VAL *val, const char *info );
+static int32 Verify( Z147MAP_PLAN *plan, Z147FRM_FILE *fp, u_int32 first,
+					 u_int32 end );
+static int CmpVal( const void *a, const void *b );
+static int32 DecodeLive( Z147MAP_PLAN *plan, char *device, u_int32 num );
+static void PrintValues( Z147MAP_PLAN *plan, Z147MAP_VAL *val, int32 n,
+						 double tSec, u_int32 frame );
+static void PrintError(char *info);
+static void SigIntHandler( int sig );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *mapName = NULL, *input = NULL, *only = NULL, *gen = NULL;
+	Z147MAP_PLAN *plan;
+	u_int32 num = 0, errLine;
+	int32 live = 0, bench = 0, lut = -1, i, rv;
+	double tSec = 0.0;
+
+	for(i=1; i<argc; i++){
+		if(strcmp(argv[i], "-l") == 0){
+			live = 1;
+		}else if(strcmp(argv[i], "-b") == 0){
+			bench = 1;
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			tSec = atof(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			num = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-p=", 3) == 0){
+			only = argv[i] + 3;
+		}else if(strncmp(argv[i], "-L=", 3) == 0){
+			lut = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-g=", 3) == 0){
+			gen = argv[i] + 3;
+		}else if(argv[i][0] != '-' && mapName == NULL){
+			mapName = argv[i];
+		}else if(argv[i][0] != '-' && input == NULL){
+			input = argv[i];
+		}else{
+			break;
+		}
+	}
+
+	if(i < argc || (input == NULL && gen == NULL) || (live && bench) ||
+	   lut < -1){
+		printf("Syntax: z147_decode [<opts>] <mapFile> <frmFile>\n");
+		printf("        z147_decode -l [<opts>] <mapFile> <rxDevice>\n");
+		printf("        z147_decode -g=<file> [-L=<n>] <mapFile>\n");
+		printf("Function: decode parameters of Z147 frames with a frame "
+			   "map\n");
+		printf("Options:\n");
+		printf("    -l         decode the frames of a receiver\n");
+		printf("    -t=<s>     start at seconds after the first frame\n");
+		printf("    -n=<n>     frames (0=all / until Ctrl-C)     [0]\n");
+		printf("    -p=<name>  print only this parameter\n");
+		printf("    -L=<n>     value tables, max. <n> x 32 KB      [none]\n");
+		printf("    -g=<file>  write params and tables as C source\n");
+		printf("    -b         benchmark, decode without output\n");
+		return(1);
+	}
+
+	if((plan = Z147MAP_Load(mapName, -1, &errLine)) == NULL){
+		if(errno == EINVAL && errLine)
+			printf("*** %s:%u: syntax error\n", mapName, errLine);
+		else if(errno == EINVAL)
+			printf("*** %s: no rate or parameter outside of the frame\n",
+				   mapName);
+		else
+			printf("*** can't read %s: %s\n", mapName, strerror(errno));
+		return(1);
+	}
+	if(only && (G_only = Z147MAP_Find(plan, only)) < 0){
+		printf("*** %s: no parameter %s\n", mapName, only);
+		Z147MAP_Free(plan);
+		return(1);
+	}
+
+	if(lut >= 0 || gen){
+		if((rv = Z147MAP_LutBuild(plan, lut >= 0 ? (u_int32)lut :
+								  Z147MAP_NO_LUT - 1, NULL)) < 0){
+			printf("*** can't allocate value tables\n");
+			Z147MAP_Free(plan);
+			return(1);
+		}
+		if(gen){
+			if(Z147MAP_LutWrite(plan, gen, "z147map") < 0)
+				printf("*** can't write %s: %s\n", gen, strerror(errno));
+			else
+				printf("%s: %u parameters, %d tables\n", gen,
+					   plan->numParams, rv);
+			Z147MAP_Free(plan);
+			return(0);
+		}
+	}
+
+	if(live)
+		rv = DecodeLive(plan, input, num);
+	else
+		rv = DecodeFile(plan, input, tSec, num, bench, lut);
+
+	Z147MAP_Free(plan);
+	return(rv == 0 ? 0 : 1);
+}
+
+/********************************* DecodeFile ******************************/
+/** Decode the frames of a frame file
+ *
+ *  \param plan       \IN  decoding plan
+ *  \param name       \IN  frame file
+ *  \param tSec       \IN  start time after the first frame
+ *  \param num        \IN  frames (0 = all)
+ *  \param bench      \IN  benchmark without output
+ *  \param lut        \IN  max. value tables or -1 (benchmark only)
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 DecodeFile( Z147MAP_PLAN *plan, char *name, double tSec,
+						 u_int32 num, int bench, int32 lut )
+{
+	Z147FRM_FILE *fp;
+	const Z147FRM_FRAME *frm;
+	Z147MAP_VAL *val;
+	u_int32 first, f, end;
+	int64 firstNs, nsArith;
+	int32 n, sf, error = 0;
+
+	if((fp = Z147FRM_Open(name)) == NULL){
+		printf("*** can't open %s: %s\n", name,
+			   errno == EINVAL ? "not a frame file" : strerror(errno));
+		return -1;
+	}
+	if(fp->hdr->rate != plan->rate || fp->frames == 0){
+		printf("*** %s: %s\n", name, fp->frames ? "rate differs from map" :
+			   "no frames");
+		Z147FRM_Close(fp);
+		return -1;
+	}
+	if((val = (Z147MAP_VAL*)malloc(plan->numInsn * sizeof(*val) + 1)) ==
+	   NULL){
+		printf("*** can't allocate buffers\n");
+		Z147FRM_Close(fp);
+		return -1;
+	}
+
+	/* superframe counter of the file if the map has none */
+	if(plan->sfSub == 0 && fp->hdr->sfSub >= 1 && fp->hdr->sfSub <= 4){
+		plan->sfSub  = fp->hdr->sfSub;
+		plan->sfWord = fp->hdr->sfWord;
+		plan->sfMask = fp->hdr->sfMask;
+	}
+
+	firstNs = Z147FRM_Frame(fp, 0)->tsNs;
+	first = Z147FRM_SeekTime(fp, firstNs + (int64)(tSec * 1e9));
+	end = num && first + num < fp->frames ? first + num : fp->frames;
+	if(first >= end){
+		printf("*** %s: no frames after %.3f s\n", name, tSec);
+		free(val);
+		Z147FRM_Close(fp);
+		return -1;
+	}
+
+	if(bench){
+		printf("map         %u parameters, %u instructions\n",
+			   plan->numParams, plan->numInsn);
+		printf("frames      %u x %u words\n", end - first, plan->frameWords);
+		if(lut < 0){
+			Bench(plan, fp, first, end, val, "decode");
+		}else{
+			printf("tables      %u, %u KB\n", plan->numLuts,
+				   plan->numLuts * Z147MAP_LUT_SIZE *
+				   (u_int32)sizeof(double) / 1024);
+			error = Verify(plan, fp, first, end);
+			Z147MAP_LutBuild(plan, 0, NULL);
+			nsArith = Bench(plan, fp, first, end, val, "arithmetic");
+			if(Z147MAP_LutBuild(plan, (u_int32)lut, NULL) < 0){
+				printf("*** can't allocate value tables\n");
+				error = -1;
+			}else{
+				printf("speedup     %.2fx\n", (double)nsArith /
+					   (double)Bench(plan, fp, first, end, val, "tables"));
+			}
+		}
+	}else{
+		printf("time_s,frame,param,raw,value\n");
+		for(f=first; f<end && !G_sigInt; f++){
+			frm = Z147FRM_Frame(fp, f);
+			sf  = plan->sfSub ? -1 : (int32)(frm->seq % Z147MAP_SF_FRAMES);
+			n   = Z147MAP_Decode(plan, Z147FRM_DATA(frm), sf, val);
+			PrintValues(plan, val, n, (frm->tsNs - firstNs) / 1e9, f);
+		}
+	}
+
+	free(val);
+	Z147FRM_Close(fp);
+	return error;
+}
+
+/********************************* Bench ***********************************/
+/** Decode frames repeatedly and print the decoding time
+ *
+ *  \param plan       \IN  decoding plan
+ *  \param fp         \IN  frame file
+ *  \param first      \IN  first frame
+ *  \param end        \IN  end frame
+ *  \param val        \IN  value buffer
+ *  \param info       \IN  name of the measurement
+ *
+ *  \return	          ns per frame
+ */
+static int64 Bench( Z147MAP_PLAN *plan, Z147FRM_FILE *fp, u_int32 first,
+					u_int32 end, Z147MAP_VAL *val, const char *info )
+{
+	const Z147FRM_FRAME *frm;
+	u_int32 f, rounds = 0;
+	u_int64 values = 0;
+	int64 t0, ns;
+	int32 sf;
+
+	t0 = NowNs();
+	do{
+		for(f=first; f<end; f++){
+			frm = Z147FRM_Frame(fp, f);
+			sf  = plan->sfSub ? -1 : (int32)(frm->seq % Z147MAP_SF_FRAMES);
+			values += (u_int32)Z147MAP_Decode(plan, Z147FRM_DATA(frm), sf,
+											  val);
+		}
+		rounds++;
+	}while((ns = NowNs() - t0) < MIN_TIME_NS);
+
+	printf("%-11s %.1f ns/frame, %.2f ns/value, %.1f Mvalues/s "
+		   "(%u groups)\n", info,
+		   (double)ns / ((double)rounds * (end - first)),
+		   values ? (double)ns / (double)values : 0.0,
+		   (double)values * 1e3 / (double)ns, plan->numGroups);
+	return ns / ((int64)rounds * (end - first));
+}
+
+/********************************* Verify **********************************/
+/** Compare the table decoding with the arithmetic decoding
+ *
+ *  The groups differ, so the values of a frame are compared sorted.
+ *
+ *  \param plan       \IN  decoding plan with value tables
+ *  \param fp         \IN  frame file
+ *  \param first      \IN  first frame
+ *  \param end        \IN  end frame
+ *
+ *  \return	          0 or -1 on difference or error
+ */
+static int32 Verify( Z147MAP_PLAN *plan, Z147FRM_FILE *fp, u_int32 first,
+					 u_int32 end )
+{
+	const Z147FRM_FRAME *frm;
+	Z147MAP_PLAN *ref;
+	Z147MAP_VAL *a, *b;
+	u_int32 f;
+	int32 na, nb, sf, error = 0;
+
+	ref = Z147MAP_Build(plan->param, plan->numParams, plan->rate);
+	a = (Z147MAP_VAL*)malloc(plan->numInsn * sizeof(*a) + 1);
+	b = (Z147MAP_VAL*)malloc(plan->numInsn * sizeof(*b) + 1);
+	if(ref == NULL || a == NULL || b == NULL){
+		printf("*** can't allocate buffers\n");
+		error = -1;
+		goto CLEANUP;
+	}
+	ref->sfSub  = plan->sfSub;
+	ref->sfWord = plan->sfWord;
+	ref->sfMask = plan->sfMask;
+
+	for(f=first; f<end && !error; f++){
+		frm = Z147FRM_Frame(fp, f);
+		sf  = plan->sfSub ? -1 : (int32)(frm->seq % Z147MAP_SF_FRAMES);
+		na  = Z147MAP_Decode(ref, Z147FRM_DATA(frm), sf, a);
+		nb  = Z147MAP_Decode(plan, Z147FRM_DATA(frm), sf, b);
+		qsort(a, (size_t)na, sizeof(*a), CmpVal);
+		qsort(b, (size_t)nb, sizeof(*b), CmpVal);
+		if(na != nb || memcmp(a, b, (size_t)na * sizeof(*a)) != 0){
+			printf("*** frame %u: table values differ\n", f);
+			error = -1;
+		}
+	}
+	printf("verify      %s\n", error ? "FAILED" : "identical values");
+
+CLEANUP:
+	free(a);
+	free(b);
+	if(ref)
+		Z147MAP_Free(ref);
+	return error;
+}
+
+/********************************* CmpVal **********************************/
+/** qsort compare: parameter, raw value */
+static int CmpVal( const void *a, const void *b )
+{
+	const Z147MAP_VAL *x = (const Z147MAP_VAL*)a;
+	const Z147MAP_VAL *y = (const Z147MAP_VAL*)b;
+
+	if(x->param != y->param)
+		return x->param < y->param ? -1 : 1;
+	if(x->raw != y->raw)
+		return x->raw < y->raw ? -1 : 1;
+	return 0;
+}
+
+/********************************* DecodeLive ******************************/
+/** Decode the frames of a receiver
+ *
+ *  \param plan       \IN  decoding plan
+ *  \param device     \IN  receiver device name
+ *  \param num        \IN  frames (0 = until Ctrl-C)
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 DecodeLive( Z147MAP_PLAN *plan, char *device, u_int32 num )
+{
+	MDIS_PATH path;
+	Z147MAP_VAL *val;
+	u_int16 *frame;
+	int32 cnt, lastCnt = -1, len, n, error = 0;
+	u_int32 frames = 0;
+	int64 t0 = NowNs();
+
+	val   = (Z147MAP_VAL*)malloc(plan->numInsn * sizeof(*val) + 1);
+	frame = (u_int16*)malloc(plan->frameWords * sizeof(u_int16));
+	if(val == NULL || frame == NULL){
+		printf("*** can't allocate buffers\n");
+		free(val);
+		free(frame);
+		return -1;
+	}
+
+	if((path = M_open(device)) < 0){
+		PrintError("open");
+		free(val);
+		free(frame);
+		return -1;
+	}
+	if(M_setstat(path, Z147_RX_DATA_RATE, plan->rate) < 0){
+		PrintError("setstat");
+		error = -1;
+		goto CLEANUP;
+	}
+
+	signal(SIGINT, SigIntHandler);
+	printf("time_s,frame,param,raw,value\n");
+
+	while(!G_sigInt && (num == 0 || frames < num)){
+		if(M_getstat(path, Z147_RX_FRAME_CNT, &cnt) < 0){
+			PrintError("getstat");
+			error = -1;
+			break;
+		}
+		if(cnt != lastCnt){
+			lastCnt = cnt;
+			len = M_getblock(path, (u_int8*)frame, plan->frameWords * 2);
+			if(len == (int32)(plan->frameWords * 2)){
+				n = Z147MAP_Decode(plan, frame, -1, val);
+				PrintValues(plan, val, n, (NowNs() - t0) / 1e9, frames++);
+				fflush(stdout);
+			}
+		}
+		UOS_Delay(POLL_TIME);
+	}
+
+CLEANUP:
+	if(M_close(path) < 0)
+		PrintError("close");
+	free(val);
+	free(frame);
+	return error;
+}
+
+/********************************* PrintValues *****************************/
+/** Print the values of a frame as CSV lines */
+static void PrintValues( Z147MAP_PLAN *plan, Z147MAP_VAL *val, int32 n,
+						 double tSec, u_int32 frame )
+{
+	int32 i;
+
+	for(i=0; i<n; i++){
+		if(G_only >= 0 && val[i].param != (u_int32)G_only)
+			continue;
+		printf("%.6f,%u,%s,%u,%.10g\n", tSec, frame,
+			   plan->param[val[i].param].name, val[i].raw, val[i].value);
+	}
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/********************************* SigIntHandler ***************************/
+/** Ctrl-C: stop decoding */
+static void SigIntHandler( int sig )
+{
+	G_sigInt = 1;
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
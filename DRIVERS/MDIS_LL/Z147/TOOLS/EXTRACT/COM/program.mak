@@ -0,0 +1,29 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 parallel parameter extraction
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_extract
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_map$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_frm$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_col$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/pthread$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_frm.h	\
+         $(MEN_INC_DIR)/z147_map.h	\
+         $(MEN_INC_DIR)/z147_col.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+
+MAK_INP1=z147_extract$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
@@ -0,0 +1,821 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_EXTRACT                     ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_extract.c
+ *       \author Apatil
+ *
+ *       \brief  Parallel extraction of parameters from frame files
+ *
+ *               Decodes the parameters of a frame map (z147_map.h) from
+ *               any number of indexed frame files (z147_frm.h) and writes
+ *               one column per parameter in time order:
+ *
+ *               \<dir\>/\<param\>.ts   int64  time of the value (UTC ns)
+ *               \<dir\>/\<param\>.val  double engineering value
+ *
+ *               in host byte order, so e.g. numpy.fromfile() reads them.
+ *               With -s the columns go into the column store instead
+ *               (z147_col.h, \<dir\>/\<param\>.z147c, -z compressed),
+ *               with zone maps for queries of single parameters. The
+ *               time of a value is the frame time corrected by the
+ *               position of its word in the frame.
+ *
+ *               The files are sorted by their first frame and split into
+ *               chunks of about -c frames, cut at superframe starts where
+ *               the file has a superframe index. The main thread feeds
+ *               the chunks round robin into the deques of the worker
+ *               threads, at most -w chunks ahead of the oldest unwritten
+ *               chunk, which bounds the memory. A worker decodes the
+ *               chunks of its own deque oldest first and steals the
+ *               newest chunk of another deque when its own is empty. The
+ *               main thread writes the finished chunks in order.
+ *
+ *               A worker asks the kernel to read its chunk ahead
+ *               (posix_madvise()), so the disk streams while the workers
+ *               decode. -b decodes without output, the difference shows
+ *               whether the disk or the CPU limits.
+ *
+ *     Required: libraries: z147_map, z147_frm, z147_col, pthread
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_extract.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_map.h>
+#include <MEN/z147_col.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_THREADS         256         /**< worker threads */
+#define MAX_NAME            1024        /**< output path length */
+#define STORE               0x80000000  /**< column store, with Z147COL_FL_xx */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** input file */
+typedef struct {
+	char        *name;          /**< file name */
+	Z147FRM_FILE *fp;           /**< opened file */
+	int64       firstNs;        /**< time of the first frame */
+	u_int32     sfPos;          /**< counter word or 0 = frame number */
+	u_int32     sfMask;         /**< counter bits */
+	u_int32     sfShift;        /**< shift of sfMask */
+} EX_FILE;
+
+/** chunk of a file and its decoded columns */
+typedef struct {
+	u_int32     file;           /**< index in G_file */
+	u_int32     first;          /**< first frame */
+	u_int32     end;            /**< end frame */
+	u_int32     *num;           /**< values per output column */
+	int64       **ts;           /**< times per output column */
+	double      **val;          /**< values per output column */
+	void        *mem;           /**< all of the above */
+	int         done;           /**< decoded, protected by G_lock */
+} EX_CHUNK;
+
+/** deque of a worker, chunk indices */
+typedef struct {
+	pthread_mutex_t lock;
+	u_int32     *ring;          /**< G_window entries */
+	u_int32     head;           /**< oldest */
+	u_int32     num;            /**< entries */
+	pthread_t   thread;         /**< worker */
+	u_int32     decoded;        /**< chunks decoded */
+	u_int32     stolen;         /**< chunks stolen from other deques */
+} EX_WORKER;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static Z147MAP_PLAN *G_plan;                /**< decoding plan (read only) */
+static EX_FILE  *G_file;                    /**< input files */
+static u_int32  G_numFiles;
+static EX_CHUNK *G_chunk;                   /**< all chunks in time order */
+static u_int32  G_numChunks;
+static EX_WORKER G_worker[MAX_THREADS];
+static u_int32  G_numWorkers;
+static u_int32  G_window;                   /**< chunks in flight */
+
+static u_int32  G_numOut;                   /**< output columns */
+static int32    *G_outIdx;                  /**< column of a param or -1 */
+static u_int32  *G_outParam;                /**< param of a column */
+static u_int32  *G_perFrame;                /**< max. values per frame */
+static u_int32  (*G_off)[4];                /**< their word offsets */
+static FILE     **G_raw;                    /**< .ts and .val per column */
+static Z147COL_WRITER **G_col;              /**< or column store files */
+
+/* protected by G_lock */
+static pthread_mutex_t G_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  G_workCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  G_doneCond = PTHREAD_COND_INITIALIZER;
+static u_int32  G_pending;                  /**< chunks in the deques */
+static int      G_quit;                     /**< workers stop */
+static int      G_error;                    /**< worker out of memory */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 OpenFiles( char **names, u_int32 num );
+static int32 MakeChunks( u_int32 chunkFrames );
+static int32 SelectParams( char *list );
+static void *WorkerThread( void *arg );
+static int32 Take( u_int32 w );
+static void Feed( u_int32 idx );
+static int32 Decode( EX_CHUNK *ch );
+static int32 OpenOutput( char *dir, u_int32 store );
+static int32 CloseOutput( void );
+static int32 WriteChunk( EX_CHUNK *ch );
+static void FreeChunk( EX_CHUNK *ch );
+static int32 SfFrame( const EX_FILE *f, const Z147FRM_FRAME *frm );
+static int CmpFile( const void *a, const void *b );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *mapName = NULL, *dir = NULL, *list = NULL;
+	char **names;
+	u_int32 store = 0, chunkFrames = 256, numNames = 0, fed, c, o, w;
+	u_int64 frames = 0, values = 0, bytes = 0;
+	int32 threads = 0, lut = -1, bench = 0, i, errors = 0;
+	u_int32 errLine;
+	int64 t0, ns;
+
+	names = (char**)calloc((size_t)argc, sizeof(char*));
+	if(names == NULL)
+		return(1);
+	G_window = 0;
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-o=", 3) == 0){
+			dir = argv[i] + 3;
+		}else if(strncmp(argv[i], "-j=", 3) == 0){
+			threads = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-c=", 3) == 0){
+			chunkFrames = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-w=", 3) == 0){
+			G_window = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-p=", 3) == 0){
+			list = argv[i] + 3;
+		}else if(strncmp(argv[i], "-L=", 3) == 0){
+			lut = atoi(argv[i] + 3);
+		}else if(strcmp(argv[i], "-s") == 0){
+			store |= STORE;
+		}else if(strcmp(argv[i], "-z") == 0){
+			store |= STORE | Z147COL_FL_COMPRESS;
+		}else if(strcmp(argv[i], "-b") == 0){
+			bench = 1;
+		}else if(argv[i][0] != '-' && mapName == NULL){
+			mapName = argv[i];
+		}else if(argv[i][0] != '-'){
+			names[numNames++] = argv[i];
+		}else{
+			break;
+		}
+	}
+	if(threads <= 0)
+		threads = (int32)sysconf(_SC_NPROCESSORS_ONLN);
+	if(threads <= 0)
+		threads = 1;
+	if(threads > MAX_THREADS)
+		threads = MAX_THREADS;
+	G_numWorkers = (u_int32)threads;
+	if(G_window == 0)
+		G_window = 4 * G_numWorkers;
+
+	if(i < argc || numNames == 0 || (dir == NULL && !bench) ||
+	   chunkFrames == 0 || G_window < G_numWorkers){
+		printf("Syntax: z147_extract [<opts>] -o=<dir> <mapFile> "
+			   "<frmFile>...\n");
+		printf("Function: parallel extraction of parameters from frame "
+			   "files\n");
+		printf("Options:\n");
+		printf("    -o=<dir>   output directory (existing)\n");
+		printf("    -p=<a,b>   parameters                        [all]\n");
+		printf("    -j=<n>     worker threads                    [cores]\n");
+		printf("    -c=<n>     frames per chunk                  [256]\n");
+		printf("    -w=<n>     chunks in memory (>= threads)     "
+			   "[4 x threads]\n");
+		printf("    -L=<n>     value tables, max. <n> x 32 KB    [none]\n");
+		printf("    -s         write column store files\n");
+		printf("    -z         write compressed column store files\n");
+		printf("    -b         benchmark, decode without output\n");
+		free(names);
+		return(1);
+	}
+
+	if((G_plan = Z147MAP_Load(mapName, -1, &errLine)) == NULL){
+		if(errno == EINVAL && errLine)
+			printf("*** %s:%u: syntax error\n", mapName, errLine);
+		else
+			printf("*** can't load %s: %s\n", mapName, errno == EINVAL ?
+				   "no rate or parameter outside of the frame" :
+				   strerror(errno));
+		free(names);
+		return(1);
+	}
+	if(lut >= 0 && Z147MAP_LutBuild(G_plan, (u_int32)lut, NULL) < 0){
+		printf("*** can't allocate value tables\n");
+		errors++;
+		goto CLEANUP;
+	}
+	if(SelectParams(list) < 0 || OpenFiles(names, numNames) < 0 ||
+	   MakeChunks(chunkFrames) < 0){
+		errors++;
+		goto CLEANUP;
+	}
+
+	if(!bench && OpenOutput(dir, store) < 0){
+		errors++;
+		goto CLEANUP;
+	}
+
+	for(w=0; w<G_numWorkers; w++){
+		pthread_mutex_init(&G_worker[w].lock, NULL);
+		G_worker[w].ring = (u_int32*)malloc(G_window * sizeof(u_int32));
+		if(G_worker[w].ring == NULL ||
+		   pthread_create(&G_worker[w].thread, NULL, WorkerThread,
+						  (void*)(size_t)w) != 0){
+			printf("*** can't start worker %u\n", w);
+			G_numWorkers = w;
+			errors++;
+			break;
+		}
+	}
+
+	/* feed the window, write the chunks in order */
+	t0 = NowNs();
+	for(c=0, fed=0; c<G_numChunks && !errors; c++){
+		for(; fed < G_numChunks && fed < c + G_window; fed++)
+			Feed(fed);
+
+		pthread_mutex_lock(&G_lock);
+		while(!G_chunk[c].done && !G_error)
+			pthread_cond_wait(&G_doneCond, &G_lock);
+		pthread_mutex_unlock(&G_lock);
+		if(G_error){
+			printf("*** can't allocate chunk buffers\n");
+			errors++;
+			break;
+		}
+
+		frames += G_chunk[c].end - G_chunk[c].first;
+		bytes  += (u_int64)(G_chunk[c].end - G_chunk[c].first) *
+				  G_file[G_chunk[c].file].fp->hdr->recSize;
+		for(o=0; o<G_numOut; o++)
+			values += G_chunk[c].num[o];
+		if(!bench && WriteChunk(&G_chunk[c]) < 0){
+			printf("*** can't write the columns: %s\n", strerror(errno));
+			errors++;
+		}
+		FreeChunk(&G_chunk[c]);
+	}
+	ns = NowNs() - t0;
+
+	pthread_mutex_lock(&G_lock);
+	G_quit = 1;
+	pthread_cond_broadcast(&G_workCond);
+	pthread_mutex_unlock(&G_lock);
+	for(w=0; w<G_numWorkers; w++)
+		pthread_join(G_worker[w].thread, NULL);
+
+	if(!errors){
+		printf("files       %u, %u chunks, %u threads, window %u\n",
+			   G_numFiles, G_numChunks, G_numWorkers, G_window);
+		printf("columns     %u, %llu values\n", G_numOut,
+			   (unsigned long long)values);
+		printf("throughput  %.0f frames/s, %.1f MB/s, %.1f Mvalues/s "
+			   "(%.3f s)\n", (double)frames * 1e9 / (double)ns,
+			   (double)bytes * 1e3 / (double)ns / 1.048576,
+			   (double)values * 1e3 / (double)ns, (double)ns / 1e9);
+		for(w=0; w<G_numWorkers; w++)
+			printf("worker %-4u %u chunks, %u stolen\n", w,
+				   G_worker[w].decoded, G_worker[w].stolen);
+	}
+
+CLEANUP:
+	if(CloseOutput() < 0 && !errors){
+		printf("*** can't write the columns: %s\n", strerror(errno));
+		errors++;
+	}
+	for(c=0; c<G_numChunks; c++)
+		FreeChunk(&G_chunk[c]);
+	for(w=0; w<MAX_THREADS; w++)
+		free(G_worker[w].ring);
+	for(c=0; c<G_numFiles; c++)
+		if(G_file[c].fp)
+			Z147FRM_Close(G_file[c].fp);
+	free(G_file);
+	free(G_chunk);
+	free(G_outIdx);
+	free(G_outParam);
+	free(G_perFrame);
+	free(G_off);
+	free(names);
+	Z147MAP_Free(G_plan);
+	return(errors ? 1 : 0);
+}
+
+/********************************* OpenFiles *******************************/
+/** Open the frame files and sort them by their first frame
+ *
+ *  \param names      \IN  file names
+ *  \param num        \IN  files
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 OpenFiles( char **names, u_int32 num )
+{
+	const Z147FRM_HDR *hdr;
+	EX_FILE *f;
+	u_int32 i;
+
+	if((G_file = (EX_FILE*)calloc(num, sizeof(EX_FILE))) == NULL){
+		printf("*** can't allocate buffers\n");
+		return -1;
+	}
+	for(i=0; i<num; i++){
+		f = &G_file[G_numFiles];
+		f->name = names[i];
+		if((f->fp = Z147FRM_Open(names[i])) == NULL){
+			printf("*** can't open %s: %s\n", names[i],
+				   errno == EINVAL ? "not a frame file" : strerror(errno));
+			return -1;
+		}
+		G_numFiles++;
+		hdr = f->fp->hdr;
+		if(hdr->rate != G_plan->rate){
+			printf("*** %s: rate differs from map\n", names[i]);
+			return -1;
+		}
+		f->firstNs = f->fp->frames ? Z147FRM_Frame(f->fp, 0)->tsNs : 0;
+
+		/* superframe counter of the file if the map has none */
+		if(G_plan->sfSub == 0 && hdr->sfSub >= 1 && hdr->sfSub <= 4 &&
+		   (hdr->sfMask & 0xfff)){
+			f->sfPos  = (hdr->sfSub - 1) * (64u << hdr->rate) + hdr->sfWord;
+			f->sfMask = hdr->sfMask & 0xfff;
+			while(!(f->sfMask & (1u << f->sfShift)))
+				f->sfShift++;
+		}
+	}
+	qsort(G_file, G_numFiles, sizeof(EX_FILE), CmpFile);
+	return 0;
+}
+
+/********************************* MakeChunks ******************************/
+/** Split the files into chunks, at superframe starts if indexed
+ *
+ *  \param chunkFrames \IN  frames per chunk
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 MakeChunks( u_int32 chunkFrames )
+{
+	const Z147FRM_FILE *fp;
+	u_int32 i, k, max = 0, start, cut;
+
+	for(i=0; i<G_numFiles; i++)
+		max += G_file[i].fp->frames / chunkFrames + 1 +
+			   G_file[i].fp->sfIdxNum;
+	if((G_chunk = (EX_CHUNK*)calloc(max, sizeof(EX_CHUNK))) == NULL){
+		printf("*** can't allocate buffers\n");
+		return -1;
+	}
+
+	for(i=0; i<G_numFiles; i++){
+		fp = G_file[i].fp;
+		for(start=0, k=0; start<fp->frames; start=cut){
+			cut = start + chunkFrames < fp->frames ? start + chunkFrames :
+				  fp->frames;
+			/* first superframe start at or after the cut */
+			if(fp->sfIdx && cut < fp->frames){
+				while(k < fp->sfIdxNum && fp->sfIdx[k].frame < cut)
+					k++;
+				if(k < fp->sfIdxNum)
+					cut = fp->sfIdx[k].frame;
+				else
+					cut = fp->frames;
+			}
+			G_chunk[G_numChunks].file  = i;
+			G_chunk[G_numChunks].first = start;
+			G_chunk[G_numChunks].end   = cut;
+			G_numChunks++;
+		}
+	}
+	return 0;
+}
+
+/********************************* SelectParams ****************************/
+/** Select the output columns
+ *
+ *  \param list       \IN  comma separated names or NULL (all)
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 SelectParams( char *list )
+{
+	u_int32 i, k;
+	int32 p;
+	char *name;
+
+	G_outIdx   = (int32*)malloc(G_plan->numParams * sizeof(int32) + 1);
+	G_outParam = (u_int32*)malloc(G_plan->numParams * sizeof(u_int32) + 1);
+	G_perFrame = (u_int32*)calloc(G_plan->numParams + 1, sizeof(u_int32));
+	G_off      = (u_int32(*)[4])calloc(G_plan->numParams + 1,
+										 sizeof(*G_off));
+	if(G_outIdx == NULL || G_outParam == NULL || G_perFrame == NULL ||
+	   G_off == NULL){
+		printf("*** can't allocate buffers\n");
+		return -1;
+	}
+	for(i=0; i<G_plan->numParams; i++)
+		G_outIdx[i] = list ? -1 : (int32)i;
+
+	if(list == NULL){
+		for(i=0; i<G_plan->numParams; i++)
+			G_outParam[i] = i;
+		G_numOut = G_plan->numParams;
+	}else{
+		for(name=strtok(list, ","); name; name=strtok(NULL, ",")){
+			if((p = Z147MAP_Find(G_plan, name)) < 0){
+				printf("*** no parameter %s in the map\n", name);
+				return -1;
+			}
+			if(G_outIdx[p] < 0){
+				G_outIdx[p] = (int32)G_numOut;
+				G_outParam[G_numOut++] = (u_int32)p;
+			}
+		}
+	}
+
+	/*
+	 * instructions of a parameter (one per subframe, max. 4) = values per
+	 * frame, sorted by offset as the decoder returns them
+	 */
+	for(i=0; i<G_plan->numInsn; i++){
+		if((p = G_outIdx[G_plan->insn[i].param]) < 0)
+			continue;
+		for(k=G_perFrame[p]; k>0 && G_off[p][k-1] > G_plan->insn[i].off; k--)
+			G_off[p][k] = G_off[p][k-1];
+		G_off[p][k] = G_plan->insn[i].off;
+		G_perFrame[p]++;
+	}
+	return 0;
+}
+
+/********************************* WorkerThread ****************************/
+/** Worker: decode chunks of the own deque, steal if empty */
+static void *WorkerThread( void *arg )
+{
+	u_int32 w = (u_int32)(size_t)arg;
+	EX_CHUNK *ch;
+	int32 idx, rv;
+
+	for(;;){
+		if((idx = Take(w)) < 0){
+			pthread_mutex_lock(&G_lock);
+			while(!G_quit && G_pending == 0)
+				pthread_cond_wait(&G_workCond, &G_lock);
+			if(G_quit && G_pending == 0){
+				pthread_mutex_unlock(&G_lock);
+				break;
+			}
+			pthread_mutex_unlock(&G_lock);
+			continue;
+		}
+
+		ch = &G_chunk[idx];
+		rv = Decode(ch);
+		G_worker[w].decoded++;
+
+		pthread_mutex_lock(&G_lock);
+		if(rv < 0)
+			G_error = 1;
+		ch->done = 1;
+		pthread_cond_signal(&G_doneCond);
+		pthread_mutex_unlock(&G_lock);
+	}
+	return NULL;
+}
+
+/********************************* Take ************************************/
+/** Next chunk of a worker
+ *
+ *  The oldest chunk of the own deque, else the newest chunk of the next
+ *  non empty deque.
+ *
+ *  \param w          \IN  worker
+ *
+ *  \return	          chunk index or -1 if all deques are empty
+ */
+static int32 Take( u_int32 w )
+{
+	EX_WORKER *wk;
+	u_int32 k;
+	int32 idx = -1;
+
+	for(k=0; k<G_numWorkers && idx < 0; k++){
+		wk = &G_worker[(w + k) % G_numWorkers];
+		pthread_mutex_lock(&wk->lock);
+		if(wk->num){
+			if(k == 0){
+				idx = (int32)wk->ring[wk->head];
+				wk->head = (wk->head + 1) % G_window;
+			}else{
+				idx = (int32)wk->ring[(wk->head + wk->num - 1) % G_window];
+				G_worker[w].stolen++;
+			}
+			wk->num--;
+		}
+		pthread_mutex_unlock(&wk->lock);
+	}
+
+	if(idx >= 0){
+		pthread_mutex_lock(&G_lock);
+		G_pending--;
+		pthread_mutex_unlock(&G_lock);
+	}
+	return idx;
+}
+
+/********************************* Feed ************************************/
+/** Put a chunk into the deque of the next worker (round robin)
+ *
+ *  \param idx        \IN  chunk index
+ */
+static void Feed( u_int32 idx )
+{
+	EX_WORKER *wk = &G_worker[idx % G_numWorkers];
+
+	pthread_mutex_lock(&wk->lock);
+	wk->ring[(wk->head + wk->num) % G_window] = idx;
+	wk->num++;
+	pthread_mutex_unlock(&wk->lock);
+
+	pthread_mutex_lock(&G_lock);
+	G_pending++;
+	pthread_cond_signal(&G_workCond);
+	pthread_mutex_unlock(&G_lock);
+}
+
+/********************************* Decode **********************************/
+/** Decode the frames of a chunk into its columns
+ *
+ *  \param ch         \IN  chunk
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 Decode( EX_CHUNK *ch )
+{
+	const EX_FILE *f = &G_file[ch->file];
+	const Z147FRM_FRAME *frm;
+	Z147MAP_VAL *val;
+	u_int32 frames = ch->end - ch->first, recSize = f->fp->hdr->recSize;
+	u_int32 o, fr, cap, k, nsPerWord = 1000000000u / (64u << G_plan->rate);
+	size_t size, pos;
+	const u_int8 *from;
+	int32 n, i, c;
+	u_int32 *last, *kth;
+	u_int8 *mem;
+	long page = sysconf(_SC_PAGESIZE);
+
+	/* read ahead */
+	from = (const u_int8*)Z147FRM_Frame(f->fp, ch->first);
+	pos  = (size_t)(from - f->fp->base) & ~((size_t)page - 1);
+	posix_madvise((void*)(f->fp->base + pos),
+				  (size_t)(from - f->fp->base) - pos +
+				  (size_t)frames * recSize, POSIX_MADV_WILLNEED);
+
+	size = G_numOut * (sizeof(u_int32) + sizeof(int64*) + sizeof(double*)) +
+		   8;
+	for(o=0; o<G_numOut; o++)
+		size += (size_t)frames * G_perFrame[o] *
+				(sizeof(int64) + sizeof(double));
+	mem = (u_int8*)malloc(size + 1);
+	val = (Z147MAP_VAL*)malloc(G_plan->numInsn * sizeof(*val) + 1);
+	last = (u_int32*)malloc(2 * G_numOut * sizeof(u_int32) + 1);
+	if(mem == NULL || val == NULL || last == NULL){
+		free(mem);
+		free(val);
+		free(last);
+		return -1;
+	}
+	kth = last + G_numOut;
+	for(o=0; o<G_numOut; o++)
+		last[o] = ch->end;
+
+	/* num, ts and val pointers, then the columns */
+	ch->mem = mem;
+	ch->ts  = (int64**)mem;
+	ch->val = (double**)(ch->ts + G_numOut);
+	ch->num = (u_int32*)(ch->val + G_numOut);
+	pos = (size_t)G_numOut * (sizeof(u_int32) + sizeof(int64*) +
+							  sizeof(double*));
+	pos = (pos + 7) & ~(size_t)7;
+	for(o=0; o<G_numOut; o++){
+		cap = frames * G_perFrame[o];
+		ch->ts[o]  = (int64*)(mem + pos);
+		ch->val[o] = (double*)(mem + pos + (size_t)cap * sizeof(int64));
+		ch->num[o] = 0;
+		pos += (size_t)cap * (sizeof(int64) + sizeof(double));
+	}
+
+	for(fr=ch->first; fr<ch->end; fr++){
+		frm = Z147FRM_Frame(f->fp, fr);
+		n = Z147MAP_Decode(G_plan, Z147FRM_DATA(frm), SfFrame(f, frm), val);
+		for(i=0; i<n; i++){
+			if((c = G_outIdx[val[i].param]) < 0)
+				continue;
+			/*
+			 * the k-th value of a parameter in this frame, the frame
+			 * time is the time of its last word
+			 */
+			if(last[c] != fr){
+				last[c] = fr;
+				kth[c]  = 0;
+			}
+			k = kth[c]++;
+			ch->ts[c][ch->num[c]] = frm->tsNs - (int64)nsPerWord *
+				(int64)(G_plan->frameWords - 1 - G_off[c][k]);
+			ch->val[c][ch->num[c]] = val[i].value;
+			ch->num[c]++;
+		}
+	}
+	free(val);
+	free(last);
+	return 0;
+}
+
+/********************************* OpenOutput ******************************/
+/** Create the output files of all columns
+ *
+ *  \param dir        \IN  output directory
+ *  \param store      \IN  0 = raw columns, else STORE | Z147COL_FL_xx
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 OpenOutput( char *dir, u_int32 store )
+{
+	char path[MAX_NAME];
+	const char *name;
+	u_int32 o;
+
+	if(store)
+		G_col = (Z147COL_WRITER**)calloc(G_numOut + 1, sizeof(*G_col));
+	else
+		G_raw = (FILE**)calloc(2 * G_numOut + 1, sizeof(FILE*));
+	if(G_col == NULL && G_raw == NULL){
+		printf("*** can't allocate buffers\n");
+		return -1;
+	}
+
+	for(o=0; o<G_numOut; o++){
+		name = G_plan->param[G_outParam[o]].name;
+		if(store){
+			snprintf(path, sizeof(path), "%s/%s%s", dir, name,
+					 Z147COL_EXT);
+			if((G_col[o] = Z147COL_Create(path, name, 0,
+										  store & ~STORE)) == NULL)
+				break;
+		}else{
+			snprintf(path, sizeof(path), "%s/%s.ts", dir, name);
+			if((G_raw[2*o] = fopen(path, "w")) == NULL)
+				break;
+			snprintf(path, sizeof(path), "%s/%s.val", dir, name);
+			if((G_raw[2*o+1] = fopen(path, "w")) == NULL)
+				break;
+		}
+	}
+	if(o < G_numOut){
+		printf("*** can't create %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+	return 0;
+}
+
+/********************************* CloseOutput *****************************/
+/** Finish and close the output files
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 CloseOutput( void )
+{
+	u_int32 o;
+	int32 error = 0;
+
+	for(o=0; o<G_numOut; o++){
+		if(G_col && G_col[o] && Z147COL_Finish(G_col[o]) != 0)
+			error = -1;
+		if(G_raw && G_raw[2*o] && fclose(G_raw[2*o]) != 0)
+			error = -1;
+		if(G_raw && G_raw[2*o+1] && fclose(G_raw[2*o+1]) != 0)
+			error = -1;
+	}
+	free(G_col);
+	free(G_raw);
+	G_col = NULL;
+	G_raw = NULL;
+	return error;
+}
+
+/********************************* WriteChunk ******************************/
+/** Append the columns of a chunk to the output files
+ *
+ *  \param ch         \IN  decoded chunk
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 WriteChunk( EX_CHUNK *ch )
+{
+	u_int32 o, n;
+
+	for(o=0; o<G_numOut; o++){
+		if((n = ch->num[o]) == 0)
+			continue;
+		if(G_col){
+			if(Z147COL_Append(G_col[o], ch->ts[o], ch->val[o], n) != 0)
+				return -1;
+		}else if(fwrite(ch->ts[o], sizeof(int64), n, G_raw[2*o]) != n ||
+				 fwrite(ch->val[o], sizeof(double), n, G_raw[2*o+1]) != n){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/********************************* FreeChunk *******************************/
+/** Free the columns of a chunk */
+static void FreeChunk( EX_CHUNK *ch )
+{
+	free(ch->mem);
+	ch->mem = NULL;
+	ch->num = NULL;
+	ch->ts  = NULL;
+	ch->val = NULL;
+}
+
+/********************************* SfFrame *********************************/
+/** Frame of the superframe
+ *
+ *  \return	          -1 = counter of the map, else from the counter of
+ *                    the file or the frame number
+ */
+static int32 SfFrame( const EX_FILE *f, const Z147FRM_FRAME *frm )
+{
+	if(G_plan->sfSub)
+		return -1;
+	if(f->sfMask)
+		return (int32)(((Z147FRM_DATA(frm)[f->sfPos] & f->sfMask) >>
+						f->sfShift) % Z147MAP_SF_FRAMES);
+	return (int32)(frm->seq % Z147MAP_SF_FRAMES);
+}
+
+/********************************* CmpFile *********************************/
+/** qsort compare: time of the first frame */
+static int CmpFile( const void *a, const void *b )
+{
+	const EX_FILE *x = (const EX_FILE*)a;
+	const EX_FILE *y = (const EX_FILE*)b;
+
+	if(x->firstNs != y->firstNs)
+		return x->firstNs < y->firstNs ? -1 : 1;
+	return 0;
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
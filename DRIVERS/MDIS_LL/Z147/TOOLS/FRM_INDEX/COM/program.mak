@@ -0,0 +1,27 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile definitions for the Z147 frame file index tool
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: program.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_frm_index
+
+MAK_LIBS=$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_frm$(LIB_SUFFIX)	\
+			$(LIB_PREFIX)$(MEN_LIB_DIR)/z147_pack$(LIB_SUFFIX)	\
+
+MAK_INCL=$(MEN_INC_DIR)/z147_rec.h	\
+         $(MEN_INC_DIR)/z147_frm.h	\
+         $(MEN_INC_DIR)/z147_pack.h	\
+         $(MEN_INC_DIR)/men_typs.h	\
+
+MAK_INP1=z147_frm_index$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
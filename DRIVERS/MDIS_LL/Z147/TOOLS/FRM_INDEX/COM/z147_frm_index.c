@@ -0,0 +1,431 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_FRM_INDEX                   ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_frm_index.c
+ *       \author Apatil
+ *
+ *       \brief  Convert recordings to indexed frame files and seek in them
+ *
+ *               Without -q, the frames of one channel of a z147_recorder
+ *               recording (format see z147_rec.h) are written to an
+ *               indexed frame file (format see z147_frm.h). Lost frames
+ *               show up as gaps in the frame numbers. Packed records
+ *               (#Z147REC_ST_PACKED) are unpacked.
+ *
+ *               With -q, the header and index of a frame file are shown
+ *               and -n frames are listed from the position given by -t
+ *               (seconds after the first frame) or -S (superframe). Only
+ *               the pages needed for the seek are read.
+ *
+ *     Required: libraries: z147_frm, z147_pack
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_frm_index.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_rec.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_pack.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define SHOW_WORDS          8           /**< words listed per frame */
+#define MAX_WORDS           32768       /**< frame words at 8192 words/s */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 Convert( char *out, char **files, u_int32 num, u_int32 chan,
+					  Z147FRM_HDR *hdr, u_int32 step );
+static int32 ConvertSegment( Z147FRM_WRITER *wr, char *name, u_int32 chan,
+							 Z147FRM_HDR *hdr, u_int32 *frames );
+static int32 Query( char *name, double tSec, int32 sf, u_int32 num );
+static void PrintTime( int64 ns );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *out = NULL;
+	char **files;
+	Z147FRM_HDR hdr;
+	u_int32 fileNum = 0, chan = 0, step = 0, num = 1;
+	int32 query = 0, sf = -1, i, rv;
+	double tSec = -1.0;
+
+	files = (char**)calloc(argc, sizeof(char*));
+	if(files == NULL)
+		return(1);
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.syncCfg = Z147FRM_UNKNOWN;
+	hdr.modeCfg = Z147FRM_UNKNOWN;
+
+	for(i=1; i<argc; i++){
+		if(strcmp(argv[i], "-q") == 0){
+			query = 1;
+		}else if(strncmp(argv[i], "-c=", 3) == 0){
+			chan = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-k=", 3) == 0){
+			step = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-y=", 3) == 0){
+			hdr.syncCfg = (u_int32)strtoul(argv[i] + 3, NULL, 0);
+		}else if(strncmp(argv[i], "-e=", 3) == 0){
+			hdr.modeCfg = (u_int32)strtoul(argv[i] + 3, NULL, 0);
+		}else if(strncmp(argv[i], "-w=", 3) == 0){
+			if(sscanf(argv[i] + 3, "%u,%u,%i", &hdr.sfSub, &hdr.sfWord,
+					  (int*)&hdr.sfMask) != 3)
+				break;
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			tSec = atof(argv[i] + 3);
+		}else if(strncmp(argv[i], "-S=", 3) == 0){
+			sf = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			num = (u_int32)atoi(argv[i] + 3);
+		}else if(argv[i][0] != '-' && out == NULL){
+			out = argv[i];
+		}else if(argv[i][0] != '-'){
+			files[fileNum++] = argv[i];
+		}else{
+			break;
+		}
+	}
+
+	if(i < argc || out == NULL || (!query && fileNum == 0) ||
+	   chan >= Z147REC_MAX_CH || hdr.sfSub > 4){
+		printf("Syntax: z147_frm_index [<opts>] <frmFile> <segment> "
+			   "[<segment>...]\n");
+		printf("        z147_frm_index -q [<opts>] <frmFile>\n");
+		printf("Function: convert a recording to an indexed frame file,\n");
+		printf("          seek in a frame file (-q)\n");
+		printf("Options (convert):\n");
+		printf("    -c=<n>     recorded channel                  [0]\n");
+		printf("    -k=<n>     frames per time index entry       [%u]\n",
+			   Z147FRM_TIDX_STEP);
+		printf("    -y=<cfg>   sync config of the receiver       [unknown]\n");
+		printf("    -e=<cfg>   receive mode of the receiver      [unknown]\n");
+		printf("    -w=<sub>,<word>,<mask>\n");
+		printf("               superframe counter location       "
+			   "[16 frames]\n");
+		printf("Options (query):\n");
+		printf("    -t=<s>     seek to seconds after first frame\n");
+		printf("    -S=<n>     seek to superframe n\n");
+		printf("    -n=<n>     frames listed                     [1]\n");
+		free(files);
+		return(1);
+	}
+
+	if(query)
+		rv = Query(out, tSec, sf, num);
+	else
+		rv = Convert(out, files, fileNum, chan, &hdr, step);
+
+	free(files);
+	return(rv == 0 ? 0 : 1);
+}
+
+/********************************* Convert *********************************/
+/** Convert the frames of one channel of a recording
+ *
+ *  \param out        \IN  frame file
+ *  \param files      \IN  segment files in recording order
+ *  \param num        \IN  number of segment files
+ *  \param chan       \IN  channel
+ *  \param hdr        \IN  sync, mode and superframe counter location
+ *  \param step       \IN  frames per time index entry
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 Convert( char *out, char **files, u_int32 num, u_int32 chan,
+					  Z147FRM_HDR *hdr, u_int32 step )
+{
+	Z147REC_FILE_HDR fh;
+	Z147FRM_WRITER *wr;
+	FILE *fp;
+	u_int32 i, frames = 0;
+	int32 error = 0;
+
+	/* data rate and name from the first segment */
+	if((fp = fopen(files[0], "rb")) == NULL ||
+	   fread(&fh, sizeof(fh), 1, fp) != 1){
+		printf("*** can't read %s: %s\n", files[0], strerror(errno));
+		if(fp)
+			fclose(fp);
+		return -1;
+	}
+	fclose(fp);
+	if(memcmp(fh.magic, Z147REC_FILE_MAGIC, sizeof(Z147REC_FILE_MAGIC)) != 0 ||
+	   fh.version != Z147REC_VERSION || chan >= fh.channels ||
+	   fh.rate[chan] > 7){
+		printf("*** %s: not a Z147 recording or no channel %u\n",
+			   files[0], chan);
+		return -1;
+	}
+	hdr->rate      = fh.rate[chan];
+	hdr->createdNs = fh.createdNs;
+	strncpy(hdr->name, fh.name[chan], Z147FRM_NAME_LEN - 1);
+
+	if((wr = Z147FRM_Create(out, hdr, step)) == NULL){
+		printf("*** can't create %s: %s\n", out, strerror(errno));
+		return -1;
+	}
+
+	for(i=0; i<num && error == 0; i++)
+		error = ConvertSegment(wr, files[i], chan, hdr, &frames);
+
+	if(Z147FRM_Finish(wr) != 0){
+		printf("*** can't write %s: %s\n", out, strerror(errno));
+		error = -1;
+	}
+	printf("%u frames of %s (%u words/s) written to %s\n",
+		   frames, hdr->name, 64u << hdr->rate, out);
+	return error;
+}
+
+/********************************* ConvertSegment **************************/
+/** Append the frames of one segment file
+ *
+ *  A damaged record ends the segment.
+ *
+ *  \param wr         \IN  frame file writer
+ *  \param name       \IN  segment file
+ *  \param chan       \IN  channel
+ *  \param hdr        \IN  frame file header (rate)
+ *  \param frames     \IN  frames so far, \OUT incremented
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 ConvertSegment( Z147FRM_WRITER *wr, char *name, u_int32 chan,
+							 Z147FRM_HDR *hdr, u_int32 *frames )
+{
+	static int haveFirst;
+	static u_int32 firstCnt, lastErrSigs;
+	static u_int16 unpacked[MAX_WORDS];
+	const u_int16 *data;
+	u_int32 words;
+	const Z147REC_FILE_HDR *fh;
+	const Z147REC_HDR *rec;
+	Z147FRM_FRAME frm;
+	struct stat st;
+	u_int8 *base;
+	size_t off;
+	int fd;
+	int32 error = 0;
+
+	if((fd = open(name, O_RDONLY)) < 0 || fstat(fd, &st) != 0){
+		printf("*** can't open %s: %s\n", name, strerror(errno));
+		if(fd >= 0)
+			close(fd);
+		return -1;
+	}
+	if(st.st_size < Z147REC_ALIGN){
+		close(fd);
+		printf("*** %s: no recording\n", name);
+		return -1;
+	}
+	base = (u_int8*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+						 fd, 0);
+	close(fd);
+	if(base == MAP_FAILED){
+		printf("*** can't map %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+	madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	fh = (const Z147REC_FILE_HDR*)base;
+	if(memcmp(fh->magic, Z147REC_FILE_MAGIC,
+			  sizeof(Z147REC_FILE_MAGIC)) != 0 ||
+	   fh->version != Z147REC_VERSION || fh->hdrSize != Z147REC_ALIGN ||
+	   chan >= fh->channels || fh->rate[chan] != hdr->rate){
+		printf("*** %s: not a segment of the same recording\n", name);
+		munmap(base, (size_t)st.st_size);
+		return -1;
+	}
+
+	for(off = Z147REC_ALIGN; off + sizeof(Z147REC_HDR) <= (size_t)st.st_size;
+		off += rec->size){
+		rec = (const Z147REC_HDR*)(base + off);
+		if(rec->magic != Z147REC_MAGIC || rec->size < sizeof(Z147REC_HDR) ||
+		   rec->size % Z147REC_REC_ALIGN ||
+		   off + rec->size > (size_t)st.st_size ||
+		   rec->dataLen > rec->size - sizeof(Z147REC_HDR)){
+			printf("*** %s: damaged record at %lu, rest skipped\n",
+				   name, (unsigned long)off);
+			break;
+		}
+		if(rec->type != Z147REC_TYPE_FRAME || rec->channel != chan)
+			continue;
+
+		if(!haveFirst){
+			firstCnt    = rec->frameCnt;
+			lastErrSigs = rec->errSigs;
+			haveFirst   = 1;
+		}
+		memset(&frm, 0, sizeof(frm));
+		frm.tsNs = rec->tsNs;
+		frm.seq  = rec->frameCnt - firstCnt;
+		frm.lost = rec->lost > 0xffff ? 0xffff : (u_int16)rec->lost;
+		if(rec->status & Z147REC_ST_INSYNC)
+			frm.status |= Z147FRM_ST_INSYNC;
+		if(rec->status & Z147REC_ST_TORN)
+			frm.status |= Z147FRM_ST_TORN;
+		if(rec->status & Z147REC_ST_LOST)
+			frm.status |= Z147FRM_ST_LOST;
+		if(rec->errSigs != lastErrSigs)
+			frm.status |= Z147FRM_ST_ERR;
+		lastErrSigs = rec->errSigs;
+
+		if(rec->status & Z147REC_ST_PACKED){
+			words = rec->dataLen * 2 / 3;
+			if(words > MAX_WORDS)
+				words = MAX_WORDS;
+			Z147PK_Unpack((const u_int8*)(rec + 1), unpacked, words);
+			data = unpacked;
+		}else{
+			words = rec->dataLen / 2;
+			data  = (const u_int16*)(rec + 1);
+		}
+
+		if(Z147FRM_Append(wr, &frm, data, words) != 0){
+			printf("*** write error: %s\n", strerror(errno));
+			error = -1;
+			break;
+		}
+		(*frames)++;
+	}
+
+	munmap(base, (size_t)st.st_size);
+	return error;
+}
+
+/********************************* Query ***********************************/
+/** Show a frame file and list frames from a time or superframe
+ *
+ *  \param name       \IN  frame file
+ *  \param tSec       \IN  seconds after the first frame (< 0: not used)
+ *  \param sf         \IN  superframe (< 0: not used)
+ *  \param num        \IN  frames to list
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 Query( char *name, double tSec, int32 sf, u_int32 num )
+{
+	Z147FRM_FILE *fp;
+	const Z147FRM_HDR *hdr;
+	const Z147FRM_FRAME *frm, *first;
+	const u_int16 *data;
+	u_int32 idx, i, w;
+	int32 pos;
+
+	if((fp = Z147FRM_Open(name)) == NULL){
+		printf("*** can't open %s: %s\n", name,
+			   errno == EINVAL ? "not a frame file" : strerror(errno));
+		return -1;
+	}
+	hdr = fp->hdr;
+
+	printf("file        %s\n", name);
+	printf("device      %s\n", hdr->name);
+	printf("rate        %u words/s, %u words/frame\n",
+		   64u << hdr->rate, hdr->frameWords);
+	if(hdr->syncCfg != Z147FRM_UNKNOWN)
+		printf("sync cfg    %u\n", hdr->syncCfg);
+	if(hdr->modeCfg != Z147FRM_UNKNOWN)
+		printf("mode cfg    %u\n", hdr->modeCfg);
+	if(hdr->sfSub)
+		printf("superframe  subframe %u word %u mask 0x%03x\n",
+			   hdr->sfSub, hdr->sfWord, hdr->sfMask);
+	printf("frames      %u\n", fp->frames);
+	if(fp->tIdx)
+		printf("index       %u time entries, %u superframes, "
+			   "%u counter errors\n", fp->tIdxNum, fp->sfIdxNum,
+			   fp->sfErrNum);
+	else
+		printf("index       none (file not finished)\n");
+
+	if(fp->frames == 0){
+		Z147FRM_Close(fp);
+		return 0;
+	}
+	first = Z147FRM_Frame(fp, 0);
+	printf("first frame ");
+	PrintTime(first->tsNs);
+	printf("\nlast frame  ");
+	PrintTime(Z147FRM_Frame(fp, fp->frames - 1)->tsNs);
+	printf("\n");
+
+	if(sf >= 0){
+		if((pos = Z147FRM_SeekSuperframe(fp, (u_int32)sf)) < 0){
+			printf("*** no superframe %d\n", sf);
+			Z147FRM_Close(fp);
+			return -1;
+		}
+		idx = (u_int32)pos;
+	}else if(tSec >= 0.0){
+		idx = Z147FRM_SeekTime(fp, first->tsNs + (int64)(tSec * 1e9));
+	}else{
+		Z147FRM_Close(fp);
+		return 0;
+	}
+
+	printf("\n   frame      seq   time [s]  sf status   words\n");
+	for(i=0; i<num && idx + i < fp->frames; i++){
+		frm  = Z147FRM_Frame(fp, idx + i);
+		data = Z147FRM_DATA(frm);
+		printf("%8u %8u %10.3f %3d %c%c%c%c%c  ", idx + i, frm->seq,
+			   (double)(frm->tsNs - first->tsNs) / 1e9,
+			   (int)Z147FRM_Superframe(fp, idx + i),
+			   frm->status & Z147FRM_ST_INSYNC ? 'S' : '-',
+			   frm->status & Z147FRM_ST_TORN   ? 'T' : '-',
+			   frm->status & Z147FRM_ST_LOST   ? 'L' : '-',
+			   frm->status & Z147FRM_ST_SHORT  ? 'H' : '-',
+			   frm->status & Z147FRM_ST_ERR    ? 'E' : '-');
+		for(w=0; w<SHOW_WORDS; w++)
+			printf(" %03x", data[w]);
+		printf("\n");
+	}
+
+	Z147FRM_Close(fp);
+	return 0;
+}
+
+/********************************* PrintTime *******************************/
+/** Print a UTC time stamp
+ *
+ *  \param ns         \IN  ns since 1970
+ */
+static void PrintTime( int64 ns )
+{
+	time_t sec = (time_t)(ns / 1000000000);
+	struct tm tm;
+	char buf[32];
+
+	gmtime_r(&sec, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+	printf("%s.%03u UTC", buf, (unsigned)(ns / 1000000 % 1000));
+}
@@ -0,0 +1,512 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_JITTER_TEST                 ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_jitter_test.c
+ *       \author Apatil
+ *
+ *       \brief  Z147 frame period and jitter analyzer
+ *
+ *               Measures the arrival time of every received frame with
+ *               microsecond resolution. The signal handler only takes the
+ *               time stamp and posts a semaphore, a reader thread fetches
+ *               the frame into a preallocated buffer. The signal-to-data
+ *               latency of the reader is measured as well.
+ *
+ *               For each data rate the tool prints the frame period
+ *               statistics, a histogram of the deviation from the nominal
+ *               frame time (4 s), the Allan deviation of the frame clock and
+ *               the drift of the received rate against the nominal rate.
+ *               With -o all time stamps are exported as CSV:
+ *
+ *               rate_wps,frame,t_us,period_us,dev_us,read_us
+ *
+ *     Required: libraries: mdis_api, usr_oss, pthread
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_jitter_test.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define Z147_FRAME_TIME_US  4000000     /**< nominal frame time in us */
+#define MAX_DATA_LEN        32768       /**< frame length at 8192 words/s */
+#define SIG_RING            64          /**< pending signal time stamps */
+#define SKIP_FRAMES         2           /**< frames ignored after sync */
+#define HIST_HALF           10          /**< histogram bins per side */
+#define MAX_ADEV            16          /**< max. Allan deviation taus */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** one received frame */
+typedef struct {
+	int64   tUs;                /**< signal time stamp */
+	int64   readUs;             /**< signal -> frame copied */
+	int32   len;                /**< M_getblock() result */
+} JT_SAMPLE;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static MDIS_PATH G_rxPath;
+static sem_t G_sigSem;
+static int64 G_sigTs[SIG_RING];             /**< written by signal handler */
+static volatile u_int32 G_sigHead;          /**< signal handler index */
+static u_int32 G_sigTail;                   /**< reader thread index */
+static volatile u_int32 G_sigLost;          /**< ring overflows */
+static volatile u_int32 G_errSigs;          /**< receive error signals */
+static volatile int G_stop;
+
+static JT_SAMPLE *G_sample;                 /**< preallocated samples */
+static volatile u_int32 G_sampleNum;        /**< samples of current rate */
+static u_int32 G_sampleMax;                 /**< allocated samples */
+static u_int16 *G_rxData;                   /**< preallocated frame buffer */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void PrintError(char *info);
+static void __MAPILIB SignalHandler( u_int32 sig );
+static void *ReaderThread( void *arg );
+static int64 NowUs( void );
+static int32 RunRate( int32 dataRate, u_int32 frames, u_int32 binUs,
+					  FILE *csv );
+static void Analyze( int32 dataRate, JT_SAMPLE *smp, u_int32 num,
+					 u_int32 binUs, FILE *csv );
+static double AllanDev( JT_SAMPLE *smp, u_int32 num, u_int32 m );
+static double Sqrt( double x );
+static int CmpI64( const void *a, const void *b );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *rxDevice = NULL;
+	char *csvName = NULL;
+	FILE *csv = NULL;
+	pthread_t reader;
+	int32 dataRate = -1;
+	u_int32 frames = 20;
+	u_int32 binUs = 100;
+	int32 errors = 0;
+	int32 i, r;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			dataRate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			frames = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-b=", 3) == 0){
+			binUs = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-o=", 3) == 0){
+			csvName = argv[i] + 3;
+		}else if(argv[i][0] != '-' && rxDevice == NULL){
+			rxDevice = argv[i];
+		}else{
+			rxDevice = NULL;
+			break;
+		}
+	}
+
+	if(rxDevice == NULL || frames < 3 || binUs == 0){
+		printf("Syntax: z147_jitter_test <rxDevice> [<opts>]\n");
+		printf("Function: Z147 frame period and jitter analyzer\n");
+		printf("Options:\n");
+		printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [all]\n");
+		printf("    -n=<n>     frame periods per rate (>=3)      [20]\n");
+		printf("    -b=<us>    histogram bin width in us         [100]\n");
+		printf("    -o=<file>  export time stamps as CSV\n");
+		return(1);
+	}
+
+	if(csvName){
+		if((csv = fopen(csvName, "w")) == NULL){
+			printf("*** can't create %s\n", csvName);
+			return(1);
+		}
+		fprintf(csv, "rate_wps,frame,t_us,period_us,dev_us,read_us\n");
+	}
+
+	/* all memory is allocated before the measurement */
+	G_sampleMax = frames + SKIP_FRAMES + 1;
+	G_sample = (JT_SAMPLE*)calloc(G_sampleMax, sizeof(JT_SAMPLE));
+	G_rxData = (u_int16*)calloc(MAX_DATA_LEN, sizeof(u_int16));
+	if(G_sample == NULL || G_rxData == NULL || sem_init(&G_sigSem, 0, 0) != 0){
+		printf("*** can't allocate buffers\n");
+		return(1);
+	}
+
+	/*--------------------+
+	|  open               |
+	+--------------------*/
+	if((G_rxPath = M_open(rxDevice)) < 0){
+		PrintError("open");
+		return(1);
+	}
+
+	UOS_SigInit( SignalHandler );
+	UOS_SigInstall( UOS_SIG_USR1 );
+	UOS_SigInstall( UOS_SIG_USR2 );
+
+	if(M_setstat(G_rxPath, Z147_SET_SIGNAL, UOS_SIG_USR1) < 0 ||
+	   M_setstat(G_rxPath, Z147_SET_ERR_SIGNAL, UOS_SIG_USR2) < 0){
+		PrintError("setstat");
+		errors++;
+		goto CLEANUP;
+	}
+
+	if(pthread_create(&reader, NULL, ReaderThread, NULL) != 0){
+		printf("*** can't create reader thread\n");
+		errors++;
+		goto CLEANUP;
+	}
+
+	for(r=Z147_RX_DATA_RATE_64; r<=Z147_RX_DATA_RATE_8192; r++){
+		if(dataRate < 0 || dataRate == r)
+			errors += RunRate(r, frames, binUs, csv);
+	}
+
+	G_stop = 1;
+	sem_post(&G_sigSem);
+	pthread_join(reader, NULL);
+
+	printf("Signal time stamps lost: %u, error signals: %u\n",
+		   G_sigLost, G_errSigs);
+	printf("Test Result : %s\n", errors ? "FAILED" : "PASSED");
+
+CLEANUP:
+	M_setstat(G_rxPath, Z147_CLR_SIGNAL, 0);
+	M_setstat(G_rxPath, Z147_CLR_ERR_SIGNAL, 0);
+	UOS_SigRemove( UOS_SIG_USR1 );
+	UOS_SigRemove( UOS_SIG_USR2 );
+	UOS_SigExit();
+	if(M_close(G_rxPath) < 0)
+		PrintError("close");
+
+	if(csv)
+		fclose(csv);
+	sem_destroy(&G_sigSem);
+	free(G_sample);
+	free(G_rxData);
+
+	return(errors ? 1 : 0);
+}
+
+/********************************* RunRate *********************************/
+/** Collect and analyze the frame times of one data rate
+ *
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param frames     \IN  frame periods to measure
+ *  \param binUs      \IN  histogram bin width
+ *  \param csv        \IN  CSV file or NULL
+ *
+ *  \return	          0 or 1 on error
+ */
+static int32 RunRate( int32 dataRate, u_int32 frames, u_int32 binUs,
+					  FILE *csv )
+{
+	u_int32 need = frames + SKIP_FRAMES + 1;
+	u_int32 timeout, start;
+	u_int32 i, bad = 0;
+
+	printf("################ rate %u words/s ################\n",
+		   64 << dataRate);
+
+	/* the reader stores nothing while G_sampleNum is at the limit */
+	G_sampleNum = G_sampleMax;
+	if(M_setstat(G_rxPath, Z147_RX_DATA_RATE, dataRate) < 0){
+		PrintError("set data rate");
+		return 1;
+	}
+	G_sampleNum = 0;
+
+	/* sync takes up to two frames */
+	timeout = (need + 3) * (Z147_FRAME_TIME_US / 1000);
+	start = UOS_MsecTimerGet();
+	while(G_sampleNum < need && UOS_MsecTimerGet() - start < timeout)
+		UOS_Delay(100);
+
+	if(G_sampleNum < need){
+		printf("*** only %u of %u frames received\n", G_sampleNum, need);
+		return 1;
+	}
+
+	for(i=SKIP_FRAMES; i<need; i++){
+		if(G_sample[i].len != 8 * (64 << dataRate))
+			bad++;
+	}
+	if(bad)
+		printf("*** %u frames with wrong length\n", bad);
+
+	Analyze(dataRate, G_sample + SKIP_FRAMES, frames + 1, binUs, csv);
+	return bad ? 1 : 0;
+}
+
+/********************************* Analyze *********************************/
+/** Print the statistics of one data rate
+ *
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param smp        \IN  samples
+ *  \param num        \IN  number of samples (>= 4)
+ *  \param binUs      \IN  histogram bin width
+ *  \param csv        \IN  CSV file or NULL
+ */
+static void Analyze( int32 dataRate, JT_SAMPLE *smp, u_int32 num,
+					 u_int32 binUs, FILE *csv )
+{
+	u_int32 hist[2 * HIST_HALF + 3];
+	int64 *sorted;
+	int64 period, dev, minDev = 0, maxDev = 0;
+	double sum = 0.0, sumSq = 0.0, mean, std;
+	double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, slope, drift;
+	u_int32 i, m, n = num - 1;
+	int32 bin;
+
+	memset(hist, 0, sizeof(hist));
+	sorted = (int64*)malloc(num * sizeof(int64));
+
+	for(i=0; i<num; i++){
+		/* time stamps relative to the first one, for the regression */
+		sx  += i;
+		sy  += (double)(smp[i].tUs - smp[0].tUs);
+		sxx += (double)i * i;
+		sxy += (double)i * (smp[i].tUs - smp[0].tUs);
+		if(sorted)
+			sorted[i] = smp[i].readUs;
+
+		if(i == 0){
+			if(csv)
+				fprintf(csv, "%u,%u,%lld,,,%lld\n", 64 << dataRate, i,
+						(long long)smp[i].tUs, (long long)smp[i].readUs);
+			continue;
+		}
+
+		period = smp[i].tUs - smp[i-1].tUs;
+		dev = period - Z147_FRAME_TIME_US;
+		sum += dev;
+		sumSq += (double)dev * dev;
+		if(i == 1 || dev < minDev)
+			minDev = dev;
+		if(i == 1 || dev > maxDev)
+			maxDev = dev;
+
+		/* bin 0: underflow, bin 2*HIST_HALF+2: overflow */
+		bin = (int32)((dev + (int64)binUs / 2 + (int64)binUs * (HIST_HALF + 1))
+					  / (int64)binUs);
+		if(dev + (int64)binUs / 2 + (int64)binUs * (HIST_HALF + 1) < 0)
+			bin = 0;
+		if(bin > 2 * HIST_HALF + 2)
+			bin = 2 * HIST_HALF + 2;
+		hist[bin]++;
+
+		if(csv)
+			fprintf(csv, "%u,%u,%lld,%lld,%lld,%lld\n", 64 << dataRate, i,
+					(long long)smp[i].tUs, (long long)period, (long long)dev,
+					(long long)smp[i].readUs);
+	}
+
+	mean = sum / n;
+	std  = Sqrt(sumSq / n - mean * mean);
+
+	/* least squares frame period over all time stamps */
+	slope = (num * sxy - sx * sy) / (num * sxx - sx * sx);
+	drift = (slope - Z147_FRAME_TIME_US) * 1e6 / Z147_FRAME_TIME_US;
+
+	printf("  periods     : %u, mean %.1f us, std %.1f us, min %+lld us, "
+		   "max %+lld us (vs. %u us)\n", n, Z147_FRAME_TIME_US + mean, std,
+		   (long long)minDev, (long long)maxDev, Z147_FRAME_TIME_US);
+	printf("  drift       : %+.2f ppm, %.4f words/s (nominal %u)\n",
+		   drift, (4.0 * (64 << dataRate)) * 1e6 / slope, 64 << dataRate);
+
+	if(sorted){
+		qsort(sorted, num, sizeof(int64), CmpI64);
+		printf("  read        : p50 %lld us, max %lld us (signal -> data)\n",
+			   (long long)sorted[num / 2], (long long)sorted[num - 1]);
+		free(sorted);
+	}
+
+	printf("  deviation histogram (bin %u us):\n", binUs);
+	for(i=0; i<2 * HIST_HALF + 3; i++){
+		if(hist[i] == 0)
+			continue;
+		if(i == 0)
+			printf("    < %+7d us : %u\n",
+				   -(int32)(binUs * HIST_HALF + binUs / 2), hist[i]);
+		else if(i == 2 * HIST_HALF + 2)
+			printf("    > %+7d us : %u\n",
+				   (int32)(binUs * HIST_HALF + binUs / 2), hist[i]);
+		else
+			printf("    %+9d us : %u\n",
+				   ((int32)i - HIST_HALF - 1) * (int32)binUs, hist[i]);
+	}
+
+	printf("  Allan deviation:\n");
+	for(m=1, i=0; 2 * m < num && i < MAX_ADEV; m *= 2, i++)
+		printf("    tau %6u s : %.3e\n", m * (Z147_FRAME_TIME_US / 1000000),
+			   AllanDev(smp, num, m));
+	fflush(stdout);
+}
+
+/********************************* AllanDev ********************************/
+/** Overlapping Allan deviation of the frame clock
+ *
+ *  Computed from the time error x[i] = t[i] - i * T against the nominal
+ *  frame time T, tau = m * T.
+ *
+ *  \param smp        \IN  samples
+ *  \param num        \IN  number of samples
+ *  \param m          \IN  averaging factor
+ *
+ *  \return	          Allan deviation (fractional frequency)
+ */
+static double AllanDev( JT_SAMPLE *smp, u_int32 num, u_int32 m )
+{
+	double sum = 0.0, d, tau;
+	double x0, x1, x2;
+	u_int32 i;
+
+	for(i=0; i + 2 * m < num; i++){
+		x0 = (double)(smp[i].tUs - smp[0].tUs) -
+			 (double)i * Z147_FRAME_TIME_US;
+		x1 = (double)(smp[i+m].tUs - smp[0].tUs) -
+			 (double)(i + m) * Z147_FRAME_TIME_US;
+		x2 = (double)(smp[i+2*m].tUs - smp[0].tUs) -
+			 (double)(i + 2 * m) * Z147_FRAME_TIME_US;
+		d = x2 - 2 * x1 + x0;
+		sum += d * d;
+	}
+	tau = (double)m * Z147_FRAME_TIME_US;
+	return Sqrt(sum / (2.0 * tau * tau * (num - 2 * m)));
+}
+
+/********************************* ReaderThread ****************************/
+/** Fetch a frame for every signal time stamp
+ *
+ *  \param arg        \IN  not used
+ *
+ *  \return	          NULL
+ */
+static void *ReaderThread( void *arg )
+{
+	JT_SAMPLE *s;
+	int64 t;
+	int32 len;
+
+	while(1){
+		while(sem_wait(&G_sigSem) != 0 && errno == EINTR)
+			;
+		if(G_stop)
+			break;
+
+		t = G_sigTs[G_sigTail % SIG_RING];
+		G_sigTail++;
+
+		len = M_getblock(G_rxPath, (u_int8*)G_rxData,
+						 MAX_DATA_LEN * sizeof(u_int16));
+
+		if(G_sampleNum < G_sampleMax){
+			s = &G_sample[G_sampleNum];
+			s->tUs    = t;
+			s->readUs = NowUs() - t;
+			s->len    = len;
+			G_sampleNum++;
+		}
+	}
+	return NULL;
+}
+
+/********************************* NowUs ***********************************/
+/** Monotonic time in us (async signal safe) */
+static int64 NowUs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/********************************* Sqrt ************************************/
+/** Square root (Newton), avoids linking the math library */
+static double Sqrt( double x )
+{
+	double r = x;
+	int i;
+
+	if(x <= 0.0)
+		return 0.0;
+	if(r < 1.0)
+		r = 1.0;
+	for(i=0; i<64; i++)
+		r = 0.5 * (r + x / r);
+	return r;
+}
+
+/********************************* CmpI64 **********************************/
+/** qsort compare function for int64 */
+static int CmpI64( const void *a, const void *b )
+{
+	int64 x = *(const int64*)a, y = *(const int64*)b;
+
+	return (x > y) - (x < y);
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/****************************** SignalHandler ******************************/
+/** Signal handler: time stamp the frame and wake up the reader
+ *
+ *  Only async signal safe calls, no printf and no driver access.
+ *
+ *  \param  sig    \IN   received signal
+ */
+static void __MAPILIB SignalHandler( u_int32 sig )
+{
+	u_int32 head = G_sigHead;
+
+	if(sig == UOS_SIG_USR1){
+		if(head - G_sigTail < SIG_RING){
+			G_sigTs[head % SIG_RING] = NowUs();
+			G_sigHead = head + 1;
+			sem_post(&G_sigSem);
+		}else{
+			G_sigLost++;
+		}
+	}else if(sig == UOS_SIG_USR2){
+		G_errSigs++;
+	}
+}
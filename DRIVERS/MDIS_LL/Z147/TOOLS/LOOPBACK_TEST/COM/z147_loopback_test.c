@@ -0,0 +1,726 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_LOOPBACK_TEST               ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_loopback_test.c
+ *       \author Apatil
+ *
+ *       \brief  Z147/Z247 loopback bit error rate and throughput test
+ *
+ *               The transmitter is switched to loopback mode (Z247_LOOPBACK)
+ *               and sends one new frame per frame time. Every sub frame
+ *               carries a 24 bit frame sequence number in its first two
+ *               data words, followed by a PRBS-15 pattern seeded by the
+ *               sequence number and the sub frame index. Each received sub
+ *               frame is therefore checked on its own, independent of where
+ *               the receive driver splits the frames.
+ *
+ *               For each data rate and receiver sync mode the tool reports
+ *               the bit and word error rate, lost and repeated frames, sync
+ *               losses, the latency from M_setblock() to M_getblock() of a
+ *               frame (p50/p99/max) and the sustained received words per
+ *               second. With -n=0 the sweep is repeated until Ctrl-C.
+ *
+ *     Required: libraries: mdis_api, usr_oss
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_loopback_test.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z247_drv.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define Z147_FRAME_TIME     4000        /**< frame time in ms (all rates) */
+#define MAX_DATA_LEN        32768       /**< frame length at 8192 words/s */
+#define POLL_TIME           10          /**< main loop poll time in ms */
+#define SEQ_WIN             64          /**< tracked frame sequence numbers */
+#define SEQ_MASK            0xFFFFFF    /**< 24 bit sequence number */
+#define LAT_BINS            30000       /**< latency histogram (1 ms bins) */
+#define SUB_ALL             0xF         /**< all four sub frames received */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** test statistics */
+typedef struct {
+	u_int64 words;              /**< checked words */
+	u_int64 wordErrs;           /**< words with bit errors */
+	u_int64 bitErrs;            /**< bit errors */
+	u_int32 framesTx;           /**< written frames */
+	u_int32 framesOk;           /**< frames with all sub frames received */
+	u_int32 framesLost;         /**< frames not received at all */
+	u_int32 subLost;            /**< missing sub frames of received frames */
+	u_int32 subRepeat;          /**< sub frames received twice */
+	u_int32 syncLosses;         /**< in sync -> out of sync transitions */
+	u_int32 errSigs;            /**< receive error signals */
+	u_int32 readErrs;           /**< failed M_getblock() */
+	u_int32 rxMs;               /**< receive time in ms */
+	u_int32 latNum;             /**< latency samples */
+	u_int32 lat[LAT_BINS];      /**< latency histogram in ms */
+} LB_STATS;
+
+/** frame sequence number state */
+typedef struct {
+	u_int32 nextSeq;            /**< next sequence number to send */
+	u_int32 firstSeq;           /**< first checked sequence number */
+	u_int32 pacedSeq;           /**< first frame written after a receive */
+	int32   paced;              /**< writes follow the received frames */
+	u_int32 lastGood;           /**< last verified sequence number */
+	int32   locked;             /**< first error free sub frame received */
+	int32   draining;           /**< writing stopped, repeats expected */
+	u_int32 slotSeq[SEQ_WIN];   /**< sequence number of slot */
+	u_int32 slotMs[SEQ_WIN];    /**< write time of slot */
+	u_int8  slotMask[SEQ_WIN];  /**< received sub frames of slot */
+} LB_SEQ;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static volatile u_int32 G_rxSigCnt;
+static volatile u_int32 G_errSigCnt;
+static volatile int G_stop;
+static LB_STATS G_combo;
+static LB_STATS G_total;
+static LB_SEQ G_seq;
+static u_int16 G_txData[MAX_DATA_LEN];
+static u_int16 G_rxData[MAX_DATA_LEN];
+
+static const u_int16 G_syncWord[4] = {
+	Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+	Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+};
+
+static const char *G_syncName[] = { "none", "part", "full" };
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void PrintError(char *info);
+static void __MAPILIB SignalHandler( u_int32 sig );
+static void StopHandler( int sig );
+static int32 RunCombo( MDIS_PATH rxPath, MDIS_PATH txPath, int32 dataRate,
+					   int32 syncMode, u_int32 testMs, u_int32 statusMs );
+static int32 WriteFrame( MDIS_PATH txPath, u_int32 sfs, u_int32 now );
+static void CheckFrame( u_int16 *buf, u_int32 sfs, u_int32 now );
+static u_int32 CheckSub( u_int16 *w, u_int32 sfs, u_int32 sub, u_int32 seq,
+						 u_int32 *wordErrsP );
+static void MarkSub( u_int32 seq, u_int32 sub, u_int32 now );
+static void Finalize( u_int32 seq );
+static void PrintStats( const char *name, LB_STATS *st );
+static void AddStats( LB_STATS *dst, LB_STATS *src );
+static u_int32 LatPercentile( LB_STATS *st, u_int32 pct );
+static u_int16 Prbs15( u_int32 *stateP );
+static u_int32 PrbsSeed( u_int32 seq, u_int32 sub );
+static u_int32 BitCount( u_int32 x );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *rxDevice = NULL;
+	char *txDevice = NULL;
+	MDIS_PATH rxPath = -1, txPath = -1;
+	int32 dataRate = -1;
+	int32 syncMode = -1;
+	u_int32 testSec = 60;
+	u_int32 statusSec = 10;
+	u_int32 loops = 1;
+	u_int32 loop;
+	int32 errors = 0;
+	int32 i, r, m;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			dataRate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-m=", 3) == 0){
+			syncMode = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			testSec = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-s=", 3) == 0){
+			statusSec = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			loops = (u_int32)atoi(argv[i] + 3);
+		}else if(argv[i][0] != '-' && rxDevice == NULL){
+			rxDevice = argv[i];
+		}else if(argv[i][0] != '-' && txDevice == NULL){
+			txDevice = argv[i];
+		}else{
+			rxDevice = NULL;
+			break;
+		}
+	}
+
+	if(rxDevice == NULL || txDevice == NULL ||
+	   (syncMode >= 0 && (syncMode < 1 || syncMode > 2))){
+		printf("Syntax: z147_loopback_test <rxDevice> <txDevice> [<opts>]\n");
+		printf("Function: Z147/Z247 loopback bit error rate and throughput test\n");
+		printf("Options:\n");
+		printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [all]\n");
+		printf("    -m=<mode>  RX sync mode 1=part 2=full        [both]\n");
+		printf("    -t=<sec>   test time per combination         [60]\n");
+		printf("    -s=<sec>   status interval (0=none)          [10]\n");
+		printf("    -n=<n>     number of sweeps (0=until Ctrl-C) [1]\n");
+		return(1);
+	}
+
+	/*--------------------+
+	|  open               |
+	+--------------------*/
+	if((rxPath = M_open(rxDevice)) < 0){
+		PrintError("open rx");
+		return(1);
+	}
+	if((txPath = M_open(txDevice)) < 0){
+		PrintError("open tx");
+		M_close(rxPath);
+		return(1);
+	}
+
+	UOS_SigInit( SignalHandler );
+	UOS_SigInstall( UOS_SIG_USR1 );
+	UOS_SigInstall( UOS_SIG_USR2 );
+	signal( SIGINT, StopHandler );
+
+	if(M_setstat(rxPath, Z147_SET_SIGNAL, UOS_SIG_USR1) < 0 ||
+	   M_setstat(rxPath, Z147_SET_ERR_SIGNAL, UOS_SIG_USR2) < 0 ||
+	   M_setstat(txPath, Z247_LOOPBACK, 1) < 0){
+		PrintError("setstat");
+		errors++;
+		goto CLEANUP;
+	}
+
+	memset(&G_total, 0, sizeof(G_total));
+
+	/*--------------------+
+	|  sweep              |
+	+--------------------*/
+	for(loop=0; (loops == 0 || loop < loops) && !G_stop; loop++){
+		for(r=Z147_RX_DATA_RATE_64; r<=Z147_RX_DATA_RATE_8192 && !G_stop; r++){
+			if(dataRate >= 0 && dataRate != r)
+				continue;
+			for(m=1; m<=2 && !G_stop; m++){
+				if(syncMode >= 0 && syncMode != m)
+					continue;
+				errors += RunCombo(rxPath, txPath, r, m, testSec * 1000,
+								   statusSec * 1000);
+				AddStats(&G_total, &G_combo);
+			}
+		}
+	}
+
+	printf("-------------------------------------------\n");
+	PrintStats("total", &G_total);
+	printf("Test Result : %s\n", errors ? "FAILED" : "PASSED");
+	printf("-------------------------------------------\n");
+
+CLEANUP:
+	M_setstat(txPath, Z247_LOOPBACK, 0);
+	M_setstat(rxPath, Z147_CLR_SIGNAL, 0);
+	M_setstat(rxPath, Z147_CLR_ERR_SIGNAL, 0);
+	UOS_SigRemove( UOS_SIG_USR1 );
+	UOS_SigRemove( UOS_SIG_USR2 );
+	UOS_SigExit();
+
+	if(M_close(txPath) < 0)
+		PrintError("close tx");
+	if(M_close(rxPath) < 0)
+		PrintError("close rx");
+
+	return(errors ? 1 : 0);
+}
+
+/********************************* RunCombo ********************************/
+/** Run the test for one data rate and sync mode
+ *
+ *  \param rxPath     \IN  receiver path
+ *  \param txPath     \IN  transmitter path
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param syncMode   \IN  RX sync mode (1=part, 2=full)
+ *  \param testMs     \IN  test time in ms
+ *  \param statusMs   \IN  status interval in ms (0=none)
+ *
+ *  \return	          0 or 1 on error
+ */
+static int32 RunCombo( MDIS_PATH rxPath, MDIS_PATH txPath, int32 dataRate,
+					   int32 syncMode, u_int32 testMs, u_int32 statusMs )
+{
+	LB_STATS *st = &G_combo;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 now, startMs, endMs, nextWrite, nextStatus;
+	u_int32 lastSig, lastErrSig, s;
+	int32 inSync, wasSync = 0;
+	int32 nbr, error = 0;
+
+	memset(st, 0, sizeof(*st));
+	memset(&G_seq, 0, sizeof(G_seq));
+
+	printf("################ rate %u words/s, sync %s ################\n",
+		   64 << dataRate, G_syncName[syncMode]);
+
+	/* sync mode first: it stops reception until the rate is set */
+	if(M_setstat(rxPath, Z147_RX_SYNC_CFG, syncMode) < 0 ||
+	   M_setstat(txPath, Z247_TX_DATA_RATE, dataRate) < 0 ||
+	   M_setstat(rxPath, Z147_RX_DATA_RATE, dataRate) < 0){
+		PrintError("configure");
+		return 1;
+	}
+
+	lastSig = G_rxSigCnt;
+	lastErrSig = G_errSigCnt;
+	startMs = now = UOS_MsecTimerGet();
+	endMs = startMs + testMs;
+	nextWrite = now;
+	nextStatus = now + statusMs;
+
+	/* test time plus two frame times to receive the last frames */
+	while((int32)(now - (endMs + 2 * Z147_FRAME_TIME)) < 0 && !G_stop){
+		if((int32)(now - endMs) >= 0)
+			G_seq.draining = 1;
+
+		if(G_rxSigCnt != lastSig){
+			lastSig = G_rxSigCnt;
+			nbr = M_getblock(rxPath, (u_int8*)G_rxData, sizeof(G_rxData));
+			if(nbr == (int32)(8 * sfs)){
+				CheckFrame(G_rxData, sfs, now);
+			}else{
+				st->readErrs++;
+			}
+			/* write in the middle of the transmitted frame */
+			nextWrite = now + Z147_FRAME_TIME / 2;
+			if(!G_seq.paced){
+				G_seq.paced = 1;
+				G_seq.pacedSeq = G_seq.nextSeq;
+			}
+		}
+
+		if(!G_seq.draining && (int32)(now - nextWrite) >= 0){
+			if(WriteFrame(txPath, sfs, now) < 0){
+				PrintError("write");
+				error = 1;
+				break;
+			}
+			nextWrite += Z147_FRAME_TIME;
+		}
+
+		if(G_errSigCnt != lastErrSig){
+			st->errSigs += G_errSigCnt - lastErrSig;
+			lastErrSig = G_errSigCnt;
+		}
+		if(M_getstat(rxPath, Z147_RX_IN_SYNC, &inSync) == 0){
+			if(wasSync && !inSync)
+				st->syncLosses++;
+			wasSync = inSync;
+		}
+
+		if(statusMs && (int32)(now - nextStatus) >= 0){
+			nextStatus += statusMs;
+			printf("  %6us: tx %u ok %u lost %u, sync losses %u, "
+				   "word errors %llu\n", (now - startMs) / 1000,
+				   st->framesTx, st->framesOk, st->framesLost,
+				   st->syncLosses, (unsigned long long)st->wordErrs);
+			fflush(stdout);
+		}
+
+		UOS_Delay(POLL_TIME);
+		now = UOS_MsecTimerGet();
+	}
+	st->rxMs = now - startMs;
+
+	/* evaluate the frames still in the window */
+	for(s = (G_seq.nextSeq > SEQ_WIN / 2) ? G_seq.nextSeq - SEQ_WIN / 2 : 0;
+		s < G_seq.nextSeq; s++)
+		Finalize(s);
+
+	PrintStats("result", st);
+	if(!G_seq.locked)
+		printf("*** no error free frame received\n");
+
+	if(error || !G_seq.locked || st->wordErrs || st->framesLost ||
+	   st->subLost || st->readErrs)
+		return 1;
+	return 0;
+}
+
+/********************************* WriteFrame ******************************/
+/** Build and write the next frame
+ *
+ *  \param txPath     \IN  transmitter path
+ *  \param sfs        \IN  sub frame size in words
+ *  \param now        \IN  current time in ms
+ *
+ *  \return	          M_setblock() result
+ */
+static int32 WriteFrame( MDIS_PATH txPath, u_int32 sfs, u_int32 now )
+{
+	u_int32 seq = G_seq.nextSeq;
+	u_int32 slot = seq % SEQ_WIN;
+	u_int32 sub, i, state;
+	u_int16 *w;
+	int32 result;
+
+	/* the transmitter inserts the sync words */
+	for(sub=0; sub<4; sub++){
+		w = G_txData + sub * (sfs - 1);
+		w[0] = (u_int16)(seq & 0xFFF);
+		w[1] = (u_int16)((seq >> 12) & 0xFFF);
+		state = PrbsSeed(seq, sub);
+		for(i=2; i<sfs-1; i++)
+			w[i] = Prbs15(&state);
+	}
+
+	result = M_setblock(txPath, (u_int8*)G_txData, (4 * sfs - 4) * 2);
+	if(result < 0)
+		return result;
+
+	/* the slot is reused: evaluate its frame */
+	if(seq >= SEQ_WIN / 2)
+		Finalize(seq - SEQ_WIN / 2);
+
+	G_seq.slotSeq[slot]  = seq;
+	G_seq.slotMs[slot]   = now;
+	G_seq.slotMask[slot] = 0;
+	G_seq.nextSeq = (seq + 1) & SEQ_MASK;
+	G_combo.framesTx++;
+
+	return result;
+}
+
+/********************************* CheckFrame ******************************/
+/** Check the four sub frames of a received frame
+ *
+ *  The sequence number of a sub frame is trusted if it was sent recently,
+ *  else the better matching of the last verified number and its successor
+ *  is used, so that bit errors in the sequence words are counted like any
+ *  other bit error.
+ *
+ *  \param buf        \IN  frame
+ *  \param sfs        \IN  sub frame size in words
+ *  \param now        \IN  receive time in ms
+ */
+static void CheckFrame( u_int16 *buf, u_int32 sfs, u_int32 now )
+{
+	LB_STATS *st = &G_combo;
+	u_int16 *w;
+	u_int32 sub, seq, bits, bits2, wordErrs, wordErrs2;
+	int32 valid;
+
+	for(sub=0; sub<4; sub++){
+		w = buf + sub * sfs;
+		seq = (w[1] & 0xFFF) | ((u_int32)(w[2] & 0xFFF) << 12);
+		valid = seq < G_seq.nextSeq &&
+				seq + SEQ_WIN / 2 >= G_seq.nextSeq &&
+				G_seq.slotSeq[seq % SEQ_WIN] == seq;
+
+		if(!G_seq.locked){
+			/*
+			 * Discard until the first error free sub frame of a frame
+			 * written in step with the receiver. Before, frames may be
+			 * overwritten or repeated by the transmit driver.
+			 */
+			if(!valid || !G_seq.paced || seq < G_seq.pacedSeq ||
+			   CheckSub(w, sfs, sub, seq, &wordErrs) != 0)
+				continue;
+			G_seq.locked   = 1;
+			G_seq.firstSeq = seq;
+			G_seq.lastGood = seq;
+		}
+
+		if(valid){
+			bits = CheckSub(w, sfs, sub, seq, &wordErrs);
+		}else{
+			seq  = G_seq.lastGood;
+			bits = CheckSub(w, sfs, sub, seq, &wordErrs);
+			bits2 = CheckSub(w, sfs, sub, seq + 1, &wordErrs2);
+			if(bits2 < bits){
+				seq = seq + 1;
+				bits = bits2;
+				wordErrs = wordErrs2;
+			}
+		}
+
+		st->words    += sfs;
+		st->bitErrs  += bits;
+		st->wordErrs += wordErrs;
+		if(bits == 0)
+			G_seq.lastGood = seq;
+		MarkSub(seq, sub, now);
+	}
+}
+
+/********************************* CheckSub ********************************/
+/** Compare a received sub frame with the sent pattern
+ *
+ *  \param w          \IN  sub frame (sync word first)
+ *  \param sfs        \IN  sub frame size in words
+ *  \param sub        \IN  sub frame index 0..3
+ *  \param seq        \IN  expected sequence number
+ *  \param wordErrsP  \OUT words with bit errors
+ *
+ *  \return	          number of bit errors
+ */
+static u_int32 CheckSub( u_int16 *w, u_int32 sfs, u_int32 sub, u_int32 seq,
+						 u_int32 *wordErrsP )
+{
+	u_int32 i, state, diff;
+	u_int32 bits = 0, words = 0;
+
+	state = PrbsSeed(seq, sub);
+	for(i=0; i<sfs; i++){
+		if(i == 0)
+			diff = w[i] ^ G_syncWord[sub];
+		else if(i == 1)
+			diff = w[i] ^ (seq & 0xFFF);
+		else if(i == 2)
+			diff = w[i] ^ ((seq >> 12) & 0xFFF);
+		else
+			diff = w[i] ^ Prbs15(&state);
+		diff &= 0xFFF;
+		if(diff){
+			bits += BitCount(diff);
+			words++;
+		}
+	}
+	*wordErrsP = words;
+	return bits;
+}
+
+/********************************* MarkSub *********************************/
+/** Record a received sub frame
+ *
+ *  \param seq        \IN  sequence number
+ *  \param sub        \IN  sub frame index 0..3
+ *  \param now        \IN  receive time in ms
+ */
+static void MarkSub( u_int32 seq, u_int32 sub, u_int32 now )
+{
+	LB_STATS *st = &G_combo;
+	u_int32 slot = seq % SEQ_WIN;
+	u_int32 lat;
+
+	if(G_seq.slotSeq[slot] != seq || seq >= G_seq.nextSeq)
+		return;
+
+	if(G_seq.slotMask[slot] & (1 << sub)){
+		/* frame sent again: the next one was written too late */
+		if(!G_seq.draining)
+			st->subRepeat++;
+		return;
+	}
+
+	G_seq.slotMask[slot] |= 1 << sub;
+	if(G_seq.slotMask[slot] == SUB_ALL){
+		st->framesOk++;
+		lat = now - G_seq.slotMs[slot];
+		st->lat[lat < LAT_BINS ? lat : LAT_BINS - 1]++;
+		st->latNum++;
+	}
+}
+
+/********************************* Finalize ********************************/
+/** Evaluate a sent frame when its slot is reused or the test ends
+ *
+ *  \param seq        \IN  sequence number
+ */
+static void Finalize( u_int32 seq )
+{
+	LB_STATS *st = &G_combo;
+	u_int32 slot = seq % SEQ_WIN;
+	u_int8 mask = G_seq.slotMask[slot];
+
+	/* frames sent before the first received one are not counted */
+	if(!G_seq.locked || seq <= G_seq.firstSeq || G_seq.slotSeq[slot] != seq)
+		return;
+
+	if(mask == 0)
+		st->framesLost++;
+	else if(mask != SUB_ALL)
+		st->subLost += 4 - BitCount(mask);
+
+	G_seq.slotSeq[slot] = (u_int32)-1;
+}
+
+/********************************* PrintStats ******************************/
+/** Print test statistics
+ *
+ *  \param name       \IN  title
+ *  \param st         \IN  statistics
+ */
+static void PrintStats( const char *name, LB_STATS *st )
+{
+	u_int64 bits = st->words * 12;
+
+	printf("%s:\n", name);
+	printf("  frames      : tx %u, ok %u, lost %u, sub frames lost %u, "
+		   "repeated %u\n", st->framesTx, st->framesOk, st->framesLost,
+		   st->subLost, st->subRepeat);
+	printf("  errors      : BER %.3e (%llu bits), WER %.3e (%llu words)\n",
+		   bits ? (double)st->bitErrs / bits : 0.0,
+		   (unsigned long long)st->bitErrs,
+		   st->words ? (double)st->wordErrs / st->words : 0.0,
+		   (unsigned long long)st->wordErrs);
+	printf("  sync        : losses %u, error signals %u, read errors %u\n",
+		   st->syncLosses, st->errSigs, st->readErrs);
+	printf("  latency ms  : p50 %u, p99 %u, max %u (%u frames)\n",
+		   LatPercentile(st, 50), LatPercentile(st, 99),
+		   LatPercentile(st, 100), st->latNum);
+	printf("  throughput  : %.1f words/s (%llu words in %u s)\n",
+		   st->rxMs ? (double)st->words * 1000.0 / st->rxMs : 0.0,
+		   (unsigned long long)st->words, st->rxMs / 1000);
+	fflush(stdout);
+}
+
+/********************************* AddStats ********************************/
+/** Accumulate statistics
+ *
+ *  \param dst        \IN  sum, \OUT sum + src
+ *  \param src        \IN  statistics to add
+ */
+static void AddStats( LB_STATS *dst, LB_STATS *src )
+{
+	u_int32 i;
+
+	dst->words      += src->words;
+	dst->wordErrs   += src->wordErrs;
+	dst->bitErrs    += src->bitErrs;
+	dst->framesTx   += src->framesTx;
+	dst->framesOk   += src->framesOk;
+	dst->framesLost += src->framesLost;
+	dst->subLost    += src->subLost;
+	dst->subRepeat  += src->subRepeat;
+	dst->syncLosses += src->syncLosses;
+	dst->errSigs    += src->errSigs;
+	dst->readErrs   += src->readErrs;
+	dst->rxMs       += src->rxMs;
+	dst->latNum     += src->latNum;
+	for(i=0; i<LAT_BINS; i++)
+		dst->lat[i] += src->lat[i];
+}
+
+/********************************* LatPercentile ***************************/
+/** Latency percentile from the histogram
+ *
+ *  \param st         \IN  statistics
+ *  \param pct        \IN  percentile 0..100
+ *
+ *  \return	          latency in ms
+ */
+static u_int32 LatPercentile( LB_STATS *st, u_int32 pct )
+{
+	u_int64 need, sum = 0;
+	u_int32 i;
+
+	if(st->latNum == 0)
+		return 0;
+	need = ((u_int64)st->latNum * pct + 99) / 100;
+	if(need == 0)
+		need = 1;
+	for(i=0; i<LAT_BINS; i++){
+		sum += st->lat[i];
+		if(sum >= need)
+			return i;
+	}
+	return LAT_BINS - 1;
+}
+
+/********************************* Prbs15 **********************************/
+/** Next 12 bit word of the PRBS-15 sequence (x^15 + x^14 + 1)
+ *
+ *  \param stateP     \IN  LFSR state, \OUT next state
+ *
+ *  \return	          12 bit word
+ */
+static u_int16 Prbs15( u_int32 *stateP )
+{
+	u_int32 s = *stateP;
+	u_int32 i, bit, word = 0;
+
+	for(i=0; i<12; i++){
+		bit = ((s >> 14) ^ (s >> 13)) & 1;
+		s = ((s << 1) | bit) & 0x7FFF;
+		word = (word << 1) | bit;
+	}
+	*stateP = s;
+	return (u_int16)word;
+}
+
+/********************************* PrbsSeed ********************************/
+/** PRBS start value of a sub frame (never 0)
+ *
+ *  \param seq        \IN  sequence number
+ *  \param sub        \IN  sub frame index 0..3
+ *
+ *  \return	          LFSR state
+ */
+static u_int32 PrbsSeed( u_int32 seq, u_int32 sub )
+{
+	u_int32 s = ((seq * 4 + sub) * 0x9E37 + 0x5A5A) & 0x7FFF;
+
+	return s ? s : 1;
+}
+
+/********************************* BitCount ********************************/
+/** Number of set bits */
+static u_int32 BitCount( u_int32 x )
+{
+	u_int32 n = 0;
+
+	for(; x; x &= x - 1)
+		n++;
+	return n;
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/****************************** SignalHandler ******************************/
+/** Signal handler: count receive and error signals
+ *
+ *  \param  sig    \IN   received signal
+ */
+static void __MAPILIB SignalHandler( u_int32 sig )
+{
+	if(sig == UOS_SIG_USR1)
+		G_rxSigCnt++;
+	else if(sig == UOS_SIG_USR2)
+		G_errSigCnt++;
+}
+
+/****************************** StopHandler ********************************/
+/** Ctrl-C: finish the current combination and print the results
+ *
+ *  \param  sig    \IN   received signal
+ */
+static void StopHandler( int sig )
+{
+	G_stop = 1;
+}
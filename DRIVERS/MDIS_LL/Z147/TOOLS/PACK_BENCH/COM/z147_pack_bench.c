@@ -0,0 +1,180 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_PACK_BENCH                  ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_pack_bench.c
+ *       \author Apatil
+ *
+ *       \brief  Throughput of the 12 bit pack/unpack kernels
+ *
+ *               For the frame size of every data rate, all pack/unpack
+ *               kernels supported by the CPU are checked against the
+ *               scalar code and their throughput is measured in MB/s of
+ *               unpacked frame data, next to memcpy() of the u_int16
+ *               frame as reference. Frame buffers stay in the cache.
+ *
+ *               Output is a table, with -c CSV:
+ *
+ *               op,kernel,words,mbs
+ *
+ *     Required: libraries: z147_pack
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_pack_bench.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_pack.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_WORDS           32768       /**< frame words at 8192 words/s */
+#define MIN_TIME_NS         100000000LL /**< min. time per measurement */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static u_int16 G_src[MAX_WORDS];
+static u_int16 G_dst[MAX_WORDS];
+static u_int8  G_ref[Z147PK_SIZE(MAX_WORDS)];
+static u_int8  G_pkd[Z147PK_SIZE(MAX_WORDS)];
+static volatile u_int32 G_sink;     /**< keeps results alive */
+static int     G_csv;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static double Measure( int op, u_int32 words );
+static void Report( const char *op, const char *kernel, u_int32 words,
+					double mbs );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	u_int32 rate, words, i;
+	int32 k, errors = 0;
+
+	if(argc > 2 || (argc == 2 && strcmp(argv[1], "-c") != 0)){
+		printf("Syntax: z147_pack_bench [-c]\n");
+		printf("Function: throughput of the 12 bit pack/unpack kernels\n");
+		printf("Options:\n");
+		printf("    -c         CSV output\n");
+		return(1);
+	}
+	G_csv = argc == 2;
+
+	srand(1);
+	for(i=0; i<MAX_WORDS; i++)
+		G_src[i] = (u_int16)(rand() & 0xfff);
+
+	if(G_csv)
+		printf("op,kernel,words,mbs\n");
+	else
+		printf("%-8s %-7s %6s %10s\n", "op", "kernel", "words", "MB/s");
+
+	for(rate=0; rate<8; rate++){
+		words = 4 * (64u << rate);
+		Report("memcpy", "-", words, Measure(0, words));
+
+		Z147PK_Select(Z147PK_SCALAR);
+		Z147PK_Pack(G_src, G_ref, words);
+
+		for(k=0; k<Z147PK_NUM; k++){
+			if(Z147PK_Select(k) < 0)
+				continue;
+
+			/* odd sizes exercise the tails of the kernels */
+			for(i=words-3; i<=words; i++){
+				memset(G_pkd, 0, sizeof(G_pkd));
+				memset(G_dst, 0, sizeof(G_dst));
+				Z147PK_Pack(G_src, G_pkd, i);
+				Z147PK_Unpack(G_pkd, G_dst, i);
+				if(memcmp(G_pkd, G_ref, Z147PK_SIZE(i) - (i & 1)) != 0 ||
+				   memcmp(G_dst, G_src, i * 2) != 0){
+					printf("*** %s: wrong result for %u words\n",
+						   Z147PK_Name(k), i);
+					errors++;
+				}
+			}
+			Report("pack", Z147PK_Name(k), words, Measure(1, words));
+			Report("unpack", Z147PK_Name(k), words, Measure(2, words));
+		}
+	}
+
+	if(!G_csv)
+		printf("%s\n", errors ? "Test Result : FAILED" :
+			   "Test Result : PASSED");
+	return(errors ? 1 : 0);
+}
+
+/********************************* Measure *********************************/
+/** Throughput of one operation
+ *
+ *  \param op         \IN  0=memcpy, 1=pack, 2=unpack
+ *  \param words      \IN  frame words
+ *
+ *  \return	          MB/s of u_int16 frame data
+ */
+static double Measure( int op, u_int32 words )
+{
+	u_int64 rounds = 0, batch = 1 + 1000000 / words;
+	u_int64 r;
+	int64 t0, t;
+
+	t0 = NowNs();
+	do{
+		for(r=0; r<batch; r++){
+			if(op == 0)
+				memcpy(G_dst, G_src, words * 2);
+			else if(op == 1)
+				Z147PK_Pack(G_src, G_pkd, words);
+			else
+				Z147PK_Unpack(G_pkd, G_dst, words);
+			G_sink += G_dst[r % words] + G_pkd[r % words];
+		}
+		rounds += batch;
+	}while((t = NowNs() - t0) < MIN_TIME_NS);
+
+	return (double)rounds * words * 2 / (double)t * 1e3;
+}
+
+/********************************* Report **********************************/
+/** Print one result */
+static void Report( const char *op, const char *kernel, u_int32 words,
+					double mbs )
+{
+	if(G_csv)
+		printf("%s,%s,%u,%.0f\n", op, kernel, words, mbs);
+	else
+		printf("%-8s %-7s %6u %10.0f\n", op, kernel, words, mbs);
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
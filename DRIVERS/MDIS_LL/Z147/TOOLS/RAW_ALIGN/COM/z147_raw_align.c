@@ -0,0 +1,304 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_RAW_ALIGN                   ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_raw_align.c
+ *       \author Apatil
+ *
+ *       \brief  Align a raw word dump to frames and write a frame file
+ *
+ *               The dump holds u_int16 words (host byte order) without
+ *               frame position, e.g. read from a receiver in raw mode
+ *               (Z147_RX_SYNC_CFG 0) or taken by a line analyzer. Data
+ *               rate and alignment are detected (z147_align.h), then the
+ *               dump is walked frame by frame. A frame with less than 3
+ *               correct sync words ends the alignment, the search starts
+ *               again half a frame after the last good frame, so a lost
+ *               or inserted word costs at most one frame.
+ *
+ *               The frames go to an indexed frame file (z147_frm.h):
+ *               - seq is the frame position in the dump, skipped words
+ *                 show up as gaps (Z147FRM_ST_LOST)
+ *               - the time is -t plus the word position at the data rate
+ *               - frames with all sync words are marked
+ *                 Z147FRM_ST_INSYNC, frames with one wrong sync word
+ *                 Z147FRM_ST_ERR
+ *
+ *               Without frame file only the alignment is reported. The
+ *               throughput is shown, -k selects the search kernel.
+ *
+ *     Required: libraries: z147_align, z147_frm
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_raw_align.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_align.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MIN_SYNC_OK         3           /**< sync words of an aligned frame */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** result of an alignment */
+typedef struct {
+	int32   rate;               /**< detected data rate */
+	u_int64 first;              /**< word index of the first frame */
+	u_int32 frames;             /**< frames written */
+	u_int32 errFrames;          /**< frames with a wrong sync word */
+	u_int32 realign;            /**< alignments lost and found again */
+	u_int64 skipped;            /**< words in no frame */
+} RESULT;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 Align( const u_int16 *w, u_int64 num, int32 rate,
+					Z147FRM_HDR *hdr, char *out, int64 startNs,
+					RESULT *res );
+static int64 NowNs( void );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *in = NULL, *out = NULL, *name = NULL;
+	Z147FRM_HDR hdr;
+	RESULT res;
+	struct stat st;
+	u_int16 *w;
+	int32 rate = Z147AL_ANY_RATE, kernel = Z147AL_AUTO, i, rv;
+	int64 startNs = 0, t;
+	int fd;
+
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.syncCfg = Z147FRM_UNKNOWN;
+	hdr.modeCfg = Z147FRM_UNKNOWN;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			rate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-k=", 3) == 0){
+			kernel = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			startNs = (int64)(atof(argv[i] + 3) * 1e9);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			name = argv[i] + 3;
+		}else if(strncmp(argv[i], "-y=", 3) == 0){
+			hdr.syncCfg = (u_int32)strtoul(argv[i] + 3, NULL, 0);
+		}else if(strncmp(argv[i], "-e=", 3) == 0){
+			hdr.modeCfg = (u_int32)strtoul(argv[i] + 3, NULL, 0);
+		}else if(argv[i][0] != '-' && in == NULL){
+			in = argv[i];
+		}else if(argv[i][0] != '-' && out == NULL){
+			out = argv[i];
+		}else{
+			break;
+		}
+	}
+
+	if(i < argc || in == NULL || rate < Z147AL_ANY_RATE || rate > 7 ||
+	   kernel < Z147AL_AUTO || kernel >= Z147AL_NUM){
+		printf("Syntax: z147_raw_align [<opts>] <dump> [<frmFile>]\n");
+		printf("Function: detect data rate and frame alignment of a raw\n");
+		printf("          word dump and write its frames to a frame file\n");
+		printf("Options:\n");
+		printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [detect]\n");
+		printf("    -k=<n>     search kernel 0=scalar 1=sse2 2=avx2 [best]\n");
+		printf("    -t=<s>     time of the first word (s since 1970) [0]\n");
+		printf("    -n=<name>  device name                        [dump]\n");
+		printf("    -y=<cfg>   sync config of the receiver        [unknown]\n");
+		printf("    -e=<cfg>   receive mode of the receiver       [unknown]\n");
+		return(1);
+	}
+
+	if((kernel = Z147AL_Select(kernel)) < 0){
+		printf("*** search kernel not supported by the CPU\n");
+		return(1);
+	}
+	strncpy(hdr.name, name ? name : in, Z147FRM_NAME_LEN - 1);
+	hdr.createdNs = startNs;
+
+	if((fd = open(in, O_RDONLY)) < 0 || fstat(fd, &st) != 0){
+		printf("*** can't open %s: %s\n", in, strerror(errno));
+		if(fd >= 0)
+			close(fd);
+		return(1);
+	}
+	if(st.st_size < 2){
+		close(fd);
+		printf("*** %s: no words\n", in);
+		return(1);
+	}
+	w = (u_int16*)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+					   fd, 0);
+	close(fd);
+	if(w == MAP_FAILED){
+		printf("*** can't map %s: %s\n", in, strerror(errno));
+		return(1);
+	}
+	madvise(w, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+	t  = NowNs();
+	rv = Align(w, (u_int64)st.st_size / 2, rate, &hdr, out, startNs, &res);
+	t  = NowNs() - t;
+	munmap(w, (size_t)st.st_size);
+
+	if(rv == 0){
+		printf("rate        %u words/s, %u words/frame\n",
+			   64u << res.rate, 4 * (64u << res.rate));
+		printf("first frame word %llu\n", (unsigned long long)res.first);
+		printf("frames      %u (%u with a wrong sync word)\n",
+			   res.frames, res.errFrames);
+		printf("realigned   %u times, %llu words skipped\n",
+			   res.realign, (unsigned long long)res.skipped);
+	}
+	printf("%.1f MB in %.3f s, %.1f MB/s (%s)\n", st.st_size / 1e6,
+		   t / 1e9, t ? st.st_size * 1e3 / t : 0.0, Z147AL_Name(kernel));
+	return(rv == 0 ? 0 : 1);
+}
+
+/********************************* Align ***********************************/
+/** Detect the alignment and write the frames
+ *
+ *  \param w          \IN  words
+ *  \param num        \IN  number of words
+ *  \param rate       \IN  data rate or Z147AL_ANY_RATE
+ *  \param hdr        \IN  frame file header (name, config)
+ *  \param out        \IN  frame file or NULL
+ *  \param startNs    \IN  time of the first word
+ *  \param res        \OUT result
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 Align( const u_int16 *w, u_int64 num, int32 rate,
+					Z147FRM_HDR *hdr, char *out, int64 startNs,
+					RESULT *res )
+{
+	Z147FRM_WRITER *wr = NULL;
+	Z147AL_ALIGN al;
+	Z147FRM_FRAME frm;
+	u_int64 pos, from, wps, seq, lastSeq = 0, end = 0, covered = 0;
+	u_int32 frameWords, words, ok;
+	int32 error = 0, haveFrame = 0;
+
+	memset(res, 0, sizeof(*res));
+	if(Z147AL_Detect(w, num, rate, &al) != 0){
+		printf("*** no frames found%s\n",
+			   rate < 0 ? "" : " at this data rate");
+		return -1;
+	}
+	res->rate  = al.rate;
+	res->first = al.start;
+	frameWords = al.frameWords;
+	wps = 64u << al.rate;
+
+	if(out){
+		hdr->rate = (u_int32)al.rate;
+		if((wr = Z147FRM_Create(out, hdr, 0)) == NULL){
+			printf("*** can't create %s: %s\n", out, strerror(errno));
+			return -1;
+		}
+	}
+
+	pos = al.start;
+	while(pos < num){
+		ok = 0;
+		if(pos + frameWords <= num)
+			ok = Z147AL_SyncOk(w + pos, al.rate);
+
+		if(ok < MIN_SYNC_OK){
+			if(pos + frameWords > num &&
+			   (w[pos] & 0x0fff) == Z147_ARINC717_SUB_1_SYNC){
+				/* last frame, incomplete */
+				ok = MIN_SYNC_OK;
+			}else{
+				/* lost: search from half a frame after the last frame */
+				from = haveFrame ? end - frameWords / 2 : pos + 1;
+				if(Z147AL_Detect(w + from, num - from, al.rate, &al) != 0)
+					break;
+				pos = from + al.start;
+				res->realign++;
+				continue;
+			}
+		}
+
+		memset(&frm, 0, sizeof(frm));
+		seq = (pos - res->first + frameWords / 2) / frameWords;
+		if(haveFrame && seq <= lastSeq)
+			seq = lastSeq + 1;
+		if(haveFrame && seq > lastSeq + 1){
+			frm.status |= Z147FRM_ST_LOST;
+			frm.lost = seq - lastSeq - 1 > 0xffff ? 0xffff :
+				(u_int16)(seq - lastSeq - 1);
+		}
+		frm.seq  = (u_int32)seq;
+		frm.tsNs = startNs + (int64)(pos / wps) * 1000000000LL +
+			(int64)(pos % wps) * 1000000000LL / (int64)wps;
+		if(ok == 4){
+			frm.status |= Z147FRM_ST_INSYNC;
+		}else{
+			frm.status |= Z147FRM_ST_ERR;
+			res->errFrames++;
+		}
+
+		words = num - pos < frameWords ? (u_int32)(num - pos) : frameWords;
+		if(wr && Z147FRM_Append(wr, &frm, w + pos, words) != 0){
+			printf("*** write error: %s\n", strerror(errno));
+			error = -1;
+			break;
+		}
+		res->frames++;
+		haveFrame = 1;
+		lastSeq = seq;
+		/* a frame found after a slip may overlap the previous one */
+		covered += words - (pos < end ? end - pos : 0);
+		pos += words;
+		end = pos;
+	}
+	res->skipped = num - covered;
+
+	if(wr && Z147FRM_Finish(wr) != 0){
+		printf("*** can't write %s: %s\n", out, strerror(errno));
+		error = -1;
+	}
+	return error;
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
@@ -0,0 +1,940 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_RECORDER                    ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_recorder.c
+ *       \author Apatil
+ *
+ *       \brief  Z147 flight data recorder
+ *
+ *               Records the frames of one or more Z147 receivers to disk
+ *               (format see z147_rec.h).
+ *
+ *               All receivers send the same signal. The signal handler
+ *               only wakes up the reader thread of every channel, each
+ *               reader checks #Z147_RX_FRAME_CNT of its device and reads a
+ *               new frame with M_getblock() directly behind a record header
+ *               in a buffer of a preallocated pool. Filled buffers are
+ *               queued for the writer thread, which collects them in a
+ *               large aligned block and writes it with O_DIRECT (or
+ *               buffered with -D=0). The writer flushes a partial block at
+ *               least every -f ms, starts a new segment file every -s MB
+ *               and deletes the oldest segments to stay below -d MB.
+ *
+ *               With -P the drivers deliver the packed 12 bit frame
+ *               format (#Z147_RX_PACKED), the records then hold 3/4 of the
+ *               data and are flagged with #Z147REC_ST_PACKED.
+ *
+ *               The tool reports the write latency, the writer queue depth
+ *               and every frame lost on the way.
+ *
+ *     Required: libraries: mdis_api, usr_oss, pthread
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_recorder.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#define _GNU_SOURCE         /* O_DIRECT */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_rec.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MB                  (1024 * 1024)
+#define MAX_SEGS            4096        /**< segments kept on disk */
+#define LAT_RING            4096        /**< write latencies kept */
+
+#ifndef O_DIRECT
+# define O_DIRECT           0
+#endif
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** pool buffer: record header and frame */
+typedef struct REC_BUF {
+	struct REC_BUF *next;       /**< free list / writer queue */
+	u_int8  *mem;               /**< Z147REC_ALIGN aligned record */
+} REC_BUF;
+
+/** one receive channel */
+typedef struct {
+	char        *name;          /**< device name */
+	MDIS_PATH   path;           /**< receive path */
+	u_int16     idx;            /**< channel index */
+	pthread_t   reader;         /**< reader thread */
+	sem_t       sem;            /**< woken by every receive signal */
+	int         haveCnt;        /**< lastCnt valid */
+	u_int32     lastCnt;        /**< last driver frame count */
+	u_int32     seq;            /**< records of this channel */
+	u_int32     pendLost;       /**< lost frames not yet reported */
+
+	/* statistics */
+	u_int32     frames;         /**< frames queued */
+	u_int32     lost;           /**< frames missed by the reader */
+	u_int32     dropped;        /**< frames dropped on empty pool */
+	u_int32     torn;           /**< frames changed during the read */
+	u_int32     readErrs;       /**< failed driver calls */
+	u_int32     noSync;         /**< frames read out of sync */
+} REC_CHAN;
+
+/** one segment file on disk */
+typedef struct {
+	u_int32     num;            /**< segment number */
+	u_int64     size;           /**< bytes */
+} REC_SEG;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static REC_CHAN G_ch[Z147REC_MAX_CH];
+static u_int32  G_chNum;
+static int32    G_rate = Z147_RX_DATA_RATE_8192;
+static u_int32  G_frameBytes;               /**< M_getblock() size */
+static u_int32  G_recSize;                  /**< pool buffer size */
+static volatile int G_stop;                 /**< stop readers */
+static volatile int G_wrStop;               /**< stop writer */
+static volatile int G_sigInt;               /**< Ctrl-C */
+static volatile u_int32 G_errSigs;          /**< receive error signals */
+
+/* pool and writer queue, protected by G_lock */
+static pthread_mutex_t G_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  G_wrCond = PTHREAD_COND_INITIALIZER;
+static REC_BUF  *G_bufs;                    /**< all pool buffers */
+static REC_BUF  *G_free;                    /**< free list */
+static REC_BUF  *G_qHead, *G_qTail;         /**< writer queue */
+static u_int32  G_qDepth, G_qMax;           /**< queue depth */
+static u_int64  G_qSum, G_qSamples;         /**< mean queue depth */
+static u_int32  G_poolNum;                  /**< pool buffers */
+
+/* writer, only used by the writer thread after start */
+static char     *G_dir = ".";
+static char     *G_prefix = "z147rec";
+static int      G_direct = 1;               /**< use O_DIRECT */
+static int      G_packed;                   /**< packed 12 bit frames */
+static u_int64  G_segMax = 64 * (u_int64)MB;
+static u_int64  G_diskMax = 1024 * (u_int64)MB;
+static u_int32  G_flushMs = 1000;
+static u_int32  G_batchSize = 1 * MB;
+static int      G_fd = -1;                  /**< current segment */
+static u_int32  G_segNum;                   /**< current segment number */
+static u_int64  G_segBytes;                 /**< written to current segment */
+static REC_SEG  G_seg[MAX_SEGS];            /**< closed segments, oldest first */
+static u_int32  G_segCnt;                   /**< entries in G_seg */
+static u_int64  G_diskUsed;                 /**< bytes of closed segments */
+static u_int8   *G_batch;                   /**< aligned write block */
+static u_int32  G_fill;                     /**< bytes in G_batch */
+
+/* writer statistics */
+static u_int64  G_wrBytes;                  /**< bytes written */
+static u_int32  G_wrCalls;                  /**< write() calls */
+static u_int32  G_wrErrs;                   /**< failed writes */
+static u_int32  G_wrLat[LAT_RING];          /**< last write latencies in us */
+static int64    G_wrLatMax;                 /**< max. write latency in us */
+static u_int32  G_segDeleted;               /**< segments removed */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void PrintError(char *info);
+static void __MAPILIB SignalHandler( u_int32 sig );
+static void SigIntHandler( int sig );
+static void *ReaderThread( void *arg );
+static void *WriterThread( void *arg );
+static int32 PoolInit( u_int32 num );
+static void PoolExit( void );
+static REC_BUF *PoolGet( void );
+static void PoolPut( REC_BUF *buf );
+static void Queue( REC_BUF *buf );
+static void Append( REC_BUF *buf );
+static void Flush( int pad );
+static int32 SegOpen( void );
+static void SegClose( void );
+static void SegTrim( u_int64 need );
+static int64 NowNs( clockid_t clk );
+static u_int32 LatPercentile( u_int32 pct );
+static int CmpU32( const void *a, const void *b );
+static void PrintStatus( u_int32 sec );
+static void PrintReport( u_int32 sec );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	pthread_t writer;
+	u_int32 runTime = 0, statusSec = 10, poolPerCh = 16;
+	u_int32 start, now, lastStatus, sec = 0;
+	int32 i, errors = 0;
+	int writerUp = 0;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			G_rate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-o=", 3) == 0){
+			G_dir = argv[i] + 3;
+		}else if(strncmp(argv[i], "-p=", 3) == 0){
+			G_prefix = argv[i] + 3;
+		}else if(strncmp(argv[i], "-s=", 3) == 0){
+			G_segMax = (u_int64)atoi(argv[i] + 3) * MB;
+		}else if(strncmp(argv[i], "-d=", 3) == 0){
+			G_diskMax = (u_int64)atoi(argv[i] + 3) * MB;
+		}else if(strncmp(argv[i], "-b=", 3) == 0){
+			poolPerCh = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-w=", 3) == 0){
+			G_batchSize = (u_int32)atoi(argv[i] + 3) * 1024;
+		}else if(strncmp(argv[i], "-f=", 3) == 0){
+			G_flushMs = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-D=", 3) == 0){
+			G_direct = atoi(argv[i] + 3);
+		}else if(strcmp(argv[i], "-P") == 0){
+			G_packed = 1;
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			runTime = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-i=", 3) == 0){
+			statusSec = (u_int32)atoi(argv[i] + 3);
+		}else if(argv[i][0] != '-' && G_chNum < Z147REC_MAX_CH){
+			G_ch[G_chNum].name = argv[i];
+			G_ch[G_chNum].idx  = (u_int16)G_chNum;
+			G_chNum++;
+		}else{
+			G_chNum = 0;
+			break;
+		}
+	}
+
+	if(G_packed)
+		G_frameBytes = Z147_PACKED_SIZE(4 * (64 << (G_rate & 0x7)));
+	else
+		G_frameBytes = 8 * (64 << (G_rate & 0x7));
+	G_recSize    = Z147REC_REC_SIZE(G_frameBytes);
+	G_batchSize &= ~(u_int32)(Z147REC_ALIGN - 1);
+
+	if(G_chNum == 0 || G_rate < Z147_RX_DATA_RATE_64 ||
+	   G_rate > Z147_RX_DATA_RATE_8192 || poolPerCh < 2 ||
+	   G_batchSize < G_recSize + Z147REC_ALIGN || G_segMax < G_batchSize ||
+	   G_diskMax < 2 * G_segMax){
+		printf("Syntax: z147_recorder [<opts>] <rxDevice> [<rxDevice>...]\n");
+		printf("Function: Z147 flight data recorder (max. %d devices)\n",
+			   Z147REC_MAX_CH);
+		printf("Options:\n");
+		printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [7]\n");
+		printf("    -o=<dir>   output directory                  [.]\n");
+		printf("    -p=<name>  segment file prefix               [z147rec]\n");
+		printf("    -s=<MB>    segment size                      [64]\n");
+		printf("    -d=<MB>    max. disk usage (>= 2 segments)   [1024]\n");
+		printf("    -b=<n>     pool buffers per device           [16]\n");
+		printf("    -w=<KB>    write block size                  [1024]\n");
+		printf("    -f=<ms>    max. time data stays in memory    [1000]\n");
+		printf("    -D=0       buffered writes instead of O_DIRECT\n");
+		printf("    -P         record the packed 12 bit frame format\n");
+		printf("    -t=<sec>   recording time (0=until Ctrl-C)   [0]\n");
+		printf("    -i=<sec>   status interval (0=off)           [10]\n");
+		return(1);
+	}
+
+	for(i=0; i<Z147REC_MAX_CH; i++)
+		sem_init(&G_ch[i].sem, 0, 0);
+
+	/* all memory is allocated before the recording */
+	if(PoolInit(poolPerCh * G_chNum) != 0 ||
+	   posix_memalign((void**)&G_batch, Z147REC_ALIGN, G_batchSize) != 0){
+		printf("*** can't allocate buffers\n");
+		return(1);
+	}
+
+	if(SegOpen() != 0){
+		PoolExit();
+		return(1);
+	}
+
+	/*--------------------+
+	|  open               |
+	+--------------------*/
+	for(i=0; i<(int32)G_chNum; i++){
+		if((G_ch[i].path = M_open(G_ch[i].name)) < 0){
+			printf("*** %s: ", G_ch[i].name);
+			PrintError("open");
+			G_chNum = i;
+			errors++;
+			goto CLEANUP;
+		}
+	}
+
+	signal(SIGINT, SigIntHandler);
+	UOS_SigInit( SignalHandler );
+	UOS_SigInstall( UOS_SIG_USR1 );
+	UOS_SigInstall( UOS_SIG_USR2 );
+
+	if(pthread_create(&writer, NULL, WriterThread, NULL) != 0){
+		printf("*** can't create writer thread\n");
+		errors++;
+		goto CLEANUP;
+	}
+	writerUp = 1;
+
+	for(i=0; i<(int32)G_chNum; i++){
+		if(M_setstat(G_ch[i].path, Z147_RX_DATA_RATE, G_rate) < 0 ||
+		   M_setstat(G_ch[i].path, Z147_RX_PACKED, G_packed) < 0 ||
+		   M_setstat(G_ch[i].path, Z147_SET_SIGNAL, UOS_SIG_USR1) < 0 ||
+		   M_setstat(G_ch[i].path, Z147_SET_ERR_SIGNAL, UOS_SIG_USR2) < 0){
+			printf("*** %s: ", G_ch[i].name);
+			PrintError("setstat");
+			errors++;
+			goto CLEANUP;
+		}
+		if(pthread_create(&G_ch[i].reader, NULL, ReaderThread,
+						  &G_ch[i]) != 0){
+			printf("*** can't create reader thread\n");
+			errors++;
+			goto CLEANUP;
+		}
+	}
+
+	printf("Recording %u device(s) at %u words/s to %s/%s_*.z147 (%s)\n",
+		   G_chNum, 64 << G_rate, G_dir, G_prefix,
+		   G_direct ? "O_DIRECT" : "buffered");
+	fflush(stdout);
+
+	start = lastStatus = UOS_MsecTimerGet();
+	while(!G_sigInt){
+		UOS_Delay(100);
+		now = UOS_MsecTimerGet();
+		if(runTime && now - start >= runTime * 1000)
+			break;
+		if(statusSec && now - lastStatus >= statusSec * 1000){
+			lastStatus = now;
+			PrintStatus((now - start) / 1000);
+		}
+	}
+	sec = (UOS_MsecTimerGet() - start) / 1000;
+
+CLEANUP:
+	/* readers first, the writer empties the queue */
+	for(i=0; i<(int32)G_chNum; i++){
+		M_setstat(G_ch[i].path, Z147_CLR_SIGNAL, 0);
+		M_setstat(G_ch[i].path, Z147_CLR_ERR_SIGNAL, 0);
+	}
+	G_stop = 1;
+	for(i=0; i<(int32)G_chNum; i++){
+		if(G_ch[i].reader){
+			sem_post(&G_ch[i].sem);
+			pthread_join(G_ch[i].reader, NULL);
+		}
+	}
+	if(writerUp){
+		pthread_mutex_lock(&G_lock);
+		G_wrStop = 1;
+		pthread_cond_signal(&G_wrCond);
+		pthread_mutex_unlock(&G_lock);
+		pthread_join(writer, NULL);
+	}else{
+		SegClose();
+	}
+
+	UOS_SigRemove( UOS_SIG_USR1 );
+	UOS_SigRemove( UOS_SIG_USR2 );
+	UOS_SigExit();
+
+	for(i=0; i<(int32)G_chNum; i++){
+		if(M_close(G_ch[i].path) < 0){
+			printf("*** %s: ", G_ch[i].name);
+			PrintError("close");
+		}
+	}
+
+	if(errors == 0){
+		PrintReport(sec);
+		for(i=0; i<(int32)G_chNum; i++)
+			errors += G_ch[i].lost + G_ch[i].dropped + G_ch[i].readErrs;
+		errors += G_wrErrs;
+		printf("Recording   : %s\n", errors ? "FRAMES LOST" : "COMPLETE");
+	}
+
+	for(i=0; i<Z147REC_MAX_CH; i++)
+		sem_destroy(&G_ch[i].sem);
+	PoolExit();
+	free(G_batch);
+
+	return(errors ? 1 : 0);
+}
+
+/********************************* ReaderThread ****************************/
+/** Read the new frames of one channel into pool buffers
+ *
+ *  \param arg        \IN  REC_CHAN
+ *
+ *  \return	          NULL
+ */
+static void *ReaderThread( void *arg )
+{
+	REC_CHAN *ch = (REC_CHAN*)arg;
+	Z147REC_HDR *hdr;
+	REC_BUF *buf;
+	int32 cnt, cnt2, inSync, len;
+	int64 tsNs, monoNs;
+	u_int32 lost;
+
+	while(1){
+		while(sem_wait(&ch->sem) != 0 && errno == EINTR)
+			;
+		if(G_stop)
+			break;
+
+		/* the signal may come from another device */
+		if(M_getstat(ch->path, Z147_RX_FRAME_CNT, &cnt) < 0){
+			ch->readErrs++;
+			continue;
+		}
+		if(ch->haveCnt && (u_int32)cnt == ch->lastCnt)
+			continue;
+
+		monoNs = NowNs(CLOCK_MONOTONIC);
+		tsNs   = NowNs(CLOCK_REALTIME);
+		lost   = ch->haveCnt ? (u_int32)cnt - ch->lastCnt - 1 : 0;
+		ch->haveCnt = 1;
+		ch->lastCnt = (u_int32)cnt;
+		ch->lost += lost;
+		ch->pendLost += lost;
+
+		if((buf = PoolGet()) == NULL){
+			/* writer too slow */
+			ch->dropped++;
+			ch->pendLost++;
+			continue;
+		}
+
+		len = M_getblock(ch->path, buf->mem + sizeof(Z147REC_HDR),
+						 G_frameBytes);
+		if(len <= 0){
+			ch->readErrs++;
+			PoolPut(buf);
+			continue;
+		}
+		if(M_getstat(ch->path, Z147_RX_FRAME_CNT, &cnt2) < 0)
+			cnt2 = cnt;
+		if(M_getstat(ch->path, Z147_RX_IN_SYNC, &inSync) < 0)
+			inSync = 0;
+
+		hdr = (Z147REC_HDR*)buf->mem;
+		memset(hdr, 0, sizeof(*hdr));
+		hdr->magic    = Z147REC_MAGIC;
+		hdr->type     = Z147REC_TYPE_FRAME;
+		hdr->channel  = ch->idx;
+		hdr->size     = Z147REC_REC_SIZE((u_int32)len);
+		hdr->dataLen  = (u_int32)len;
+		hdr->seq      = ch->seq++;
+		hdr->frameCnt = (u_int32)cnt;
+		hdr->tsNs     = tsNs;
+		hdr->monoNs   = monoNs;
+		hdr->rate     = (u_int16)G_rate;
+		hdr->lost     = ch->pendLost;
+		hdr->errSigs  = G_errSigs;
+		if(inSync)
+			hdr->status |= Z147REC_ST_INSYNC;
+		else
+			ch->noSync++;
+		if(cnt2 != cnt){
+			hdr->status |= Z147REC_ST_TORN;
+			ch->torn++;
+		}
+		if(ch->pendLost)
+			hdr->status |= Z147REC_ST_LOST;
+		if(G_packed)
+			hdr->status |= Z147REC_ST_PACKED;
+		ch->pendLost = 0;
+
+		/* clear the padding, the record goes to disk as it is */
+		memset(buf->mem + sizeof(Z147REC_HDR) + len, 0,
+			   hdr->size - sizeof(Z147REC_HDR) - len);
+
+		ch->frames++;
+		Queue(buf);
+	}
+	return NULL;
+}
+
+/********************************* WriterThread ****************************/
+/** Collect queued records and write them to the segment files
+ *
+ *  \param arg        \IN  not used
+ *
+ *  \return	          NULL
+ */
+static void *WriterThread( void *arg )
+{
+	struct timespec ts;
+	REC_BUF *buf;
+	int64 flushNs = 0, nowNs;
+	int64 flushIv = (int64)G_flushMs * 1000000;
+
+	while(1){
+		pthread_mutex_lock(&G_lock);
+		while(G_qHead == NULL && !G_wrStop){
+			if(G_fill == 0){
+				pthread_cond_wait(&G_wrCond, &G_lock);
+				continue;
+			}
+			/* partial block pending: wait until it is due */
+			nowNs = NowNs(CLOCK_REALTIME);
+			if(nowNs >= flushNs)
+				break;
+			ts.tv_sec  = (time_t)(flushNs / 1000000000);
+			ts.tv_nsec = (long)(flushNs % 1000000000);
+			pthread_cond_timedwait(&G_wrCond, &G_lock, &ts);
+		}
+		buf = G_qHead;
+		if(buf){
+			G_qHead = buf->next;
+			if(G_qHead == NULL)
+				G_qTail = NULL;
+			G_qSum += G_qDepth;
+			G_qSamples++;
+			G_qDepth--;
+		}
+		pthread_mutex_unlock(&G_lock);
+
+		if(buf){
+			/* first data of a new block: start the flush timer */
+			if(G_fill == 0)
+				flushNs = NowNs(CLOCK_REALTIME) + flushIv;
+			Append(buf);
+			PoolPut(buf);
+			continue;
+		}
+
+		/* timeout or stop */
+		if(G_fill)
+			Flush(1);
+		if(G_wrStop)
+			break;
+	}
+
+	SegClose();
+	return NULL;
+}
+
+/********************************* Append **********************************/
+/** Add a record to the write block, write full blocks
+ *
+ *  \param buf        \IN  pool buffer
+ */
+static void Append( REC_BUF *buf )
+{
+	u_int32 size = ((Z147REC_HDR*)buf->mem)->size;
+
+	/* records never cross segments */
+	if(G_segBytes + G_fill + size > G_segMax){
+		Flush(1);
+		SegClose();
+		SegOpen();
+	}
+	if(G_fill + size > G_batchSize)
+		Flush(0);
+
+	memcpy(G_batch + G_fill, buf->mem, size);
+	G_fill += size;
+}
+
+/********************************* Flush ***********************************/
+/** Write the aligned part of the write block
+ *
+ *  Without padding the rest (less than Z147REC_ALIGN bytes) stays in the
+ *  block, with padding a pad record fills the block up to the next
+ *  boundary and everything is written.
+ *
+ *  \param pad        \IN  write everything
+ */
+static void Flush( int pad )
+{
+	Z147REC_HDR *hdr;
+	u_int32 len, gap;
+	int64 t0, us;
+	ssize_t n;
+
+	if(pad){
+		gap = (Z147REC_ALIGN - (G_fill % Z147REC_ALIGN)) % Z147REC_ALIGN;
+		if(gap){
+			hdr = (Z147REC_HDR*)(G_batch + G_fill);
+			memset(hdr, 0, gap);
+			hdr->magic = Z147REC_MAGIC;
+			hdr->type  = Z147REC_TYPE_PAD;
+			hdr->size  = gap;
+			G_fill += gap;
+		}
+	}
+	len = G_fill & ~(u_int32)(Z147REC_ALIGN - 1);
+	if(len == 0)
+		return;
+
+	if(G_fd >= 0){
+		t0 = NowNs(CLOCK_MONOTONIC);
+		n = write(G_fd, G_batch, len);
+		us = (NowNs(CLOCK_MONOTONIC) - t0) / 1000;
+
+		G_wrCalls++;
+		if(n != (ssize_t)len){
+			G_wrErrs++;
+		}else{
+			G_wrBytes  += len;
+			G_segBytes += len;
+		}
+		G_wrLat[(G_wrCalls - 1) % LAT_RING] = (u_int32)us;
+		if(us > G_wrLatMax)
+			G_wrLatMax = us;
+	}else{
+		G_wrErrs++;
+	}
+
+	G_fill -= len;
+	if(G_fill)
+		memmove(G_batch, G_batch + len, G_fill);
+}
+
+/********************************* SegOpen *********************************/
+/** Open the next segment file and write its header
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 SegOpen( void )
+{
+	Z147REC_FILE_HDR *fh = (Z147REC_FILE_HDR*)G_batch;
+	char name[512];
+	int flags = O_WRONLY | O_CREAT | O_TRUNC;
+	u_int32 i;
+
+	/* the last pad record may exceed the segment size */
+	SegTrim(G_segMax + Z147REC_ALIGN);
+
+	snprintf(name, sizeof(name), "%s/%s_%06u.z147", G_dir, G_prefix,
+			 G_segNum);
+	G_fd = -1;
+	if(G_direct && O_DIRECT){
+		G_fd = open(name, flags | O_DIRECT, 0644);
+		if(G_fd < 0 && errno == EINVAL){
+			/* file system without O_DIRECT (e.g. tmpfs) */
+			printf("*** %s: O_DIRECT not supported, buffered writes\n", name);
+			G_direct = 0;
+		}
+	}
+	if(G_fd < 0 && !(G_direct && O_DIRECT))
+		G_fd = open(name, flags, 0644);
+	if(G_fd < 0){
+		printf("*** can't create %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+	/* reserve the segment, fewer metadata updates while recording */
+	posix_fallocate(G_fd, 0, (off_t)G_segMax);
+
+	/* header block in front of the (empty) write block */
+	memset(G_batch, 0, Z147REC_ALIGN);
+	memcpy(fh->magic, Z147REC_FILE_MAGIC, sizeof(Z147REC_FILE_MAGIC));
+	fh->version   = Z147REC_VERSION;
+	fh->hdrSize   = Z147REC_ALIGN;
+	fh->segment   = G_segNum;
+	fh->channels  = G_chNum;
+	fh->createdNs = NowNs(CLOCK_REALTIME);
+	for(i=0; i<G_chNum; i++){
+		fh->rate[i] = (u_int32)G_rate;
+		strncpy(fh->name[i], G_ch[i].name, Z147REC_NAME_LEN - 1);
+	}
+	G_fill = Z147REC_ALIGN;
+	G_segBytes = 0;
+	Flush(0);
+	return 0;
+}
+
+/********************************* SegClose ********************************/
+/** Write the rest and close the current segment */
+static void SegClose( void )
+{
+	if(G_fd < 0)
+		return;
+	if(G_fill)
+		Flush(1);
+
+	/* give back the unused reservation */
+	if(ftruncate(G_fd, (off_t)G_segBytes) != 0)
+		G_wrErrs++;
+	if(!G_direct)
+		fdatasync(G_fd);
+	close(G_fd);
+	G_fd = -1;
+
+	if(G_segCnt == MAX_SEGS)
+		SegTrim((u_int64)-1);
+	G_seg[G_segCnt].num  = G_segNum;
+	G_seg[G_segCnt].size = G_segBytes;
+	G_segCnt++;
+	G_diskUsed += G_segBytes;
+	G_segNum++;
+}
+
+/********************************* SegTrim *********************************/
+/** Delete the oldest segments until there is room for a new one
+ *
+ *  \param need       \IN  bytes needed, (u_int64)-1 deletes the oldest
+ */
+static void SegTrim( u_int64 need )
+{
+	char name[512];
+	u_int32 i;
+
+	while(G_segCnt &&
+		  (need == (u_int64)-1 || G_diskUsed + need > G_diskMax)){
+		snprintf(name, sizeof(name), "%s/%s_%06u.z147", G_dir, G_prefix,
+				 G_seg[0].num);
+		unlink(name);
+		G_diskUsed -= G_seg[0].size;
+		G_segDeleted++;
+		for(i=1; i<G_segCnt; i++)
+			G_seg[i-1] = G_seg[i];
+		G_segCnt--;
+		if(need == (u_int64)-1)
+			break;
+	}
+}
+
+/********************************* PoolInit ********************************/
+/** Allocate the aligned record buffers
+ *
+ *  \param num        \IN  number of buffers
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 PoolInit( u_int32 num )
+{
+	u_int32 i;
+
+	G_bufs = (REC_BUF*)calloc(num, sizeof(REC_BUF));
+	if(G_bufs == NULL)
+		return -1;
+	G_poolNum = num;
+	for(i=0; i<num; i++){
+		if(posix_memalign((void**)&G_bufs[i].mem, Z147REC_ALIGN,
+						  G_recSize) != 0)
+			return -1;
+		/* touch the pages now, not while recording */
+		memset(G_bufs[i].mem, 0, G_recSize);
+		G_bufs[i].next = G_free;
+		G_free = &G_bufs[i];
+	}
+	return 0;
+}
+
+/********************************* PoolExit ********************************/
+/** Free the record buffers */
+static void PoolExit( void )
+{
+	u_int32 i;
+
+	if(G_bufs == NULL)
+		return;
+	for(i=0; i<G_poolNum; i++)
+		free(G_bufs[i].mem);
+	free(G_bufs);
+	G_bufs = NULL;
+}
+
+/********************************* PoolGet *********************************/
+/** Take a free buffer
+ *
+ *  \return	          buffer or NULL if the pool is empty
+ */
+static REC_BUF *PoolGet( void )
+{
+	REC_BUF *buf;
+
+	pthread_mutex_lock(&G_lock);
+	if((buf = G_free) != NULL)
+		G_free = buf->next;
+	pthread_mutex_unlock(&G_lock);
+	return buf;
+}
+
+/********************************* PoolPut *********************************/
+/** Return a buffer to the pool
+ *
+ *  \param buf        \IN  buffer
+ */
+static void PoolPut( REC_BUF *buf )
+{
+	pthread_mutex_lock(&G_lock);
+	buf->next = G_free;
+	G_free = buf;
+	pthread_mutex_unlock(&G_lock);
+}
+
+/********************************* Queue ***********************************/
+/** Pass a filled buffer to the writer
+ *
+ *  \param buf        \IN  buffer
+ */
+static void Queue( REC_BUF *buf )
+{
+	buf->next = NULL;
+	pthread_mutex_lock(&G_lock);
+	if(G_qTail)
+		G_qTail->next = buf;
+	else
+		G_qHead = buf;
+	G_qTail = buf;
+	if(++G_qDepth > G_qMax)
+		G_qMax = G_qDepth;
+	pthread_cond_signal(&G_wrCond);
+	pthread_mutex_unlock(&G_lock);
+}
+
+/********************************* NowNs ***********************************/
+/** Time in ns
+ *
+ *  \param clk        \IN  CLOCK_REALTIME or CLOCK_MONOTONIC
+ */
+static int64 NowNs( clockid_t clk )
+{
+	struct timespec ts;
+
+	clock_gettime(clk, &ts);
+	return (int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/********************************* LatPercentile ***************************/
+/** Write latency percentile of the last LAT_RING writes
+ *
+ *  \param pct        \IN  percent
+ *
+ *  \return	          latency in us
+ */
+static u_int32 LatPercentile( u_int32 pct )
+{
+	static u_int32 sorted[LAT_RING];
+	u_int32 num = G_wrCalls < LAT_RING ? G_wrCalls : LAT_RING;
+
+	if(num == 0)
+		return 0;
+	memcpy(sorted, G_wrLat, num * sizeof(u_int32));
+	qsort(sorted, num, sizeof(u_int32), CmpU32);
+	return sorted[(num - 1) * pct / 100];
+}
+
+/********************************* CmpU32 **********************************/
+/** qsort compare function for u_int32 */
+static int CmpU32( const void *a, const void *b )
+{
+	u_int32 x = *(const u_int32*)a, y = *(const u_int32*)b;
+
+	return (x > y) - (x < y);
+}
+
+/********************************* PrintStatus *****************************/
+/** Print one status line
+ *
+ *  \param sec        \IN  seconds since start
+ */
+static void PrintStatus( u_int32 sec )
+{
+	u_int32 i, frames = 0, lost = 0;
+
+	for(i=0; i<G_chNum; i++){
+		frames += G_ch[i].frames;
+		lost   += G_ch[i].lost + G_ch[i].dropped;
+	}
+	printf("%6us: frames %u lost %u, %.1f MB in seg %u, queue %u (max %u), "
+		   "write p50 %u us max %lld us\n", sec, frames, lost,
+		   (double)G_wrBytes / MB, G_segNum, G_qDepth, G_qMax,
+		   LatPercentile(50), (long long)G_wrLatMax);
+	fflush(stdout);
+}
+
+/********************************* PrintReport *****************************/
+/** Print the final statistics
+ *
+ *  \param sec        \IN  recording time in s
+ */
+static void PrintReport( u_int32 sec )
+{
+	u_int32 i;
+
+	printf("\n--------------------- Recording ---------------------\n");
+	for(i=0; i<G_chNum; i++){
+		printf("%-16s: frames %u, lost %u, dropped %u, torn %u, "
+			   "no sync %u, errors %u\n", G_ch[i].name, G_ch[i].frames,
+			   G_ch[i].lost, G_ch[i].dropped, G_ch[i].torn, G_ch[i].noSync,
+			   G_ch[i].readErrs);
+	}
+	printf("Error signals: %u\n", G_errSigs);
+	printf("Writes      : %u (%s), %.1f MB, %.2f MB/s, errors %u\n",
+		   G_wrCalls, G_direct ? "O_DIRECT" : "buffered",
+		   (double)G_wrBytes / MB,
+		   sec ? (double)G_wrBytes / MB / sec : 0.0, G_wrErrs);
+	printf("Write time  : p50 %u us, p99 %u us (last %u), max %lld us\n",
+		   LatPercentile(50), LatPercentile(99),
+		   G_wrCalls < LAT_RING ? G_wrCalls : LAT_RING, (long long)G_wrLatMax);
+	printf("Queue depth : mean %.2f, max %u of %u buffers\n",
+		   G_qSamples ? (double)G_qSum / G_qSamples : 0.0, G_qMax,
+		   G_poolNum);
+	printf("Segments    : %u written, %u deleted, %.1f MB on disk\n",
+		   G_segNum, G_segDeleted, (double)G_diskUsed / MB);
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/****************************** SignalHandler ******************************/
+/** Signal handler: wake up the readers of all channels
+ *
+ *  Only async signal safe calls, no printf and no driver access.
+ *
+ *  \param  sig    \IN   received signal
+ */
+static void __MAPILIB SignalHandler( u_int32 sig )
+{
+	u_int32 i;
+
+	if(sig == UOS_SIG_USR1){
+		for(i=0; i<G_chNum; i++)
+			sem_post(&G_ch[i].sem);
+	}else if(sig == UOS_SIG_USR2){
+		G_errSigs++;
+	}
+}
+
+/****************************** SigIntHandler ******************************/
+/** Ctrl-C: stop the recording */
+static void SigIntHandler( int sig )
+{
+	G_sigInt = 1;
+}
@@ -0,0 +1,743 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_REPLAY                      ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_replay.c
+ *       \author Apatil
+ *
+ *       \brief  Replay of recorded frames with a Z247 transmitter
+ *
+ *               Sends the frames of one channel of a z147_recorder
+ *               recording (format see z147_rec.h) at their original timing.
+ *
+ *               The segment files are memory mapped. While playing, the
+ *               pages ahead of the playback cursor are requested with
+ *               madvise(MADV_WILLNEED), the pages behind it are released.
+ *
+ *               Frames are paced by the transmitter, not by sleeps: the
+ *               driver sends #Z247_SET_FRAME_SIGNAL whenever it starts a
+ *               frame, then the frame for the following frame slot is
+ *               written. A recorded frame is assigned to the slot of its
+ *               time stamp relative to the first frame. If the recording
+ *               has a gap, no frame is written and the transmitter repeats
+ *               the last one; if several frames fall into one slot, only
+ *               the newest is sent.
+ *
+ *               Speed up for bench tests: -x=<n> plays n frame times of the
+ *               recording per transmitted frame (every n-th frame), -m=1
+ *               sends all frames back to back and ignores the gaps.
+ *
+ *               The timing error of every sent frame is its transmit time
+ *               minus its recorded time (both relative to the first frame,
+ *               the recorded time divided by the speed up factor). With
+ *               -o the values are exported as CSV:
+ *
+ *               frame,seq,slot,rec_us,tx_us,err_us
+ *
+ *               Packed recordings (#Z147REC_ST_PACKED) are unpacked
+ *               frame by frame before they are sent.
+ *
+ *     Required: libraries: mdis_api, usr_oss, z147_pack
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_replay.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z247_drv.h>
+#include <MEN/z147_rec.h>
+#include <MEN/z147_pack.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define Z147_FRAME_TIME_NS  4000000000LL    /**< nominal frame time */
+#define MAX_DATA_LEN        32768           /**< frame length at 8192 words/s */
+#define SIG_RING            64              /**< pending signal time stamps */
+#define SIG_TIMEOUT_S       10              /**< transmitter stalled */
+#define PERIOD_FRAMES       64              /**< frames to estimate the period */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** one mapped segment file */
+typedef struct {
+	char    *name;              /**< file name */
+	u_int8  *base;              /**< mapping */
+	size_t  size;               /**< file size */
+	size_t  done;               /**< released up to here */
+	size_t  ahead;              /**< prefetched up to here */
+} RP_SEG;
+
+/** playback cursor */
+typedef struct {
+	u_int32 seg;                /**< segment index */
+	size_t  off;                /**< offset of the next record */
+} RP_CURSOR;
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static RP_SEG   *G_seg;
+static u_int32  G_segNum;
+static u_int32  G_chan;
+static u_int32  G_rate;                     /**< data rate of the channel */
+static size_t   G_ahead;                    /**< prefetch window in bytes */
+static size_t   G_page;
+
+static sem_t    G_sigSem;
+static int64    G_sigTs[SIG_RING];          /**< written by signal handler */
+static volatile u_int32 G_sigHead;          /**< signal handler index */
+static u_int32  G_sigTail;                  /**< main thread index */
+static volatile u_int32 G_sigLost;          /**< ring overflows */
+static volatile u_int32 G_errSigs;          /**< transmit error signals */
+static volatile int G_sigInt;               /**< Ctrl-C */
+
+/* statistics */
+static u_int32  G_corrupt;                  /**< segments with bad records */
+static u_int32  G_invalid;                  /**< records with wrong length */
+static u_int16  G_rxBuf[MAX_DATA_LEN];      /**< unpacked frame */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void PrintError(char *info);
+static void __MAPILIB SignalHandler( u_int32 sig );
+static void SigIntHandler( int sig );
+static int32 MapSegments( char **names, u_int32 num, u_int32 *rateP );
+static void UnmapSegments( void );
+static Z147REC_HDR *NextFrame( RP_CURSOR *cur );
+static void Prefetch( RP_CURSOR *cur );
+static int64 RecPeriod( RP_CURSOR *start );
+static int CmpI64( const void *a, const void *b );
+static void ToTxFrame( Z147REC_HDR *rec, u_int16 *tx, u_int32 sfs );
+static int32 WaitFrameStart( MDIS_PATH path, int64 *tsP, u_int32 *cntP );
+static int64 NowNs( void );
+static double Sqrt( double x );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *txDevice = NULL, *csvName = NULL;
+	char **files = NULL;
+	FILE *csv = NULL;
+	MDIS_PATH txPath = -1;
+	RP_CURSOR cur;
+	Z147REC_HDR *rec, *next;
+	u_int16 *txBuf;
+	u_int32 fileNum = 0, speed = 1, ahead = 32, rate = 0, sfs;
+	u_int32 cnt, slotBase = 0, slot;
+	int32 mode = 0, errors = 0, i;
+	int64 recTs0 = 0, txRef = 0, recRef = 0, ts, recSlot, errUs, period;
+	int64 errMin = 0, errMax = 0;
+	double errSum = 0.0, errSq = 0.0, mean;
+	u_int32 sent = 0, timed = 0, held = 0, skipped = 0, recIdx = 0;
+	u_int32 pendSeq = 0;
+	int64 pendRecTs = 0;
+	int pending = 0;
+
+	files = (char**)calloc(argc, sizeof(char*));
+	if(files == NULL)
+		return(1);
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-c=", 3) == 0){
+			G_chan = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-m=", 3) == 0){
+			mode = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-x=", 3) == 0){
+			speed = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-a=", 3) == 0){
+			ahead = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-o=", 3) == 0){
+			csvName = argv[i] + 3;
+		}else if(argv[i][0] != '-' && txDevice == NULL){
+			txDevice = argv[i];
+		}else if(argv[i][0] != '-'){
+			files[fileNum++] = argv[i];
+		}else{
+			txDevice = NULL;
+			break;
+		}
+	}
+
+	if(txDevice == NULL || fileNum == 0 || speed == 0 ||
+	   (mode != 0 && mode != 1) || G_chan >= Z147REC_MAX_CH){
+		printf("Syntax: z147_replay [<opts>] <txDevice> <segment> "
+			   "[<segment>...]\n");
+		printf("Function: replay recorded frames with the transmitter\n");
+		printf("Options:\n");
+		printf("    -c=<n>     recorded channel                  [0]\n");
+		printf("    -m=<mode>  0=original timing, 1=back to back [0]\n");
+		printf("    -x=<n>     speed up, play every n-th frame   [1]\n");
+		printf("    -a=<n>     frames prefetched ahead           [32]\n");
+		printf("    -o=<file>  export timing errors as CSV\n");
+		free(files);
+		return(1);
+	}
+
+	if(MapSegments(files, fileNum, &rate) != 0){
+		free(files);
+		return(1);
+	}
+	free(files);
+
+	sfs = 64 << rate;
+	G_page  = (size_t)sysconf(_SC_PAGESIZE);
+	G_ahead = (size_t)ahead * Z147REC_REC_SIZE(8 * sfs);
+	txBuf = (u_int16*)calloc(MAX_DATA_LEN, sizeof(u_int16));
+	if(txBuf == NULL || sem_init(&G_sigSem, 0, 0) != 0){
+		printf("*** can't allocate buffers\n");
+		UnmapSegments();
+		return(1);
+	}
+
+	if(csvName){
+		if((csv = fopen(csvName, "w")) == NULL){
+			printf("*** can't create %s\n", csvName);
+			errors++;
+			goto CLEANUP;
+		}
+		fprintf(csv, "frame,seq,slot,rec_us,tx_us,err_us\n");
+	}
+
+	memset(&cur, 0, sizeof(cur));
+	cur.off = Z147REC_ALIGN;
+	period = RecPeriod(&cur);
+	if((rec = NextFrame(&cur)) == NULL){
+		printf("*** no frames of channel %u\n", G_chan);
+		errors++;
+		goto CLEANUP;
+	}
+	recTs0 = rec->tsNs;
+
+	/*--------------------+
+	|  open               |
+	+--------------------*/
+	if((txPath = M_open(txDevice)) < 0){
+		PrintError("open");
+		errors++;
+		goto CLEANUP;
+	}
+
+	signal(SIGINT, SigIntHandler);
+	UOS_SigInit( SignalHandler );
+	UOS_SigInstall( UOS_SIG_USR1 );
+	UOS_SigInstall( UOS_SIG_USR2 );
+
+	if(M_setstat(txPath, Z247_TX_DATA_RATE, rate) < 0 ||
+	   M_setstat(txPath, Z247_SET_FRAME_SIGNAL, UOS_SIG_USR1) < 0 ||
+	   M_setstat(txPath, Z247_SET_SIGNAL, UOS_SIG_USR2) < 0){
+		PrintError("setstat");
+		errors++;
+		goto CLEANUP;
+	}
+
+	printf("Replay of channel %u at %u words/s, %s, speed x%u, "
+		   "recorded frame period %lld us\n", G_chan, sfs,
+		   mode ? "back to back" : "original timing", speed,
+		   (long long)(period / 1000));
+	fflush(stdout);
+
+	/* the first write starts the transmitter */
+	ToTxFrame(rec, txBuf, sfs);
+	if(M_setblock(txPath, (u_int8*)txBuf, (4 * sfs - 4) * 2) < 0){
+		PrintError("write");
+		errors++;
+		goto CLEANUP;
+	}
+	pending = 1;
+	pendSeq = rec->seq;
+	pendRecTs = rec->tsNs;
+	recIdx = 1;
+	next = NextFrame(&cur);
+
+	/*--------------------+
+	|  play               |
+	+--------------------*/
+	while(!G_sigInt){
+		if(WaitFrameStart(txPath, &ts, &cnt) != 0){
+			printf("*** transmitter stalled\n");
+			errors++;
+			break;
+		}
+
+		/* the frame written last is on the line now */
+		if(pending){
+			if(sent == 0)
+				slotBase = cnt;
+			/*
+			 * The first frame goes into the empty FIFO at once, the
+			 * following ones when the FIFO has space: the time reference
+			 * is the second frame.
+			 */
+			if(sent <= 1){
+				txRef  = ts;
+				recRef = pendRecTs;
+			}
+			errUs = ((ts - txRef) - (pendRecTs - recRef) / (int64)speed) /
+					1000;
+			if(sent >= 1){
+				if(timed == 0 || errUs < errMin)
+					errMin = errUs;
+				if(timed == 0 || errUs > errMax)
+					errMax = errUs;
+				errSum += (double)errUs;
+				errSq  += (double)errUs * errUs;
+				timed++;
+			}
+			if(csv)
+				fprintf(csv, "%u,%u,%u,%lld,%lld,%lld\n", sent, pendSeq,
+						cnt - slotBase,
+						(long long)((pendRecTs - recRef) / 1000),
+						(long long)((ts - txRef) / 1000), (long long)errUs);
+			sent++;
+			pending = 0;
+		}
+		if(next == NULL)
+			break;
+
+		/* slot that starts with the next frame signal */
+		slot = cnt - slotBase + 1;
+
+		/*
+		 * Newest recorded frame up to that slot, older ones are skipped.
+		 * Slot k holds the frames recorded after (k - 1) and up to k
+		 * speed up intervals, within half a frame time.
+		 */
+		rec = NULL;
+		while(next){
+			if(mode == 1)
+				recSlot = (int64)(recIdx + speed - 1) / speed;
+			else
+				recSlot = ((next->tsNs - recTs0) + period * speed -
+						   period / 2) / (period * speed);
+			if(recSlot > (int64)slot)
+				break;
+			if(rec)
+				skipped++;
+			rec = next;
+			recIdx++;
+			next = NextFrame(&cur);
+		}
+
+		if(rec == NULL){
+			/* gap in the recording, the last frame is repeated */
+			held++;
+		}else{
+			ToTxFrame(rec, txBuf, sfs);
+			if(M_setblock(txPath, (u_int8*)txBuf, (4 * sfs - 4) * 2) < 0){
+				PrintError("write");
+				errors++;
+				break;
+			}
+			pending = 1;
+			pendSeq = rec->seq;
+			pendRecTs = rec->tsNs;
+		}
+
+		Prefetch(&cur);
+	}
+
+	M_setstat(txPath, Z247_CLR_FRAME_SIGNAL, 0);
+	M_setstat(txPath, Z247_CLR_SIGNAL, 0);
+
+	/*--------------------+
+	|  report             |
+	+--------------------*/
+	printf("\n---------------------- Replay -----------------------\n");
+	printf("Frames      : sent %u, held (gaps) %u, skipped %u, invalid %u\n",
+		   sent, held, skipped, G_invalid);
+	if(timed){
+		mean = errSum / timed;
+		printf("Timing error: mean %+.0f us, std %.0f us, min %+lld us, "
+			   "max %+lld us\n", mean, Sqrt(errSq / timed - mean * mean),
+			   (long long)errMin, (long long)errMax);
+	}
+	printf("Signals     : errors %u, time stamps lost %u\n", G_errSigs,
+		   G_sigLost);
+	if(G_corrupt)
+		printf("*** %u segment(s) with corrupt records\n", G_corrupt);
+
+CLEANUP:
+	UOS_SigRemove( UOS_SIG_USR1 );
+	UOS_SigRemove( UOS_SIG_USR2 );
+	UOS_SigExit();
+
+	if(txPath >= 0 && M_close(txPath) < 0)
+		PrintError("close");
+
+	if(csv)
+		fclose(csv);
+	sem_destroy(&G_sigSem);
+	free(txBuf);
+	UnmapSegments();
+
+	return(errors ? 1 : 0);
+}
+
+/********************************* MapSegments *****************************/
+/** Map the segment files and check their headers
+ *
+ *  \param names      \IN  file names in recording order
+ *  \param num        \IN  number of files
+ *  \param rateP      \OUT data rate of the channel
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 MapSegments( char **names, u_int32 num, u_int32 *rateP )
+{
+	Z147REC_FILE_HDR *fh;
+	struct stat st;
+	u_int32 i;
+	int fd;
+
+	G_seg = (RP_SEG*)calloc(num, sizeof(RP_SEG));
+	if(G_seg == NULL)
+		return -1;
+
+	for(i=0; i<num; i++){
+		if((fd = open(names[i], O_RDONLY)) < 0 || fstat(fd, &st) != 0){
+			printf("*** can't open %s: %s\n", names[i], strerror(errno));
+			goto ERR_EXIT;
+		}
+		if(st.st_size < Z147REC_ALIGN){
+			printf("*** %s: no recording\n", names[i]);
+			close(fd);
+			goto ERR_EXIT;
+		}
+		G_seg[i].base = (u_int8*)mmap(NULL, (size_t)st.st_size, PROT_READ,
+									  MAP_SHARED, fd, 0);
+		close(fd);
+		if(G_seg[i].base == MAP_FAILED){
+			printf("*** can't map %s: %s\n", names[i], strerror(errno));
+			goto ERR_EXIT;
+		}
+		G_seg[i].name = names[i];
+		G_seg[i].size = (size_t)st.st_size;
+		G_segNum++;
+		madvise(G_seg[i].base, G_seg[i].size, MADV_SEQUENTIAL);
+
+		fh = (Z147REC_FILE_HDR*)G_seg[i].base;
+		if(memcmp(fh->magic, Z147REC_FILE_MAGIC,
+				  sizeof(Z147REC_FILE_MAGIC)) != 0 ||
+		   fh->version != Z147REC_VERSION || fh->hdrSize != Z147REC_ALIGN){
+			printf("*** %s: not a Z147 recording\n", names[i]);
+			goto ERR_EXIT;
+		}
+		if(G_chan >= fh->channels){
+			printf("*** %s: no channel %u\n", names[i], G_chan);
+			goto ERR_EXIT;
+		}
+		if(i == 0)
+			G_rate = fh->rate[G_chan];
+		else if(fh->rate[G_chan] != G_rate){
+			printf("*** %s: different data rate\n", names[i]);
+			goto ERR_EXIT;
+		}
+	}
+	*rateP = G_rate;
+	return 0;
+
+ERR_EXIT:
+	UnmapSegments();
+	return -1;
+}
+
+/********************************* UnmapSegments ***************************/
+/** Unmap all segment files */
+static void UnmapSegments( void )
+{
+	u_int32 i;
+
+	for(i=0; i<G_segNum; i++)
+		munmap(G_seg[i].base, G_seg[i].size);
+	free(G_seg);
+	G_seg = NULL;
+	G_segNum = 0;
+}
+
+/********************************* NextFrame *******************************/
+/** Find the next frame record of the selected channel
+ *
+ *  A damaged record ends its segment, the search goes on with the next.
+ *
+ *  \param cur        \IN  cursor, advanced behind the record
+ *
+ *  \return	          record or NULL at the end of the recording
+ */
+static Z147REC_HDR *NextFrame( RP_CURSOR *cur )
+{
+	Z147REC_HDR *hdr;
+	RP_SEG *seg;
+	u_int32 len;
+
+	while(cur->seg < G_segNum){
+		seg = &G_seg[cur->seg];
+		if(cur->off + sizeof(Z147REC_HDR) > seg->size){
+			cur->seg++;
+			cur->off = Z147REC_ALIGN;
+			continue;
+		}
+		hdr = (Z147REC_HDR*)(seg->base + cur->off);
+		if(hdr->magic != Z147REC_MAGIC || hdr->size < sizeof(Z147REC_HDR) ||
+		   hdr->size % Z147REC_REC_ALIGN || cur->off + hdr->size > seg->size){
+			G_corrupt++;
+			cur->seg++;
+			cur->off = Z147REC_ALIGN;
+			continue;
+		}
+		cur->off += hdr->size;
+
+		if(hdr->type != Z147REC_TYPE_FRAME || hdr->channel != G_chan)
+			continue;
+		if(hdr->status & Z147REC_ST_PACKED)
+			len = Z147_PACKED_SIZE(4 * (64u << G_rate));
+		else
+			len = 8 * (64u << G_rate);
+		if(hdr->rate != G_rate || hdr->dataLen != len ||
+		   hdr->dataLen > hdr->size - sizeof(Z147REC_HDR)){
+			G_invalid++;
+			continue;
+		}
+		return hdr;
+	}
+	return NULL;
+}
+
+/********************************* RecPeriod *******************************/
+/** Frame period of the recording
+ *
+ *  Median time between consecutive frames at the start of the recording,
+ *  the nominal frame time if there are not enough frames. The clock of the
+ *  recording host may differ from the transmitter clock.
+ *
+ *  \param start      \IN  cursor at the start (not changed)
+ *
+ *  \return	          period in ns
+ */
+static int64 RecPeriod( RP_CURSOR *start )
+{
+	int64 diff[PERIOD_FRAMES];
+	RP_CURSOR cur = *start;
+	Z147REC_HDR *rec, *last = NULL;
+	u_int32 num = 0, corrupt = G_corrupt, invalid = G_invalid;
+
+	while(num < PERIOD_FRAMES && (rec = NextFrame(&cur)) != NULL){
+		if(last && rec->lost == 0 && rec->tsNs > last->tsNs)
+			diff[num++] = rec->tsNs - last->tsNs;
+		last = rec;
+	}
+	/* counted again while playing */
+	G_corrupt = corrupt;
+	G_invalid = invalid;
+
+	if(num == 0)
+		return Z147_FRAME_TIME_NS;
+	qsort(diff, num, sizeof(int64), CmpI64);
+	return diff[num / 2];
+}
+
+/********************************* Prefetch ********************************/
+/** Read ahead of the cursor, release the pages behind it
+ *
+ *  \param cur        \IN  playback cursor
+ */
+static void Prefetch( RP_CURSOR *cur )
+{
+	RP_SEG *seg;
+	size_t from, to, left = G_ahead;
+	u_int32 i;
+
+	if(cur->seg >= G_segNum)
+		return;
+
+	/* whole pages behind the cursor are not needed again */
+	seg = &G_seg[cur->seg];
+	to = cur->off & ~(G_page - 1);
+	if(to > seg->done){
+		madvise(seg->base + seg->done, to - seg->done, MADV_DONTNEED);
+		seg->done = to;
+	}
+	for(i=0; i<cur->seg; i++){
+		if(G_seg[i].done < G_seg[i].size){
+			madvise(G_seg[i].base, G_seg[i].size, MADV_DONTNEED);
+			G_seg[i].done = G_seg[i].size;
+		}
+	}
+
+	/* window ahead, may reach into the next segments */
+	from = cur->off;
+	for(i=cur->seg; i<G_segNum && left; i++){
+		seg = &G_seg[i];
+		to = from + left < seg->size ? from + left : seg->size;
+		left -= to - from;
+		/* only when at least half of the window is new */
+		if(to > seg->ahead + G_ahead / 2 || to == seg->size){
+			if(to > seg->ahead){
+				from = seg->ahead > from ? seg->ahead : from;
+				from &= ~(G_page - 1);
+				madvise(seg->base + from, to - from, MADV_WILLNEED);
+				seg->ahead = to;
+			}
+		}
+		from = 0;
+	}
+}
+
+/********************************* ToTxFrame *******************************/
+/** Remove the sync words, the transmitter inserts them
+ *
+ *  \param rec        \IN  frame record
+ *  \param tx         \OUT transmit frame, 4 * sfs - 4 words
+ *  \param sfs        \IN  sub frame size
+ */
+static void ToTxFrame( Z147REC_HDR *rec, u_int16 *tx, u_int32 sfs )
+{
+	u_int16 *rx = (u_int16*)(rec + 1);
+	u_int32 sub;
+
+	if(rec->status & Z147REC_ST_PACKED){
+		Z147PK_Unpack((u_int8*)(rec + 1), G_rxBuf, 4 * sfs);
+		rx = G_rxBuf;
+	}
+
+	for(sub=0; sub<4; sub++)
+		memcpy(tx + sub * (sfs - 1), rx + sub * sfs + 1,
+			   (sfs - 1) * sizeof(u_int16));
+}
+
+/********************************* WaitFrameStart **************************/
+/** Wait for the next frame start of the transmitter
+ *
+ *  \param path       \IN  transmit path
+ *  \param tsP        \OUT time stamp of the signal
+ *  \param cntP       \OUT started frame count
+ *
+ *  \return	          0 or -1 on timeout
+ */
+static int32 WaitFrameStart( MDIS_PATH path, int64 *tsP, u_int32 *cntP )
+{
+	struct timespec ts;
+	int32 cnt;
+	int rv;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += SIG_TIMEOUT_S;
+	while((rv = sem_timedwait(&G_sigSem, &ts)) != 0 && errno == EINTR &&
+		  !G_sigInt)
+		;
+	if(rv != 0)
+		return -1;
+
+	*tsP = G_sigTs[G_sigTail % SIG_RING];
+	G_sigTail++;
+	if(M_getstat(path, Z247_TX_FRAME_CNT, &cnt) < 0)
+		return -1;
+	*cntP = (u_int32)cnt;
+	return 0;
+}
+
+/********************************* NowNs ***********************************/
+/** Monotonic time in ns (async signal safe) */
+static int64 NowNs( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/********************************* Sqrt ************************************/
+/** Square root (Newton), avoids linking the math library */
+static double Sqrt( double x )
+{
+	double r = x;
+	int i;
+
+	if(x <= 0.0)
+		return 0.0;
+	if(r < 1.0)
+		r = 1.0;
+	for(i=0; i<64; i++)
+		r = 0.5 * (r + x / r);
+	return r;
+}
+
+/********************************* CmpI64 **********************************/
+/** qsort compare function for int64 */
+static int CmpI64( const void *a, const void *b )
+{
+	int64 x = *(const int64*)a, y = *(const int64*)b;
+
+	return (x > y) - (x < y);
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/****************************** SignalHandler ******************************/
+/** Signal handler: time stamp the frame start and wake up the main thread
+ *
+ *  Only async signal safe calls, no printf and no driver access.
+ *
+ *  \param  sig    \IN   received signal
+ */
+static void __MAPILIB SignalHandler( u_int32 sig )
+{
+	u_int32 head = G_sigHead;
+
+	if(sig == UOS_SIG_USR1){
+		if(head - G_sigTail < SIG_RING){
+			G_sigTs[head % SIG_RING] = NowNs();
+			G_sigHead = head + 1;
+			sem_post(&G_sigSem);
+		}else{
+			G_sigLost++;
+		}
+	}else if(sig == UOS_SIG_USR2){
+		G_errSigs++;
+	}
+}
+
+/****************************** SigIntHandler ******************************/
+/** Ctrl-C: stop the replay */
+static void SigIntHandler( int sig )
+{
+	G_sigInt = 1;
+}
@@ -0,0 +1,296 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_SUPERFRAME                  ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_superframe.c
+ *       \author Apatil
+ *
+ *       \brief  Assemble superframes and report counter gaps
+ *
+ *               Passes the frames of an indexed frame file (z147_frm.h)
+ *               or, with -l, of a receiver through the superframe
+ *               assembler (z147_sf.h) and prints one CSV line per
+ *               superframe:
+ *
+ *               superframe,counter,frames,present,lost,dups
+ *
+ *               present is the hex mask of the received frame positions,
+ *               lost and dups are the frames lost and repeated since the
+ *               previous superframe. The counter word is given with -c,
+ *               else taken from the frame file header, else the frame
+ *               numbers of the file are the counter. Live frames are read
+ *               directly into the assembler buffers.
+ *
+ *     Required: libraries: z147_sf, z147_frm, mdis_api, usr_oss
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_superframe.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_frm.h>
+#include <MEN/z147_sf.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define POLL_TIME           10              /**< receiver poll time in ms */
+
+/*--------------------------------------+
+|   GLOBALS                             |
++--------------------------------------*/
+static volatile int G_sigInt;               /**< Ctrl-C */
+static int G_quiet;                         /**< summary only */
+static u_int32 G_superframes;               /**< superframes printed */
+static Z147SF_STATS G_last;                 /**< statistics of last line */
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static int32 RunFile( char *name, int32 sub, u_int32 word, u_int32 mask,
+					  u_int32 num );
+static int32 RunLive( char *device, u_int32 rate, int32 sub, u_int32 word,
+					  u_int32 mask, u_int32 num );
+static void Notify( void *arg, Z147SF_SUPER *sf );
+static void PrintStats( Z147SF_ASM *sa );
+static void PrintError(char *info);
+static void SigIntHandler( int sig );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	char *input = NULL;
+	u_int32 rate = 7, num = 0, word = 0, mask = 0;
+	int32 live = 0, sub = -1, i, rv;
+
+	for(i=1; i<argc; i++){
+		if(strcmp(argv[i], "-l") == 0){
+			live = 1;
+		}else if(strcmp(argv[i], "-q") == 0){
+			G_quiet = 1;
+		}else if(strncmp(argv[i], "-r=", 3) == 0){
+			rate = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			num = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-c=", 3) == 0){
+			if(sscanf(argv[i] + 3, "%d,%u,%x", &sub, &word, &mask) != 3 ||
+			   sub < 1 || sub > 4)
+				break;
+		}else if(argv[i][0] != '-' && input == NULL){
+			input = argv[i];
+		}else{
+			break;
+		}
+	}
+
+	if(i < argc || input == NULL || rate > 7 || (live && sub < 0)){
+		printf("Syntax: z147_superframe [<opts>] <frmFile>\n");
+		printf("        z147_superframe -l -c=<s>,<w>,<m> [<opts>] "
+			   "<rxDevice>\n");
+		printf("Function: assemble superframes and report counter gaps\n");
+		printf("Options:\n");
+		printf("    -l              assemble the frames of a receiver\n");
+		printf("    -r=<rate>       data rate 0..7 (64..8192 words/s) [7]\n");
+		printf("    -c=<s>,<w>,<m>  counter: subframe 1..4, word, hex "
+			   "mask\n");
+		printf("    -n=<n>          superframes (0=all / until Ctrl-C) "
+			   "[0]\n");
+		printf("    -q              print the summary only\n");
+		return(1);
+	}
+
+	if(!G_quiet)
+		printf("superframe,counter,frames,present,lost,dups\n");
+	if(live)
+		rv = RunLive(input, rate, sub, word, mask, num);
+	else
+		rv = RunFile(input, sub, word, mask, num);
+	return(rv == 0 ? 0 : 1);
+}
+
+/********************************* RunFile *********************************/
+/** Assemble the superframes of a frame file
+ *
+ *  \param name       \IN  frame file
+ *  \param sub        \IN  counter subframe or -1 (file header)
+ *  \param word       \IN  counter word
+ *  \param mask       \IN  counter bits
+ *  \param num        \IN  superframes (0 = all)
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 RunFile( char *name, int32 sub, u_int32 word, u_int32 mask,
+					  u_int32 num )
+{
+	Z147FRM_FILE *fp;
+	const Z147FRM_FRAME *frm;
+	Z147SF_ASM *sa;
+	u_int32 f;
+	int32 seq;
+
+	if((fp = Z147FRM_Open(name)) == NULL){
+		printf("*** can't open %s: %s\n", name,
+			   errno == EINVAL ? "not a frame file" : strerror(errno));
+		return -1;
+	}
+	if(sub < 0){
+		sub  = fp->hdr->sfSub <= 4 ? (int32)fp->hdr->sfSub : 0;
+		word = fp->hdr->sfWord;
+		mask = fp->hdr->sfMask;
+	}
+	if((sa = Z147SF_Init(fp->hdr->rate, (u_int32)sub, word, mask, 1,
+						 Notify, &sa)) == NULL){
+		printf("*** can't create assembler: %s\n", strerror(errno));
+		Z147FRM_Close(fp);
+		return -1;
+	}
+
+	/* the frame numbers are the counter without counter word */
+	for(f=0; f<fp->frames && (num == 0 || G_superframes < num); f++){
+		frm = Z147FRM_Frame(fp, f);
+		seq = sub ? -1 : (int32)(frm->seq & 0x7fffffff);
+		memcpy(Z147SF_Slot(sa), Z147FRM_DATA(frm),
+			   fp->hdr->frameWords * sizeof(u_int16));
+		Z147SF_Push(sa, seq);
+	}
+	if(num == 0 || G_superframes < num)
+		Z147SF_Flush(sa);
+
+	PrintStats(sa);
+	Z147SF_Exit(sa);
+	Z147FRM_Close(fp);
+	return 0;
+}
+
+/********************************* RunLive *********************************/
+/** Assemble the superframes of a receiver
+ *
+ *  \param device     \IN  receiver device name
+ *  \param rate       \IN  data rate
+ *  \param sub        \IN  counter subframe
+ *  \param word       \IN  counter word
+ *  \param mask       \IN  counter bits
+ *  \param num        \IN  superframes (0 = until Ctrl-C)
+ *
+ *  \return	          0 or -1 on error
+ */
+static int32 RunLive( char *device, u_int32 rate, int32 sub, u_int32 word,
+					  u_int32 mask, u_int32 num )
+{
+	MDIS_PATH path;
+	Z147SF_ASM *sa;
+	int32 cnt, lastCnt = -1, len, bytes, error = 0;
+
+	if((sa = Z147SF_Init(rate, (u_int32)sub, word, mask, 1, Notify,
+						 &sa)) == NULL){
+		printf("*** can't create assembler: %s\n", strerror(errno));
+		return -1;
+	}
+	bytes = (int32)Z147FRM_FRAME_WORDS(rate) * 2;
+
+	if((path = M_open(device)) < 0){
+		PrintError("open");
+		Z147SF_Exit(sa);
+		return -1;
+	}
+	if(M_setstat(path, Z147_RX_DATA_RATE, rate) < 0){
+		PrintError("setstat");
+		error = -1;
+		goto CLEANUP;
+	}
+
+	signal(SIGINT, SigIntHandler);
+	while(!G_sigInt && (num == 0 || G_superframes < num)){
+		if(M_getstat(path, Z147_RX_FRAME_CNT, &cnt) < 0){
+			PrintError("getstat");
+			error = -1;
+			break;
+		}
+		if(cnt != lastCnt){
+			lastCnt = cnt;
+			/* straight into the assembler, no copy */
+			len = M_getblock(path, (u_int8*)Z147SF_Slot(sa), bytes);
+			if(len == bytes)
+				Z147SF_Push(sa, -1);
+			fflush(stdout);
+		}
+		UOS_Delay(POLL_TIME);
+	}
+	PrintStats(sa);
+
+CLEANUP:
+	if(M_close(path) < 0)
+		PrintError("close");
+	Z147SF_Exit(sa);
+	return error;
+}
+
+/********************************* Notify **********************************/
+/** Superframe finished: print it and give it back
+ *
+ *  \param arg        \IN  assembler
+ *  \param sf         \IN  superframe
+ */
+static void Notify( void *arg, Z147SF_SUPER *sf )
+{
+	Z147SF_ASM *sa = *(Z147SF_ASM**)arg;
+	const Z147SF_STATS *st = Z147SF_Stats(sa);
+
+	if(!G_quiet)
+		printf("%u,%u,%u,0x%04x,%u,%u\n", sf->number, sf->counter,
+			   sf->frames, sf->present, st->lost - G_last.lost,
+			   st->dups - G_last.dups);
+	G_last = *st;
+	G_superframes++;
+	Z147SF_Put(sa, sf);
+}
+
+/********************************* PrintStats ******************************/
+/** Print the summary */
+static void PrintStats( Z147SF_ASM *sa )
+{
+	const Z147SF_STATS *st = Z147SF_Stats(sa);
+
+	printf("# frames %u, superframes %u (%u complete), lost %u, repeated %u, "
+		   "counter restarts %u\n", st->frames, st->superframes,
+		   st->complete, st->lost, st->dups, st->back);
+}
+
+/********************************* PrintError ******************************/
+/** Print MDIS error message
+ *
+ *  \param info       \IN  info string
+ */
+static void PrintError(char *info)
+{
+	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
+}
+
+/********************************* SigIntHandler ***************************/
+/** Ctrl-C: stop */
+static void SigIntHandler( int sig )
+{
+	G_sigInt = 1;
+}
@@ -11,7 +11,11 @@
  *
  *       \brief  Z147 test tool for timing (rx part)
  *
- *     Required: libraries: mdis_api, usr_oss
+ *               The frame distance is measured from microsecond time stamps
+ *               taken in the signal handler of the z147_rt runtime, the
+ *               frames are fetched by its reader thread.
+ *
+ *     Required: libraries: mdis_api, usr_oss, z147_rt, pthread
  *     \switches (none)
  */
 /*-------------------------------[ History ]--------------------------------
@@ -31,30 +35,29 @@
 #include <MEN/usr_oss.h>
 #include <MEN/z147_drv.h>
 #include <MEN/z247_drv.h>
+#include <MEN/z147_rt.h>
 
 /*--------------------------------------+
 |   DEFINES                             |
 +--------------------------------------*/
 #define Z147_FRAME_TIME		4000
 #define MAX_DATA_LEN 		32768
+#define RT_SLOTS			4
 
 /*--------------------------------------+
 |   GLOBALS                             |
 +--------------------------------------*/
-static int G_sigCount = 0;
 MDIS_PATH G_rxPath;
 int G_errors = 0;
 int G_timingError = 0;
-u_int32 G_dataLen = 0;
-u_int8 G_dataByte = 0;
 u_int32 G_rxFrameCnt = 0;
-u_int32 prevTime = 0;
+int64 G_prevUs = 0;
 
 /*--------------------------------------+
 |   PROTOTYPES                          |
 +--------------------------------------*/
 static void PrintError(char *info);
-static void __MAPILIB SignalHandler( u_int32 sig );
+static void CheckFrame( Z147RT_FRAME *frm );
 
 /********************************* main ************************************/
 /** Program main function
@@ -66,16 +69,12 @@ static void __MAPILIB SignalHandler( u_int32 sig );
  */
 int main(int argc, char *argv[])
 {
-	int32 irqCount;
 	char *rxDevice;
 	int32 result = 0;
 	int32 isSync = 0;
-
-	int i = 0;
-	int j = 0;
 	int k = 0;
 	int dataRate =0;
-	u_int32 data = 0;
+	Z147RT_FRAME *frm;
 
 	if (argc < 2 || strcmp(argv[1],"-?")==0) {
 		printf("Syntax: z147_timing_test_rx <rxDevice>\n");
@@ -96,41 +95,12 @@ int main(int argc, char *argv[])
 		/*--------------------+
 	    |  config             |
 	    +--------------------*/
-		UOS_SigInit( SignalHandler );
-		UOS_SigInstall( UOS_SIG_USR1 );
-		
-		result = M_setstat(G_rxPath, Z147_SET_SIGNAL, UOS_SIG_USR1);
+		result = Z147RT_Start(G_rxPath, RT_SLOTS, MAX_DATA_LEN);
 		if(result != 0){
+			printf("Starting the reader failed: %s\n", M_errstring(result));
 			G_errors++;
-		}
-		switch(dataRate){
-		case Z147_RX_DATA_RATE_64:
-			G_dataLen = 256;
-			break;
-		case Z147_RX_DATA_RATE_128:
-			G_dataLen = 512;
-			break;
-		case Z147_RX_DATA_RATE_256:
-			G_dataLen = 1024;
-			break;
-		case Z147_RX_DATA_RATE_512:
-			G_dataLen = 2048;
-			break;
-		case Z147_RX_DATA_RATE_1024:
-			G_dataLen = 4096;
+			M_close(G_rxPath);
 			break;
-		case Z147_RX_DATA_RATE_2048:
-			G_dataLen = 8192;
-			break;
-		case Z147_RX_DATA_RATE_4096:
-			G_dataLen = 16384;
-			break;
-		case Z147_RX_DATA_RATE_8192:
-			G_dataLen = 32768;
-			break;
-		default:
-			G_dataLen = 256;
-			printf("Unknown dataRate = %d, setting default rate to 64.\n", dataRate);
 		}
 
 		result = M_setstat(G_rxPath, Z147_RX_DATA_RATE, dataRate);
@@ -138,28 +108,27 @@ int main(int argc, char *argv[])
 			printf("Setting receive data rate failed.\n");
 			G_errors++;
 		}
-		G_dataByte = 0;
-		prevTime = 0;
-		G_sigCount = 0;
+		G_prevUs = 0;
 
 		for(k=0;k<20; ){
-			
-			if(G_sigCount == ( k + 1)){
+			if((frm = Z147RT_Get(100)) != NULL){
 				printf("\n");
 				printf("################### Test Run-%d (Data Rate-%d) ################\n",
 					k+1, dataRate);
 				k++;
-				printf("G_sigCount = %d\n", G_sigCount);
+				printf("Frame = %u\n", frm->seq + 1);
+				CheckFrame(frm);
+				Z147RT_Put(frm);
 			}else{
 				result = M_getstat(G_rxPath, Z147_RX_IN_SYNC, &isSync);
 				if((k!=0) && (isSync != 1)){
 					printf("Sync Lost\n");
 					goto Z147_EXIT;
 				}
-				UOS_Delay(100);
 			}
 		}
 
+		Z147RT_Stop();
 		result = M_setstat(G_rxPath, Z147_DISABLE_RX, 1);
 		if(result != 0){
 			G_errors++;
@@ -173,7 +142,6 @@ int main(int argc, char *argv[])
 	printf("-------------------------------------------\n\n");
 	printf("Receive frame count : %d\n", G_rxFrameCnt);
 	printf("Test Result : ");
-	
 	if((G_errors != 0) || (G_timingError != 0)){
 		printf("FAILED\n");
 		if(G_timingError != 0){
@@ -182,13 +150,13 @@ int main(int argc, char *argv[])
 	}else{
 		printf("PASSED\n");
 	}
-	
 	printf("\n-------------------------------------------\n");
 	printf("-------------------------------------------\n");
 
 	return(0);
 
 Z147_EXIT:
+	Z147RT_Stop();
 	result = M_setstat(G_rxPath, Z147_DISABLE_RX, 1);
 	if(result != 0){
 		G_errors++;
@@ -210,80 +178,61 @@ static void PrintError(char *info)
 	printf("*** can't %s: %s\n", info, M_errstring(UOS_ErrnoGet()));
 }
 
-/**********************************************************************/
-/** Signal handler
+/********************************* CheckFrame ******************************/
+/** Check frame distance and data of a received frame
  *
- *  \param  sig    \IN   received signal
+ *  \param  frm    \IN   frame from the reader thread
  */
-static void __MAPILIB SignalHandler( u_int32 sig )
+static void CheckFrame( Z147RT_FRAME *frm )
 {
-	int32 result = 0;
-	int i = 0;
 	int j=0;
 	u_int32 timeDiff = 0;
-	u_int16 rxDataArray[MAX_DATA_LEN];
-	u_int32 currentTime = 0;
+	u_int8 dataByte = 0;
+	u_int16 *rxDataArray = frm->data;
+	int32 result = frm->len;
 
-	if( sig == UOS_SIG_USR1 ) {
-		++G_sigCount;
-		currentTime = UOS_MsecTimerGet();
-		
-		if(prevTime != 0){
-			
-			if(prevTime <currentTime){
-				timeDiff = (currentTime - prevTime);
-			}else{
-				timeDiff = (prevTime - currentTime);
-			}
-			
-			if((timeDiff > (Z147_FRAME_TIME + 5)) || (timeDiff < (Z147_FRAME_TIME - 5))){
-				printf("Time difference is expected 4000ms but received %d\n", timeDiff);
-				G_timingError++;
-			}else{
-				printf(" Time difference is 4000ms as expected.\n");
-			}
-			
-			prevTime = currentTime;
+	/* time stamps of the signals, not of the printing */
+	if(G_prevUs != 0){
+		timeDiff = (u_int32)((frm->sigUs - G_prevUs + 500) / 1000);
+
+		if((timeDiff > (Z147_FRAME_TIME + 5)) || (timeDiff < (Z147_FRAME_TIME - 5))){
+			printf("Time difference is expected 4000ms but received %d\n", timeDiff);
+			G_timingError++;
 		}else{
-			prevTime = currentTime;
+			printf(" Time difference is 4000ms as expected.\n");
 		}
-		result = M_getblock( G_rxPath, (u_int8*)rxDataArray, (G_dataLen *2) );
-		if(result < 0){
-			G_errors++;
-		}
-		
-		if(result > 0){
-			printf("----------------- Receive -----------------\n");
-			printf("Receiving = %d bytes data\n", result);
-			G_dataByte = 0;
-			
-			/* Add 4 sync words and ignore them in check. */
-			for(j=0, i=0;j<(result/2);j++){
-				if((rxDataArray[j] != Z147_ARINC717_SUB_1_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_2_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_3_SYNC) &&
-						(rxDataArray[j] != Z147_ARINC717_SUB_4_SYNC))
-				{
-					if(rxDataArray[j] != (G_dataByte)){
-						printf("Expected 0x%x but received rxDataArray[%d] = 0x%x\n",
-							( G_dataByte), j, rxDataArray[j]);
-						G_errors++;
-					}
-					if((j<10) || (j>((result/2) - 5))){
-						printf(" [%d]0x%x",j, rxDataArray[j]);
-					}
-					G_dataByte++;
-				}
+	}
+	G_prevUs = frm->sigUs;
 
-				/* Reset the buffer. */
-				rxDataArray[j] = 0;
+	if(result < 0){
+		G_errors++;
+	}
+	if(result > 0){
+		printf("----------------- Receive -----------------\n");
+		printf("Receiving = %d bytes data\n", result);
+		/* Add 4 sync words and ignore them in check. */
+		for(j=0;j<(result/2);j++){
+			if((rxDataArray[j] != Z147_ARINC717_SUB_1_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_2_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_3_SYNC) &&
+					(rxDataArray[j] != Z147_ARINC717_SUB_4_SYNC))
+			{
+				if(rxDataArray[j] != (dataByte)){
+					printf("Expected 0x%x but received rxDataArray[%d] = 0x%x\n",
+						( dataByte), j, rxDataArray[j]);
+					G_errors++;
+				}
+				if((j<10) || (j>((result/2) - 5))){
+					printf(" [%d]0x%x",j, rxDataArray[j]);
+				}
+				dataByte++;
 			}
-			printf("\n");
-			printf("Received %d bytes successfully\n", result);
-			printf("--------------------------------\n");
-			G_rxFrameCnt++;
-		}else{
-			printf("Read failed with the result = %d\n", result);
 		}
+		printf("\n");
+		printf("Received %d bytes successfully\n", result);
+		printf("--------------------------------\n");
+		G_rxFrameCnt++;
+	}else{
+		printf("Read failed with the result = %d\n", result);
 	}
 }
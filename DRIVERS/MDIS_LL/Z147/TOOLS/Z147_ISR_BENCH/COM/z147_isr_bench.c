@@ -0,0 +1,276 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_ISR_BENCH                   ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_isr_bench.c
+ *       \author Apatil
+ *
+ *       \brief  ISR throughput benchmark of the Z147/Z247 LL drivers
+ *
+ *               Runs Z147_Irq and Z247_Irq against the simulated cores for
+ *               every data rate and FIFO trigger level and prints one CSV
+ *               line per combination:
+ *
+ *               driver,rate_wps,trig_words,irqs,words,ns_per_word,
+ *               ns_per_irq,mmio_per_irq,p50_ns,p99_ns,max_ns,
+ *               work_p50_ns,work_max_ns
+ *
+ *               The receiver is fed by the built-in frame generator, the
+ *               transmitter sends into an open line. With -m the tool
+ *               fails if the ISR cost per word exceeds a limit, so that it
+ *               can gate releases.
+ *
+ *               With -w the receive driver drains its FIFO deferred
+ *               (Z147_RX_DEFERRED, driver "z147w"): the ISR columns show
+ *               the interrupt routine only, the work columns the deferred
+ *               processing, ns_per_word the cost of both.
+ *
+ *               The tool runs on the build host only and is built by
+ *               TOOLS/Z147_SIM/COM/Makefile together with libz147sim.
+ *
+ *     Required: libraries: z147sim, pthread
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_isr_bench.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <MEN/men_typs.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_api.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z247_drv.h>
+#include <MEN/z147_sim.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_DATA_LEN    32768       /**< frame length at 8192 words/s */
+#define TICKS_PER_FRAME (4 * 64 * Z147SIM_PERIOD(0))  /**< same for all rates */
+#define TRIG_LVL_MIN    1           /**< FCR trigger level 8 words */
+#define TRIG_LVL_MAX    7           /**< FCR trigger level 512 words */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** ISR duration samples */
+typedef struct {
+	u_int64 *ns;        /**< durations */
+	u_int32 num;        /**< used entries */
+	u_int32 size;       /**< allocated entries */
+	u_int64 sum;        /**< sum of durations */
+} SAMPLES;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void IrqHook( Z147SIM_DEV *dev, u_int64 ns, void *arg );
+static int CmpU64( const void *a, const void *b );
+static int32 Bench( int32 type, int32 dataRate, int32 trigLvl,
+					u_int32 frames, double maxNsWord, int32 deferred );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	int32 dataRate = -1;
+	int32 trigLvl = -1;
+	int32 type = -1;
+	u_int32 frames = 2;
+	double maxNsWord = 0.0;
+	int32 deferred = 0;
+	int32 errors = 0;
+	int32 i, r, t, d;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			dataRate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-t=", 3) == 0){
+			trigLvl = atoi(argv[i] + 3);
+		}else if(strcmp(argv[i], "-d=rx") == 0){
+			type = Z147SIM_RX;
+		}else if(strcmp(argv[i], "-d=tx") == 0){
+			type = Z147SIM_TX;
+		}else if(strncmp(argv[i], "-f=", 3) == 0){
+			frames = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-m=", 3) == 0){
+			maxNsWord = atof(argv[i] + 3);
+		}else if(strcmp(argv[i], "-w") == 0){
+			deferred = 1;
+		}else{
+			printf("Syntax: z147_isr_bench [<opts>]\n");
+			printf("Function: ISR benchmark of the Z147/Z247 LL drivers (CSV)\n");
+			printf("Options:\n");
+			printf("    -d=rx|tx   driver                            [both]\n");
+			printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [all]\n");
+			printf("    -t=<lvl>   trigger level 1..7 (8..512 words) [all]\n");
+			printf("    -f=<n>     frames measured per combination   [2]\n");
+			printf("    -m=<ns>    fail if ns per word exceeds limit\n");
+			printf("    -w         deferred receive processing\n");
+			return(1);
+		}
+	}
+
+	printf("driver,rate_wps,trig_words,irqs,words,ns_per_word,ns_per_irq,"
+		   "mmio_per_irq,p50_ns,p99_ns,max_ns,work_p50_ns,work_max_ns\n");
+
+	for(d=Z147SIM_RX; d<=Z147SIM_TX; d++){
+		if(type >= 0 && type != d)
+			continue;
+		for(r=Z147_RX_DATA_RATE_64; r<=Z147_RX_DATA_RATE_8192; r++){
+			if(dataRate >= 0 && dataRate != r)
+				continue;
+			for(t=TRIG_LVL_MIN; t<=TRIG_LVL_MAX; t++){
+				if(trigLvl < 0 || trigLvl == t)
+					errors += Bench(d, r, t, frames, maxNsWord, deferred);
+			}
+		}
+	}
+
+	return(errors ? 1 : 0);
+}
+
+/********************************* Bench ***********************************/
+/** Measure one driver/rate/trigger level combination
+ *
+ *  \param type       \IN  Z147SIM_RX or Z147SIM_TX
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param trigLvl    \IN  FCR trigger level
+ *  \param frames     \IN  frames to measure
+ *  \param maxNsWord  \IN  limit of ns per word (0 = none)
+ *  \param deferred   \IN  RX: Z147_RX_DEFERRED
+ *
+ *  \return	          0 or 1 on error/limit exceeded
+ */
+static int32 Bench( int32 type, int32 dataRate, int32 trigLvl,
+					u_int32 frames, double maxNsWord, int32 deferred )
+{
+	static u_int16 txData[MAX_DATA_LEN];
+	Z147SIM_WORLD *world;
+	Z147SIM_DEV *dev;
+	Z147SIM_STATS *st;
+	SAMPLES smp, work;
+	const char *name;
+	u_int32 frameLen = 4 * (64 << dataRate);
+	u_int64 irqs, words, mmio;
+	double nsWord;
+	int32 nbr, error = 0;
+
+	memset(&smp, 0, sizeof(smp));
+	memset(&work, 0, sizeof(work));
+	world = Z147SIM_WorldCreate();
+	if(Z147SIM_DevOpen(world, type, NULL, &dev) != 0){
+		fprintf(stderr, "*** can't open simulated device\n");
+		Z147SIM_WorldDestroy(world);
+		return 1;
+	}
+
+	if(type == Z147SIM_RX){
+		error |= Z147SIM_SetStat(dev, Z147_RX_DATA_RATE, dataRate);
+		error |= Z147SIM_SetStat(dev, Z147_RX_THR_LEV, trigLvl);
+		error |= Z147SIM_SetStat(dev, Z147_RX_DEFERRED, deferred);
+	}else{
+		error |= Z147SIM_SetStat(dev, Z247_TX_DATA_RATE, dataRate);
+		error |= Z147SIM_SetStat(dev, Z247_TX_THR_LEV, trigLvl);
+		memset(txData, 0x5A, sizeof(txData));
+		error |= Z147SIM_BlockWrite(dev, txData, (frameLen - 4) * 2, &nbr);
+	}
+	if(error){
+		fprintf(stderr, "*** configuration failed: 0x%x\n", error);
+		Z147SIM_DevClose(dev);
+		Z147SIM_WorldDestroy(world);
+		return 1;
+	}
+
+	/* warm up: synchronization and first frame */
+	Z147SIM_Run(world, 2 * TICKS_PER_FRAME);
+
+	st = Z147SIM_Stats(dev);
+	memset(st, 0, sizeof(*st));
+	Z147SIM_SetIrqHook(dev, IrqHook, &smp);
+	Z147SIM_SetWorkHook(dev, IrqHook, &work);
+	Z147SIM_Run(world, (u_int64)frames * TICKS_PER_FRAME);
+	Z147SIM_SetIrqHook(dev, NULL, NULL);
+	Z147SIM_SetWorkHook(dev, NULL, NULL);
+
+	irqs  = st->irqs;
+	words = st->words;
+	mmio  = st->mmioRd + st->mmioWr;
+	nsWord = words ? (double)(smp.sum + work.sum) / words : 0.0;
+	name = type == Z147SIM_TX ? "z247" : deferred ? "z147w" : "z147";
+
+	qsort(smp.ns, smp.num, sizeof(u_int64), CmpU64);
+	qsort(work.ns, work.num, sizeof(u_int64), CmpU64);
+	printf("%s,%u,%u,%llu,%llu,%.1f,%.1f,%.1f,%llu,%llu,%llu,%llu,%llu\n",
+		   name, 64 << dataRate, 4 << trigLvl,
+		   (unsigned long long)irqs, (unsigned long long)words, nsWord,
+		   irqs ? (double)smp.sum / irqs : 0.0,
+		   irqs ? (double)mmio / irqs : 0.0,
+		   (unsigned long long)(smp.num ? smp.ns[smp.num / 2] : 0),
+		   (unsigned long long)(smp.num ? smp.ns[(smp.num * 99ULL) / 100] : 0),
+		   (unsigned long long)(smp.num ? smp.ns[smp.num - 1] : 0),
+		   (unsigned long long)(work.num ? work.ns[work.num / 2] : 0),
+		   (unsigned long long)(work.num ? work.ns[work.num - 1] : 0));
+
+	if(maxNsWord > 0.0 && nsWord > maxNsWord){
+		fprintf(stderr, "*** %s rate %u trigger %u: %.1f ns/word exceeds %.1f\n",
+				name, 64 << dataRate, 4 << trigLvl, nsWord, maxNsWord);
+		error = 1;
+	}
+
+	free(smp.ns);
+	free(work.ns);
+	Z147SIM_DevClose(dev);
+	Z147SIM_WorldDestroy(world);
+
+	return error ? 1 : 0;
+}
+
+/********************************* IrqHook *********************************/
+/** Record the duration of one ISR invocation
+ *
+ *  \param dev        \IN  device
+ *  \param ns         \IN  ISR duration
+ *  \param arg        \IN  SAMPLES
+ */
+static void IrqHook( Z147SIM_DEV *dev, u_int64 ns, void *arg )
+{
+	SAMPLES *smp = (SAMPLES*)arg;
+	u_int64 *p;
+
+	if(smp->num == smp->size){
+		smp->size = smp->size ? smp->size * 2 : 4096;
+		if((p = (u_int64*)realloc(smp->ns, smp->size * sizeof(u_int64))) == NULL){
+			smp->size = smp->num;
+			return;
+		}
+		smp->ns = p;
+	}
+	smp->ns[smp->num++] = ns;
+	smp->sum += ns;
+}
+
+/********************************* CmpU64 **********************************/
+/** qsort compare function for u_int64 */
+static int CmpU64( const void *a, const void *b )
+{
+	u_int64 x = *(const u_int64*)a, y = *(const u_int64*)b;
+
+	return (x > y) - (x < y);
+}
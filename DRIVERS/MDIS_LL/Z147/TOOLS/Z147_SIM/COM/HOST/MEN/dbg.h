@@ -0,0 +1,61 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  dbg.h
+ *
+ *       \brief  Host replacement of the MEN debug macros
+ *
+ *               Debug output is compiled in when DBG is defined and is
+ *               written to stderr.
+ *
+ *    \switches  DBG
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _DBG_H
+#define _DBG_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+typedef struct DBG_HANDLE DBG_HANDLE;
+
+#define DBG_LEV1    0x00000001      /**< level 1 */
+#define DBG_LEV2    0x00000002      /**< level 2 */
+#define DBG_LEV3    0x00000004      /**< level 3 */
+#define DBG_INTR    0x40000000      /**< also print in interrupt routines */
+
+extern int32 DBG_Init( char *name, DBG_HANDLE **dbgHdlP );
+extern int32 DBG_Exit( DBG_HANDLE **dbgHdlP );
+extern int32 DBG_Write( DBG_HANDLE *dbgHdl, char *fmt, ... );
+
+#ifdef DBG
+# define DBGINIT(_x_)   DBG_Init _x_
+# define DBGEXIT(_x_)   DBG_Exit _x_
+# define DBGWRT_1(_x_)  ((void)((DBG_MYLEVEL & DBG_LEV1) && DBG_Write _x_))
+# define DBGWRT_2(_x_)  ((void)((DBG_MYLEVEL & DBG_LEV2) && DBG_Write _x_))
+# define DBGWRT_3(_x_)  ((void)((DBG_MYLEVEL & DBG_LEV3) && DBG_Write _x_))
+# define IDBGWRT_1(_x_) ((void)(((DBG_MYLEVEL & (DBG_LEV1|DBG_INTR)) == \
+                                (DBG_LEV1|DBG_INTR)) && DBG_Write _x_))
+# define IDBGWRT_2(_x_) ((void)(((DBG_MYLEVEL & (DBG_LEV2|DBG_INTR)) == \
+                                (DBG_LEV2|DBG_INTR)) && DBG_Write _x_))
+# define IDBGWRT_3(_x_) ((void)(((DBG_MYLEVEL & (DBG_LEV3|DBG_INTR)) == \
+                                (DBG_LEV3|DBG_INTR)) && DBG_Write _x_))
+#else
+# define DBGINIT(_x_)
+# define DBGEXIT(_x_)
+# define DBGWRT_1(_x_)
+# define DBGWRT_2(_x_)
+# define DBGWRT_3(_x_)
+# define IDBGWRT_1(_x_)
+# define IDBGWRT_2(_x_)
+# define IDBGWRT_3(_x_)
+#endif
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _DBG_H */
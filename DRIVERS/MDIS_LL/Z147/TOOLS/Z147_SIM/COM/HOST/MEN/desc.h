@@ -0,0 +1,43 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  desc.h
+ *
+ *       \brief  Host replacement of the MEN descriptor library
+ *
+ *               A descriptor is an array of key/value pairs terminated
+ *               by an entry with a NULL key.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _DESC_H
+#define _DESC_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/** descriptor entry */
+typedef struct {
+	const char  *key;       /**< key name or NULL for the last entry */
+	u_int32     value;      /**< key value */
+} DESC_SPEC;
+
+typedef struct DESC_HANDLE DESC_HANDLE;
+
+extern char* DESC_Ident( void );
+extern int32 DESC_Init( DESC_SPEC *descSpec, OSS_HANDLE *osHdl,
+                        DESC_HANDLE **descHdlP );
+extern int32 DESC_Exit( DESC_HANDLE **descHdlP );
+extern int32 DESC_GetUInt32( DESC_HANDLE *descHdl, u_int32 defVal,
+                             u_int32 *valueP, char *fmt, ... );
+extern void  DESC_DbgLevelSet( DESC_HANDLE *descHdl, u_int32 dbgLevel );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _DESC_H */
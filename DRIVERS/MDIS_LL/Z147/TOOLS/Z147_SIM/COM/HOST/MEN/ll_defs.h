@@ -0,0 +1,37 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  ll_defs.h
+ *
+ *       \brief  Host replacement of the MDIS low-level driver definitions
+ *
+ *    \switches  _NO_LL_HANDLE
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _LL_DEFS_H
+#define _LL_DEFS_H
+
+#ifndef _NO_LL_HANDLE
+typedef void LL_HANDLE;                 /**< opaque for non-drivers */
+#endif
+
+/* info codes */
+#define LL_INFO_HW_CHARACTER    0x01
+#define LL_INFO_ADDRSPACE_COUNT 0x02
+#define LL_INFO_ADDRSPACE       0x03
+#define LL_INFO_IRQ             0x04
+#define LL_INFO_LOCKMODE        0x05
+
+/* irq return codes */
+#define LL_IRQ_DEVICE           0       /**< irq caused by device */
+#define LL_IRQ_DEV_NOT          1       /**< irq not caused by device */
+#define LL_IRQ_UNKNOWN          2       /**< unknown */
+
+/* lock modes */
+#define LL_LOCK_NONE            0
+#define LL_LOCK_CALL            1
+#define LL_LOCK_CHAN            2
+
+#endif /* _LL_DEFS_H */
@@ -0,0 +1,42 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  maccess.h
+ *
+ *       \brief  Host replacement of the MEN hardware access macros
+ *
+ *               Every register access of the LL drivers is routed to the
+ *               16Z147/16Z247 register model of the host simulator, see
+ *               z147_sim.h. A MACCESS handle is a simulated device.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MACCESS_H
+#define _MACCESS_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+typedef struct Z147SIM_DEV *MACCESS;
+
+extern u_int32 Z147SIM_Read( MACCESS ma, u_int32 offs, u_int32 width );
+extern void    Z147SIM_Write( MACCESS ma, u_int32 offs, u_int32 width,
+                              u_int32 val );
+
+#define MREAD_D8(ma,offs)       ((u_int8) Z147SIM_Read((ma),(offs),1))
+#define MREAD_D16(ma,offs)      ((u_int16)Z147SIM_Read((ma),(offs),2))
+#define MREAD_D32(ma,offs)      ((u_int32)Z147SIM_Read((ma),(offs),4))
+
+#define MWRITE_D8(ma,offs,val)  Z147SIM_Write((ma),(offs),1,(u_int32)(val))
+#define MWRITE_D16(ma,offs,val) Z147SIM_Write((ma),(offs),2,(u_int32)(val))
+#define MWRITE_D32(ma,offs,val) Z147SIM_Write((ma),(offs),4,(u_int32)(val))
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _MACCESS_H */
@@ -0,0 +1,75 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  mdis_api.h
+ *
+ *       \brief  Host replacement of the MDIS API definitions
+ *
+ *               Provides the status code ranges and the standard codes
+ *               used by the Z147/Z247 LL drivers and the MDIS API
+ *               functions used by the tools.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MDIS_API_H
+#define _MDIS_API_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+#define __MAPILIB                       /**< calling convention (none) */
+
+typedef INT32_OR_64 MDIS_PATH;          /**< MDIS path */
+
+/* status code ranges */
+#define M_LL_OF             0x0000      /**< low-level standard codes */
+#define M_MK_OF             0x0100      /**< MDIS kernel standard codes */
+#define M_DEV_OF            0x0200      /**< device specific codes */
+#define M_LL_BLK_OF         0x1000      /**< low-level block codes */
+#define M_MK_BLK_OF         0x1100      /**< MDIS kernel block codes */
+#define M_DEV_BLK_OF        0x1200      /**< device specific block codes */
+
+/* standard codes used by the drivers */
+#define M_LL_CH_NUMBER      (M_LL_OF+0x00)  /**< number of channels */
+#define M_LL_CH_DIR         (M_LL_OF+0x01)  /**< channel direction */
+#define M_LL_CH_LEN         (M_LL_OF+0x02)  /**< channel length */
+#define M_LL_CH_TYP         (M_LL_OF+0x03)  /**< channel type */
+#define M_LL_IRQ_COUNT      (M_LL_OF+0x04)  /**< irq counter */
+#define M_LL_ID_CHECK       (M_LL_OF+0x05)  /**< ID PROM check */
+#define M_LL_DEBUG_LEVEL    (M_LL_OF+0x07)  /**< debug level */
+#define M_MK_IRQ_ENABLE     (M_MK_OF+0x01)  /**< enable interrupt */
+#define M_MK_BLK_REV_ID     (M_MK_BLK_OF+0x01)  /**< ident table */
+
+/* channel directions and types */
+#define M_CH_IN             0
+#define M_CH_OUT            1
+#define M_CH_INOUT          2
+#define M_CH_BINARY         1
+
+/** block getstat/setstat parameter */
+typedef struct {
+	int32   size;       /**< data buffer size in bytes */
+	void    *data;      /**< data buffer */
+} M_SG_BLOCK;
+
+/* MDIS API (z147_sim_mdis.c: paths to simulated devices) */
+extern MDIS_PATH __MAPILIB M_open( const char *device );
+extern int32 __MAPILIB M_close( MDIS_PATH path );
+extern int32 __MAPILIB M_getstat( MDIS_PATH path, int32 code, int32 *dataP );
+extern int32 __MAPILIB M_setstat( MDIS_PATH path, int32 code,
+                                  INT32_OR_64 data );
+extern int32 __MAPILIB M_getblock( MDIS_PATH path, u_int8 *buffer,
+                                   int32 length );
+extern int32 __MAPILIB M_setblock( MDIS_PATH path, const u_int8 *buffer,
+                                   int32 length );
+extern char* __MAPILIB M_errstring( int32 errCode );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _MDIS_API_H */
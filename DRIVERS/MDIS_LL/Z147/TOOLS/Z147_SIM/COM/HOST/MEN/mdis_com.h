@@ -0,0 +1,33 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  mdis_com.h
+ *
+ *       \brief  Host replacement of the MDIS common definitions
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MDIS_COM_H
+#define _MDIS_COM_H
+
+#define MDIS_MAX_MODULES    5   /**< max. number of ident functions */
+
+/** ident function table */
+typedef struct {
+	struct {
+		char* (*identCall)( void );
+	} idCall[MDIS_MAX_MODULES];
+} MDIS_IDENT_FUNCT_TBL;
+
+/* address/data modes */
+#define MDIS_MA08           0x0001
+#define MDIS_MA24           0x0002
+#define MDIS_MA32           0x0004
+#define MDIS_MD08           0x0001
+#define MDIS_MD16           0x0002
+#define MDIS_MD32           0x0004
+
+#endif /* _MDIS_COM_H */
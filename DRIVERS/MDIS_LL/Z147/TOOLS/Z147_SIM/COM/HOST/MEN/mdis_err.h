@@ -0,0 +1,41 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  mdis_err.h
+ *
+ *       \brief  Host replacement of the MDIS error codes
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MDIS_ERR_H
+#define _MDIS_ERR_H
+
+#define ERR_SUCCESS             0x0000      /**< no error */
+
+#define ERR_OSS                 0x0600
+#define ERR_OSS_MEM_ALLOC       (ERR_OSS+0x01)  /**< can't allocate memory */
+#define ERR_OSS_SIG_SET         (ERR_OSS+0x09)  /**< signal already installed */
+#define ERR_OSS_SIG_CLR         (ERR_OSS+0x0a)  /**< signal not installed */
+#define ERR_OSS_TIMEOUT         (ERR_OSS+0x05)  /**< timeout */
+
+#define ERR_DESC                0x0900
+#define ERR_DESC_KEY_NOTFOUND   (ERR_DESC+0x01) /**< descriptor key not found */
+
+#define ERR_MBUF                0x0b00
+#define ERR_MBUF_ILL_SIZE       (ERR_MBUF+0x02) /**< illegal buffer size */
+#define ERR_MBUF_USERBUF        (ERR_MBUF+0x05) /**< user buffer too small */
+
+#define ERR_LL                  0x0c00
+#define ERR_LL_ILL_PARAM        (ERR_LL+0x01)   /**< illegal parameter */
+#define ERR_LL_ILL_CHAN         (ERR_LL+0x02)   /**< illegal channel */
+#define ERR_LL_ILL_DIR          (ERR_LL+0x03)   /**< illegal direction */
+#define ERR_LL_ILL_FUNC         (ERR_LL+0x04)   /**< illegal function */
+#define ERR_LL_UNK_CODE         (ERR_LL+0x05)   /**< unknown status code */
+#define ERR_LL_DEV_BUSY         (ERR_LL+0x06)   /**< device busy */
+#define ERR_LL_DEV_NOTRDY       (ERR_LL+0x07)   /**< device not ready */
+#define ERR_LL_READ             (ERR_LL+0x08)   /**< read error */
+
+#endif /* _MDIS_ERR_H */
@@ -0,0 +1,44 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  men_typs.h
+ *
+ *       \brief  Host replacement of the MEN basic type definitions
+ *
+ *               Only used by the Z147 host simulator build. Provides the
+ *               subset of types needed to compile the Z147/Z247 LL drivers
+ *               and the user tools on a plain Linux host.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MEN_TYPS_H
+#define _MEN_TYPS_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int8_t      int8;
+typedef uint8_t     u_int8;
+typedef int16_t     int16;
+typedef uint16_t    u_int16;
+typedef int32_t     int32;
+typedef uint32_t    u_int32;
+typedef int64_t     int64;
+typedef uint64_t    u_int64;
+
+/* 32/64 bit pointer compatible integers (MDIS5) */
+#define INT32_OR_64     intptr_t
+#define U_INT32_OR_64   uintptr_t
+
+#ifndef TRUE
+# define TRUE   1
+#endif
+#ifndef FALSE
+# define FALSE  0
+#endif
+
+#endif /* _MEN_TYPS_H */
@@ -0,0 +1,18 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  modcom.h
+ *
+ *       \brief  Host replacement of the MEN ID PROM definitions
+ *
+ *               The Z147/Z247 cores have no ID PROM, nothing is needed.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _MODCOM_H
+#define _MODCOM_H
+
+#endif /* _MODCOM_H */
@@ -0,0 +1,60 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  oss.h
+ *
+ *       \brief  Host replacement of the MEN operating system services
+ *
+ *               Only the OSS functions used by the Z147/Z247 LL drivers
+ *               are provided. They are implemented by the host simulator.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _OSS_H
+#define _OSS_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+typedef struct OSS_HANDLE       OSS_HANDLE;
+typedef struct OSS_IRQ_HANDLE   OSS_IRQ_HANDLE;
+typedef struct OSS_SEM_HANDLE   OSS_SEM_HANDLE;
+typedef struct OSS_SIG_HANDLE   OSS_SIG_HANDLE;
+typedef struct OSS_ALARM_HANDLE OSS_ALARM_HANDLE;
+typedef int32                   OSS_IRQ_STATE;
+
+#define OSS_DBG_DEFAULT     0x00000000  /**< no debug output by default */
+
+extern char* OSS_Ident( void );
+extern void* OSS_MemGet( OSS_HANDLE *osHdl, u_int32 size, u_int32 *gotsizeP );
+extern int32 OSS_MemFree( OSS_HANDLE *osHdl, void *addr, u_int32 size );
+extern void  OSS_MemCopy( OSS_HANDLE *osHdl, u_int32 size, char *src,
+                          char *dest );
+extern void  OSS_MemFill( OSS_HANDLE *osHdl, u_int32 size, char *adr,
+                          int8 value );
+extern int32 OSS_SigCreate( OSS_HANDLE *osHdl, int32 signal,
+                            OSS_SIG_HANDLE **sigHdlP );
+extern int32 OSS_SigRemove( OSS_HANDLE *osHdl, OSS_SIG_HANDLE **sigHdlP );
+extern int32 OSS_SigSend( OSS_HANDLE *osHdl, OSS_SIG_HANDLE *sigHdl );
+extern int32 OSS_Delay( OSS_HANDLE *osHdl, int32 msec );
+extern int32 OSS_MikroDelay( OSS_HANDLE *osHdl, u_int32 mikroSec );
+extern int32 OSS_AlarmCreate( OSS_HANDLE *osHdl, void (*funct)( void *arg ),
+							  void *arg, OSS_ALARM_HANDLE **alarmP );
+extern int32 OSS_AlarmRemove( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE **alarmP );
+extern int32 OSS_AlarmSet( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE *alarm,
+						   u_int32 msec, u_int32 cyclic, u_int32 *realMsecP );
+extern int32 OSS_AlarmClear( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE *alarm );
+extern OSS_IRQ_STATE OSS_IrqMaskR( OSS_HANDLE *osHdl,
+								   OSS_IRQ_HANDLE *irqHdl );
+extern void  OSS_IrqRestore( OSS_HANDLE *osHdl, OSS_IRQ_HANDLE *irqHdl,
+							 OSS_IRQ_STATE oldState );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _OSS_H */
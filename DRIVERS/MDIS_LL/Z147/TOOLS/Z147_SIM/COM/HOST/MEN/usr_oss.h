@@ -0,0 +1,39 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  usr_oss.h
+ *
+ *       \brief  Host replacement of the user OSS library definitions
+ *
+ *               Subset used by the Z147 tools, implemented by
+ *               z147_sim_mdis.c. Time follows the simulation time when a
+ *               simulated device is open.
+ *
+ *    \switches  -
+ */
+/*---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _USR_OSS_H
+#define _USR_OSS_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+#define UOS_SIG_USR1        1           /**< user signal 1 */
+#define UOS_SIG_USR2        2           /**< user signal 2 */
+
+extern int32   UOS_SigInit( void (*sigHandler)(u_int32 sigCode) );
+extern int32   UOS_SigExit( void );
+extern int32   UOS_SigInstall( u_int32 sigCode );
+extern int32   UOS_SigRemove( u_int32 sigCode );
+extern int32   UOS_Delay( u_int32 msec );
+extern u_int32 UOS_MsecTimerGet( void );
+extern u_int32 UOS_ErrnoGet( void );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _USR_OSS_H */
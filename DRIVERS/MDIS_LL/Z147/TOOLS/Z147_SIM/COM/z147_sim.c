@@ -0,0 +1,789 @@
+/****************************************************************************
+ ************                                                    ************
+ ************                   Z147_SIM                         ************
+ ************                                                    ************
+ ****************************************************************************/
+/*!
+ *         \file z147_sim.c
+ *       \author Apatil
+ *
+ *       \brief  Host test of the Z147/Z247 LL drivers against the simulated
+ *               cores
+ *
+ *               For each data rate a transmitter and a receiver are
+ *               connected, the counting pattern of the test tools is sent
+ *               and every received frame is checked (sync words and data).
+ *               Without faults the change only mode (Z147_RX_CHANGE_ONLY)
+ *               is checked afterwards: the repeated frame must not be
+ *               signaled, a frame with one changed word must be, with
+ *               its slot. Then the watch triggers (Z147_BLK_RX_WATCH) of
+ *               all types are set on a word that is changed and changed
+ *               back, every watch must report its transitions only.
+ *               Then the capture (Z147_BLK_RX_CAPTURE) must freeze the
+ *               frames around a watch event and a Z147_RX_CAPT_TRIG.
+ *               In raw mode (Z147_RX_SYNC_CFG 0) the driver has to align
+ *               the frames itself and to realign after a lost word.
+ *               Last the receiver is set to a wrong rate, the rate
+ *               detection (Z147_RX_RATE_DETECT) has to find the rate of
+ *               the transmitter and, in follow mode, its next rate.
+ *               The devices are closed after Z147_DISABLE_RX and
+ *               Z247_DISABLE_TX, without waiting.
+ *               Optionally faults are injected on the line to exercise the
+ *               error paths of the receive driver, or the receive driver
+ *               drains its FIFO deferred (Z147_RX_DEFERRED).
+ *
+ *     Required: libraries: z147sim, pthread
+ *     \switches (none)
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sim.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <MEN/men_typs.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_api.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z247_drv.h>
+#include <MEN/z147_sim.h>
+
+/*--------------------------------------+
+|   DEFINES                             |
++--------------------------------------*/
+#define MAX_DATA_LEN    32768       /**< frame length at 8192 words/s */
+#define RX_DATA_SIG     1           /**< signal number of RX data */
+#define RX_ERR_SIG      2           /**< signal number of RX errors */
+#define RX_TRIG_SIG     3           /**< signal number of RX triggers */
+
+/*--------------------------------------+
+|   TYPEDEFS                            |
++--------------------------------------*/
+/** signal counters */
+typedef struct {
+	u_int32 dataSigs;
+	u_int32 errSigs;
+	u_int32 trigSigs;
+} SIG_CNT;
+
+/*--------------------------------------+
+|   PROTOTYPES                          |
++--------------------------------------*/
+static void SigHook( Z147SIM_DEV *dev, int32 sigNum, void *arg );
+static int32 CheckFrame( u_int16 *buf, u_int32 frameLen, u_int32 sfs,
+						  int32 verbose );
+static int32 RunRate( int32 dataRate, u_int32 frames, double errRate,
+					  int32 useTx, int32 deferred );
+static int32 RunChange( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData );
+static int32 RunWatch( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+					   SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData );
+static int32 RunCapture( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						 int32 dataRate, u_int16 *txData );
+static int32 ReadCapture( Z147SIM_DEV *rxDev, u_int32 source, u_int32 pos,
+						  u_int16 before, u_int16 after );
+static int32 RunRaw( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+					 SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData );
+static int32 RunDetect( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						int32 dataRate, u_int16 *txData );
+
+/********************************* main ************************************/
+/** Program main function
+ *
+ *  \param argc       \IN  argument counter
+ *  \param argv       \IN  argument vector
+ *
+ *  \return	          success (0) or error (1)
+ */
+int main(int argc, char *argv[])
+{
+	int32 dataRate = -1;
+	u_int32 frames = 5;
+	double errRate = 0.0;
+	int32 useTx = 1;
+	int32 deferred = 0;
+	int32 errors = 0;
+	int32 i;
+
+	for(i=1; i<argc; i++){
+		if(strncmp(argv[i], "-r=", 3) == 0){
+			dataRate = atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-n=", 3) == 0){
+			frames = (u_int32)atoi(argv[i] + 3);
+		}else if(strncmp(argv[i], "-e=", 3) == 0){
+			errRate = atof(argv[i] + 3);
+		}else if(strcmp(argv[i], "-g") == 0){
+			useTx = 0;
+		}else if(strcmp(argv[i], "-w") == 0){
+			deferred = 1;
+		}else{
+			printf("Syntax: z147_sim [<opts>]\n");
+			printf("Function: Z147/Z247 LL driver test against simulated cores\n");
+			printf("Options:\n");
+			printf("    -r=<rate>  data rate 0..7 (64..8192 words/s) [all]\n");
+			printf("    -n=<n>     frames to check per rate          [5]\n");
+			printf("    -e=<p>     inject faults with probability p per word\n");
+			printf("    -g         receiver only, built-in frame generator\n");
+			printf("    -w         deferred receive processing\n");
+			return(1);
+		}
+	}
+
+	for(i=Z147_RX_DATA_RATE_64; i<=Z147_RX_DATA_RATE_8192; i++){
+		if(dataRate < 0 || dataRate == i)
+			errors += RunRate(i, frames, errRate, useTx, deferred);
+	}
+
+	printf("Test Result : %s\n", errors ? "FAILED" : "PASSED");
+	return(errors ? 1 : 0);
+}
+
+/********************************* RunRate *********************************/
+/** Send/receive frames at one data rate
+ *
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param frames     \IN  frames to check
+ *  \param errRate    \IN  fault probability per word (0 = no faults)
+ *  \param useTx      \IN  connect a transmitter (else generator)
+ *  \param deferred   \IN  Z147_RX_DEFERRED
+ *
+ *  \return	          number of errors
+ */
+static int32 RunRate( int32 dataRate, u_int32 frames, double errRate,
+					  int32 useTx, int32 deferred )
+{
+	static u_int16 txData[MAX_DATA_LEN];
+	static u_int16 rxData[MAX_DATA_LEN];
+	Z147SIM_WORLD *world;
+	Z147SIM_DEV *txDev = NULL, *rxDev = NULL;
+	Z147SIM_FAULTS faults;
+	Z147SIM_STATS *st;
+	SIG_CNT sigCnt;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 frameLen = 4 * sfs;
+	u_int32 i, checked = 0, bad = 0, lastSig = 0;
+	u_int64 limit, closeTicks;
+	int32 errors = 0, nbr, result;
+
+	memset(&sigCnt, 0, sizeof(sigCnt));
+	world = Z147SIM_WorldCreate();
+
+	if((result = Z147SIM_DevOpen(world, Z147SIM_RX, NULL, &rxDev)) != 0 ||
+	   (useTx && (result = Z147SIM_DevOpen(world, Z147SIM_TX, NULL, &txDev)) != 0)){
+		printf("*** can't open device: 0x%x\n", result);
+		Z147SIM_WorldDestroy(world);
+		return 1;
+	}
+	Z147SIM_SetSigHook(rxDev, SigHook, &sigCnt);
+
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_DATA_RATE, dataRate) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_SET_SIGNAL, RX_DATA_SIG) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_SET_ERR_SIGNAL, RX_ERR_SIG) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_DEFERRED, deferred) != 0;
+
+	if(txDev){
+		Z147SIM_Connect(txDev, rxDev);
+		errors += Z147SIM_SetStat(txDev, Z247_TX_DATA_RATE, dataRate) != 0;
+		for(i=0; i<frameLen - 4; i++)
+			txData[i] = (u_int16)(i & 0xFF);
+		result = Z147SIM_BlockWrite(txDev, txData, (frameLen - 4) * 2, &nbr);
+		if(result != 0){
+			printf("*** write failed: 0x%x\n", result);
+			errors++;
+		}
+	}
+
+	if(errRate > 0.0){
+		memset(&faults, 0, sizeof(faults));
+		faults.bitErrRate  = errRate;
+		faults.slipRate    = errRate / 4;
+		faults.syncErrRate = errRate * 4;
+		faults.gapRate     = errRate / 4;
+		Z147SIM_SetFaults(rxDev, &faults, 0x1234 + dataRate);
+	}
+
+	/* two frames for synchronization, then one frame time per check */
+	limit = (u_int64)(frames + 3) * frameLen * Z147SIM_PERIOD(dataRate);
+	while(checked < frames && Z147SIM_Ticks(world) < limit){
+		Z147SIM_Run(world, Z147SIM_PERIOD(dataRate));
+		if(sigCnt.dataSigs == lastSig)
+			continue;
+		lastSig = sigCnt.dataSigs;
+
+		result = Z147SIM_BlockRead(rxDev, rxData, sizeof(rxData), &nbr);
+		if(result != 0 || (u_int32)nbr != frameLen * 2){
+			printf("*** read failed: 0x%x (%d bytes)\n", result, nbr);
+			bad++;
+		}else if(CheckFrame(rxData, frameLen, sfs, errRate == 0.0) != 0){
+			bad++;
+		}
+		checked++;
+	}
+
+	st = Z147SIM_Stats(rxDev);
+	printf("rate %4u: frames %u/%u bad %u, err sigs %u, IRQs %llu "
+		   "(%.1f/frame, %.1f MMIO/IRQ), faults %llu, alarms %llu\n",
+		   64 << dataRate, checked, frames, bad, sigCnt.errSigs,
+		   (unsigned long long)st->irqs,
+		   checked ? (double)st->irqsHandled / (lastSig ? lastSig : 1) : 0.0,
+		   st->irqs ? (double)(st->mmioRd + st->mmioWr) / st->irqs : 0.0,
+		   (unsigned long long)st->faults, (unsigned long long)st->alarms);
+
+	/* faults are expected to corrupt and drop frames */
+	if(errRate == 0.0)
+		errors += bad + (checked < frames);
+
+	if(txDev && errRate == 0.0 && errors == 0)
+		errors += RunChange(txDev, rxDev, &sigCnt, dataRate, txData);
+	if(txDev && errRate == 0.0 && errors == 0)
+		errors += RunWatch(txDev, rxDev, &sigCnt, dataRate, txData);
+	if(txDev && errRate == 0.0 && errors == 0)
+		errors += RunCapture(txDev, rxDev, dataRate, txData);
+	if(txDev && errRate == 0.0 && errors == 0)
+		errors += RunRaw(txDev, rxDev, &sigCnt, dataRate, txData);
+	if(txDev && errRate == 0.0 && errors == 0)
+		errors += RunDetect(txDev, rxDev, dataRate, txData);
+
+	/* close like the test tools, after disabling, with frames in flight */
+	if(txDev)
+		errors += Z147SIM_SetStat(txDev, Z247_DISABLE_TX, 1) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_DISABLE_RX, 1) != 0;
+	Z147SIM_Run(world, frameLen * Z147SIM_PERIOD(dataRate) / 2);
+	closeTicks = Z147SIM_Ticks(world);
+	if(txDev && (result = Z147SIM_DevClose(txDev)) != 0){
+		printf("*** close TX failed: 0x%x\n", result);
+		errors++;
+	}
+	if((result = Z147SIM_DevClose(rxDev)) != 0){
+		printf("*** close RX failed: 0x%x\n", result);
+		errors++;
+	}
+	/* nothing running in the ISR, the close must not wait */
+	closeTicks = Z147SIM_Ticks(world) - closeTicks;
+	if(closeTicks != 0){
+		printf("*** close took %llu ticks\n", (unsigned long long)closeTicks);
+		errors++;
+	}
+	Z147SIM_WorldDestroy(world);
+
+	return errors;
+}
+
+/********************************* RunChange *******************************/
+/** Check the change only mode
+ *
+ *  The transmitter repeats its frame, so after the first frame no frame
+ *  may be signaled. Then one data word of subframe 3 is changed.
+ *
+ *  \param txDev      \IN  transmitter, sending the test pattern
+ *  \param rxDev      \IN  receiver in sync
+ *  \param sigCnt     \IN  signal counters
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param txData     \IN  test pattern
+ *
+ *  \return	          number of errors
+ */
+static int32 RunChange( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData )
+{
+	Z147SIM_WORLD *world = Z147SIM_World(rxDev);
+	Z147_CHANGES chg;
+	M_SG_BLOCK blk;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 frameTicks = 4 * sfs * Z147SIM_PERIOD(dataRate);
+	u_int32 idle, changed, word, slot;
+	int32 errors = 0, nbr;
+
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_CHANGE_ONLY, 1) != 0;
+
+	/* the first frame has no previous one, then the repeated frame */
+	Z147SIM_Run(world, frameTicks);
+	idle = sigCnt->dataSigs;
+	Z147SIM_Run(world, 3 * frameTicks);
+	idle = sigCnt->dataSigs - idle;
+
+	/* data word 5 of subframe 3 */
+	word = 2 * (sfs - 1) + 5;
+	slot = (2 * sfs + 6) / (sfs / 16);
+	txData[word] ^= 0x800;
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	changed = sigCnt->dataSigs;
+	Z147SIM_Run(world, 3 * frameTicks);
+	changed = sigCnt->dataSigs - changed;
+	txData[word] ^= 0x800;
+
+	memset(&chg, 0, sizeof(chg));
+	blk.size = sizeof(chg);
+	blk.data = &chg;
+	errors += Z147SIM_GetStat(rxDev, Z147_BLK_RX_CHANGES,
+							  (INT32_OR_64*)&blk) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_CHANGE_ONLY, 0) != 0;
+
+	printf("rate %4u: change only: %u signals for 3 equal frames, %u for "
+		   "a changed word (subframes 0x%x, slots 0x%08x%08x)\n",
+		   sfs, idle, changed, chg.subMask, chg.slotMask[1],
+		   chg.slotMask[0]);
+	if(idle != 0 || changed != 1 || chg.subMask != 0x4 ||
+	   chg.slotMask[slot / 32] != (1u << (slot % 32)) ||
+	   chg.slotMask[1 - slot / 32] != 0)
+		errors++;
+	return errors;
+}
+
+/********************************* RunWatch ********************************/
+/** Check the watch triggers
+ *
+ *  Data word 5 of subframe 3 is changed in bit 11 and changed back. The
+ *  watches on it fire on the change (EQUAL, RANGE) or on both (CHANGE,
+ *  RATE), the EQUAL watch on a constant word fires on its first frame.
+ *  The constant word is the last in the list, so the driver has to sort.
+ *
+ *  \param txDev      \IN  transmitter, sending the test pattern
+ *  \param rxDev      \IN  receiver in sync
+ *  \param sigCnt     \IN  signal counters
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param txData     \IN  test pattern
+ *
+ *  \return	          number of errors
+ */
+static int32 RunWatch( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+					   SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData )
+{
+	static const u_int32 expect[5] = { 1, 2, 1, 2, 1 };
+	Z147SIM_WORLD *world = Z147SIM_World(rxDev);
+	Z147_WATCH watch[5];
+	Z147_TRIG_EVENT ev[Z147_TRIG_QUEUE];
+	M_SG_BLOCK blk;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 frameTicks = 4 * sfs * Z147SIM_PERIOD(dataRate);
+	u_int32 word = 2 * (sfs - 1) + 5;
+	u_int32 num[5], i, n, sigs;
+	u_int16 val = txData[word];
+	int32 errors = 0, nbr, trigCnt = 0;
+
+	memset(watch, 0, sizeof(watch));
+	for(i=0; i<4; i++){
+		watch[i].pos  = (u_int16)(2 * sfs + 6);
+		watch[i].type = (u_int16)i;
+		watch[i].mask = 0xFFF;
+	}
+	watch[Z147_WATCH_EQUAL].lo  = val ^ 0x800;
+	watch[Z147_WATCH_CHANGE].mask = 0x800;
+	watch[Z147_WATCH_RANGE].lo  = 0;
+	watch[Z147_WATCH_RANGE].hi  = 0x7FF;
+	watch[Z147_WATCH_RATE].lo   = 0x400;
+	/* word 3 of subframe 2 */
+	watch[4].pos  = (u_int16)(sfs + 3);
+	watch[4].type = Z147_WATCH_EQUAL;
+	watch[4].mask = 0xFFF;
+	watch[4].lo   = txData[sfs + 1];
+
+	/* the change only check left its change on the line */
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	Z147SIM_Run(world, 2 * frameTicks);
+
+	errors += Z147SIM_SetStat(rxDev, Z147_SET_TRIG_SIGNAL, RX_TRIG_SIG) != 0;
+	blk.size = sizeof(watch);
+	blk.data = watch;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_WATCH,
+							  (INT32_OR_64)&blk) != 0;
+	sigs = sigCnt->trigSigs;
+	Z147SIM_Run(world, 2 * frameTicks);
+	txData[word] ^= 0x800;
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	Z147SIM_Run(world, 3 * frameTicks);
+	txData[word] ^= 0x800;
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	Z147SIM_Run(world, 3 * frameTicks);
+	sigs = sigCnt->trigSigs - sigs;
+
+	blk.size = sizeof(ev);
+	blk.data = ev;
+	errors += Z147SIM_GetStat(rxDev, Z147_BLK_RX_TRIG,
+							  (INT32_OR_64*)&blk) != 0;
+	errors += Z147SIM_GetStat(rxDev, Z147_RX_TRIG_CNT,
+							  (INT32_OR_64*)&trigCnt) != 0;
+	n = blk.size / sizeof(Z147_TRIG_EVENT);
+
+	memset(num, 0, sizeof(num));
+	for(i=0; i<n; i++){
+		if(ev[i].watch >= 5 || ev[i].pos != watch[ev[i].watch].pos)
+			errors++;
+		else
+			num[ev[i].watch]++;
+	}
+	/* the RANGE watch leaves 0..0x7FF with the changed word */
+	for(i=0; i<n; i++){
+		if(ev[i].watch == Z147_WATCH_RANGE &&
+		   (ev[i].value != (val ^ 0x800) || ev[i].prev != val))
+			errors++;
+	}
+
+	blk.size = 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_WATCH,
+							  (INT32_OR_64)&blk) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_CLR_TRIG_SIGNAL, 0) != 0;
+
+	printf("rate %4u: watch: %u events (%u %u %u %u %u), %u signals\n",
+		   sfs, n, num[0], num[1], num[2], num[3], num[4], sigs);
+	for(i=0; i<5; i++)
+		errors += num[i] != expect[i];
+	if((u_int32)trigCnt != n || sigs == 0 || sigs > n)
+		errors++;
+	return errors;
+}
+
+/********************************* RunCapture ******************************/
+/** Check the pre/post trigger capture
+ *
+ *  Captures of 2 frames before and 3 after the trigger frame from a
+ *  history of 8 frames. The first one is triggered by a watch on a word
+ *  changed in the trigger frame, the second one by Z147_RX_CAPT_TRIG
+ *  after the word is changed back.
+ *
+ *  \param txDev      \IN  transmitter, sending the test pattern
+ *  \param rxDev      \IN  receiver in sync
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param txData     \IN  test pattern
+ *
+ *  \return	          number of errors
+ */
+static int32 RunCapture( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						 int32 dataRate, u_int16 *txData )
+{
+	Z147SIM_WORLD *world = Z147SIM_World(rxDev);
+	Z147_CAPTURE cfg;
+	Z147_WATCH watch;
+	M_SG_BLOCK blk;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 frameTicks = 4 * sfs * Z147SIM_PERIOD(dataRate);
+	u_int32 word = 2 * (sfs - 1) + 5;
+	u_int16 val = txData[word];
+	int32 errors = 0, nbr;
+
+	memset(&watch, 0, sizeof(watch));
+	watch.pos  = (u_int16)(2 * sfs + 6);
+	watch.type = Z147_WATCH_CHANGE;
+	watch.mask = 0xFFF;
+	blk.size = sizeof(watch);
+	blk.data = &watch;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_WATCH,
+							  (INT32_OR_64)&blk) != 0;
+
+	cfg.frames   = 8;
+	cfg.pre      = 2;
+	cfg.post     = 3;
+	cfg.trigMask = Z147_CAPT_WATCH | Z147_CAPT_USER;
+	blk.size = sizeof(cfg);
+	blk.data = &cfg;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_CAPTURE,
+							  (INT32_OR_64)&blk) != 0;
+
+	/* history, then the watch event and the post trigger frames */
+	Z147SIM_Run(world, 4 * frameTicks);
+	txData[word] ^= 0x800;
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	Z147SIM_Run(world, 5 * frameTicks);
+	errors += ReadCapture(rxDev, Z147_CAPT_WATCH, watch.pos, val,
+						  val ^ 0x800);
+
+	/* the capture continued in the other region */
+	blk.size = 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_WATCH,
+							  (INT32_OR_64)&blk) != 0;
+	txData[word] ^= 0x800;
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	Z147SIM_Run(world, 3 * frameTicks);
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_CAPT_TRIG, 0) != 0;
+	Z147SIM_Run(world, 5 * frameTicks);
+	errors += ReadCapture(rxDev, Z147_CAPT_USER, watch.pos, val, val);
+
+	cfg.frames = 0;
+	blk.size = sizeof(cfg);
+	blk.data = &cfg;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_CAPTURE,
+							  (INT32_OR_64)&blk) != 0;
+	printf("rate %4u: capture: %s\n", sfs, errors ? "FAILED" : "ok");
+	return errors;
+}
+
+/********************************* ReadCapture *****************************/
+/** Read a frozen capture of 2 + 1 + 3 frames and check a word of it
+ *
+ *  \param rxDev      \IN  receiver
+ *  \param source     \IN  expected Z147_CAPT_xx
+ *  \param pos        \IN  frame position of the word
+ *  \param before     \IN  expected word before the trigger frame
+ *  \param after      \IN  expected word from the trigger frame on
+ *
+ *  \return	          number of errors
+ */
+static int32 ReadCapture( Z147SIM_DEV *rxDev, u_int32 source, u_int32 pos,
+						  u_int16 before, u_int16 after )
+{
+	static u_int16 buf[(sizeof(Z147_CAPT_HDR) / 2) + 6 * MAX_DATA_LEN];
+	Z147_CAPT_HDR *hdr = (Z147_CAPT_HDR*)buf;
+	u_int16 *frm = buf + sizeof(Z147_CAPT_HDR) / 2;
+	M_SG_BLOCK blk;
+	int32 size = 0, errors = 0;
+	u_int32 i;
+
+	errors += Z147SIM_GetStat(rxDev, Z147_RX_CAPT_SIZE,
+							  (INT32_OR_64*)&size) != 0;
+	blk.size = sizeof(buf);
+	blk.data = buf;
+	errors += Z147SIM_GetStat(rxDev, Z147_BLK_RX_CAPTURE,
+							  (INT32_OR_64*)&blk) != 0;
+	if(blk.size == 0 || blk.size != size){
+		printf("*** capture: %d bytes, size %d\n", blk.size, size);
+		return errors + 1;
+	}
+
+	printf("           capture %u: source 0x%x, frames %u..%u "
+		   "(trigger %u), lost %u\n", hdr->capture, hdr->source,
+		   hdr->firstFrame, hdr->firstFrame + hdr->frames - 1,
+		   hdr->trigFrame, hdr->lost);
+	if(hdr->source != source || hdr->frames != 6 ||
+	   hdr->trigFrame != hdr->firstFrame + 2 || hdr->lost != 0)
+		errors++;
+	for(i=0; i<hdr->frames; i++){
+		if(frm[i * hdr->frameWords + pos] != (i < 2 ? before : after))
+			errors++;
+	}
+
+	/* released */
+	errors += Z147SIM_GetStat(rxDev, Z147_RX_CAPT_SIZE,
+							  (INT32_OR_64*)&size) != 0;
+	errors += size != 0;
+	return errors;
+}
+
+/********************************* RunRaw **********************************/
+/** Check the software frame synchronizer of the raw mode
+ *
+ *  The receiver is switched to Z147_RX_SYNC_CFG 0 in the middle of a
+ *  frame, with a decoy sync word in the data. The frames must be aligned
+ *  by the driver. Then one word is lost on the line, the driver must
+ *  realign once without losing the synchronization.
+ *
+ *  \param txDev      \IN  transmitter, sending the test pattern
+ *  \param rxDev      \IN  receiver
+ *  \param sigCnt     \IN  signal counters
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param txData     \IN  test pattern
+ *
+ *  \return	          number of errors
+ */
+static int32 RunRaw( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+					 SIG_CNT *sigCnt, int32 dataRate, u_int16 *txData )
+{
+	static const u_int16 syncWord[4] = {
+		Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+		Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+	};
+	static u_int16 expect[MAX_DATA_LEN];
+	static u_int16 rxData[MAX_DATA_LEN];
+	Z147SIM_WORLD *world = Z147SIM_World(rxDev);
+	Z147SIM_FAULTS faults;
+	u_int32 sfs = 64 << dataRate;
+	u_int32 frameLen = 4 * sfs;
+	u_int32 frameTicks = frameLen * Z147SIM_PERIOD(dataRate);
+	u_int32 errSigs = sigCnt->errSigs;
+	u_int32 k, bad[2];
+	u_int16 decoy = txData[5];
+	INT32_OR_64 inSync[2], slips = 0;
+	int32 errors = 0, nbr, i;
+
+	/* 0x5B8 in the data, not followed by 0xA47 */
+	txData[5] = Z147_ARINC717_SUB_2_SYNC;
+	errors += Z147SIM_BlockWrite(txDev, txData, (frameLen - 4) * 2, &nbr) != 0;
+	for(k=0; k<frameLen; k++)
+		expect[k] = (k % sfs) ? txData[k - k / sfs - 1] : syncWord[k / sfs];
+	Z147SIM_Run(world, frameTicks + frameTicks / 3);
+
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_SYNC_CFG, 0) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_DATA_RATE, dataRate) != 0;
+
+	memset(&faults, 0, sizeof(faults));
+	for(i=0; i<2; i++){
+		if(i == 1){
+			/* lose one word */
+			faults.slipRate = 1.0;
+			Z147SIM_SetFaults(rxDev, &faults, 1);
+			Z147SIM_Run(world, Z147SIM_PERIOD(dataRate));
+			faults.slipRate = 0.0;
+			Z147SIM_SetFaults(rxDev, &faults, 1);
+		}
+		Z147SIM_Run(world, 3 * frameTicks);
+		bad[i] = 0;
+		if(Z147SIM_BlockRead(rxDev, rxData, frameLen * 2, &nbr) != 0 ||
+		   (u_int32)nbr != frameLen * 2){
+			bad[i]++;
+		}
+		for(k=0; k<frameLen; k++)
+			bad[i] += rxData[k] != expect[k];
+		errors += Z147SIM_GetStat(rxDev, Z147_RX_IN_SYNC, &inSync[i]) != 0;
+	}
+	errors += Z147SIM_GetStat(rxDev, Z147_RX_SLIP_CNT, &slips) != 0;
+	errSigs = sigCnt->errSigs - errSigs;
+
+	printf("rate %4u: raw: %u/%u wrong words, in sync %d/%d, slips %d, "
+		   "err sigs %u\n", sfs, bad[0], bad[1], (int32)inSync[0],
+		   (int32)inSync[1], (int32)slips, errSigs);
+	errors += bad[0] + bad[1] + !inSync[0] + !inSync[1] + (slips != 1) +
+		errSigs;
+
+	txData[5] = decoy;
+	errors += Z147SIM_BlockWrite(txDev, txData, (frameLen - 4) * 2, &nbr) != 0;
+	return errors;
+}
+
+/********************************* RunDetect *******************************/
+/** Check the automatic data rate detection
+ *
+ *  The receiver starts at a wrong rate with full synchronization. The
+ *  detection once has to find the rate of the transmitter, then the
+ *  transmitter changes its rate and the follow mode has to find the new
+ *  one. Both times a correct frame must be received afterwards.
+ *
+ *  \param txDev      \IN  transmitter, sending the test pattern
+ *  \param rxDev      \IN  receiver
+ *  \param dataRate   \IN  Z147_RX_DATA_RATE_xx
+ *  \param txData     \IN  test pattern buffer
+ *
+ *  \return	          number of errors
+ */
+static int32 RunDetect( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev,
+						int32 dataRate, u_int16 *txData )
+{
+	static u_int16 rxData[MAX_DATA_LEN];
+	Z147SIM_WORLD *world = Z147SIM_World(rxDev);
+	INT32_OR_64 got = 0, inSync = 0, mode[2] = { 0, 0 }, ms[2] = { 0, 0 };
+	Z147_WATCH watch;
+	M_SG_BLOCK blk;
+	int32 rate[2], wrong[2] = { 0, 0 };
+	int32 errors = 0, nbr, i;
+	u_int32 k, sfs = 0;
+	u_int64 t0;
+
+	rate[0] = dataRate;
+	rate[1] = (dataRate + 3) & 0x7;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_SYNC_CFG, 2) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_DATA_RATE, (dataRate + 5) & 0x7) != 0;
+
+	for(i=0; i<2; i++){
+		sfs = 64 << rate[i];
+		errors += Z147SIM_SetStat(txDev, Z247_TX_DATA_RATE, rate[i]) != 0;
+		for(k=0; k<4 * sfs - 4; k++)
+			txData[k] = (u_int16)(k & 0xFF);
+		errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+		errors += Z147SIM_SetStat(rxDev, Z147_RX_RATE_DETECT,
+								  i ? Z147_DETECT_FOLLOW : Z147_DETECT_ONCE) != 0;
+
+		/* sync lost, all rates probed, full synchronization, one frame */
+		t0 = Z147SIM_Ticks(world);
+		do{
+			Z147SIM_Run(world, Z147SIM_MS2TICKS(100));
+			Z147SIM_GetStat(rxDev, Z147_RX_DATA_RATE, &got);
+			Z147SIM_GetStat(rxDev, Z147_RX_IN_SYNC, &inSync);
+		}while((got != rate[i] || !inSync) &&
+			   Z147SIM_Ticks(world) - t0 < Z147SIM_MS2TICKS(40000));
+
+		errors += Z147SIM_GetStat(rxDev, Z147_RX_DETECT_MS, &ms[i]) != 0;
+		errors += Z147SIM_GetStat(rxDev, Z147_RX_RATE_DETECT, &mode[i]) != 0;
+		if(Z147SIM_BlockRead(rxDev, rxData, sizeof(rxData), &nbr) != 0 ||
+		   (u_int32)nbr != 4 * sfs * 2)
+			wrong[i]++;
+		else
+			wrong[i] += CheckFrame(rxData, 4 * sfs, sfs, 1);
+		errors += (got != rate[i]) + !inSync + (ms[i] <= 0) + wrong[i];
+	}
+	/* once is over, follow goes on */
+	errors += (mode[0] != Z147_DETECT_OFF) + (mode[1] != Z147_DETECT_FOLLOW);
+
+	/* the probes change the frame size, no watch meanwhile */
+	memset(&watch, 0, sizeof(watch));
+	watch.type = Z147_WATCH_CHANGE;
+	watch.mask = 0xFFF;
+	blk.size = sizeof(watch);
+	blk.data = &watch;
+	errors += Z147SIM_SetStat(rxDev, Z147_BLK_RX_WATCH,
+							  (INT32_OR_64)&blk) == 0;
+
+	printf("rate %4u: detect: %d ms, follow to %u: %d ms, "
+		   "%d/%d wrong words\n", 64 << dataRate, (int32)ms[0],
+		   64 << rate[1], (int32)ms[1], wrong[0], wrong[1]);
+
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_RATE_DETECT, Z147_DETECT_OFF) != 0;
+	errors += Z147SIM_SetStat(rxDev, Z147_RX_DATA_RATE, dataRate) != 0;
+	sfs = 64 << dataRate;
+	errors += Z147SIM_SetStat(txDev, Z247_TX_DATA_RATE, dataRate) != 0;
+	for(k=0; k<4 * sfs - 4; k++)
+		txData[k] = (u_int16)(k & 0xFF);
+	errors += Z147SIM_BlockWrite(txDev, txData, (4 * sfs - 4) * 2, &nbr) != 0;
+	return errors;
+}
+
+/********************************* CheckFrame ******************************/
+/** Check a received frame against the test pattern
+ *
+ *  Slot k holds sync word k/sfs at the sub frame start, else data word
+ *  (k - k/sfs - 1) & 0xFF.
+ *
+ *  \param buf        \IN  frame
+ *  \param frameLen   \IN  frame length in words
+ *  \param sfs        \IN  sub frame size in words
+ *  \param verbose    \IN  print the first wrong words
+ *
+ *  \return	          0 or number of wrong words
+ */
+static int32 CheckFrame( u_int16 *buf, u_int32 frameLen, u_int32 sfs,
+						 int32 verbose )
+{
+	static const u_int16 syncWord[4] = {
+		Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+		Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+	};
+	u_int32 k;
+	u_int16 expect;
+	int32 wrong = 0;
+
+	for(k=0; k<frameLen; k++){
+		if((k % sfs) == 0)
+			expect = syncWord[k / sfs];
+		else
+			expect = (u_int16)((k - k / sfs - 1) & 0xFF);
+		if(buf[k] != expect){
+			if(verbose && wrong < 4)
+				printf("    word %u: 0x%03x, expected 0x%03x\n",
+					   k, buf[k], expect);
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+/********************************* SigHook *********************************/
+/** Count the signals sent by the receive driver
+ *
+ *  \param dev        \IN  device
+ *  \param sigNum     \IN  signal number
+ *  \param arg        \IN  SIG_CNT
+ */
+static void SigHook( Z147SIM_DEV *dev, int32 sigNum, void *arg )
+{
+	SIG_CNT *cnt = (SIG_CNT*)arg;
+
+	if(sigNum == RX_DATA_SIG)
+		cnt->dataSigs++;
+	else if(sigNum == RX_TRIG_SIG)
+		cnt->trigSigs++;
+	else
+		cnt->errSigs++;
+}
@@ -0,0 +1,1414 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_sim_core.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Register model of the 16Z147/16Z247 ARINC717 cores
+ *
+ *               RX (16Z147) register map:
+ *               - 0x0000..0x07FF  RX FIFO window, word i = i-th unread word
+ *               - 0x800  STAT     bit0 line status IRQ, bit1 data available
+ *               - 0x801  LSR      OE/SE/LSE (write 1 to clear), INSYNC,
+ *                                 RXSUB (sub frame of the first FIFO word)
+ *               - 0x802  RXC      number of words in the FIFO
+ *               - 0x804  RXA      acknowledge (remove) words from the FIFO
+ *               - 0x806  SUB_PTR  word position of the first FIFO word
+ *               - 0x808  IER      bit0 RLSIEN, bit1 RDAIEN
+ *               - 0x809  LCR      sync mode, data rate, RX mode
+ *               - 0x80A  FCR      trigger level
+ *               - 0x80B  RST      core reset
+ *
+ *               TX (16Z247) register map:
+ *               - 0x0000..0x07FF  TX FIFO window, committed by TXA
+ *               - 0x800  IIR      bit0 line status IRQ, bit1 space available
+ *               - 0x801  LSR      bit0 underrun (write 1 to clear)
+ *               - 0x802  TXC      number of words in the FIFO
+ *               - 0x804  TXA      commit words from the window to the FIFO
+ *               - 0x806  SUB_PTR  word position of the next sent word
+ *               - 0x808  IER, 0x809 LCR (loop, rate, mode), 0x80A FCR,
+ *                 0x80B RST
+ *
+ *               The transmitter inserts the four sync words itself, the
+ *               receiver acquires synchronization according to the LCR
+ *               sync mode and passes all words including the sync words
+ *               into its FIFO.
+ *
+ *     Required: pthread
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sim_core.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#define _LL_DRV_
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <signal.h>
+#include <MEN/men_typs.h>
+#include <MEN/maccess.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_com.h>
+#include <MEN/mdis_err.h>
+#include <MEN/ll_defs.h>
+#include <MEN/ll_entry.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z247_drv.h>
+#include <MEN/z147_sim.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define REG_STAT        0x800       /**< STAT/IIR */
+#define REG_LSR         0x801       /**< line status */
+#define REG_CNT         0x802       /**< RXC/TXC (16 bit) */
+#define REG_ACK         0x804       /**< RXA/TXA (16 bit) */
+#define REG_SUB_PTR     0x806       /**< SUB_PTR (16 bit) */
+#define REG_IER         0x808       /**< interrupt enable */
+#define REG_LCR         0x809       /**< line control */
+#define REG_FCR         0x80A       /**< FIFO control */
+#define REG_RST         0x80B       /**< reset */
+
+#define STAT_LS_IRQ     0x01        /**< line status IRQ pending */
+#define STAT_DATA_IRQ   0x02        /**< data available/space IRQ pending */
+
+#define RX_LSR_OE       0x02        /**< overrun error */
+#define RX_LSR_SE       0x04        /**< stream interruption error */
+#define RX_LSR_LSE      0x08        /**< lost synchronization error */
+#define RX_LSR_ERR      (RX_LSR_OE|RX_LSR_SE|RX_LSR_LSE)
+#define RX_LSR_INSYNC   0x10        /**< receiver in sync */
+#define RX_LSR_SUB_OFF  5           /**< sub frame number offset */
+
+#define TX_LSR_UE       0x01        /**< underrun error */
+
+#define LCR_SYNC(lcr)   ((lcr) & 0x03)
+#define LCR_RATE(lcr)   (((lcr) >> 2) & 0x07)
+#define LCR_MODE(lcr)   (((lcr) >> 5) & 0x01)
+
+#define SE_IDLE_WORDS   2           /**< idle words until stream error */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** OSS handle of a device, points back to the device */
+struct OSS_HANDLE {
+	Z147SIM_DEV     *dev;
+};
+
+/** simulated IP core */
+struct Z147SIM_DEV {
+	Z147SIM_WORLD   *world;         /**< owning world */
+	int32           type;           /**< Z147SIM_RX/Z147SIM_TX */
+	OSS_HANDLE      oss;            /**< OSS handle passed to the driver */
+	MACCESS         ma;             /**< hw access handle (this device) */
+	LL_ENTRY        entry;          /**< driver jump table */
+	LL_HANDLE       *llHdl;         /**< driver handle */
+
+	/* registers */
+	u_int8          lsr;            /**< LSR error bits */
+	u_int8          ier;            /**< IER */
+	u_int8          lcr;            /**< LCR */
+	u_int8          fcr;            /**< FCR */
+	u_int8          rst;            /**< RST */
+	u_int16         ack;            /**< last RXA/TXA value */
+
+	/* FIFO */
+	u_int16         fifo[Z147SIM_FIFO_WORDS];    /**< FIFO words */
+	u_int16         fifoPos[Z147SIM_FIFO_WORDS]; /**< RX: frame position */
+	u_int16         window[Z147SIM_FIFO_WORDS];  /**< TX: write window */
+	u_int32         fifoRd;         /**< FIFO read index */
+	u_int32         fifoCnt;        /**< FIFO fill level */
+
+	/* line */
+	u_int32         linePos;        /**< frame position of next word */
+	u_int8          inSync;         /**< RX: synchronized */
+	u_int8          txStarted;      /**< TX: first data committed */
+	u_int32         idleWords;      /**< RX: consecutive idle words */
+	u_int64         wordIdx;        /**< RX: received word index */
+	u_int32         huntCnt;        /**< RX: sync words found in order */
+	u_int32         huntSub;        /**< RX: next expected sub frame */
+	u_int64         huntIdx;        /**< RX: word index of next sync */
+	u_int16         lineWord;       /**< TX: word on the line */
+	u_int8          lineValid;      /**< TX: lineWord is valid */
+	u_int8          irqDirty;       /**< re-evaluate IRQ at next tick */
+	Z147SIM_DEV     *peer;          /**< RX: connected transmitter */
+
+	/* generator (RX without transmitter) */
+	Z147SIM_GENFUNC genFunc;        /**< data word generator */
+	void            *genArg;        /**< generator argument */
+	u_int32         genFrame;       /**< generator frame count */
+	u_int32         genPos;         /**< generator frame position */
+
+	/* fault injection */
+	Z147SIM_FAULTS  faults;         /**< fault settings */
+	u_int32         rng;            /**< PRNG state */
+
+	Z147SIM_SIGFUNC sigFunc;        /**< signal hook */
+	void            *sigArg;        /**< signal hook argument */
+	Z147SIM_IRQFUNC irqFunc;        /**< ISR hook */
+	void            *irqArg;        /**< ISR hook argument */
+	Z147SIM_IRQFUNC workFunc;       /**< alarm routine hook */
+	void            *workArg;       /**< alarm routine hook argument */
+	OSS_ALARM_HANDLE *alarms;       /**< alarms of the driver */
+	Z147SIM_STATS   stats;          /**< statistics */
+};
+
+/** simulation world */
+struct Z147SIM_WORLD {
+	pthread_mutex_t lock;           /**< interrupt lock (recursive) */
+	int32           lockDepth;      /**< nesting of lock by owner */
+	pthread_t       thread;         /**< background thread */
+	volatile int32  running;        /**< background thread active */
+	volatile u_int64 tick;          /**< current tick */
+	double          speed;          /**< 0: unpaced, else x real time */
+	struct timespec paceStart;      /**< wall clock at paceTick */
+	u_int64         paceTick;       /**< tick at paceStart */
+	Z147SIM_DEV     *dev[Z147SIM_MAX_DEV];   /**< devices */
+};
+
+/** OSS signal handle */
+struct OSS_SIG_HANDLE {
+	int32           sigNum;         /**< signal number */
+};
+
+/** OSS alarm handle, fired by Z147SIM_Run() in simulation time */
+struct OSS_ALARM_HANDLE {
+	Z147SIM_DEV     *dev;           /**< device of the driver */
+	void            (*funct)( void *arg ); /**< alarm routine */
+	void            *arg;           /**< alarm routine argument */
+	u_int64         due;            /**< tick to fire at */
+	u_int64         period;         /**< cyclic: period in ticks, else 0 */
+	u_int8          active;         /**< alarm set */
+	OSS_ALARM_HANDLE *next;         /**< next alarm of the device */
+};
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static const u_int16 G_syncWord[4] = {
+	Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+	Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+};
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern void Z147_GetEntry( LL_ENTRY *drvP );
+extern void Z247_GetEntry( LL_ENTRY *drvP );
+
+static void DevReset( Z147SIM_DEV *dev );
+static void RxHuntReset( Z147SIM_DEV *dev );
+static void RxLineWord( Z147SIM_DEV *dev, u_int16 word );
+static void RxStep( Z147SIM_DEV *dev );
+static void TxStep( Z147SIM_DEV *dev );
+static u_int8 IrqPending( Z147SIM_DEV *dev );
+static void RunAlarms( Z147SIM_DEV *dev );
+static void DelayTicks( Z147SIM_WORLD *world, u_int64 ticks );
+static void Pace( Z147SIM_WORLD *world );
+static u_int64 NsNow( void );
+static void* RunThread( void *arg );
+
+/**********************************************************************/
+/** Sub frame size in words for the current LCR rate */
+static u_int32 SubFrameSize( Z147SIM_DEV *dev )
+{
+	return 64 << LCR_RATE(dev->lcr);
+}
+
+/**********************************************************************/
+/** FIFO trigger level in words for the current FCR */
+static u_int32 TrigWords( Z147SIM_DEV *dev )
+{
+	u_int32 lvl = dev->fcr & 0x07;
+
+	return lvl ? (4u << lvl) : 1;
+}
+
+/**********************************************************************/
+/** Pseudo random number 0.0..1.0 (xorshift32) */
+static double Rand( Z147SIM_DEV *dev )
+{
+	u_int32 x = dev->rng;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	dev->rng = x;
+	return (double)x / 4294967296.0;
+}
+
+/**********************************************************************/
+/** Sync word index (0..3) of a word or -1 */
+static int32 SyncIndex( u_int16 word )
+{
+	int32 i;
+
+	for( i=0; i<4; i++ )
+		if( word == G_syncWord[i] )
+			return i;
+	return -1;
+}
+
+/******************************* Z147SIM_WorldCreate ************************/
+/** Create an empty simulation world
+ *
+ *  \return           world or NULL
+ */
+Z147SIM_WORLD* Z147SIM_WorldCreate( void )
+{
+	Z147SIM_WORLD *world;
+	pthread_mutexattr_t attr;
+
+	if( (world = (Z147SIM_WORLD*)calloc(1, sizeof(*world))) == NULL )
+		return NULL;
+
+	pthread_mutexattr_init( &attr );
+	pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+	pthread_mutex_init( &world->lock, &attr );
+	pthread_mutexattr_destroy( &attr );
+
+	return world;
+}
+
+/******************************* Z147SIM_WorldDestroy ***********************/
+/** Stop the world and close all remaining devices
+ *
+ *  \param world      \IN  world
+ */
+void Z147SIM_WorldDestroy( Z147SIM_WORLD *world )
+{
+	int32 i;
+
+	Z147SIM_Stop( world );
+	for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+		if( world->dev[i] ){
+			/* force removal even if the driver refuses to exit */
+			if( Z147SIM_DevClose(world->dev[i]) != ERR_SUCCESS && world->dev[i] ){
+				free( world->dev[i] );
+				world->dev[i] = NULL;
+			}
+		}
+	}
+	pthread_mutex_destroy( &world->lock );
+	free( world );
+}
+
+/******************************* Z147SIM_SetSpeed ***************************/
+/** Set simulation speed
+ *
+ *  \param world      \IN  world
+ *  \param speed      \IN  0 = as fast as possible, 1.0 = real time,
+ *                         n = n times faster than real time
+ */
+void Z147SIM_SetSpeed( Z147SIM_WORLD *world, double speed )
+{
+	Z147SIM_Lock( world );
+	world->speed = speed;
+	world->paceTick = world->tick;
+	clock_gettime( CLOCK_MONOTONIC, &world->paceStart );
+	Z147SIM_Unlock( world );
+}
+
+/******************************* Z147SIM_Lock *******************************/
+/** Take the interrupt lock of the world
+ *
+ *  All driver entries are called with this lock held, the simulated
+ *  interrupt runs with it held as well.
+ *
+ *  \param world      \IN  world
+ */
+void Z147SIM_Lock( Z147SIM_WORLD *world )
+{
+	pthread_mutex_lock( &world->lock );
+	world->lockDepth++;
+}
+
+/******************************* Z147SIM_Unlock *****************************/
+/** Release the interrupt lock of the world
+ *
+ *  \param world      \IN  world
+ */
+void Z147SIM_Unlock( Z147SIM_WORLD *world )
+{
+	world->lockDepth--;
+	pthread_mutex_unlock( &world->lock );
+}
+
+/******************************* Z147SIM_Ticks ******************************/
+/** Current simulation time
+ *
+ *  \param world      \IN  world
+ *  \return           ticks since creation
+ */
+u_int64 Z147SIM_Ticks( Z147SIM_WORLD *world )
+{
+	return world->tick;
+}
+
+/******************************* Z147SIM_Run ********************************/
+/** Advance the simulation
+ *
+ *  Moves words over the line, updates the FIFOs and calls the driver ISR
+ *  of each device while its interrupt is pending.
+ *
+ *  \param world      \IN  world
+ *  \param ticks      \IN  ticks to run
+ *  \return           ticks run
+ */
+u_int64 Z147SIM_Run( Z147SIM_WORLD *world, u_int64 ticks )
+{
+	u_int64 n, t0;
+	int32 i, irqRes;
+	Z147SIM_DEV *dev;
+
+	for( n=0; n<ticks; n++ ){
+		Z147SIM_Lock( world );
+
+		/* transmitters first, the receivers sample the line afterwards */
+		for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+			dev = world->dev[i];
+			if( dev && dev->type == Z147SIM_TX &&
+				(world->tick % Z147SIM_PERIOD(LCR_RATE(dev->lcr))) == 0 ){
+				TxStep( dev );
+				dev->irqDirty = 1;
+			}
+		}
+		for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+			dev = world->dev[i];
+			if( dev && dev->type == Z147SIM_RX &&
+				(world->tick % Z147SIM_PERIOD(LCR_RATE(dev->lcr))) == 0 ){
+				RxStep( dev );
+				dev->irqDirty = 1;
+			}
+		}
+
+		/* level triggered interrupt, evaluated when the device changed */
+		for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+			dev = world->dev[i];
+			if( dev && dev->irqDirty && dev->llHdl ){
+				dev->irqDirty = 0;
+				if( IrqPending(dev) ){
+					dev->stats.irqs++;
+					if( dev->irqFunc ){
+						t0 = NsNow();
+						irqRes = dev->entry.irq( dev->llHdl );
+						dev->irqFunc( dev, NsNow() - t0, dev->irqArg );
+					}else{
+						irqRes = dev->entry.irq( dev->llHdl );
+					}
+					if( irqRes == LL_IRQ_DEVICE )
+						dev->stats.irqsHandled++;
+				}
+			}
+		}
+
+		/* alarms, the deferred work of the drivers */
+		for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+			dev = world->dev[i];
+			if( dev && dev->alarms )
+				RunAlarms( dev );
+		}
+
+		world->tick++;
+		Z147SIM_Unlock( world );
+
+		if( world->speed > 0.0 )
+			Pace( world );
+	}
+
+	return n;
+}
+
+/******************************* Z147SIM_Start ******************************/
+/** Run the simulation in a background thread
+ *
+ *  Useful together with Z147SIM_SetSpeed() to emulate a device running
+ *  concurrently to the application.
+ *
+ *  \param world      \IN  world
+ *  \return           0 on success or error code
+ */
+int32 Z147SIM_Start( Z147SIM_WORLD *world )
+{
+	if( world->running )
+		return ERR_LL_DEV_BUSY;
+
+	world->running = 1;
+	if( pthread_create(&world->thread, NULL, RunThread, world) != 0 ){
+		world->running = 0;
+		return ERR_OSS_MEM_ALLOC;
+	}
+	return ERR_SUCCESS;
+}
+
+/******************************* Z147SIM_Stop *******************************/
+/** Stop the background thread
+ *
+ *  \param world      \IN  world
+ */
+void Z147SIM_Stop( Z147SIM_WORLD *world )
+{
+	if( world->running ){
+		world->running = 0;
+		pthread_join( world->thread, NULL );
+	}
+}
+
+/**********************************************************************/
+/** Background thread: run until stopped
+ *
+ *  Signals are blocked, process signals (e.g. sent for driver signals by
+ *  the MDIS API of the simulator) go to the application threads.
+ */
+static void* RunThread( void *arg )
+{
+	Z147SIM_WORLD *world = (Z147SIM_WORLD*)arg;
+	sigset_t set;
+
+	sigfillset( &set );
+	pthread_sigmask( SIG_BLOCK, &set, NULL );
+
+	while( world->running )
+		Z147SIM_Run( world, 1 );
+
+	return NULL;
+}
+
+/**********************************************************************/
+/** Monotonic clock in ns */
+static u_int64 NsNow( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (u_int64)ts.tv_sec * 1000000000ULL + (u_int64)ts.tv_nsec;
+}
+
+/**********************************************************************/
+/** Sleep until wall clock catches up with the simulation time */
+static void Pace( Z147SIM_WORLD *world )
+{
+	struct timespec now, target;
+	double ns;
+
+	ns = (double)(world->tick - world->paceTick) * 1e9 /
+		(Z147SIM_TICK_HZ * world->speed);
+	target = world->paceStart;
+	target.tv_sec  += (time_t)(ns / 1e9);
+	target.tv_nsec += (long)(ns - (double)(time_t)(ns / 1e9) * 1e9);
+	if( target.tv_nsec >= 1000000000L ){
+		target.tv_sec++;
+		target.tv_nsec -= 1000000000L;
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	if( now.tv_sec < target.tv_sec ||
+		(now.tv_sec == target.tv_sec && now.tv_nsec < target.tv_nsec) )
+		clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL );
+}
+
+/******************************* Z147SIM_DevOpen ****************************/
+/** Create a simulated core and initialize its LL driver
+ *
+ *  \param world      \IN  world
+ *  \param type       \IN  Z147SIM_RX or Z147SIM_TX
+ *  \param desc       \IN  descriptor (may be NULL)
+ *  \param devP       \OUT device
+ *  \return           0 on success or error code of the driver
+ */
+int32 Z147SIM_DevOpen(
+	Z147SIM_WORLD *world,
+	int32 type,
+	DESC_SPEC *desc,
+	Z147SIM_DEV **devP )
+{
+	static DESC_SPEC noDesc[] = { { NULL, 0 } };
+	Z147SIM_DEV *dev;
+	int32 i, error;
+
+	*devP = NULL;
+	if( (dev = (Z147SIM_DEV*)calloc(1, sizeof(*dev))) == NULL )
+		return ERR_OSS_MEM_ALLOC;
+
+	dev->world   = world;
+	dev->type    = type;
+	dev->oss.dev = dev;
+	dev->ma      = dev;
+	dev->rng     = 0x147247;
+	DevReset( dev );
+
+	if( type == Z147SIM_RX )
+		Z147_GetEntry( &dev->entry );
+	else
+		Z247_GetEntry( &dev->entry );
+
+	Z147SIM_Lock( world );
+	for( i=0; i<Z147SIM_MAX_DEV && world->dev[i]; i++ )
+		;
+	if( i == Z147SIM_MAX_DEV ){
+		Z147SIM_Unlock( world );
+		free( dev );
+		return ERR_LL_DEV_BUSY;
+	}
+	world->dev[i] = dev;
+
+	error = dev->entry.init( desc ? desc : noDesc, &dev->oss, &dev->ma,
+							 NULL, NULL, &dev->llHdl );
+	if( error ){
+		world->dev[i] = NULL;
+		Z147SIM_Unlock( world );
+		free( dev );
+		return error;
+	}
+	Z147SIM_Unlock( world );
+
+	*devP = dev;
+	return ERR_SUCCESS;
+}
+
+/******************************* Z147SIM_DevClose ***************************/
+/** Exit the LL driver and remove the core
+ *
+ *  If the driver refuses to exit, the device stays open and the driver
+ *  error is returned.
+ *
+ *  \param dev        \IN  device
+ *  \return           0 on success or error code of the driver
+ */
+int32 Z147SIM_DevClose( Z147SIM_DEV *dev )
+{
+	Z147SIM_WORLD *world = dev->world;
+	int32 i, error;
+
+	Z147SIM_Lock( world );
+	error = dev->entry.exit( &dev->llHdl );
+	if( error == ERR_SUCCESS || dev->llHdl == NULL ){
+		for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+			if( world->dev[i] == dev )
+				world->dev[i] = NULL;
+			else if( world->dev[i] && world->dev[i]->peer == dev )
+				world->dev[i]->peer = NULL;
+		}
+		free( dev );
+	}
+	Z147SIM_Unlock( world );
+
+	return error;
+}
+
+/******************************* Z147SIM_Connect ****************************/
+/** Connect a transmitter to a receiver (ARINC717 bus)
+ *
+ *  The receiver gets the words of the transmitter when both use the same
+ *  data rate and line mode, otherwise it sees an idle line.
+ *
+ *  \param txDev      \IN  transmitter
+ *  \param rxDev      \IN  receiver
+ */
+void Z147SIM_Connect( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev )
+{
+	Z147SIM_Lock( rxDev->world );
+	rxDev->peer = txDev;
+	Z147SIM_Unlock( rxDev->world );
+}
+
+/******************************* Z147SIM_SetGenerator ***********************/
+/** Set the data word generator of a receiver without transmitter
+ *
+ *  Without generator the receiver gets the counting pattern of the test
+ *  tools (data word n of a frame is n & 0xFF).
+ *
+ *  \param dev        \IN  receiver
+ *  \param func       \IN  generator or NULL
+ *  \param arg        \IN  generator argument
+ */
+void Z147SIM_SetGenerator( Z147SIM_DEV *dev, Z147SIM_GENFUNC func, void *arg )
+{
+	Z147SIM_Lock( dev->world );
+	dev->genFunc = func;
+	dev->genArg  = arg;
+	Z147SIM_Unlock( dev->world );
+}
+
+/******************************* Z147SIM_SetFaults **************************/
+/** Set fault injection of a receiver
+ *
+ *  \param dev        \IN  receiver
+ *  \param faults     \IN  fault probabilities or NULL to disable
+ *  \param seed       \IN  random seed (0 keeps the current state)
+ */
+void Z147SIM_SetFaults(
+	Z147SIM_DEV *dev,
+	const Z147SIM_FAULTS *faults,
+	u_int32 seed )
+{
+	Z147SIM_Lock( dev->world );
+	if( faults )
+		dev->faults = *faults;
+	else
+		memset( &dev->faults, 0, sizeof(dev->faults) );
+	if( seed )
+		dev->rng = seed;
+	Z147SIM_Unlock( dev->world );
+}
+
+/******************************* Z147SIM_SetSigHook *************************/
+/** Set hook called for each signal the driver sends
+ *
+ *  \param dev        \IN  device
+ *  \param func       \IN  hook or NULL
+ *  \param arg        \IN  hook argument
+ */
+void Z147SIM_SetSigHook( Z147SIM_DEV *dev, Z147SIM_SIGFUNC func, void *arg )
+{
+	Z147SIM_Lock( dev->world );
+	dev->sigFunc = func;
+	dev->sigArg  = arg;
+	Z147SIM_Unlock( dev->world );
+}
+
+/******************************* Z147SIM_SetWorkHook ************************/
+/** Set hook called after each alarm routine of the driver
+ *
+ *  The hook gets the duration of the routine, like the ISR hook. It is
+ *  called with the interrupt lock held.
+ *
+ *  \param dev        \IN  device
+ *  \param func       \IN  hook or NULL
+ *  \param arg        \IN  hook argument
+ */
+void Z147SIM_SetWorkHook( Z147SIM_DEV *dev, Z147SIM_IRQFUNC func, void *arg )
+{
+	Z147SIM_Lock( dev->world );
+	dev->workFunc = func;
+	dev->workArg  = arg;
+	Z147SIM_Unlock( dev->world );
+}
+
+/******************************* Z147SIM_SetIrqHook *************************/
+/** Set hook called after each ISR invocation
+ *
+ *  The hook gets the ISR duration measured with CLOCK_MONOTONIC. It is
+ *  called with the interrupt lock held.
+ *
+ *  \param dev        \IN  device
+ *  \param func       \IN  hook or NULL
+ *  \param arg        \IN  hook argument
+ */
+void Z147SIM_SetIrqHook( Z147SIM_DEV *dev, Z147SIM_IRQFUNC func, void *arg )
+{
+	Z147SIM_Lock( dev->world );
+	dev->irqFunc = func;
+	dev->irqArg  = arg;
+	Z147SIM_Unlock( dev->world );
+}
+
+/******************************* Z147SIM_Stats ******************************/
+/** Statistics of a device
+ *
+ *  \param dev        \IN  device
+ *  \return           statistics (may be cleared by the caller)
+ */
+Z147SIM_STATS* Z147SIM_Stats( Z147SIM_DEV *dev )
+{
+	return &dev->stats;
+}
+
+/******************************* Z147SIM_World ******************************/
+/** World of a device
+ *
+ *  \param dev        \IN  device
+ *  \return           world
+ */
+Z147SIM_WORLD* Z147SIM_World( Z147SIM_DEV *dev )
+{
+	return dev->world;
+}
+
+/******************************* Z147SIM_SetStat ****************************/
+/** Call the SetStat entry of the driver
+ *
+ *  \param dev        \IN  device
+ *  \param code       \IN  status code
+ *  \param value      \IN  value or pointer to M_SG_BLOCK
+ *  \return           driver result
+ */
+int32 Z147SIM_SetStat( Z147SIM_DEV *dev, int32 code, INT32_OR_64 value )
+{
+	int32 error;
+
+	Z147SIM_Lock( dev->world );
+	error = dev->entry.setStat( dev->llHdl, code, 0, value );
+	Z147SIM_Unlock( dev->world );
+	return error;
+}
+
+/******************************* Z147SIM_GetStat ****************************/
+/** Call the GetStat entry of the driver
+ *
+ *  \param dev        \IN  device
+ *  \param code       \IN  status code
+ *  \param valueP     \OUT value or \IN pointer to M_SG_BLOCK
+ *  \return           driver result
+ */
+int32 Z147SIM_GetStat( Z147SIM_DEV *dev, int32 code, INT32_OR_64 *valueP )
+{
+	int32 error;
+
+	Z147SIM_Lock( dev->world );
+	error = dev->entry.getStat( dev->llHdl, code, 0, valueP );
+	Z147SIM_Unlock( dev->world );
+	return error;
+}
+
+/******************************* Z147SIM_BlockRead **************************/
+/** Call the BlockRead entry of the driver
+ *
+ *  \param dev         \IN  device
+ *  \param buf         \IN  data buffer
+ *  \param size        \IN  data buffer size
+ *  \param nbrRdBytesP \OUT number of read bytes
+ *  \return            driver result
+ */
+int32 Z147SIM_BlockRead(
+	Z147SIM_DEV *dev,
+	void *buf,
+	int32 size,
+	int32 *nbrRdBytesP )
+{
+	int32 error;
+
+	Z147SIM_Lock( dev->world );
+	error = dev->entry.blockRead( dev->llHdl, 0, buf, size, nbrRdBytesP );
+	Z147SIM_Unlock( dev->world );
+	return error;
+}
+
+/******************************* Z147SIM_BlockWrite *************************/
+/** Call the BlockWrite entry of the driver
+ *
+ *  \param dev         \IN  device
+ *  \param buf         \IN  data buffer
+ *  \param size        \IN  data buffer size
+ *  \param nbrWrBytesP \OUT number of written bytes
+ *  \return            driver result
+ */
+int32 Z147SIM_BlockWrite(
+	Z147SIM_DEV *dev,
+	void *buf,
+	int32 size,
+	int32 *nbrWrBytesP )
+{
+	int32 error;
+
+	Z147SIM_Lock( dev->world );
+	error = dev->entry.blockWrite( dev->llHdl, 0, buf, size, nbrWrBytesP );
+	Z147SIM_Unlock( dev->world );
+	return error;
+}
+
+/******************************* Z147SIM_Read *******************************/
+/** Simulated register/FIFO read
+ *
+ *  \param dev        \IN  device
+ *  \param offs       \IN  byte offset
+ *  \param width      \IN  access width in bytes (1, 2, 4)
+ *  \return           register value
+ */
+u_int32 Z147SIM_Read( Z147SIM_DEV *dev, u_int32 offs, u_int32 width )
+{
+	u_int32 val = 0, pos, i, sfs = SubFrameSize(dev);
+	u_int8  regs[12];
+
+	dev->stats.mmioRd++;
+
+	/* FIFO window */
+	if( offs < REG_STAT ){
+		i = offs / 2;
+		if( dev->type == Z147SIM_RX )
+			val = (i < dev->fifoCnt) ?
+				dev->fifo[(dev->fifoRd + i) % Z147SIM_FIFO_WORDS] : 0;
+		else
+			val = dev->window[i % Z147SIM_FIFO_WORDS];
+		return val;
+	}
+
+	/* register block as byte image */
+	if( dev->type == Z147SIM_RX )
+		pos = dev->fifoCnt ? dev->fifoPos[dev->fifoRd] : dev->linePos;
+	else
+		pos = dev->linePos;
+
+	regs[0x0] = IrqPending( dev );
+	regs[0x1] = (u_int8)(dev->lsr | (((pos / sfs) & 0x3) << RX_LSR_SUB_OFF) |
+		((dev->type == Z147SIM_RX && dev->inSync) ? RX_LSR_INSYNC : 0));
+	regs[0x2] = (u_int8)(dev->fifoCnt & 0xFF);
+	regs[0x3] = (u_int8)(dev->fifoCnt >> 8);
+	regs[0x4] = (u_int8)(dev->ack & 0xFF);
+	regs[0x5] = (u_int8)(dev->ack >> 8);
+	regs[0x6] = (u_int8)((pos % sfs) & 0xFF);
+	regs[0x7] = (u_int8)((pos % sfs) >> 8);
+	regs[0x8] = dev->ier;
+	regs[0x9] = dev->lcr;
+	regs[0xA] = dev->fcr;
+	regs[0xB] = dev->rst;
+
+	for( i=0; i<width; i++ ){
+		if( offs - REG_STAT + i < sizeof(regs) )
+			val |= (u_int32)regs[offs - REG_STAT + i] << (8 * i);
+	}
+	return val;
+}
+
+/******************************* Z147SIM_Write ******************************/
+/** Simulated register/FIFO write
+ *
+ *  \param dev        \IN  device
+ *  \param offs       \IN  byte offset
+ *  \param width      \IN  access width in bytes (1, 2, 4)
+ *  \param val        \IN  value
+ */
+void Z147SIM_Write( Z147SIM_DEV *dev, u_int32 offs, u_int32 width, u_int32 val )
+{
+	u_int32 i, n;
+	u_int8 old;
+
+	dev->stats.mmioWr++;
+
+	if( offs < REG_STAT ){
+		if( dev->type == Z147SIM_TX )
+			dev->window[(offs / 2) % Z147SIM_FIFO_WORDS] = (u_int16)val;
+		return;
+	}
+
+	/* wider accesses touch the following registers */
+	for( i=0; i<width; i++, offs++, val >>= 8 ){
+		switch( offs ){
+		case REG_LSR:
+			/* error bits are write one to clear */
+			dev->lsr &= (u_int8)~val;
+			break;
+		case REG_ACK:
+			n = (width >= 2) ? (val & 0xFFFF) : (val & 0xFF);
+			dev->ack = (u_int16)n;
+			if( dev->type == Z147SIM_RX ){
+				if( n > dev->fifoCnt )
+					n = dev->fifoCnt;
+				dev->fifoRd = (dev->fifoRd + n) % Z147SIM_FIFO_WORDS;
+				dev->fifoCnt -= n;
+			}else{
+				for( i=0; i<n && i<Z147SIM_FIFO_WORDS; i++ ){
+					if( dev->fifoCnt < Z147SIM_FIFO_WORDS ){
+						dev->fifo[(dev->fifoRd + dev->fifoCnt) %
+								  Z147SIM_FIFO_WORDS] = dev->window[i];
+						dev->fifoCnt++;
+					}
+				}
+				if( n )
+					dev->txStarted = 1;
+			}
+			/* RXA/TXA consumed the 16 bit value */
+			dev->irqDirty = 1;
+			return;
+		case REG_IER:
+			dev->ier = (u_int8)val;
+			break;
+		case REG_LCR:
+			old = dev->lcr;
+			dev->lcr = (u_int8)val;
+			if( (old ^ dev->lcr) & 0x3E ){
+				/* new framing: receiver has to synchronize again */
+				dev->linePos = 0;
+				if( dev->type == Z147SIM_RX ){
+					dev->inSync = 0;
+					RxHuntReset( dev );
+				}
+			}
+			break;
+		case REG_FCR:
+			dev->fcr = (u_int8)val;
+			break;
+		case REG_RST:
+			dev->rst = (u_int8)(val & 0x01);
+			if( dev->rst )
+				DevReset( dev );
+			break;
+		default:
+			break;
+		}
+		dev->irqDirty = 1;
+	}
+}
+
+/**********************************************************************/
+/** Core reset: clear FIFO, errors and framing, keep configuration */
+static void DevReset( Z147SIM_DEV *dev )
+{
+	dev->fifoRd    = 0;
+	dev->fifoCnt   = 0;
+	dev->lsr       = 0;
+	dev->linePos   = 0;
+	dev->inSync    = 0;
+	dev->txStarted = 0;
+	dev->lineValid = 0;
+	dev->idleWords = 0;
+	RxHuntReset( dev );
+}
+
+/**********************************************************************/
+/** Restart sync word search of the receiver */
+static void RxHuntReset( Z147SIM_DEV *dev )
+{
+	dev->huntCnt = 0;
+	dev->huntSub = 0;
+	dev->huntIdx = 0;
+}
+
+/**********************************************************************/
+/** Interrupt pending (STAT/IIR value, masked by IER) */
+static u_int8 IrqPending( Z147SIM_DEV *dev )
+{
+	u_int8 stat = 0;
+
+	if( dev->rst )
+		return 0;
+
+	if( dev->type == Z147SIM_RX ){
+		if( (dev->lsr & RX_LSR_ERR) && (dev->ier & 0x01) )
+			stat |= STAT_LS_IRQ;
+		if( dev->fifoCnt >= TrigWords(dev) && (dev->ier & 0x02) )
+			stat |= STAT_DATA_IRQ;
+	}else{
+		if( (dev->lsr & TX_LSR_UE) && (dev->ier & 0x01) )
+			stat |= STAT_LS_IRQ;
+		if( dev->fifoCnt <= TrigWords(dev) && (dev->ier & 0x02) )
+			stat |= STAT_DATA_IRQ;
+	}
+	return stat;
+}
+
+/**********************************************************************/
+/** Receiver: sample the line for one word time */
+static void RxStep( Z147SIM_DEV *dev )
+{
+	Z147SIM_DEV *tx = dev->peer;
+	u_int32 sfs = SubFrameSize(dev);
+	u_int32 frameLen = 4 * sfs;
+	u_int16 word = 0;
+	u_int8 valid;
+
+	if( dev->rst )
+		return;
+
+	if( tx ){
+		valid = tx->lineValid &&
+			LCR_RATE(tx->lcr) == LCR_RATE(dev->lcr) &&
+			LCR_MODE(tx->lcr) == LCR_MODE(dev->lcr);
+		word = tx->lineWord;
+	}else{
+		/* built-in framer: sync words plus generated data */
+		if( (dev->genPos % sfs) == 0 )
+			word = G_syncWord[dev->genPos / sfs];
+		else if( dev->genFunc )
+			word = dev->genFunc( dev->genArg, dev->genFrame, dev->genPos );
+		else
+			word = (u_int16)((dev->genPos - dev->genPos / sfs - 1) & 0xFF);
+		valid = 1;
+		if( ++dev->genPos == frameLen ){
+			dev->genPos = 0;
+			dev->genFrame++;
+		}
+	}
+
+	/* fault injection */
+	if( valid ){
+		if( dev->faults.gapRate > 0.0 && Rand(dev) < dev->faults.gapRate ){
+			dev->stats.faults++;
+			valid = 0;
+		}else if( dev->faults.slipRate > 0.0 &&
+				  Rand(dev) < dev->faults.slipRate ){
+			/* word lost, the next one takes its place */
+			dev->stats.faults++;
+			return;
+		}else{
+			if( dev->faults.bitErrRate > 0.0 &&
+				Rand(dev) < dev->faults.bitErrRate ){
+				dev->stats.faults++;
+				word ^= (u_int16)(1 << (u_int32)(Rand(dev) * 12));
+			}
+			if( dev->faults.syncErrRate > 0.0 && SyncIndex(word) >= 0 &&
+				Rand(dev) < dev->faults.syncErrRate ){
+				dev->stats.faults++;
+				word ^= 0x001;
+			}
+		}
+	}
+
+	if( !valid ){
+		if( dev->inSync && ++dev->idleWords >= SE_IDLE_WORDS ){
+			dev->lsr |= RX_LSR_SE;
+			dev->inSync = 0;
+			dev->stats.syncLosses++;
+			RxHuntReset( dev );
+		}
+		return;
+	}
+	dev->idleWords = 0;
+	word &= 0xFFF;
+	dev->stats.words++;
+	RxLineWord( dev, word );
+}
+
+/**********************************************************************/
+/** Receiver: synchronization and FIFO input of one received word */
+static void RxLineWord( Z147SIM_DEV *dev, u_int16 word )
+{
+	u_int32 sfs = SubFrameSize(dev);
+	u_int32 syncMode = LCR_SYNC(dev->lcr);
+	u_int32 need = (syncMode == 1) ? 2 : 4;
+	int32 k;
+
+	dev->wordIdx++;
+
+	/* check the sync slots while in sync */
+	if( dev->inSync && syncMode != 0 && (dev->linePos % sfs) == 0 &&
+		word != G_syncWord[dev->linePos / sfs] ){
+		dev->lsr |= RX_LSR_LSE;
+		dev->inSync = 0;
+		dev->stats.syncLosses++;
+		RxHuntReset( dev );
+	}
+
+	if( !dev->inSync ){
+		if( syncMode == 0 ){
+			/* no synchronization: start from the first word */
+			dev->inSync  = 1;
+			dev->linePos = 0;
+		}else{
+			if( dev->huntCnt && dev->wordIdx < dev->huntIdx )
+				return;
+			if( dev->huntCnt && dev->wordIdx == dev->huntIdx ){
+				if( word == G_syncWord[dev->huntSub] ){
+					if( ++dev->huntCnt >= need ){
+						dev->inSync  = 1;
+						dev->linePos = dev->huntSub * sfs;
+					}else{
+						dev->huntIdx += sfs;
+						dev->huntSub = (dev->huntSub + 1) & 0x3;
+						return;
+					}
+				}else{
+					RxHuntReset( dev );
+				}
+			}
+			if( !dev->inSync ){
+				if( (k = SyncIndex(word)) >= 0 ){
+					dev->huntCnt = 1;
+					dev->huntSub = (k + 1) & 0x3;
+					dev->huntIdx = dev->wordIdx + sfs;
+				}
+				return;
+			}
+		}
+	}
+
+	/* store in FIFO */
+	if( dev->fifoCnt < Z147SIM_FIFO_WORDS ){
+		k = (dev->fifoRd + dev->fifoCnt) % Z147SIM_FIFO_WORDS;
+		dev->fifo[k]    = word;
+		dev->fifoPos[k] = (u_int16)dev->linePos;
+		dev->fifoCnt++;
+	}else{
+		dev->lsr |= RX_LSR_OE;
+		dev->stats.fifoOverruns++;
+	}
+	dev->linePos = (dev->linePos + 1) % (4 * sfs);
+}
+
+/**********************************************************************/
+/** Transmitter: send one word time */
+static void TxStep( Z147SIM_DEV *dev )
+{
+	u_int32 sfs = SubFrameSize(dev);
+
+	dev->lineValid = 0;
+	if( dev->rst || !dev->txStarted )
+		return;
+
+	if( (dev->linePos % sfs) == 0 ){
+		dev->lineWord  = G_syncWord[dev->linePos / sfs];
+		dev->lineValid = 1;
+	}else if( dev->fifoCnt ){
+		dev->lineWord  = dev->fifo[dev->fifoRd];
+		dev->fifoRd    = (dev->fifoRd + 1) % Z147SIM_FIFO_WORDS;
+		dev->fifoCnt--;
+		dev->lineValid = 1;
+	}else{
+		/* nothing to send, the line stays idle for this word */
+		dev->lsr |= TX_LSR_UE;
+		dev->stats.underruns++;
+	}
+	if( dev->lineValid )
+		dev->stats.words++;
+	dev->linePos = (dev->linePos + 1) % (4 * sfs);
+}
+
+/******************************* RunAlarms **********************************/
+/** Call the alarm routines due at the current tick
+ *
+ *  \param dev        \IN  device
+ */
+static void RunAlarms( Z147SIM_DEV *dev )
+{
+	OSS_ALARM_HANDLE *al, *next;
+	u_int64 t0;
+
+	for( al=dev->alarms; al; al=next ){
+		next = al->next;
+		if( !al->active || al->due > dev->world->tick )
+			continue;
+		if( al->period )
+			al->due += al->period;
+		else
+			al->active = 0;
+		dev->stats.alarms++;
+		if( dev->workFunc ){
+			t0 = NsNow();
+			al->funct( al->arg );
+			dev->workFunc( dev, NsNow() - t0, dev->workArg );
+		}else{
+			al->funct( al->arg );
+		}
+	}
+}
+
+/*-----------------------------------------+
+|  OSS services needing the device         |
++-----------------------------------------*/
+
+/******************************* OSS_SigCreate ******************************/
+/** Create a signal handle
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param signal     \IN  signal number
+ *  \param sigHdlP    \OUT signal handle
+ *  \return           0 on success or error code
+ */
+int32 OSS_SigCreate( OSS_HANDLE *osHdl, int32 signal, OSS_SIG_HANDLE **sigHdlP )
+{
+	if( (*sigHdlP = (OSS_SIG_HANDLE*)calloc(1, sizeof(**sigHdlP))) == NULL )
+		return ERR_OSS_MEM_ALLOC;
+	(*sigHdlP)->sigNum = signal;
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_SigRemove ******************************/
+/** Remove a signal handle
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param sigHdlP    \IN  signal handle, \OUT NULL
+ *  \return           0 on success or error code
+ */
+int32 OSS_SigRemove( OSS_HANDLE *osHdl, OSS_SIG_HANDLE **sigHdlP )
+{
+	free( *sigHdlP );
+	*sigHdlP = NULL;
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_SigSend ********************************/
+/** Send a signal: count it and call the signal hook of the device
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param sigHdl     \IN  signal handle
+ *  \return           0 on success or error code
+ */
+int32 OSS_SigSend( OSS_HANDLE *osHdl, OSS_SIG_HANDLE *sigHdl )
+{
+	Z147SIM_DEV *dev = osHdl->dev;
+
+	dev->stats.sigs++;
+	if( dev->sigFunc )
+		dev->sigFunc( dev, sigHdl->sigNum, dev->sigArg );
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_Delay **********************************/
+/** Delay the caller
+ *
+ *  With a background thread running, the interrupt lock is released and
+ *  the caller sleeps until the simulation time has advanced. Otherwise
+ *  the simulation time is advanced by the caller, so that interrupts keep
+ *  coming while the driver waits.
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param msec       \IN  milliseconds
+ *  \return           milliseconds delayed
+ */
+int32 OSS_Delay( OSS_HANDLE *osHdl, int32 msec )
+{
+	DelayTicks( osHdl->dev->world, Z147SIM_MS2TICKS(msec) );
+	return msec;
+}
+
+/******************************* OSS_MikroDelay *****************************/
+/** Busy wait, like OSS_Delay() in simulation time
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param mikroSec   \IN  microseconds, rounded up to ticks
+ *  \return           0 on success or error code
+ */
+int32 OSS_MikroDelay( OSS_HANDLE *osHdl, u_int32 mikroSec )
+{
+	DelayTicks( osHdl->dev->world,
+				((u_int64)mikroSec * Z147SIM_TICK_HZ + 999999) / 1000000 );
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_IrqMaskR *******************************/
+/** Keep the interrupt routine off, takes the interrupt lock of the world
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param irqHdl     \IN  irq handle (not used)
+ *  \return           state for OSS_IrqRestore()
+ */
+OSS_IRQ_STATE OSS_IrqMaskR( OSS_HANDLE *osHdl, OSS_IRQ_HANDLE *irqHdl )
+{
+	Z147SIM_Lock( osHdl->dev->world );
+	return 0;
+}
+
+/******************************* OSS_IrqRestore *****************************/
+/** Let the interrupt routine run again
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param irqHdl     \IN  irq handle (not used)
+ *  \param oldState   \IN  state of OSS_IrqMaskR()
+ */
+void OSS_IrqRestore( OSS_HANDLE *osHdl, OSS_IRQ_HANDLE *irqHdl,
+					 OSS_IRQ_STATE oldState )
+{
+	Z147SIM_Unlock( osHdl->dev->world );
+}
+
+/******************************* DelayTicks *********************************/
+/** Let the simulation time advance for a delaying driver
+ *
+ *  \param world      \IN  world
+ *  \param ticks      \IN  ticks
+ */
+static void DelayTicks( Z147SIM_WORLD *world, u_int64 ticks )
+{
+	struct timespec ts = { 0, 100000L };
+	u_int64 until = world->tick + ticks;
+	int32 depth;
+
+	if( world->running ){
+		depth = world->lockDepth;
+		while( world->lockDepth > 0 )
+			Z147SIM_Unlock( world );
+		while( world->running && world->tick < until )
+			nanosleep( &ts, NULL );
+		while( depth-- > 0 )
+			Z147SIM_Lock( world );
+	}else{
+		Z147SIM_Run( world, ticks );
+	}
+}
+
+/******************************* OSS_AlarmCreate ****************************/
+/** Create an alarm
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param funct      \IN  alarm routine
+ *  \param arg        \IN  alarm routine argument
+ *  \param alarmP     \OUT alarm handle
+ *  \return           0 on success or error code
+ */
+int32 OSS_AlarmCreate( OSS_HANDLE *osHdl, void (*funct)( void *arg ),
+					   void *arg, OSS_ALARM_HANDLE **alarmP )
+{
+	OSS_ALARM_HANDLE *al;
+
+	if( (al = (OSS_ALARM_HANDLE*)calloc(1, sizeof(*al))) == NULL )
+		return ERR_OSS_MEM_ALLOC;
+	al->dev   = osHdl->dev;
+	al->funct = funct;
+	al->arg   = arg;
+	al->next  = osHdl->dev->alarms;
+	osHdl->dev->alarms = al;
+	*alarmP = al;
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_AlarmRemove ****************************/
+/** Remove an alarm
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param alarmP     \IN  alarm handle, \OUT NULL
+ *  \return           0 on success or error code
+ */
+int32 OSS_AlarmRemove( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE **alarmP )
+{
+	OSS_ALARM_HANDLE **pp;
+
+	for( pp=&osHdl->dev->alarms; *pp; pp=&(*pp)->next ){
+		if( *pp == *alarmP ){
+			*pp = (*alarmP)->next;
+			break;
+		}
+	}
+	free( *alarmP );
+	*alarmP = NULL;
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_AlarmSet *******************************/
+/** Set an alarm
+ *
+ *  The alarm fires in simulation time, at the earliest at the next tick.
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param alarm      \IN  alarm handle
+ *  \param msec       \IN  time to the alarm in milliseconds
+ *  \param cyclic     \IN  0 = once, else every msec
+ *  \param realMsecP  \OUT time used
+ *  \return           0 on success or error code
+ */
+int32 OSS_AlarmSet( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE *alarm,
+					u_int32 msec, u_int32 cyclic, u_int32 *realMsecP )
+{
+	u_int64 ticks = Z147SIM_MS2TICKS(msec);
+
+	if( ticks == 0 )
+		ticks = 1;
+	alarm->due    = osHdl->dev->world->tick + ticks;
+	alarm->period = cyclic ? ticks : 0;
+	alarm->active = 1;
+	if( realMsecP )
+		*realMsecP = msec;
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_AlarmClear *****************************/
+/** Clear an alarm
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param alarm      \IN  alarm handle
+ *  \return           0 on success or error code
+ */
+int32 OSS_AlarmClear( OSS_HANDLE *osHdl, OSS_ALARM_HANDLE *alarm )
+{
+	alarm->active = 0;
+	return ERR_SUCCESS;
+}
@@ -0,0 +1,534 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_sim_mdis.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   MDIS API and user OSS functions of the host simulator
+ *
+ *               Lets the MDIS tools of the Z147 package run on a host
+ *               against simulated cores. M_open() of a device name
+ *               containing "tx" opens a 16Z247, any other name a 16Z147.
+ *               A transmitter is connected to the receiver whose name
+ *               differs only in "tx"/"rx" (e.g. arinc717_tx_1 drives
+ *               arinc717_rx_1). All paths to the same name share the
+ *               device.
+ *
+ *               The simulation runs in a background thread. Its speed
+ *               is taken from the environment variable Z147SIM_SPEED
+ *               (default 1.0 = real time). UOS_Delay() and
+ *               UOS_MsecTimerGet() follow the simulation time, so the
+ *               tools behave the same at any speed.
+ *
+ *               Driver signals are delivered as SIGUSR1/SIGUSR2 to the
+ *               process and passed to the UOS_SigInit() handler. They are
+ *               blocked during M_xxx() calls, as a driver call cannot be
+ *               interrupted by a signal handler on a target either.
+ *
+ *     Required: pthread
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sim_mdis.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <MEN/men_typs.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_err.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_sim.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define MAX_PATHS       64          /**< max. open paths */
+#define NAME_LEN        64          /**< max. device name length */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** open device */
+typedef struct {
+	char            name[NAME_LEN]; /**< device name */
+	Z147SIM_DEV     *dev;           /**< simulated device */
+	int32           type;           /**< Z147SIM_RX/Z147SIM_TX */
+	int32           refCnt;         /**< open paths */
+} SIM_DEVICE;
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static pthread_mutex_t G_lock = PTHREAD_MUTEX_INITIALIZER;
+static Z147SIM_WORLD *G_world;
+static SIM_DEVICE G_device[Z147SIM_MAX_DEV];
+static SIM_DEVICE *G_path[MAX_PATHS];
+static void (*G_sigHandler)(u_int32 sigCode);
+static u_int32 G_sigInstalled;      /**< bit n: UOS signal n installed */
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static void SigHook( Z147SIM_DEV *dev, int32 sigNum, void *arg );
+static void SigDispatch( int sig );
+
+/**********************************************************************/
+/** Block the driver signals for the duration of a driver call */
+static void SigBlock( sigset_t *oldP )
+{
+	sigset_t set;
+
+	sigemptyset( &set );
+	sigaddset( &set, SIGUSR1 );
+	sigaddset( &set, SIGUSR2 );
+	pthread_sigmask( SIG_BLOCK, &set, oldP );
+}
+
+/**********************************************************************/
+/** Restore signal mask after a driver call */
+static void SigRestore( sigset_t *oldP )
+{
+	pthread_sigmask( SIG_SETMASK, oldP, NULL );
+}
+
+/**********************************************************************/
+/** Path to device, NULL and errno set if invalid */
+static SIM_DEVICE* PathDev( MDIS_PATH path )
+{
+	if( path < 0 || path >= MAX_PATHS || G_path[path] == NULL ){
+		errno = ERR_LL_ILL_PARAM;
+		return NULL;
+	}
+	return G_path[path];
+}
+
+/**********************************************************************/
+/** Connect transmitter/receiver pairs whose names match */
+static void ConnectPeers( SIM_DEVICE *sd )
+{
+	char peer[NAME_LEN];
+	char *p;
+	int32 i;
+
+	strcpy( peer, sd->name );
+	if( (p = strstr(peer, sd->type == Z147SIM_TX ? "tx" : "rx")) == NULL )
+		return;
+	p[0] = (sd->type == Z147SIM_TX) ? 'r' : 't';
+
+	for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+		if( G_device[i].dev && strcmp(G_device[i].name, peer) == 0 ){
+			if( sd->type == Z147SIM_TX )
+				Z147SIM_Connect( sd->dev, G_device[i].dev );
+			else
+				Z147SIM_Connect( G_device[i].dev, sd->dev );
+		}
+	}
+}
+
+/********************************* M_open **********************************/
+/** Open a path to a simulated device
+ *
+ *  \param device     \IN  device name
+ *  \return           path or -1 (errno set)
+ */
+MDIS_PATH __MAPILIB M_open( const char *device )
+{
+	SIM_DEVICE *sd = NULL;
+	char *env;
+	int32 i, path, error;
+	sigset_t old;
+
+	SigBlock( &old );
+	pthread_mutex_lock( &G_lock );
+
+	if( G_world == NULL ){
+		if( (G_world = Z147SIM_WorldCreate()) == NULL ){
+			error = ERR_OSS_MEM_ALLOC;
+			goto ERR_EXIT;
+		}
+		env = getenv( "Z147SIM_SPEED" );
+		Z147SIM_SetSpeed( G_world, env ? atof(env) : 1.0 );
+		Z147SIM_Start( G_world );
+	}
+
+	for( path=0; path<MAX_PATHS && G_path[path]; path++ )
+		;
+	if( path == MAX_PATHS ){
+		error = ERR_LL_DEV_BUSY;
+		goto ERR_EXIT;
+	}
+
+	/* device already open? */
+	for( i=0; i<Z147SIM_MAX_DEV; i++ ){
+		if( G_device[i].dev && strcmp(G_device[i].name, device) == 0 )
+			sd = &G_device[i];
+	}
+
+	if( sd == NULL ){
+		for( i=0; i<Z147SIM_MAX_DEV && G_device[i].dev; i++ )
+			;
+		if( i == Z147SIM_MAX_DEV || strlen(device) >= NAME_LEN ){
+			error = ERR_LL_DEV_BUSY;
+			goto ERR_EXIT;
+		}
+		sd = &G_device[i];
+		sd->type = strstr(device, "tx") ? Z147SIM_TX : Z147SIM_RX;
+		if( (error = Z147SIM_DevOpen(G_world, sd->type, NULL, &sd->dev)) )
+			goto ERR_EXIT;
+		strcpy( sd->name, device );
+		Z147SIM_SetSigHook( sd->dev, SigHook, NULL );
+		ConnectPeers( sd );
+	}
+
+	sd->refCnt++;
+	G_path[path] = sd;
+	pthread_mutex_unlock( &G_lock );
+	SigRestore( &old );
+	return path;
+
+ERR_EXIT:
+	pthread_mutex_unlock( &G_lock );
+	SigRestore( &old );
+	errno = error;
+	return -1;
+}
+
+/********************************* M_close *********************************/
+/** Close a path, the device is closed with its last path
+ *
+ *  \param path       \IN  path
+ *  \return           0 or -1 (errno set)
+ */
+int32 __MAPILIB M_close( MDIS_PATH path )
+{
+	SIM_DEVICE *sd;
+	int32 i, error = 0;
+	sigset_t old;
+
+	SigBlock( &old );
+	pthread_mutex_lock( &G_lock );
+
+	if( (sd = PathDev(path)) == NULL ){
+		pthread_mutex_unlock( &G_lock );
+		SigRestore( &old );
+		return -1;
+	}
+
+	if( sd->refCnt == 1 ){
+		if( (error = Z147SIM_DevClose(sd->dev)) == 0 )
+			memset( sd, 0, sizeof(*sd) );
+	}else{
+		sd->refCnt--;
+	}
+	if( error == 0 )
+		G_path[path] = NULL;
+
+	/* last device closed: stop simulation */
+	for( i=0; i<Z147SIM_MAX_DEV && G_device[i].dev == NULL; i++ )
+		;
+	if( i == Z147SIM_MAX_DEV && G_world ){
+		Z147SIM_WorldDestroy( G_world );
+		G_world = NULL;
+	}
+
+	pthread_mutex_unlock( &G_lock );
+	SigRestore( &old );
+
+	if( error ){
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+/********************************* M_getstat *******************************/
+/** Get device status
+ *
+ *  \param path       \IN  path
+ *  \param code       \IN  status code
+ *  \param dataP      \OUT value
+ *  \return           0 or -1 (errno set)
+ */
+int32 __MAPILIB M_getstat( MDIS_PATH path, int32 code, int32 *dataP )
+{
+	SIM_DEVICE *sd;
+	int32 error;
+	sigset_t old;
+
+	if( (sd = PathDev(path)) == NULL )
+		return -1;
+
+	SigBlock( &old );
+	error = Z147SIM_GetStat( sd->dev, code, (INT32_OR_64*)dataP );
+	SigRestore( &old );
+
+	if( error ){
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+/********************************* M_setstat *******************************/
+/** Set device status
+ *
+ *  \param path       \IN  path
+ *  \param code       \IN  status code
+ *  \param data       \IN  value
+ *  \return           0 or -1 (errno set)
+ */
+int32 __MAPILIB M_setstat( MDIS_PATH path, int32 code, INT32_OR_64 data )
+{
+	SIM_DEVICE *sd;
+	int32 error;
+	sigset_t old;
+
+	if( (sd = PathDev(path)) == NULL )
+		return -1;
+
+	SigBlock( &old );
+	error = Z147SIM_SetStat( sd->dev, code, data );
+	SigRestore( &old );
+
+	if( error ){
+		errno = error;
+		return -1;
+	}
+	return 0;
+}
+
+/********************************* M_getblock ******************************/
+/** Read a data block
+ *
+ *  \param path       \IN  path
+ *  \param buffer     \OUT data
+ *  \param length     \IN  buffer size in bytes
+ *  \return           number of bytes read or -1 (errno set)
+ */
+int32 __MAPILIB M_getblock( MDIS_PATH path, u_int8 *buffer, int32 length )
+{
+	SIM_DEVICE *sd;
+	int32 error, nbr = 0;
+	sigset_t old;
+
+	if( (sd = PathDev(path)) == NULL )
+		return -1;
+
+	SigBlock( &old );
+	error = Z147SIM_BlockRead( sd->dev, buffer, length, &nbr );
+	SigRestore( &old );
+
+	if( error ){
+		errno = error;
+		return -1;
+	}
+	return nbr;
+}
+
+/********************************* M_setblock ******************************/
+/** Write a data block
+ *
+ *  \param path       \IN  path
+ *  \param buffer     \IN  data
+ *  \param length     \IN  number of bytes
+ *  \return           number of bytes written or -1 (errno set)
+ */
+int32 __MAPILIB M_setblock( MDIS_PATH path, const u_int8 *buffer, int32 length )
+{
+	SIM_DEVICE *sd;
+	int32 error, nbr = 0;
+	sigset_t old;
+
+	if( (sd = PathDev(path)) == NULL )
+		return -1;
+
+	SigBlock( &old );
+	error = Z147SIM_BlockWrite( sd->dev, (void*)buffer, length, &nbr );
+	SigRestore( &old );
+
+	if( error ){
+		errno = error;
+		return -1;
+	}
+	return nbr;
+}
+
+/********************************* M_errstring *****************************/
+/** Error message of an MDIS error code
+ *
+ *  \param errCode    \IN  error code
+ *  \return           message (static buffer)
+ */
+char* __MAPILIB M_errstring( int32 errCode )
+{
+	static char msg[64];
+	const char *txt;
+
+	switch( errCode ){
+	case ERR_OSS_MEM_ALLOC:     txt = "can't allocate memory";      break;
+	case ERR_OSS_SIG_SET:       txt = "signal already installed";   break;
+	case ERR_OSS_SIG_CLR:       txt = "signal not installed";       break;
+	case ERR_MBUF_ILL_SIZE:     txt = "illegal buffer size";        break;
+	case ERR_MBUF_USERBUF:      txt = "user buffer too small";      break;
+	case ERR_LL_ILL_PARAM:      txt = "illegal parameter";          break;
+	case ERR_LL_ILL_FUNC:       txt = "illegal function";           break;
+	case ERR_LL_UNK_CODE:       txt = "unknown status code";        break;
+	case ERR_LL_DEV_BUSY:       txt = "device busy";                break;
+	case ERR_LL_DEV_NOTRDY:     txt = "device not ready";           break;
+	default:                    txt = "unknown error";              break;
+	}
+	snprintf( msg, sizeof(msg), "ERROR (SIM) 0x%04x: %s", errCode, txt );
+	return msg;
+}
+
+/********************************* UOS_SigInit *****************************/
+/** Install the user signal handler
+ *
+ *  \param sigHandler \IN  handler
+ *  \return           0
+ */
+int32 UOS_SigInit( void (*sigHandler)(u_int32 sigCode) )
+{
+	struct sigaction sa;
+
+	G_sigHandler = sigHandler;
+
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_handler = SigDispatch;
+	sa.sa_flags   = SA_RESTART;
+	sigemptyset( &sa.sa_mask );
+	sigaction( SIGUSR1, &sa, NULL );
+	sigaction( SIGUSR2, &sa, NULL );
+	return 0;
+}
+
+/********************************* UOS_SigExit *****************************/
+/** Remove the user signal handler
+ *
+ *  \return           0
+ */
+int32 UOS_SigExit( void )
+{
+	signal( SIGUSR1, SIG_IGN );
+	signal( SIGUSR2, SIG_IGN );
+	G_sigInstalled = 0;
+	G_sigHandler = NULL;
+	return 0;
+}
+
+/********************************* UOS_SigInstall **************************/
+/** Install a UOS signal
+ *
+ *  \param sigCode    \IN  UOS_SIG_USR1 or UOS_SIG_USR2
+ *  \return           0 or error code
+ */
+int32 UOS_SigInstall( u_int32 sigCode )
+{
+	if( sigCode != UOS_SIG_USR1 && sigCode != UOS_SIG_USR2 )
+		return ERR_LL_ILL_PARAM;
+	G_sigInstalled |= 1 << sigCode;
+	return 0;
+}
+
+/********************************* UOS_SigRemove ***************************/
+/** Remove a UOS signal
+ *
+ *  \param sigCode    \IN  UOS_SIG_USR1 or UOS_SIG_USR2
+ *  \return           0
+ */
+int32 UOS_SigRemove( u_int32 sigCode )
+{
+	G_sigInstalled &= ~(1 << sigCode);
+	return 0;
+}
+
+/********************************* UOS_Delay *******************************/
+/** Delay the caller (simulation time)
+ *
+ *  \param msec       \IN  milliseconds
+ *  \return           0
+ */
+int32 UOS_Delay( u_int32 msec )
+{
+	struct timespec ts = { 0, 1000000L };
+	Z147SIM_WORLD *world = G_world;
+	u_int64 until;
+
+	if( world == NULL ){
+		ts.tv_sec  = msec / 1000;
+		ts.tv_nsec = (msec % 1000) * 1000000L;
+		while( nanosleep(&ts, &ts) != 0 && errno == EINTR )
+			;
+		return 0;
+	}
+
+	until = Z147SIM_Ticks( world ) + Z147SIM_MS2TICKS(msec);
+	while( G_world == world && Z147SIM_Ticks(world) < until )
+		nanosleep( &ts, NULL );
+	return 0;
+}
+
+/********************************* UOS_MsecTimerGet ************************/
+/** Millisecond timer (simulation time while a device is open)
+ *
+ *  \return           milliseconds
+ */
+u_int32 UOS_MsecTimerGet( void )
+{
+	static u_int64 simBase;
+	struct timespec ts;
+
+	if( G_world )
+		return (u_int32)(simBase + Z147SIM_Ticks(G_world) * 1000 /
+						 Z147SIM_TICK_HZ);
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	simBase = (u_int64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	return (u_int32)simBase;
+}
+
+/********************************* UOS_ErrnoGet ****************************/
+/** Error code of the last failed call
+ *
+ *  \return           error code
+ */
+u_int32 UOS_ErrnoGet( void )
+{
+	return (u_int32)errno;
+}
+
+/**********************************************************************/
+/** Driver signal: send SIGUSR1/2 to the process (simulation thread) */
+static void SigHook( Z147SIM_DEV *dev, int32 sigNum, void *arg )
+{
+	if( sigNum == UOS_SIG_USR1 )
+		kill( getpid(), SIGUSR1 );
+	else if( sigNum == UOS_SIG_USR2 )
+		kill( getpid(), SIGUSR2 );
+}
+
+/**********************************************************************/
+/** Process signal handler: call UOS handler */
+static void SigDispatch( int sig )
+{
+	u_int32 code = (sig == SIGUSR1) ? UOS_SIG_USR1 : UOS_SIG_USR2;
+	int savedErrno = errno;
+
+	if( G_sigHandler && (G_sigInstalled & (1 << code)) )
+		G_sigHandler( code );
+	errno = savedErrno;
+}
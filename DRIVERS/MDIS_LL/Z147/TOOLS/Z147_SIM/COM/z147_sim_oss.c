@@ -0,0 +1,242 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_sim_oss.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Host versions of the OSS, DESC and DBG libraries used by
+ *               the Z147/Z247 LL drivers in the simulator
+ *
+ *               Only the functions called by the drivers are provided.
+ *               The services depending on the simulated device (signals,
+ *               delay) are located in z147_sim_core.c.
+ *
+ *     Required: -
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sim_oss.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <MEN/men_typs.h>
+#include <MEN/dbg.h>
+#include <MEN/oss.h>
+#include <MEN/desc.h>
+#include <MEN/mdis_err.h>
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** descriptor handle */
+struct DESC_HANDLE {
+	DESC_SPEC       *spec;          /**< descriptor entries */
+	u_int32         dbgLevel;       /**< debug level (unused) */
+};
+
+/** debug handle */
+struct DBG_HANDLE {
+	int32           dummy;          /**< not used */
+};
+
+/******************************* OSS_Ident **********************************/
+/** Return ident string
+ *
+ *  \return           pointer to ident string
+ */
+char* OSS_Ident( void )
+{
+	return( "OSS - Z147 host simulator" );
+}
+
+/******************************* OSS_MemGet *********************************/
+/** Allocate memory
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param size       \IN  requested size in bytes
+ *  \param gotsizeP   \OUT allocated size
+ *  \return           pointer to memory or NULL
+ */
+void* OSS_MemGet( OSS_HANDLE *osHdl, u_int32 size, u_int32 *gotsizeP )
+{
+	void *mem = malloc( size );
+
+	*gotsizeP = mem ? size : 0;
+	return mem;
+}
+
+/******************************* OSS_MemFree ********************************/
+/** Free memory
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param addr       \IN  memory
+ *  \param size       \IN  size (as returned by OSS_MemGet)
+ *  \return           0
+ */
+int32 OSS_MemFree( OSS_HANDLE *osHdl, void *addr, u_int32 size )
+{
+	free( addr );
+	return ERR_SUCCESS;
+}
+
+/******************************* OSS_MemCopy ********************************/
+/** Copy memory
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param size       \IN  size in bytes
+ *  \param src        \IN  source
+ *  \param dest       \OUT destination
+ */
+void OSS_MemCopy( OSS_HANDLE *osHdl, u_int32 size, char *src, char *dest )
+{
+	memcpy( dest, src, size );
+}
+
+/******************************* OSS_MemFill ********************************/
+/** Fill memory
+ *
+ *  \param osHdl      \IN  OSS handle
+ *  \param size       \IN  size in bytes
+ *  \param adr        \OUT memory
+ *  \param value      \IN  fill value
+ */
+void OSS_MemFill( OSS_HANDLE *osHdl, u_int32 size, char *adr, int8 value )
+{
+	memset( adr, value, size );
+}
+
+/******************************* DESC_Ident *********************************/
+/** Return ident string
+ *
+ *  \return           pointer to ident string
+ */
+char* DESC_Ident( void )
+{
+	return( "DESC - Z147 host simulator" );
+}
+
+/******************************* DESC_Init **********************************/
+/** Initialize descriptor access
+ *
+ *  \param descSpec   \IN  descriptor (array terminated by a NULL key)
+ *  \param osHdl      \IN  OSS handle
+ *  \param descHdlP   \OUT descriptor handle
+ *  \return           0 on success or error code
+ */
+int32 DESC_Init( DESC_SPEC *descSpec, OSS_HANDLE *osHdl, DESC_HANDLE **descHdlP )
+{
+	if( (*descHdlP = (DESC_HANDLE*)calloc(1, sizeof(**descHdlP))) == NULL )
+		return ERR_OSS_MEM_ALLOC;
+	(*descHdlP)->spec = descSpec;
+	return ERR_SUCCESS;
+}
+
+/******************************* DESC_Exit **********************************/
+/** Terminate descriptor access
+ *
+ *  \param descHdlP   \IN  descriptor handle, \OUT NULL
+ *  \return           0
+ */
+int32 DESC_Exit( DESC_HANDLE **descHdlP )
+{
+	free( *descHdlP );
+	*descHdlP = NULL;
+	return ERR_SUCCESS;
+}
+
+/******************************* DESC_GetUInt32 *****************************/
+/** Get a u_int32 descriptor entry
+ *
+ *  \param descHdl    \IN  descriptor handle
+ *  \param defVal     \IN  default value
+ *  \param valueP     \OUT value (defVal if not found)
+ *  \param fmt        \IN  key name (printf format)
+ *  \return           0 on success or ERR_DESC_KEY_NOTFOUND
+ */
+int32 DESC_GetUInt32(
+	DESC_HANDLE *descHdl,
+	u_int32 defVal,
+	u_int32 *valueP,
+	char *fmt,
+	... )
+{
+	char key[64];
+	va_list ap;
+	DESC_SPEC *d;
+
+	va_start( ap, fmt );
+	vsnprintf( key, sizeof(key), fmt, ap );
+	va_end( ap );
+
+	for( d=descHdl->spec; d && d->key; d++ ){
+		if( strcmp(d->key, key) == 0 ){
+			*valueP = d->value;
+			return ERR_SUCCESS;
+		}
+	}
+	*valueP = defVal;
+	return ERR_DESC_KEY_NOTFOUND;
+}
+
+/******************************* DESC_DbgLevelSet ***************************/
+/** Set debug level of the descriptor library
+ *
+ *  \param descHdl    \IN  descriptor handle
+ *  \param dbgLevel   \IN  debug level
+ */
+void DESC_DbgLevelSet( DESC_HANDLE *descHdl, u_int32 dbgLevel )
+{
+	descHdl->dbgLevel = dbgLevel;
+}
+
+/******************************* DBG_Init ***********************************/
+/** Initialize debug output (stderr)
+ *
+ *  \param name       \IN  not used
+ *  \param dbgHdlP    \OUT debug handle
+ *  \return           0
+ */
+int32 DBG_Init( char *name, DBG_HANDLE **dbgHdlP )
+{
+	static DBG_HANDLE dbgHdl;
+
+	*dbgHdlP = &dbgHdl;
+	return ERR_SUCCESS;
+}
+
+/******************************* DBG_Exit ***********************************/
+/** Terminate debug output
+ *
+ *  \param dbgHdlP    \IN  debug handle, \OUT NULL
+ *  \return           0
+ */
+int32 DBG_Exit( DBG_HANDLE **dbgHdlP )
+{
+	*dbgHdlP = NULL;
+	return ERR_SUCCESS;
+}
+
+/******************************* DBG_Write **********************************/
+/** Print debug message to stderr
+ *
+ *  \param dbgHdl     \IN  debug handle
+ *  \param fmt        \IN  printf format
+ *  \return           0
+ */
+int32 DBG_Write( DBG_HANDLE *dbgHdl, char *fmt, ... )
+{
+	va_list ap;
+
+	va_start( ap, fmt );
+	vfprintf( stderr, fmt, ap );
+	va_end( ap );
+	return ERR_SUCCESS;
+}
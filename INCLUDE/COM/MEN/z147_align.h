@@ -0,0 +1,81 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_align.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 offline frame aligner library
+ *
+ *               Finds the data rate and the frame alignment of a stream
+ *               of 12 bit words without frame position, e.g. a dump of a
+ *               receiver in raw mode (#Z147_RX_SYNC_CFG 0). Bits 12..15
+ *               of the words are ignored.
+ *
+ *               Z147AL_Find() searches the next sync word
+ *               (Z147_ARINC717_SUB_x_SYNC) with the fastest kernel the
+ *               CPU supports (AVX2, SSE2 on x86, else scalar code).
+ *               Z147AL_Detect() checks every sync word found for
+ *               #Z147AL_CONFIRM sync words in order at the subframe
+ *               distance of each data rate, the first match gives rate
+ *               and alignment.
+ *
+ *    \switches  Z147AL_NO_SIMD  scalar code only
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_align.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_ALIGN_H
+#define _Z147_ALIGN_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+/** \name kernels */
+/**@{*/
+#define Z147AL_AUTO             -1          /**< best supported kernel */
+#define Z147AL_SCALAR           0           /**< portable C */
+#define Z147AL_SSE2             1           /**< x86 SSE2 */
+#define Z147AL_AVX2             2           /**< x86 AVX2 */
+#define Z147AL_NUM              3           /**< number of kernels */
+/**@}*/
+
+#define Z147AL_ANY_RATE         -1          /**< detect the data rate */
+#define Z147AL_CONFIRM          8           /**< sync words in order (two
+												 frames) to detect */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** alignment found by Z147AL_Detect() */
+typedef struct {
+	int32   rate;               /**< Z147_RX_DATA_RATE_xx */
+	u_int32 frameWords;         /**< words per frame incl. sync words */
+	u_int64 start;              /**< word index of the first frame
+									 (subframe 1 sync word) */
+} Z147AL_ALIGN;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern u_int64 Z147AL_Find( const u_int16 *w, u_int64 num );
+extern int32 Z147AL_Detect( const u_int16 *w, u_int64 num, int32 rate,
+							Z147AL_ALIGN *al );
+extern u_int32 Z147AL_SyncOk( const u_int16 *frame, int32 rate );
+extern int32 Z147AL_Select( int32 kernel );
+extern int32 Z147AL_Supported( int32 kernel );
+extern const char* Z147AL_Name( int32 kernel );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_ALIGN_H */
@@ -0,0 +1,99 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_cmp.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 frame compression codec
+ *
+ *               Most word slots of an ARINC 717 frame change slowly, so
+ *               each word is XORed with the same slot of the previous
+ *               frame and the result is run length coded:
+ *
+ *               control byte   meaning
+ *               ------------   ---------------------------------------------
+ *               0x00..0x7f     n+1 unchanged words (n = low 7 bits)
+ *               0x80..0xbf     n+1 changed words (n = low 6 bits), XOR
+ *                              values packed 12 bit: 2 words in 3 bytes,
+ *                              an odd last word in 2 bytes
+ *               0xc0..0xff     n+1 changed words (n = low 6 bits), XOR
+ *                              values 16 bit little endian (words with
+ *                              more than 12 bits set, e.g. error flags)
+ *
+ *               Every frame starts with a Z147CMP_FRAME_HDR_SIZE byte
+ *               header. Every blockFrames-th frame is a key frame, coded
+ *               against an all-zero frame. Decoding may start at any key
+ *               frame, which are the restart points for random access;
+ *               the application keeps their offsets.
+ *
+ *               Coding is lossless for all 16 bits of a word.
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_cmp.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_CMP_H
+#define _Z147_CMP_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147CMP_MAGIC           0x5A43      /**< frame header magic */
+#define Z147CMP_FRAME_HDR_SIZE  8           /**< frame header bytes */
+#define Z147CMP_BLOCK_FRAMES    64          /**< default key frame distance */
+
+/** \name frame header flags */
+/**@{*/
+#define Z147CMP_FL_KEY          0x0001      /**< key frame (restart point) */
+/**@}*/
+
+/** max. coded size of a frame of the given words */
+#define Z147CMP_MAX_SIZE(words) \
+	(Z147CMP_FRAME_HDR_SIZE + 2 * (words) + ((words) + 63) / 64)
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/**
+ * Codec state of one channel (encoder or decoder)
+ *
+ * Frame header in the stream (little endian):
+ * u_int16 magic, u_int16 flags, u_int32 bytes after the header
+ */
+typedef struct {
+	u_int32 frameWords;         /**< words per frame */
+	u_int32 blockFrames;        /**< frames per key frame */
+	u_int32 frames;             /**< frames coded since init */
+	int32   valid;              /**< decoder: ref holds the last frame */
+	u_int16 *ref;               /**< previous frame */
+} Z147CMP_CTX;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern int32 Z147CMP_Init( Z147CMP_CTX *ctx, u_int32 frameWords,
+						   u_int32 blockFrames );
+extern void  Z147CMP_Exit( Z147CMP_CTX *ctx );
+extern void  Z147CMP_Reset( Z147CMP_CTX *ctx );
+extern int32 Z147CMP_Encode( Z147CMP_CTX *ctx, const u_int16 *frame,
+							 u_int8 *out, u_int32 outSize );
+extern int32 Z147CMP_Decode( Z147CMP_CTX *ctx, const u_int8 *in,
+							 u_int32 inSize, u_int16 *frame );
+extern int32 Z147CMP_FrameSize( const u_int8 *in, u_int32 inSize,
+								int32 *keyP );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_CMP_H */
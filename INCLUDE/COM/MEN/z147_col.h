@@ -0,0 +1,207 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_col.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 parameter column store
+ *
+ *               A column file holds the time series of one parameter,
+ *               decoded from Z147 frames, in pages of up to pageSamples
+ *               samples:
+ *
+ *               \code
+ *               +---------------------------+  0
+ *               | Z147COL_HDR               |
+ *               +---------------------------+  Z147COL_HDR_SIZE
+ *               | page 0: times, values     |
+ *               | page 1                    |
+ *               | ...                       |
+ *               +---------------------------+  hdr.zoneOff
+ *               | Z147COL_ZONE[hdr.pages]   |  zone map
+ *               +---------------------------+  hdr.sumOff
+ *               | Z147COL_SUM[sumNum[0]]    |  per second summaries
+ *               | Z147COL_SUM[sumNum[1]]    |  per minute summaries
+ *               | Z147COL_SUM[sumNum[2]]    |  per hour summaries
+ *               +---------------------------+
+ *               \endcode
+ *
+ *               A page stores its times followed by its values. Plain
+ *               pages hold int64 times and double values. Compressed pages
+ *               (Z147COL_FL_COMPRESS) start with the u_int32 size of the
+ *               times, coded as delta of delta, followed by the values
+ *               XORed with the previous value, both run length coded:
+ *
+ *               control byte   times                values
+ *               ------------   ------------------   ---------------------
+ *               0x00..0x7f     n+1 deltas equal     n+1 values unchanged
+ *                              to the last one
+ *               0x80           zigzag LEB128 delta  -
+ *                              of delta follows
+ *               0x80..0xbf     -                    changed value, XOR
+ *                                                   without lz leading and
+ *                                                   tz trailing zero bytes
+ *                                                   (0x80 | lz << 3 | tz)
+ *
+ *               Slowly changing parameters at a fixed rate shrink to a few
+ *               bytes per page.
+ *
+ *               The zone map holds time range, value range, offset and
+ *               size of every page. A query reads the zone map, skips the
+ *               pages outside the time and value range and touches only
+ *               the pages it needs of the mapped file.
+ *
+ *               The summaries form a pyramid of count, min, max and sum
+ *               per second, minute and hour (UTC aligned, empty intervals
+ *               left out), built while the file is written. An aggregate
+ *               of a time window takes the whole hours, minutes and
+ *               seconds of the window from the coarsest level they fit
+ *               in and decodes only the pages of the partial seconds at
+ *               both edges, so its cost does not grow with the recording.
+ *               Levels of less than 8 samples per interval on average are
+ *               not written (sumNum 0), then the partial intervals of the
+ *               finest level written are decoded.
+ *               Files without summaries (hdr.sumOff 0) are aggregated from
+ *               their pages.
+ *
+ *               The writer appends samples in time order and keeps one
+ *               page and the zone map in memory. The header is written
+ *               when the file is finished, a file without it (writer
+ *               killed) is not readable.
+ *
+ *               All fields are stored in the byte order of the host.
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_col.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_COL_H
+#define _Z147_COL_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147COL_MAGIC           "Z147COL"   /**< file header magic */
+#define Z147COL_VERSION         1           /**< format version */
+#define Z147COL_HDR_SIZE        512         /**< file header size */
+#define Z147COL_NAME_LEN        32          /**< parameter name length */
+#define Z147COL_PAGE_SAMPLES    4096        /**< default samples per page */
+#define Z147COL_EXT             ".z147c"    /**< file name extension */
+
+/** \name header flags */
+/**@{*/
+#define Z147COL_FL_COMPRESS     0x0001      /**< compressed pages */
+/**@}*/
+
+/** summary levels, level l covers Z147COL_SUM_NS(l) */
+#define Z147COL_SUM_LEVELS      3
+#define Z147COL_SUM_NS(l)       ((l) == 0 ? 1000000000LL :  \
+								 (l) == 1 ? 60000000000LL : 3600000000000LL)
+
+/** max. bytes of a page of n samples (compressed or not) */
+#define Z147COL_MAX_PAGE(n)     (20 * (n) + 16)
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** file header (padded to Z147COL_HDR_SIZE in the file) */
+typedef struct {
+	char    magic[8];           /**< Z147COL_MAGIC */
+	u_int32 version;            /**< Z147COL_VERSION */
+	u_int32 flags;              /**< Z147COL_FL_xx */
+	char    name[Z147COL_NAME_LEN]; /**< parameter name */
+	u_int32 pageSamples;        /**< max. samples per page */
+	u_int32 pages;              /**< pages */
+	u_int64 samples;            /**< samples */
+	u_int64 zoneOff;            /**< file offset of the zone map */
+	u_int64 rawBytes;           /**< page bytes without compression */
+	int64   firstNs;            /**< time of the first sample */
+	int64   lastNs;             /**< time of the last sample */
+	double  min;                /**< smallest value */
+	double  max;                /**< largest value */
+	u_int64 sumOff;             /**< file offset of the summaries or 0 */
+	u_int32 sumNum[Z147COL_SUM_LEVELS]; /**< summaries per level */
+	u_int32 resv;               /**< reserved (0) */
+} Z147COL_HDR;
+
+/** zone map entry of a page (48 bytes) */
+typedef struct {
+	int64   firstNs;            /**< time of the first sample */
+	int64   lastNs;             /**< time of the last sample */
+	double  min;                /**< smallest value */
+	double  max;                /**< largest value */
+	u_int64 off;                /**< file offset */
+	u_int32 size;               /**< bytes */
+	u_int32 num;                /**< samples */
+} Z147COL_ZONE;
+
+/** summary of an interval (40 bytes) */
+typedef struct {
+	int64   startNs;            /**< interval start */
+	double  min;                /**< smallest value */
+	double  max;                /**< largest value */
+	double  sum;                /**< sum of the values */
+	u_int32 num;                /**< samples */
+	u_int32 resv;               /**< reserved (0) */
+} Z147COL_SUM;
+
+/** aggregate of a time window */
+typedef struct {
+	u_int64 num;                /**< samples */
+	double  min;                /**< smallest value */
+	double  max;                /**< largest value */
+	double  sum;                /**< sum, mean = sum / num */
+} Z147COL_AGG;
+
+/** open column file (read only for the application) */
+typedef struct {
+	const u_int8        *base;      /**< mapped file */
+	size_t              size;       /**< file size */
+	const Z147COL_HDR   *hdr;       /**< file header */
+	const Z147COL_ZONE  *zone;      /**< zone map */
+	const Z147COL_SUM   *sum[Z147COL_SUM_LEVELS]; /**< summaries or NULL */
+	u_int32             pagesRead;  /**< pages decoded so far */
+	u_int32             sumsRead;   /**< summaries used so far */
+} Z147COL_FILE;
+
+/** column writer */
+typedef struct Z147COL_WRITER Z147COL_WRITER;
+
+/** sample of a query, return != 0 stops it */
+typedef int32 (*Z147COL_VISIT)( void *arg, int64 tsNs, double value );
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern Z147COL_WRITER* Z147COL_Create( const char *name, const char *param,
+									   u_int32 pageSamples, u_int32 flags );
+extern int32 Z147COL_Append( Z147COL_WRITER *wr, const int64 *ts,
+							 const double *val, u_int32 num );
+extern int32 Z147COL_Finish( Z147COL_WRITER *wr );
+
+extern Z147COL_FILE* Z147COL_Open( const char *name );
+extern void  Z147COL_Close( Z147COL_FILE *col );
+extern u_int32 Z147COL_Seek( const Z147COL_FILE *col, int64 tsNs );
+extern int32 Z147COL_Page( Z147COL_FILE *col, u_int32 page, int64 *ts,
+						   double *val );
+extern int64 Z147COL_Query( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+							double min, double max, Z147COL_VISIT visit,
+							void *arg );
+extern int32 Z147COL_Aggregate( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+								Z147COL_AGG *agg );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_COL_H */
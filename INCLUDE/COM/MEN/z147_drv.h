@@ -32,7 +32,54 @@
 /*-----------------------------------------+
 |  TYPEDEFS                                |
 +-----------------------------------------*/
-
+/** changes of a frame (Z147_BLK_RX_CHANGES) */
+typedef struct {
+	u_int32 frameCnt;       /**< Z147_RX_FRAME_CNT of the frame */
+	u_int32 changeCnt;      /**< Z147_RX_CHANGE_CNT of the frame */
+	u_int32 subMask;        /**< changed subframes, bit 0 = subframe 1 */
+	u_int32 slotMask[2];    /**< changed slots, bit k of the 64 bits =
+							     words k*sfs/16..(k+1)*sfs/16-1 */
+} Z147_CHANGES;
+
+/** watch of a word (Z147_BLK_RX_WATCH) */
+typedef struct {
+	u_int16 pos;            /**< word in the frame, (subframe-1)*sfs + word */
+	u_int16 type;           /**< Z147_WATCH_xx */
+	u_int16 mask;           /**< bits of the word watched */
+	u_int16 lo;             /**< EQUAL: value, RANGE: lower limit,
+							     RATE: max. change per frame */
+	u_int16 hi;             /**< RANGE: upper limit */
+	u_int16 resv;           /**< reserved (0) */
+} Z147_WATCH;
+
+/** trigger event (Z147_BLK_RX_TRIG) */
+typedef struct {
+	u_int32 frameCnt;       /**< Z147_RX_FRAME_CNT when the word arrived */
+	u_int16 watch;          /**< index in the watch list */
+	u_int16 pos;            /**< word in the frame */
+	u_int16 value;          /**< masked value */
+	u_int16 prev;           /**< masked value of the previous frame */
+} Z147_TRIG_EVENT;
+
+/** capture configuration (Z147_BLK_RX_CAPTURE setstat) */
+typedef struct {
+	u_int32 frames;         /**< frames per history region, 0 disables */
+	u_int32 pre;            /**< frames kept before the trigger frame */
+	u_int32 post;           /**< frames kept after the trigger frame */
+	u_int32 trigMask;       /**< Z147_CAPT_xx sources */
+} Z147_CAPTURE;
+
+/** frozen capture (Z147_BLK_RX_CAPTURE getstat), the frames follow */
+typedef struct {
+	u_int32 capture;        /**< number of the capture, from 1 */
+	u_int32 source;         /**< Z147_CAPT_xx that fired */
+	u_int32 trigFrame;      /**< Z147_RX_FRAME_CNT of the trigger frame */
+	u_int32 firstFrame;     /**< Z147_RX_FRAME_CNT of the first frame */
+	u_int32 frames;         /**< frames, up to pre + 1 + post */
+	u_int32 frameWords;     /**< words per frame */
+	u_int32 lost;           /**< triggers lost before this capture */
+	u_int32 resv;           /**< reserved (0) */
+} Z147_CAPT_HDR;
 
 /*-----------------------------------------+
 |  DEFINES                                 |
@@ -55,6 +102,27 @@
 #define Z147_CLR_ERR_SIGNAL		 M_DEV_OF+0x0C	  /**<   S: Clear RX error signal. */
 #define Z147_RX_SYNC_CFG		 M_DEV_OF+0x0D	  /**< G,S: Configure synchronization mode. */
 #define Z147_RX_MODE_CFG		 M_DEV_OF+0x0E	  /**< G,S: Configure Receive mode. */
+#define Z147_RX_FRAME_CNT		 M_DEV_OF+0x0F	  /**< G  : Get received frame count. */
+#define Z147_RX_PACKED			 M_DEV_OF+0x10	  /**< G,S: Get/Set packed 12 bit frame format of M_getblock(). */
+#define Z147_RX_CHANGE_ONLY		 M_DEV_OF+0x11	  /**< G,S: Get/Set signal only frames with changed words. */
+#define Z147_RX_CHANGE_CNT		 M_DEV_OF+0x12	  /**< G  : Get changed frame count. */
+#define Z147_SET_TRIG_SIGNAL	 M_DEV_OF+0x13	  /**<   S: Set watch trigger signal. */
+#define Z147_CLR_TRIG_SIGNAL	 M_DEV_OF+0x14	  /**<   S: Clear watch trigger signal. */
+#define Z147_RX_TRIG_CNT		 M_DEV_OF+0x15	  /**< G  : Get trigger event count. */
+#define Z147_RX_CAPT_TRIG		 M_DEV_OF+0x16	  /**<   S: Trigger a capture (Z147_CAPT_USER). */
+#define Z147_RX_CAPT_SIZE		 M_DEV_OF+0x17	  /**< G  : Get bytes of the frozen capture, 0 if none. */
+#define Z147_RX_DEFERRED		 M_DEV_OF+0x18	  /**< G,S: Drain the FIFO deferred, not in the ISR (0/1). */
+#define Z147_RX_SLIP_CNT		 M_DEV_OF+0x19	  /**< G  : Get realignments of the raw mode frame synchronizer. */
+#define Z147_RX_RATE_DETECT		 M_DEV_OF+0x1A	  /**< G,S: Get/Set automatic data rate detection (Z147_DETECT_xx). */
+#define Z147_RX_DETECT_MS		 M_DEV_OF+0x1B	  /**< G  : Get duration of the last rate detection in ms, 0 = none or running. */
+/**@}*/
+
+/** \name Z147 specific Getstat/Setstat block codes */
+/**@{*/
+#define Z147_BLK_RX_CHANGES		 M_DEV_BLK_OF+0x00 /**< G  : Get Z147_CHANGES of the last changed frame. */
+#define Z147_BLK_RX_WATCH		 M_DEV_BLK_OF+0x01 /**<   S: Set watch list, Z147_WATCH[], size 0 clears it. */
+#define Z147_BLK_RX_TRIG		 M_DEV_BLK_OF+0x02 /**< G  : Get and remove queued Z147_TRIG_EVENT[]. */
+#define Z147_BLK_RX_CAPTURE		 M_DEV_BLK_OF+0x03 /**< G,S: Get and release the frozen capture / set Z147_CAPTURE. */
 /**@}*/
 
 /* Z147_RX_DATA_RATE Get/Setstat specific defines */ 
@@ -67,6 +135,32 @@
 #define Z147_RX_DATA_RATE_4096      6    /**< Set data rate of 4096 words/sec. */
 #define Z147_RX_DATA_RATE_8192      7    /**< Set data rate of 8192 words/sec. */
 
+/* Z147_RX_PACKED frame format: 2 words in 3 bytes, w0 bits 0..7 / w0 bits
+   8..11 + w1 bits 0..3 / w1 bits 4..11, an odd last word in 2 bytes */
+#define Z147_PACKED_SIZE(words)     (((words) * 3 + 1) / 2)  /**< bytes of packed words */
+
+/* Z147_RX_CHANGE_ONLY slots, 16 per subframe */
+#define Z147_CHG_SLOTS              64   /**< change slots per frame */
+
+/* Z147_BLK_RX_WATCH types, the events fire on the transition only */
+#define Z147_WATCH_EQUAL            0    /**< masked word becomes lo */
+#define Z147_WATCH_CHANGE           1    /**< masked word changes */
+#define Z147_WATCH_RANGE            2    /**< masked word leaves lo..hi */
+#define Z147_WATCH_RATE             3    /**< masked word changes by more than lo */
+#define Z147_WATCH_MAX              16   /**< max. watches */
+#define Z147_TRIG_QUEUE             64   /**< queued trigger events */
+
+/* Z147_CAPTURE trigger sources */
+#define Z147_CAPT_SYNC              0x01 /**< lost synchronization */
+#define Z147_CAPT_ERR               0x02 /**< overrun or stream interruption */
+#define Z147_CAPT_WATCH             0x04 /**< watch event (Z147_BLK_RX_WATCH) */
+#define Z147_CAPT_USER              0x08 /**< Z147_RX_CAPT_TRIG */
+
+/* Z147_RX_RATE_DETECT modes */
+#define Z147_DETECT_OFF             0    /**< rate set by Z147_RX_DATA_RATE */
+#define Z147_DETECT_ONCE            1    /**< detect the rate, then off */
+#define Z147_DETECT_FOLLOW          2    /**< detect again when the sync is lost */
+
 /* SYNC words */
 #define Z147_ARINC717_SUB_1_SYNC      0x247
 #define Z147_ARINC717_SUB_2_SYNC      0x5B8
@@ -0,0 +1,191 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_frm.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the indexed Z147 frame file and its
+ *               reader/writer library
+ *
+ *               A frame file holds the frames of one receive channel at
+ *               one data rate. All frames have the same size, so frame n
+ *               is found at a fixed offset:
+ *
+ *               \code
+ *               +---------------------------+  0
+ *               | Z147FRM_HDR               |
+ *               +---------------------------+  hdr.hdrSize
+ *               | Z147FRM_FRAME + words     |  frame 0
+ *               | Z147FRM_FRAME + words     |  frame 1   (hdr.recSize each)
+ *               | ...                       |
+ *               +---------------------------+  trl.tIdxOff
+ *               | Z147FRM_TIDX[tIdxNum]     |  every tIdxStep-th frame
+ *               +---------------------------+  trl.sfIdxOff
+ *               | Z147FRM_SFIDX[sfIdxNum]   |  every superframe start
+ *               +---------------------------+  size - sizeof(trl)
+ *               | Z147FRM_TRAILER           |
+ *               +---------------------------+
+ *               \endcode
+ *
+ *               The frame words are stored as read by M_getblock(), incl.
+ *               the sync words. The index footer is written when the file
+ *               is finished. A file without footer (writer killed) is
+ *               still readable, the reader then searches the frames
+ *               themselves.
+ *
+ *               Seeking by time is a binary search over the sparse time
+ *               index followed by a binary search over at most tIdxStep
+ *               frames, seeking by superframe is a lookup in the
+ *               superframe index. Only the touched pages of the mapped
+ *               file are read.
+ *
+ *               All fields are stored in the byte order of the recording
+ *               host (little endian on x86 and ARM).
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_frm.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_FRM_H
+#define _Z147_FRM_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147FRM_MAGIC           "Z147FRM"   /**< file header magic */
+#define Z147FRM_IDX_MAGIC       "Z147IDX"   /**< trailer magic */
+#define Z147FRM_VERSION         1           /**< format version */
+#define Z147FRM_HDR_SIZE        4096        /**< file header size */
+#define Z147FRM_NAME_LEN        32          /**< device name length */
+#define Z147FRM_TIDX_STEP       64          /**< default time index step */
+#define Z147FRM_SF_FRAMES       16          /**< frames per superframe */
+#define Z147FRM_UNKNOWN         0xFFFFFFFF  /**< configuration not known */
+
+/** \name frame status flags */
+/**@{*/
+#define Z147FRM_ST_INSYNC       0x0001      /**< receiver in sync */
+#define Z147FRM_ST_TORN         0x0002      /**< frame changed during read */
+#define Z147FRM_ST_LOST         0x0004      /**< frames lost before this one */
+#define Z147FRM_ST_SHORT        0x0008      /**< incomplete, rest is 0 */
+#define Z147FRM_ST_ERR          0x0010      /**< receive error signalled */
+/**@}*/
+
+/** frame words of a data rate (Z147_RX_DATA_RATE_xx) */
+#define Z147FRM_FRAME_WORDS(rate)   (4 * (64u << (rate)))
+
+/** record size of a data rate */
+#define Z147FRM_REC_SIZE(rate) \
+	((u_int32)sizeof(Z147FRM_FRAME) + 2 * Z147FRM_FRAME_WORDS(rate))
+
+/** frame words behind a frame header */
+#define Z147FRM_DATA(frm)       ((const u_int16*)((frm) + 1))
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** file header (padded to Z147FRM_HDR_SIZE in the file) */
+typedef struct {
+	char    magic[8];           /**< Z147FRM_MAGIC */
+	u_int32 version;            /**< Z147FRM_VERSION */
+	u_int32 hdrSize;            /**< bytes before the first frame */
+	u_int32 recSize;            /**< bytes per frame incl. Z147FRM_FRAME */
+	u_int32 frameWords;         /**< words per frame incl. sync words */
+	u_int32 rate;               /**< Z147_RX_DATA_RATE_xx */
+	u_int32 syncCfg;            /**< Z147_RX_SYNC_CFG or Z147FRM_UNKNOWN */
+	u_int32 modeCfg;            /**< Z147_RX_MODE_CFG or Z147FRM_UNKNOWN */
+	u_int32 sfSub;              /**< superframe counter subframe 1..4,
+									 0 = superframes of 16 frame numbers
+									 (seq) */
+	u_int32 sfWord;             /**< superframe counter word in subframe,
+									 1 = first word after the sync word */
+	u_int32 sfMask;             /**< superframe counter bits of the word */
+	int64   createdNs;          /**< creation time (UTC, ns since 1970) */
+	char    name[Z147FRM_NAME_LEN]; /**< device name */
+} Z147FRM_HDR;
+
+/** frame header (16 bytes), followed by hdr.frameWords words */
+typedef struct {
+	int64   tsNs;               /**< receive time (UTC, ns since 1970) */
+	u_int32 seq;                /**< frame number, gaps = lost frames */
+	u_int16 status;             /**< Z147FRM_ST_xx */
+	u_int16 lost;               /**< frames lost before (max. 0xffff) */
+} Z147FRM_FRAME;
+
+/** time index entry */
+typedef struct {
+	int64   tsNs;               /**< time of the frame (non decreasing) */
+	u_int32 frame;              /**< frame index */
+	u_int32 reserved;           /**< 0 */
+} Z147FRM_TIDX;
+
+/** superframe index entry */
+typedef struct {
+	u_int32 frame;              /**< index of the first frame */
+	u_int32 counter;            /**< superframe counter of this frame */
+} Z147FRM_SFIDX;
+
+/** trailer (last 64 bytes of a finished file) */
+typedef struct {
+	char    magic[8];           /**< Z147FRM_IDX_MAGIC */
+	u_int32 frames;             /**< number of frames */
+	u_int32 tIdxStep;           /**< frames per time index entry */
+	int64   tIdxOff;            /**< file offset of the time index */
+	int64   sfIdxOff;           /**< file offset of the superframe index */
+	u_int32 tIdxNum;            /**< time index entries */
+	u_int32 sfIdxNum;           /**< superframe index entries */
+	int64   firstNs;            /**< time of the first frame */
+	int64   lastNs;             /**< time of the last frame */
+	u_int32 sfErrNum;           /**< superframe counter errors (repeated
+									 counter, not a wrap) */
+	u_int32 reserved;           /**< 0 */
+} Z147FRM_TRAILER;
+
+/** open frame file (read only for the application) */
+typedef struct {
+	const u_int8        *base;      /**< mapped file */
+	size_t              size;       /**< file size */
+	const Z147FRM_HDR   *hdr;       /**< file header */
+	u_int32             frames;     /**< number of frames */
+	const Z147FRM_TIDX  *tIdx;      /**< time index, NULL if no footer */
+	u_int32             tIdxNum;    /**< time index entries */
+	const Z147FRM_SFIDX *sfIdx;     /**< superframe index, NULL if none */
+	u_int32             sfIdxNum;   /**< superframe index entries */
+	u_int32             sfErrNum;   /**< superframe counter errors */
+} Z147FRM_FILE;
+
+/** frame file writer */
+typedef struct Z147FRM_WRITER Z147FRM_WRITER;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern Z147FRM_WRITER* Z147FRM_Create( const char *name,
+									   const Z147FRM_HDR *hdr,
+									   u_int32 tIdxStep );
+extern int32 Z147FRM_Append( Z147FRM_WRITER *wr, const Z147FRM_FRAME *frm,
+							 const u_int16 *data, u_int32 words );
+extern int32 Z147FRM_Finish( Z147FRM_WRITER *wr );
+
+extern Z147FRM_FILE* Z147FRM_Open( const char *name );
+extern void  Z147FRM_Close( Z147FRM_FILE *fp );
+extern const Z147FRM_FRAME* Z147FRM_Frame( const Z147FRM_FILE *fp,
+										   u_int32 idx );
+extern u_int32 Z147FRM_SeekTime( const Z147FRM_FILE *fp, int64 tsNs );
+extern int32 Z147FRM_SeekSuperframe( const Z147FRM_FILE *fp, u_int32 sf );
+extern int32 Z147FRM_Superframe( const Z147FRM_FILE *fp, u_int32 idx );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_FRM_H */
@@ -0,0 +1,215 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_map.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 frame map (parameter decoding)
+ *
+ *               A frame map describes the parameters of an ARINC 717
+ *               frame layout, one line per parameter:
+ *
+ *               \code
+ *               # comment
+ *               rate        1024             # words/s
+ *               superframe  1 1 0x00f        # counter: sub, word, mask
+ *
+ *               # name      sub word  bits  enc   [res=] [ofs=] [sf=]
+ *               ALTITUDE    1   10    12-1  BNR   res=4
+ *               ALT_FINE    1   11-12 12-1  BNR   res=0.0625
+ *               TAT         0   20    12-3  BNR   res=0.25 ofs=-40
+ *               FLAPS       2   3     3-1   DIS
+ *               DATE        4   40    12-1  BCD   sf=5
+ *               FUEL_USED   3   30-31 12-1  PACK  res=2
+ *               \endcode
+ *
+ *               sub    subframe 1..4, 0 or * = in every subframe (4
+ *                      values per frame)
+ *               word   word in the subframe, 0 = sync word (as
+ *                      Z147FRM_HDR.sfWord), a range (n-m) concatenates
+ *                      up to 4 adjacent words, the first one is the most
+ *                      significant
+ *               bits   ARINC bit range msb-lsb of every word (12..1)
+ *               enc    BNR  two's complement, value = raw * res + ofs
+ *                      BCD  4 bit digits, value = digits * res + ofs
+ *                      DIS  discrete bits, value = raw
+ *                      PACK unsigned binary, value = raw * res + ofs
+ *               sf     frame of the superframe 0..15 the parameter is
+ *                      sent in (default: every frame)
+ *
+ *               Z147MAP_Compile() turns a map into a decoding plan: one
+ *               instruction per parameter and subframe, grouped by
+ *               encoding and sorted by word offset within a group, so the
+ *               decoder walks the frame once per group in address order.
+ *               Z147MAP_Decode() applies the plan to a frame as read by
+ *               M_getblock() (4 * subframe size words incl. sync words).
+ *               Its cost depends on the number of parameters only.
+ *
+ *               Layouts known at compile time can use Z147MAP_Build()
+ *               with a static Z147MAP_PARAM table instead of a text.
+ *
+ *               Every word has only 4096 values, so Z147MAP_LutBuild()
+ *               can precompute the values of single word parameters in
+ *               tables of 4096 entries (32 KB). Parameters with the same
+ *               bits, encoding and scaling share a table, maxTables
+ *               bounds the memory. The decoder then needs one load per
+ *               value. Z147MAP_LutWrite() writes the parameters and tables
+ *               of a plan as C source, a program with a static layout
+ *               passes the compiled tables to Z147MAP_LutBuild() and
+ *               does not compute them at run time.
+ *
+ *               For bulk conversion, Z147MAP_Column() collects one word
+ *               slot of many frames into a column and Z147MAP_Convert()
+ *               converts the columns of an instruction (one per adjacent
+ *               word) with the same results as Z147MAP_Decode(). On x86
+ *               the fastest kernel the CPU supports (AVX2, SSE2) is
+ *               selected at the first call.
+ *
+ *    \switches  Z147MAP_NO_SIMD  scalar column conversion only
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_map.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_MAP_H
+#define _Z147_MAP_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147MAP_NAME_LEN        32          /**< parameter name length */
+#define Z147MAP_MAX_PARAMS      4096        /**< parameters per map */
+#define Z147MAP_MAX_WORDS       4           /**< adjacent words per param */
+#define Z147MAP_SF_FRAMES       16          /**< frames per superframe */
+#define Z147MAP_SF_ANY          0xff        /**< param in every frame */
+#define Z147MAP_LUT_SIZE        4096        /**< entries of a table */
+#define Z147MAP_NO_LUT          0xffff      /**< instruction without table */
+#define Z147MAP_GRP_LUT         Z147MAP_ENC_NUM /**< group of table lookups */
+
+/** \name encodings */
+/**@{*/
+#define Z147MAP_ENC_BNR         0           /**< two's complement binary */
+#define Z147MAP_ENC_BCD         1           /**< binary coded decimal */
+#define Z147MAP_ENC_DIS         2           /**< discrete bits */
+#define Z147MAP_ENC_PACK        3           /**< unsigned binary */
+#define Z147MAP_ENC_NUM         4           /**< number of encodings */
+/**@}*/
+
+/** \name column conversion kernels */
+/**@{*/
+#define Z147MAP_KRN_AUTO        -1          /**< best supported kernel */
+#define Z147MAP_KRN_SCALAR      0           /**< portable C */
+#define Z147MAP_KRN_SSE2        1           /**< x86 SSE2 */
+#define Z147MAP_KRN_AVX2        2           /**< x86 AVX2 */
+#define Z147MAP_KRN_NUM         3           /**< number of kernels */
+/**@}*/
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** parameter of a frame map */
+typedef struct {
+	char    name[Z147MAP_NAME_LEN]; /**< parameter name */
+	u_int8  enc;                /**< Z147MAP_ENC_xx */
+	u_int8  sub;                /**< subframe 1..4, 0 = every subframe */
+	u_int8  sf;                 /**< frame of the superframe or
+									 Z147MAP_SF_ANY */
+	u_int8  words;              /**< adjacent words 1..Z147MAP_MAX_WORDS */
+	u_int16 word;               /**< first word in the subframe, 0 = sync */
+	u_int8  msb;                /**< ARINC bit number of the msb 1..12 */
+	u_int8  lsb;                /**< ARINC bit number of the lsb 1..msb */
+	double  res;                /**< value of one lsb (not for DIS) */
+	double  ofs;                /**< value offset (not for DIS) */
+} Z147MAP_PARAM;
+
+/** decoding instruction (32 bytes) */
+typedef struct {
+	u_int32 off;                /**< word offset in the frame */
+	u_int16 param;              /**< parameter index */
+	u_int16 mask;               /**< bits of a word after the shift */
+	u_int8  shift;              /**< lsb - 1 */
+	u_int8  bits;               /**< bits per word */
+	u_int8  words;              /**< adjacent words */
+	u_int8  sf;                 /**< frame of the superframe or ANY */
+	u_int8  enc;                /**< Z147MAP_ENC_xx */
+	u_int8  reserved;
+	u_int16 lut;                /**< table or Z147MAP_NO_LUT */
+	double  res;                /**< value of one lsb */
+	double  ofs;                /**< value offset */
+} Z147MAP_INSN;
+
+/** instructions of one encoding */
+typedef struct {
+	u_int32 enc;                /**< Z147MAP_ENC_xx or Z147MAP_GRP_LUT */
+	u_int32 first;              /**< first instruction */
+	u_int32 num;                /**< instructions */
+} Z147MAP_GROUP;
+
+/** decoding plan */
+typedef struct {
+	u_int32 rate;               /**< Z147_RX_DATA_RATE_xx */
+	u_int32 frameWords;         /**< words per frame incl. sync words */
+	u_int32 sfSub;              /**< superframe counter subframe 1..4,
+									 0 = none */
+	u_int32 sfWord;             /**< superframe counter word */
+	u_int32 sfMask;             /**< superframe counter bits */
+	u_int32 numParams;          /**< parameters */
+	Z147MAP_PARAM *param;       /**< parameters in map order */
+	u_int32 numInsn;            /**< instructions (max. values per frame) */
+	Z147MAP_INSN *insn;         /**< instructions */
+	u_int32 numGroups;          /**< used groups */
+	Z147MAP_GROUP group[Z147MAP_ENC_NUM + 1]; /**< groups */
+	u_int32 numLuts;            /**< value tables */
+	const double **lut;         /**< numLuts tables of Z147MAP_LUT_SIZE */
+	double  *lutMem;            /**< tables computed by Z147MAP_LutBuild() */
+} Z147MAP_PLAN;
+
+/** decoded value */
+typedef struct {
+	u_int32 param;              /**< parameter index */
+	u_int32 raw;                /**< concatenated bits */
+	double  value;              /**< engineering value */
+} Z147MAP_VAL;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern Z147MAP_PLAN* Z147MAP_Compile( const char *text, int32 rate,
+									  u_int32 *errLine );
+extern Z147MAP_PLAN* Z147MAP_Load( const char *name, int32 rate,
+								   u_int32 *errLine );
+extern Z147MAP_PLAN* Z147MAP_Build( const Z147MAP_PARAM *param,
+									u_int32 num, u_int32 rate );
+extern void  Z147MAP_Free( Z147MAP_PLAN *plan );
+extern int32 Z147MAP_Find( const Z147MAP_PLAN *plan, const char *name );
+extern int32 Z147MAP_SfFrame( const Z147MAP_PLAN *plan,
+							  const u_int16 *frame );
+extern int32 Z147MAP_Decode( const Z147MAP_PLAN *plan, const u_int16 *frame,
+							 int32 sfFrame, Z147MAP_VAL *out );
+extern int32 Z147MAP_LutBuild( Z147MAP_PLAN *plan, u_int32 maxTables,
+							   const double * const *tables );
+extern int32 Z147MAP_LutWrite( const Z147MAP_PLAN *plan, const char *name,
+							   const char *prefix );
+
+extern void  Z147MAP_Column( const u_int16 *frames, u_int32 stride,
+							 u_int32 off, u_int32 n, u_int16 *col );
+extern void  Z147MAP_Convert( const Z147MAP_INSN *in,
+							  const u_int16 * const *col, u_int32 n,
+							  double *out );
+extern int32 Z147MAP_ConvSelect( int32 kernel );
+extern int32 Z147MAP_ConvSupported( int32 kernel );
+extern const char* Z147MAP_ConvName( int32 kernel );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_MAP_H */
@@ -0,0 +1,63 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_pack.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 12 bit pack/unpack library
+ *
+ *               Converts frames between u_int16 words and the packed
+ *               12 bit format of #Z147_RX_PACKED / #Z247_TX_PACKED
+ *               (2 words in 3 bytes, see Z147_PACKED_SIZE()). Packing
+ *               drops bits 12..15 of the words.
+ *
+ *               On x86 the fastest kernel the CPU supports (AVX2, SSE2)
+ *               is selected at the first call, other CPUs use the scalar
+ *               code. Z147PK_Select() forces a kernel for tests.
+ *
+ *    \switches  Z147PK_NO_SIMD  scalar code only
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_pack.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_PACK_H
+#define _Z147_PACK_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+/** \name kernels */
+/**@{*/
+#define Z147PK_AUTO             -1          /**< best supported kernel */
+#define Z147PK_SCALAR           0           /**< portable C */
+#define Z147PK_SSE2             1           /**< x86 SSE2 */
+#define Z147PK_AVX2             2           /**< x86 AVX2 */
+#define Z147PK_NUM              3           /**< number of kernels */
+/**@}*/
+
+/** bytes of packed words (same as Z147_PACKED_SIZE()) */
+#define Z147PK_SIZE(words)      (((words) * 3 + 1) / 2)
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern void  Z147PK_Pack( const u_int16 *src, u_int8 *dst, u_int32 words );
+extern void  Z147PK_Unpack( const u_int8 *src, u_int16 *dst, u_int32 words );
+extern int32 Z147PK_Select( int32 kernel );
+extern int32 Z147PK_Supported( int32 kernel );
+extern const char* Z147PK_Name( int32 kernel );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_PACK_H */
@@ -0,0 +1,106 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_rec.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 recording format
+ *
+ *               A recording is a sequence of segment files written by
+ *               z147_recorder. Each segment starts with a file header of
+ *               Z147REC_ALIGN bytes, followed by records. A record is a
+ *               Z147REC_HDR and the frame words of one channel as returned
+ *               by M_getblock(), padded to a multiple of Z147REC_REC_ALIGN
+ *               bytes. Pad records (Z147REC_TYPE_PAD) fill the gap up to
+ *               the next Z147REC_ALIGN boundary whenever the writer flushes
+ *               a partial block and must be skipped by readers.
+ *
+ *               All fields are stored in the byte order of the recording
+ *               host (little endian on x86 and ARM).
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_rec.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_REC_H
+#define _Z147_REC_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147REC_FILE_MAGIC      "Z147REC"   /**< file header magic */
+#define Z147REC_VERSION         1           /**< format version */
+#define Z147REC_ALIGN           4096        /**< file header and flush unit */
+#define Z147REC_REC_ALIGN       64          /**< record size granularity */
+#define Z147REC_MAX_CH          8           /**< max. channels */
+#define Z147REC_NAME_LEN        32          /**< device name length */
+
+#define Z147REC_MAGIC           0x3734315A  /**< record magic "Z147" */
+
+/** \name record types */
+/**@{*/
+#define Z147REC_TYPE_FRAME      1           /**< received frame */
+#define Z147REC_TYPE_PAD        2           /**< padding, no data */
+/**@}*/
+
+/** \name record status flags */
+/**@{*/
+#define Z147REC_ST_INSYNC       0x0001      /**< receiver in sync */
+#define Z147REC_ST_TORN         0x0002      /**< frame changed during read */
+#define Z147REC_ST_LOST         0x0004      /**< frames lost before this one */
+#define Z147REC_ST_PACKED       0x0008      /**< packed 12 bit frame data */
+/**@}*/
+
+/** record size for a frame of the given bytes */
+#define Z147REC_REC_SIZE(bytes) \
+	(((u_int32)sizeof(Z147REC_HDR) + (bytes) + Z147REC_REC_ALIGN - 1) & \
+	 ~(u_int32)(Z147REC_REC_ALIGN - 1))
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** segment file header (padded to Z147REC_ALIGN in the file) */
+typedef struct {
+	char    magic[8];           /**< Z147REC_FILE_MAGIC */
+	u_int32 version;            /**< Z147REC_VERSION */
+	u_int32 hdrSize;            /**< bytes before the first record */
+	u_int32 segment;            /**< segment number, 0 = first */
+	u_int32 channels;           /**< number of channels */
+	int64   createdNs;          /**< creation time (UTC, ns since 1970) */
+	u_int32 rate[Z147REC_MAX_CH];   /**< Z147_RX_DATA_RATE_xx per channel */
+	char    name[Z147REC_MAX_CH][Z147REC_NAME_LEN]; /**< device names */
+} Z147REC_FILE_HDR;
+
+/** record header (64 bytes) */
+typedef struct {
+	u_int32 magic;              /**< Z147REC_MAGIC */
+	u_int16 type;               /**< Z147REC_TYPE_xx */
+	u_int16 channel;            /**< channel index */
+	u_int32 size;               /**< record bytes incl. header and padding */
+	u_int32 dataLen;            /**< frame bytes after the header */
+	u_int32 seq;                /**< record number of the channel */
+	u_int32 frameCnt;           /**< driver frame count (Z147_RX_FRAME_CNT) */
+	int64   tsNs;               /**< receive time (UTC, ns since 1970) */
+	int64   monoNs;             /**< receive time (monotonic, ns) */
+	u_int16 rate;               /**< Z147_RX_DATA_RATE_xx */
+	u_int16 status;             /**< Z147REC_ST_xx */
+	u_int32 lost;               /**< frames lost before this one */
+	u_int32 errSigs;            /**< receive error signals so far */
+	u_int32 reserved[3];        /**< 0 */
+} Z147REC_HDR;
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_REC_H */
@@ -0,0 +1,89 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_rt.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 receive runtime of the tools
+ *
+ *               The runtime moves all work out of the signal handler. The
+ *               receive signal only takes a time stamp and posts a
+ *               semaphore. A reader thread fetches each frame with
+ *               M_getblock() into a preallocated buffer and passes it over
+ *               a lock-free single-producer/single-consumer queue to the
+ *               application thread, which checks and prints it:
+ *
+ *               \code
+ *               Z147RT_Start( path, 8, 0 );
+ *               while( (frm = Z147RT_Get( 5000 )) != NULL ){
+ *                   ... frm->data, frm->len ...
+ *                   Z147RT_Put( frm );
+ *               }
+ *               Z147RT_Stop();
+ *               \endcode
+ *
+ *               One receive path per process.
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_rt.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_RT_H
+#define _Z147_RT_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147RT_MAX_FRAME_LEN    32768   /**< frame words at 8192 words/s */
+#define Z147RT_SIG_DATA         UOS_SIG_USR1    /**< receive signal */
+#define Z147RT_SIG_ERR          UOS_SIG_USR2    /**< receive error signal */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** received frame (owned by the application between Get and Put) */
+typedef struct {
+	u_int32 seq;            /**< frame number since Z147RT_Start() */
+	u_int32 errSigs;        /**< error signals up to this frame */
+	int64   sigUs;          /**< time stamp of the receive signal in us */
+	int64   readUs;         /**< time stamp after M_getblock() in us */
+	int32   len;            /**< M_getblock() result in bytes, -1 on error */
+	int32   error;          /**< error code if len < 0 */
+	u_int16 *data;          /**< frame words */
+} Z147RT_FRAME;
+
+/** runtime statistics */
+typedef struct {
+	u_int32 sigs;           /**< receive signals */
+	u_int32 errSigs;        /**< receive error signals */
+	u_int32 frames;         /**< frames passed to the application */
+	u_int32 dropped;        /**< frames dropped on full queue */
+	u_int32 sigLost;        /**< signals lost on full time stamp ring */
+	u_int32 readErrs;       /**< failed M_getblock() */
+} Z147RT_STATS;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern int32 Z147RT_Start( MDIS_PATH path, u_int32 slots, u_int32 frameLen );
+extern void  Z147RT_Stop( void );
+extern Z147RT_FRAME* Z147RT_Get( u_int32 timeoutMs );
+extern void  Z147RT_Put( Z147RT_FRAME *frm );
+extern Z147RT_STATS* Z147RT_Stats( void );
+extern int64 Z147RT_NowUs( void );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_RT_H */
@@ -0,0 +1,131 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_sf.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147 superframe assembler
+ *
+ *               An ARINC 717 superframe are 16 frames, numbered by a
+ *               counter in a fixed word of one subframe. The assembler
+ *               collects the received frames of a channel into
+ *               superframes and checks the counter for lost and repeated
+ *               frames:
+ *
+ *               \code
+ *               sa = Z147SF_Init( rate, 1, 1, 0x00f, 2, NULL, NULL );
+ *               while( ... ){
+ *                   M_getblock( path, (u_int8*)Z147SF_Slot( sa ), len );
+ *                   if( Z147SF_Push( sa, -1 ) & Z147SF_EV_DONE ){
+ *                       sf = Z147SF_Get( sa );
+ *                       ... sf->frame[0..15] if sf->present bit set ...
+ *                       Z147SF_Put( sa, sf );
+ *                   }
+ *               }
+ *               Z147SF_Exit( sa );
+ *               \endcode
+ *
+ *               The frames are read directly into buffers of the
+ *               assembler. Z147SF_Push() moves the buffer into the
+ *               superframe by swapping pointers, the frames are never
+ *               copied. A superframe is finished with its last frame
+ *               (position 15) or when the counter starts a new one, a
+ *               finished superframe may have holes (see present).
+ *
+ *               The position of a frame in the superframe is the counter
+ *               modulo 16. The counter difference to the previous frame
+ *               gives the lost frames (0 = repeated frame, dropped). A 4
+ *               bit counter can't see gaps of 16 frames or more, wider
+ *               counters can, and also detect counter restarts.
+ *
+ *               With a notify function, finished superframes are passed
+ *               to it from Z147SF_Push() instead of being queued for
+ *               Z147SF_Get(). Either way the application owns the
+ *               superframe until Z147SF_Put(). While it holds all
+ *               superframe buffers, new frames are dropped.
+ *
+ *               Not thread safe, one assembler per receive channel.
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sf.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_SF_H
+#define _Z147_SF_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147SF_FRAMES           16          /**< frames per superframe */
+#define Z147SF_COMPLETE         0xffff      /**< present of a full one */
+
+/** \name Z147SF_Push() events */
+/**@{*/
+#define Z147SF_EV_FRAME         0x0001      /**< frame added */
+#define Z147SF_EV_DONE          0x0002      /**< superframe(s) finished */
+#define Z147SF_EV_GAP           0x0004      /**< frames lost before */
+#define Z147SF_EV_DUP           0x0008      /**< repeated frame dropped */
+#define Z147SF_EV_BACK          0x0010      /**< counter went back */
+#define Z147SF_EV_DROP          0x0020      /**< no free superframe,
+												 frame dropped */
+/**@}*/
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** superframe (owned by the application between Get and Put) */
+typedef struct {
+	u_int32 number;             /**< superframe number since Z147SF_Init() */
+	u_int32 counter;            /**< counter of position 0 */
+	u_int32 present;            /**< bit n: frame n received */
+	u_int32 frames;             /**< received frames */
+	u_int32 frameWords;         /**< words per frame incl. sync words */
+	u_int16 *frame[Z147SF_FRAMES]; /**< frame n, valid if present */
+} Z147SF_SUPER;
+
+/** assembler statistics */
+typedef struct {
+	u_int32 frames;             /**< frames added */
+	u_int32 superframes;        /**< superframes finished */
+	u_int32 complete;           /**< superframes with all 16 frames */
+	u_int32 lost;               /**< frames lost (counter gaps) */
+	u_int32 dups;               /**< repeated frames dropped */
+	u_int32 back;               /**< counter restarts */
+	u_int32 dropped;            /**< frames dropped, no free superframe */
+} Z147SF_STATS;
+
+/** superframe finished, called from Z147SF_Push() */
+typedef void (*Z147SF_NOTIFY)( void *arg, Z147SF_SUPER *sf );
+
+/** assembler */
+typedef struct Z147SF_ASM Z147SF_ASM;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+extern Z147SF_ASM* Z147SF_Init( u_int32 rate, u_int32 sfSub, u_int32 sfWord,
+								u_int32 sfMask, u_int32 hold,
+								Z147SF_NOTIFY notify, void *arg );
+extern void  Z147SF_Exit( Z147SF_ASM *sa );
+extern u_int16* Z147SF_Slot( Z147SF_ASM *sa );
+extern u_int32 Z147SF_Push( Z147SF_ASM *sa, int32 counter );
+extern u_int32 Z147SF_Flush( Z147SF_ASM *sa );
+extern Z147SF_SUPER* Z147SF_Get( Z147SF_ASM *sa );
+extern void  Z147SF_Put( Z147SF_ASM *sa, Z147SF_SUPER *sf );
+extern const Z147SF_STATS* Z147SF_Stats( const Z147SF_ASM *sa );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_SF_H */
@@ -0,0 +1,145 @@
+/***********************  I n c l u d e  -  F i l e  ***********************/
+/*!
+ *        \file  z147_sim.h
+ *
+ *      \author  APatil
+ *
+ *       \brief  Header file for the Z147/Z247 host simulator containing
+ *               the register model and device API
+ *
+ *               The simulator models the register map of the 16Z147
+ *               (ARINC717 RX) and 16Z247 (ARINC717 TX) cores. The LL drivers
+ *               are compiled against host versions of the OSS, DESC, DBG
+ *               libraries and of MACCESS, so that every register access of
+ *               the driver ends up in Z147SIM_Read()/Z147SIM_Write().
+ *
+ *               Time advances in ticks of 1/8192 s, i.e. one word time at
+ *               the highest data rate. Slower rates move one word every
+ *               2^(7-rate) ticks. The simulation runs either as fast as
+ *               possible or paced to (a multiple of) real time.
+ *
+ *    \switches  -
+ */
+ /*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sim.h,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#ifndef _Z147_SIM_H
+#define _Z147_SIM_H
+
+#ifdef __cplusplus
+      extern "C" {
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define Z147SIM_RX              0       /**< 16Z147 receiver core */
+#define Z147SIM_TX              1       /**< 16Z247 transmitter core */
+
+#define Z147SIM_MAX_DEV         16      /**< max. devices per world */
+#define Z147SIM_TICK_HZ         8192    /**< ticks per second */
+#define Z147SIM_FIFO_WORDS      1024    /**< hardware FIFO depth in words */
+
+/** word period in ticks for a Z147_RX_DATA_RATE_xx value */
+#define Z147SIM_PERIOD(rate)    (1 << (7 - ((rate) & 0x7)))
+
+/** ticks for a number of milliseconds */
+#define Z147SIM_MS2TICKS(ms)    (((u_int64)(ms) * Z147SIM_TICK_HZ) / 1000)
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+typedef struct Z147SIM_WORLD Z147SIM_WORLD;    /**< simulation world */
+typedef struct Z147SIM_DEV   Z147SIM_DEV;      /**< simulated IP core */
+
+/** signal hook, called when the driver sends a signal */
+typedef void (*Z147SIM_SIGFUNC)( Z147SIM_DEV *dev, int32 sigNum, void *arg );
+
+/** ISR hook, called after each ISR invocation with its duration */
+typedef void (*Z147SIM_IRQFUNC)( Z147SIM_DEV *dev, u_int64 ns, void *arg );
+
+/** data word generator for RX devices without a connected transmitter,
+ *  called for every non-sync slot of a frame */
+typedef u_int16 (*Z147SIM_GENFUNC)( void *arg, u_int32 frame, u_int32 slot );
+
+/** fault injection settings (probabilities per word, 0.0..1.0) */
+typedef struct {
+	double  bitErrRate;     /**< flip one random bit of a word */
+	double  slipRate;       /**< lose a word (receiver slips by one) */
+	double  syncErrRate;    /**< corrupt a sync word */
+	double  gapRate;        /**< line idle for one word time */
+} Z147SIM_FAULTS;
+
+/** device statistics */
+typedef struct {
+	u_int64 words;          /**< words received from / sent to the line */
+	u_int64 irqs;           /**< ISR invocations */
+	u_int64 irqsHandled;    /**< ISR invocations returning LL_IRQ_DEVICE */
+	u_int64 mmioRd;         /**< register/FIFO reads */
+	u_int64 mmioWr;         /**< register/FIFO writes */
+	u_int64 fifoOverruns;   /**< RX: words lost on full FIFO */
+	u_int64 syncLosses;     /**< RX: lost synchronization */
+	u_int64 underruns;      /**< TX: empty FIFO at data slot */
+	u_int64 faults;         /**< injected faults */
+	u_int64 sigs;           /**< signals sent by the driver */
+	u_int64 alarms;         /**< OSS alarms fired (deferred driver work) */
+} Z147SIM_STATS;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+/* world */
+extern Z147SIM_WORLD* Z147SIM_WorldCreate( void );
+extern void    Z147SIM_WorldDestroy( Z147SIM_WORLD *world );
+extern void    Z147SIM_SetSpeed( Z147SIM_WORLD *world, double speed );
+extern u_int64 Z147SIM_Run( Z147SIM_WORLD *world, u_int64 ticks );
+extern int32   Z147SIM_Start( Z147SIM_WORLD *world );
+extern void    Z147SIM_Stop( Z147SIM_WORLD *world );
+extern u_int64 Z147SIM_Ticks( Z147SIM_WORLD *world );
+extern void    Z147SIM_Lock( Z147SIM_WORLD *world );
+extern void    Z147SIM_Unlock( Z147SIM_WORLD *world );
+
+/* devices */
+extern int32   Z147SIM_DevOpen( Z147SIM_WORLD *world, int32 type,
+                                DESC_SPEC *desc, Z147SIM_DEV **devP );
+extern int32   Z147SIM_DevClose( Z147SIM_DEV *dev );
+extern void    Z147SIM_Connect( Z147SIM_DEV *txDev, Z147SIM_DEV *rxDev );
+extern void    Z147SIM_SetGenerator( Z147SIM_DEV *dev, Z147SIM_GENFUNC func,
+                                     void *arg );
+extern void    Z147SIM_SetFaults( Z147SIM_DEV *dev,
+                                  const Z147SIM_FAULTS *faults,
+                                  u_int32 seed );
+extern void    Z147SIM_SetSigHook( Z147SIM_DEV *dev, Z147SIM_SIGFUNC func,
+                                   void *arg );
+extern void    Z147SIM_SetWorkHook( Z147SIM_DEV *dev, Z147SIM_IRQFUNC func,
+								   void *arg );
+extern void    Z147SIM_SetIrqHook( Z147SIM_DEV *dev, Z147SIM_IRQFUNC func,
+                                   void *arg );
+extern Z147SIM_STATS* Z147SIM_Stats( Z147SIM_DEV *dev );
+extern Z147SIM_WORLD* Z147SIM_World( Z147SIM_DEV *dev );
+
+/* LL driver calls, serialized against the simulated interrupt */
+extern int32   Z147SIM_SetStat( Z147SIM_DEV *dev, int32 code,
+                                INT32_OR_64 value );
+extern int32   Z147SIM_GetStat( Z147SIM_DEV *dev, int32 code,
+                                INT32_OR_64 *valueP );
+extern int32   Z147SIM_BlockRead( Z147SIM_DEV *dev, void *buf, int32 size,
+                                  int32 *nbrRdBytesP );
+extern int32   Z147SIM_BlockWrite( Z147SIM_DEV *dev, void *buf, int32 size,
+                                   int32 *nbrWrBytesP );
+
+/* simulated MACCESS (see maccess.h of the host build) */
+extern u_int32 Z147SIM_Read( Z147SIM_DEV *dev, u_int32 offs, u_int32 width );
+extern void    Z147SIM_Write( Z147SIM_DEV *dev, u_int32 offs, u_int32 width,
+                              u_int32 val );
+
+#ifdef __cplusplus
+      }
+#endif
+
+#endif /* _Z147_SIM_H */
@@ -54,6 +54,10 @@
 #define Z247_DISABLE_TX          M_DEV_OF+0x0F	  /**< G,S: Set disable transmission. */
 #define Z247_SET_ERR_SIGNAL      M_DEV_OF+0x10    /**<   S: Set signal for TX error */
 #define Z247_CLR_ERR_SIGNAL      M_DEV_OF+0x11    /**<   S: Clear signal for TX error */
+#define Z247_SET_FRAME_SIGNAL    M_DEV_OF+0x12    /**<   S: Set signal sent on frame start */
+#define Z247_CLR_FRAME_SIGNAL    M_DEV_OF+0x13    /**<   S: Clear frame start signal */
+#define Z247_TX_FRAME_CNT        M_DEV_OF+0x14    /**< G  : Get started frame count. */
+#define Z247_TX_PACKED           M_DEV_OF+0x15    /**< G,S: Get/Set packed 12 bit frame format of M_setblock(). */
 
 
 /* Z17 specific Getstat/Setstat block codes (for test purposes) */
@@ -62,6 +66,9 @@
 
 /**@}*/
 
+/* Z247_TX_PACKED frame format, same as Z147_RX_PACKED */
+#define Z247_PACKED_SIZE(words)  (((words) * 3 + 1) / 2)  /**< bytes of packed words */
+
 #ifndef  Z247_VARIANT
   #define Z247_VARIANT    Z17
 #endif
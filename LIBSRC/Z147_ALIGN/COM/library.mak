@@ -0,0 +1,24 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile descriptor file for the Z147 offline frame aligner
+#                 library
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: library.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_align
+
+MAK_INCL=$(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/z147_drv.h	\
+         $(MEN_INC_DIR)/z147_align.h	\
+
+MAK_INP1=z147_align$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
@@ -0,0 +1,317 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_align.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Sync word search and frame alignment of raw Z147 word
+ *               streams with SIMD kernels
+ *
+ *               The sync words differ pairwise in bit 11 only
+ *               (0x247/0xA47, 0x5B8/0xDB8), so a search compares the
+ *               words masked with 0x7FF with two values instead of four.
+ *
+ *               SSE2 compares 8 words per step, AVX2 32 words (two
+ *               vectors, one test of both results). The first step with
+ *               a match is resolved with the byte mask of the compare.
+ *               The words behind the last full step are searched by the
+ *               next narrower kernel.
+ *
+ *     \switches Z147AL_NO_SIMD  scalar code only
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_align.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <MEN/men_typs.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_align.h>
+
+#if !defined(Z147AL_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+# define Z147AL_X86
+# include <immintrin.h>
+#endif
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define SYNC_MASK       0x07ff      /**< bits the sync word pairs share */
+#define SYNC_13         (Z147_ARINC717_SUB_1_SYNC & SYNC_MASK)
+#define SYNC_24         (Z147_ARINC717_SUB_2_SYNC & SYNC_MASK)
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+typedef u_int64 FIND_FUNC( const u_int16 *w, u_int64 num );
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static u_int64 FindScalar( const u_int16 *w, u_int64 num );
+static u_int64 FindAuto( const u_int16 *w, u_int64 num );
+static int32 SyncSub( u_int16 word );
+#ifdef Z147AL_X86
+static u_int64 FindSse2( const u_int16 *w, u_int64 num );
+static u_int64 FindAvx2( const u_int16 *w, u_int64 num );
+#endif
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static FIND_FUNC *G_find = FindAuto;
+
+static const char *G_name[Z147AL_NUM] = { "scalar", "sse2", "avx2" };
+
+static const u_int16 G_sync[4] = {
+	Z147_ARINC717_SUB_1_SYNC, Z147_ARINC717_SUB_2_SYNC,
+	Z147_ARINC717_SUB_3_SYNC, Z147_ARINC717_SUB_4_SYNC
+};
+
+/******************************* Z147AL_Find ********************************/
+/** Search the next sync word
+ *
+ *  \param w          \IN  words
+ *  \param num        \IN  number of words
+ *  \return           index of the first sync word or num if none
+ */
+u_int64 Z147AL_Find( const u_int16 *w, u_int64 num )
+{
+	return G_find( w, num );
+}
+
+/******************************* Z147AL_Detect ******************************/
+/** Detect data rate and frame alignment
+ *
+ *  Every sync word found is checked for Z147AL_CONFIRM - 1 following
+ *  sync words in order at the subframe distance of the rates, from the
+ *  lowest to the highest. The first frame starts at the next subframe 1
+ *  sync word, words of the subframes before it are skipped.
+ *
+ *  \param w          \IN  words
+ *  \param num        \IN  number of words
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx or Z147AL_ANY_RATE
+ *  \param al         \OUT rate and first frame
+ *  \return           0 or -1 if no alignment found
+ */
+int32 Z147AL_Detect( const u_int16 *w, u_int64 num, int32 rate,
+					 Z147AL_ALIGN *al )
+{
+	int32 r, rFirst, rLast, k;
+	u_int64 p, sfs;
+	u_int32 j;
+
+	rFirst = rate < 0 ? 0 : rate;
+	rLast  = rate < 0 ? 7 : rate;
+
+	for( p = G_find( w, num ); p < num;
+		 p += 1 + G_find( w + p + 1, num - p - 1 ) ){
+
+		/* no room left for the confirmation at the lowest rate */
+		if( p + (u_int64)(Z147AL_CONFIRM - 1) * (64u << rFirst) >= num )
+			break;
+
+		k = SyncSub( w[p] );
+		for( r = rFirst; r <= rLast; r++ ){
+			sfs = 64u << r;
+			if( p + (Z147AL_CONFIRM - 1) * sfs >= num )
+				break;
+			for( j = 1; j < Z147AL_CONFIRM; j++ ){
+				if( (w[p + j * sfs] & 0x0fff) != G_sync[(k + j) & 0x3] )
+					break;
+			}
+			if( j == Z147AL_CONFIRM ){
+				al->rate       = r;
+				al->frameWords = 4 * (u_int32)sfs;
+				al->start      = p + ((4 - k) & 0x3) * sfs;
+				return 0;
+			}
+		}
+	}
+	return -1;
+}
+
+/******************************* Z147AL_SyncOk ******************************/
+/** Count the correct sync words of a frame
+ *
+ *  \param frame      \IN  frame words
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \return           number of subframes with their sync word (0..4)
+ */
+u_int32 Z147AL_SyncOk( const u_int16 *frame, int32 rate )
+{
+	u_int32 sfs = 64u << rate;
+	u_int32 k, ok = 0;
+
+	for( k = 0; k < 4; k++ )
+		ok += (frame[k * sfs] & 0x0fff) == G_sync[k];
+	return ok;
+}
+
+/******************************* Z147AL_Supported ***************************/
+/** Check if the CPU supports a kernel
+ *
+ *  \param kernel     \IN  Z147AL_xx
+ *  \return           1 if supported
+ */
+int32 Z147AL_Supported( int32 kernel )
+{
+	switch( kernel ){
+	case Z147AL_SCALAR:
+		return 1;
+#ifdef Z147AL_X86
+	case Z147AL_SSE2:
+		return __builtin_cpu_supports( "sse2" ) ? 1 : 0;
+	case Z147AL_AVX2:
+		return __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+/******************************* Z147AL_Select ******************************/
+/** Select the kernel used by Z147AL_Find() and Z147AL_Detect()
+ *
+ *  \param kernel     \IN  Z147AL_xx or Z147AL_AUTO
+ *  \return           selected kernel or -1 if not supported
+ */
+int32 Z147AL_Select( int32 kernel )
+{
+	if( kernel == Z147AL_AUTO ){
+		for( kernel = Z147AL_NUM - 1; kernel > Z147AL_SCALAR; kernel-- )
+			if( Z147AL_Supported( kernel ) )
+				break;
+	}else if( !Z147AL_Supported( kernel ) ){
+		return -1;
+	}
+
+	switch( kernel ){
+#ifdef Z147AL_X86
+	case Z147AL_SSE2:
+		G_find = FindSse2;
+		break;
+	case Z147AL_AVX2:
+		G_find = FindAvx2;
+		break;
+#endif
+	default:
+		G_find = FindScalar;
+		break;
+	}
+	return kernel;
+}
+
+/******************************* Z147AL_Name ********************************/
+/** Name of a kernel
+ *
+ *  \param kernel     \IN  Z147AL_xx
+ *  \return           name
+ */
+const char* Z147AL_Name( int32 kernel )
+{
+	if( kernel < 0 || kernel >= Z147AL_NUM )
+		return "?";
+	return G_name[kernel];
+}
+
+/**********************************************************************/
+/** First call: select the best kernel and search */
+static u_int64 FindAuto( const u_int16 *w, u_int64 num )
+{
+	Z147AL_Select( Z147AL_AUTO );
+	return G_find( w, num );
+}
+
+/**********************************************************************/
+/** Subframe (0..3) of a sync word */
+static int32 SyncSub( u_int16 word )
+{
+	int32 k;
+
+	for( k = 0; k < 3; k++ )
+		if( (word & 0x0fff) == G_sync[k] )
+			break;
+	return k;
+}
+
+/**********************************************************************/
+/** Portable search */
+static u_int64 FindScalar( const u_int16 *w, u_int64 num )
+{
+	u_int64 i;
+	u_int16 v;
+
+	for( i = 0; i < num; i++ ){
+		v = w[i] & SYNC_MASK;
+		if( v == SYNC_13 || v == SYNC_24 )
+			break;
+	}
+	return i;
+}
+
+#ifdef Z147AL_X86
+/**********************************************************************/
+/** SSE2 search, 8 words per step */
+__attribute__((target("sse2")))
+static u_int64 FindSse2( const u_int16 *w, u_int64 num )
+{
+	const __m128i m11 = _mm_set1_epi16( SYNC_MASK );
+	const __m128i s13 = _mm_set1_epi16( SYNC_13 );
+	const __m128i s24 = _mm_set1_epi16( SYNC_24 );
+	__m128i v;
+	u_int32 mask;
+	u_int64 i;
+
+	for( i = 0; i + 8 <= num; i += 8 ){
+		v = _mm_and_si128( _mm_loadu_si128( (const __m128i*)(w + i) ), m11 );
+		mask = (u_int32)_mm_movemask_epi8(
+			_mm_or_si128( _mm_cmpeq_epi16( v, s13 ),
+						  _mm_cmpeq_epi16( v, s24 ) ) );
+		if( mask )
+			return i + (__builtin_ctz( mask ) >> 1);
+	}
+	return i + FindScalar( w + i, num - i );
+}
+
+/**********************************************************************/
+/** AVX2 search, 32 words per step */
+__attribute__((target("avx2")))
+static u_int64 FindAvx2( const u_int16 *w, u_int64 num )
+{
+	const __m256i m11 = _mm256_set1_epi16( SYNC_MASK );
+	const __m256i s13 = _mm256_set1_epi16( SYNC_13 );
+	const __m256i s24 = _mm256_set1_epi16( SYNC_24 );
+	__m256i a, b, ea, eb, any;
+	u_int32 mask;
+	u_int64 i;
+
+	for( i = 0; i + 32 <= num; i += 32 ){
+		a = _mm256_and_si256(
+				_mm256_loadu_si256( (const __m256i*)(w + i) ), m11 );
+		b = _mm256_and_si256(
+				_mm256_loadu_si256( (const __m256i*)(w + i + 16) ), m11 );
+		ea = _mm256_or_si256( _mm256_cmpeq_epi16( a, s13 ),
+							  _mm256_cmpeq_epi16( a, s24 ) );
+		eb = _mm256_or_si256( _mm256_cmpeq_epi16( b, s13 ),
+							  _mm256_cmpeq_epi16( b, s24 ) );
+		any = _mm256_or_si256( ea, eb );
+		if( !_mm256_testz_si256( any, any ) ){
+			mask = (u_int32)_mm256_movemask_epi8( ea );
+			if( mask == 0 ){
+				mask = (u_int32)_mm256_movemask_epi8( eb );
+				i += 16;
+			}
+			_mm256_zeroupper();
+			return i + (__builtin_ctz( mask ) >> 1);
+		}
+	}
+	/* avoid the AVX/SSE transition penalty in the SSE2 tail */
+	_mm256_zeroupper();
+	return i + FindSse2( w + i, num - i );
+}
+#endif /* Z147AL_X86 */
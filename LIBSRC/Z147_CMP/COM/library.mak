@@ -0,0 +1,23 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile descriptor file for the Z147 frame compression
+#                 library
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: library.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_cmp
+
+MAK_INCL=$(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/z147_cmp.h	\
+
+MAK_INP1=z147_cmp$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
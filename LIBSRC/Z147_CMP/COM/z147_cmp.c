@@ -0,0 +1,290 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_cmp.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Z147 frame compression codec (XOR against the previous
+ *               frame, run length coded, 12 bit packed)
+ *
+ *               Stream format see z147_cmp.h. The reference frame is
+ *               updated in place: unchanged runs are skipped, so encoder
+ *               and decoder only touch the changed words plus one copy of
+ *               the frame. Unchanged runs are found 4 words at a time.
+ *
+ *               Functions return -1 on error (output buffer too small,
+ *               damaged input, decoding not started at a key frame).
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_cmp.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_cmp.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define ZERO_MAX        128             /**< words per unchanged run */
+#define LIT_MAX         64              /**< words per changed run */
+#define CTL_LIT12       0x80            /**< changed run, 12 bit */
+#define CTL_LIT16       0xc0            /**< changed run, 16 bit */
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static u_int32 SameWords( const u_int16 *a, const u_int16 *b, u_int32 n );
+
+/******************************* Z147CMP_Init *******************************/
+/** Initialize an encoder or decoder
+ *
+ *  \param ctx          \OUT codec state
+ *  \param frameWords   \IN  words per frame
+ *  \param blockFrames  \IN  frames per key frame (0 = default)
+ *  \return             0 or -1 on error
+ */
+int32 Z147CMP_Init( Z147CMP_CTX *ctx, u_int32 frameWords,
+					u_int32 blockFrames )
+{
+	memset( ctx, 0, sizeof(*ctx) );
+	if( frameWords == 0 )
+		return -1;
+	ctx->frameWords  = frameWords;
+	ctx->blockFrames = blockFrames ? blockFrames : Z147CMP_BLOCK_FRAMES;
+	ctx->ref = (u_int16*)calloc( frameWords, sizeof(u_int16) );
+	return ctx->ref ? 0 : -1;
+}
+
+/******************************* Z147CMP_Exit *******************************/
+/** Free the codec state
+ *
+ *  \param ctx          \IN  codec state
+ */
+void Z147CMP_Exit( Z147CMP_CTX *ctx )
+{
+	free( ctx->ref );
+	ctx->ref = NULL;
+}
+
+/******************************* Z147CMP_Reset ******************************/
+/** Restart the codec
+ *
+ *  The encoder writes a key frame next, the decoder needs a key frame
+ *  next (call before decoding from a restart point).
+ *
+ *  \param ctx          \IN  codec state
+ */
+void Z147CMP_Reset( Z147CMP_CTX *ctx )
+{
+	ctx->frames = 0;
+	ctx->valid  = 0;
+}
+
+/******************************* Z147CMP_Encode *****************************/
+/** Encode a frame
+ *
+ *  \param ctx          \IN  encoder
+ *  \param frame        \IN  ctx->frameWords words
+ *  \param out          \OUT coded frame incl. header
+ *  \param outSize      \IN  size of out, >= Z147CMP_MAX_SIZE(frameWords)
+ *  \return             coded bytes or -1 on error
+ */
+int32 Z147CMP_Encode( Z147CMP_CTX *ctx, const u_int16 *frame,
+					  u_int8 *out, u_int32 outSize )
+{
+	u_int16 *ref = ctx->ref;
+	u_int32 n = ctx->frameWords, i = 0, j, k, run, len;
+	u_int16 flags = 0, r0, r1;
+	u_int8 *op = out + Z147CMP_FRAME_HDR_SIZE;
+	int wide;
+
+	if( outSize < Z147CMP_MAX_SIZE( n ) )
+		return -1;
+
+	if( ctx->frames % ctx->blockFrames == 0 ){
+		memset( ref, 0, n * sizeof(u_int16) );
+		flags |= Z147CMP_FL_KEY;
+	}
+
+	while( i < n ){
+		/* unchanged run */
+		run = SameWords( frame + i, ref + i, n - i );
+		for( i += run; run; run -= k ){
+			k = run > ZERO_MAX ? ZERO_MAX : run;
+			*op++ = (u_int8)(k - 1);
+		}
+		if( i == n )
+			break;
+
+		/* changed run, ends at two unchanged words in a row */
+		wide = 0;
+		for( j = i; j < n && j - i < LIT_MAX; j++ ){
+			if( frame[j] == ref[j] &&
+				(j + 1 == n || frame[j+1] == ref[j+1]) )
+				break;
+			if( (frame[j] ^ ref[j]) > 0xfff )
+				wide = 1;
+		}
+		k = j - i;
+		*op++ = (u_int8)((wide ? CTL_LIT16 : CTL_LIT12) | (k - 1));
+		if( wide ){
+			for( ; i < j; i++ ){
+				r0 = frame[i] ^ ref[i];
+				*op++ = (u_int8)r0;
+				*op++ = (u_int8)(r0 >> 8);
+				ref[i] = frame[i];
+			}
+		}else{
+			for( ; i + 1 < j; i += 2 ){
+				r0 = frame[i] ^ ref[i];
+				r1 = frame[i+1] ^ ref[i+1];
+				*op++ = (u_int8)r0;
+				*op++ = (u_int8)((r0 >> 8) | (r1 << 4));
+				*op++ = (u_int8)(r1 >> 4);
+				ref[i]   = frame[i];
+				ref[i+1] = frame[i+1];
+			}
+			if( i < j ){
+				r0 = frame[i] ^ ref[i];
+				*op++ = (u_int8)r0;
+				*op++ = (u_int8)(r0 >> 8);
+				ref[i] = frame[i];
+				i++;
+			}
+		}
+	}
+
+	len = (u_int32)(op - out) - Z147CMP_FRAME_HDR_SIZE;
+	out[0] = (u_int8)Z147CMP_MAGIC;
+	out[1] = (u_int8)(Z147CMP_MAGIC >> 8);
+	out[2] = (u_int8)flags;
+	out[3] = (u_int8)(flags >> 8);
+	out[4] = (u_int8)len;
+	out[5] = (u_int8)(len >> 8);
+	out[6] = (u_int8)(len >> 16);
+	out[7] = (u_int8)(len >> 24);
+
+	ctx->frames++;
+	return (int32)(len + Z147CMP_FRAME_HDR_SIZE);
+}
+
+/******************************* Z147CMP_Decode *****************************/
+/** Decode a frame
+ *
+ *  \param ctx          \IN  decoder
+ *  \param in           \IN  coded frame incl. header
+ *  \param inSize       \IN  bytes available at in
+ *  \param frame        \OUT ctx->frameWords words (NULL: only advance)
+ *  \return             bytes used or -1 on error
+ */
+int32 Z147CMP_Decode( Z147CMP_CTX *ctx, const u_int8 *in, u_int32 inSize,
+					  u_int16 *frame )
+{
+	u_int16 *ref = ctx->ref;
+	u_int32 n = ctx->frameWords, o = 0, k, need;
+	const u_int8 *ip, *end;
+	int32 size, key;
+	u_int8 c;
+
+	if( (size = Z147CMP_FrameSize( in, inSize, &key )) < 0 ||
+		(!key && !ctx->valid) )
+		return -1;
+
+	if( key )
+		memset( ref, 0, n * sizeof(u_int16) );
+	ctx->valid = 0;
+
+	ip  = in + Z147CMP_FRAME_HDR_SIZE;
+	end = in + size;
+	while( o < n ){
+		if( ip >= end )
+			return -1;
+		c = *ip++;
+		if( c < CTL_LIT12 ){
+			/* unchanged: nothing to do */
+			o += (u_int32)c + 1;
+			if( o > n )
+				return -1;
+			continue;
+		}
+
+		k = (u_int32)(c & 0x3f) + 1;
+		need = c >= CTL_LIT16 ? 2 * k : (3 * k + 1) / 2;
+		if( o + k > n || (u_int32)(end - ip) < need )
+			return -1;
+		if( c >= CTL_LIT16 ){
+			for( ; k; k--, ip += 2 )
+				ref[o++] ^= (u_int16)(ip[0] | (ip[1] << 8));
+		}else{
+			for( ; k >= 2; k -= 2, ip += 3 ){
+				ref[o++] ^= (u_int16)(ip[0] | ((ip[1] & 0x0f) << 8));
+				ref[o++] ^= (u_int16)((ip[1] >> 4) | (ip[2] << 4));
+			}
+			if( k ){
+				ref[o++] ^= (u_int16)(ip[0] | ((ip[1] & 0x0f) << 8));
+				ip += 2;
+			}
+		}
+	}
+	if( ip != end )
+		return -1;
+
+	if( frame )
+		memcpy( frame, ref, n * sizeof(u_int16) );
+	ctx->valid = 1;
+	ctx->frames++;
+	return size;
+}
+
+/******************************* Z147CMP_FrameSize **************************/
+/** Check a frame header
+ *
+ *  Used to step over coded frames without decoding them, e.g. to collect
+ *  the key frame offsets of a stream.
+ *
+ *  \param in           \IN  coded frame
+ *  \param inSize       \IN  bytes available at in
+ *  \param keyP         \OUT 1 for a key frame (may be NULL)
+ *  \return             coded bytes incl. header or -1 if not a frame
+ */
+int32 Z147CMP_FrameSize( const u_int8 *in, u_int32 inSize, int32 *keyP )
+{
+	u_int32 len;
+
+	if( inSize < Z147CMP_FRAME_HDR_SIZE ||
+		(u_int32)(in[0] | (in[1] << 8)) != Z147CMP_MAGIC )
+		return -1;
+	len = (u_int32)in[4] | ((u_int32)in[5] << 8) | ((u_int32)in[6] << 16) |
+		  ((u_int32)in[7] << 24);
+	if( len > inSize - Z147CMP_FRAME_HDR_SIZE || len > 0x7fffff00 )
+		return -1;
+	if( keyP )
+		*keyP = (in[2] & Z147CMP_FL_KEY) ? 1 : 0;
+	return (int32)(len + Z147CMP_FRAME_HDR_SIZE);
+}
+
+/**********************************************************************/
+/** Number of equal words at the start of a and b */
+static u_int32 SameWords( const u_int16 *a, const u_int16 *b, u_int32 n )
+{
+	u_int64 wa, wb;
+	u_int32 i = 0;
+
+	for( ; i + 4 <= n; i += 4 ){
+		memcpy( &wa, a + i, 8 );
+		memcpy( &wb, b + i, 8 );
+		if( wa != wb )
+			break;
+	}
+	while( i < n && a[i] == b[i] )
+		i++;
+	return i;
+}
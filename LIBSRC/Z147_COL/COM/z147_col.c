@@ -0,0 +1,894 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_col.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Reader and writer of Z147 parameter column files
+ *
+ *               Format see z147_col.h. The writer collects one page of
+ *               samples, codes it when full and keeps the zone map in
+ *               memory, Z147COL_Finish() appends the zone map and the
+ *               summaries and writes the header. The summaries are built
+ *               per sample on the second level only, a finished second is
+ *               merged into its minute and a finished minute into its
+ *               hour. The reader maps the whole file, a query decodes only
+ *               the pages whose zone matches.
+ *
+ *               Functions return -1 or NULL on error with errno set
+ *               (EINVAL: not a column file).
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_col.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <float.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_col.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define ZONE_GROW       1024            /**< zone entries per realloc */
+#define SUM_GROW        4096            /**< summaries per realloc */
+#define SUM_MIN_AVG     8               /**< min. samples per summary */
+#define MAX_RUN         128             /**< samples per run byte */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** writer state */
+struct Z147COL_WRITER {
+	FILE            *fp;            /**< output file */
+	Z147COL_HDR     hdr;            /**< file header */
+	u_int64         off;            /**< offset of the next page */
+	u_int32         num;            /**< samples in the page */
+	int64           *ts;            /**< page times */
+	double          *val;           /**< page values */
+	u_int8          *buf;           /**< coded page */
+	Z147COL_ZONE    *zone;          /**< zone map */
+	u_int32         zoneMax;
+	Z147COL_SUM     cur[Z147COL_SUM_LEVELS];    /**< open intervals */
+	Z147COL_SUM     *sum[Z147COL_SUM_LEVELS];   /**< finished intervals */
+	u_int32         sumMax[Z147COL_SUM_LEVELS];
+};
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static int32 WritePage( Z147COL_WRITER *wr );
+static int32 Summarize( Z147COL_WRITER *wr, const int64 *ts,
+						const double *val, u_int32 n );
+static int32 CloseSum( Z147COL_WRITER *wr, u_int32 l );
+static void AddSum( Z147COL_SUM *s, int64 startNs, u_int32 num, double min,
+					double max, double sum );
+static int32 AggRaw( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+					 Z147COL_AGG *agg );
+static int32 AggVisit( void *arg, int64 tsNs, double value );
+static void AggLevel( Z147COL_FILE *col, u_int32 l, int64 fromNs,
+					  int64 toNs, Z147COL_AGG *agg );
+static void AggSums( Z147COL_FILE *col, u_int32 l, int64 fromNs,
+					 int64 toNs, Z147COL_AGG *agg );
+static int64 Floor( int64 t, int64 period );
+static u_int32 EncodePage( const int64 *ts, const double *val, u_int32 n,
+						   u_int8 *out );
+static int32 DecodePage( const u_int8 *in, u_int32 size, u_int32 n,
+						 int64 *ts, double *val );
+static u_int32 PutVar( u_int8 *p, u_int64 v );
+static u_int32 GetVar( const u_int8 *p, const u_int8 *end, u_int64 *v );
+static void FreeWriter( Z147COL_WRITER *wr );
+
+/******************************* Z147COL_Create *****************************/
+/** Create a column file
+ *
+ *  \param name       \IN  file name (replaced if existing)
+ *  \param param      \IN  parameter name
+ *  \param pageSamples \IN samples per page (0 = default)
+ *  \param flags      \IN  Z147COL_FL_xx
+ *  \return           writer or NULL on error
+ */
+Z147COL_WRITER* Z147COL_Create( const char *name, const char *param,
+								u_int32 pageSamples, u_int32 flags )
+{
+	Z147COL_WRITER *wr;
+	u_int8 pad[Z147COL_HDR_SIZE];
+
+	if( pageSamples == 0 )
+		pageSamples = Z147COL_PAGE_SAMPLES;
+	if( pageSamples > 0x1000000 || (flags & ~Z147COL_FL_COMPRESS) ){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if( (wr = (Z147COL_WRITER*)calloc( 1, sizeof(*wr) )) == NULL )
+		return NULL;
+	memcpy( wr->hdr.magic, Z147COL_MAGIC, sizeof(Z147COL_MAGIC) );
+	wr->hdr.version     = Z147COL_VERSION;
+	wr->hdr.flags       = flags;
+	wr->hdr.pageSamples = pageSamples;
+	strncpy( wr->hdr.name, param, Z147COL_NAME_LEN - 1 );
+	wr->off = Z147COL_HDR_SIZE;
+
+	wr->ts  = (int64*)malloc( pageSamples * sizeof(int64) );
+	wr->val = (double*)malloc( pageSamples * sizeof(double) );
+	wr->buf = (u_int8*)malloc( Z147COL_MAX_PAGE( pageSamples ) );
+	if( wr->ts == NULL || wr->val == NULL || wr->buf == NULL ){
+		FreeWriter( wr );
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	/* header placeholder, written by Z147COL_Finish() */
+	if( (wr->fp = fopen( name, "wb" )) == NULL ){
+		FreeWriter( wr );
+		return NULL;
+	}
+	memset( pad, 0, sizeof(pad) );
+	if( fwrite( pad, sizeof(pad), 1, wr->fp ) != 1 ){
+		fclose( wr->fp );
+		FreeWriter( wr );
+		return NULL;
+	}
+	return wr;
+}
+
+/******************************* Z147COL_Append *****************************/
+/** Append samples in time order
+ *
+ *  \param wr         \IN  writer
+ *  \param ts         \IN  times (UTC ns)
+ *  \param val        \IN  values
+ *  \param num        \IN  samples
+ *  \return           0 or -1 on error
+ */
+int32 Z147COL_Append( Z147COL_WRITER *wr, const int64 *ts,
+					  const double *val, u_int32 num )
+{
+	u_int32 n;
+
+	while( num ){
+		n = wr->hdr.pageSamples - wr->num;
+		if( n > num )
+			n = num;
+		if( Summarize( wr, ts, val, n ) != 0 )
+			return -1;
+		memcpy( wr->ts + wr->num, ts, n * sizeof(int64) );
+		memcpy( wr->val + wr->num, val, n * sizeof(double) );
+		wr->num += n;
+		ts  += n;
+		val += n;
+		num -= n;
+		if( wr->num == wr->hdr.pageSamples && WritePage( wr ) != 0 )
+			return -1;
+	}
+	return 0;
+}
+
+/******************************* Z147COL_Finish *****************************/
+/** Write the last page, the zone map, the summaries and the header,
+ *  close the file and free the writer
+ *
+ *  \param wr         \IN  writer
+ *  \return           0 or -1 on error
+ */
+int32 Z147COL_Finish( Z147COL_WRITER *wr )
+{
+	static const u_int8 pad[8];
+	u_int32 fill, l, n;
+	int32 error = 0;
+	int err = 0;
+
+	if( wr->num && WritePage( wr ) != 0 )
+		error = -1;
+	for( l = 0; l < Z147COL_SUM_LEVELS && !error; l++ )
+		if( wr->cur[l].num && CloseSum( wr, l ) != 0 )
+			error = -1;
+
+	/* a summary of a few samples is no faster than its page */
+	for( l = 0; l + 1 < Z147COL_SUM_LEVELS &&
+			 (u_int64)wr->hdr.sumNum[l] * SUM_MIN_AVG > wr->hdr.samples; l++ )
+		wr->hdr.sumNum[l] = 0;
+
+	/* zone map 8 byte aligned, summaries follow */
+	fill = (u_int32)((8 - wr->off % 8) % 8);
+	wr->hdr.zoneOff = wr->off + fill;
+	wr->hdr.sumOff  = wr->hdr.zoneOff +
+		(u_int64)wr->hdr.pages * sizeof(Z147COL_ZONE);
+
+	if( !error &&
+		((fill && fwrite( pad, 1, fill, wr->fp ) != fill) ||
+		 (wr->hdr.pages &&
+		  fwrite( wr->zone, sizeof(Z147COL_ZONE), wr->hdr.pages, wr->fp ) !=
+		  wr->hdr.pages)) )
+		error = -1;
+	for( l = 0; l < Z147COL_SUM_LEVELS && !error; l++ ){
+		n = wr->hdr.sumNum[l];
+		if( n && fwrite( wr->sum[l], sizeof(Z147COL_SUM), n, wr->fp ) != n )
+			error = -1;
+	}
+	if( !error &&
+		(fseek( wr->fp, 0, SEEK_SET ) != 0 ||
+		 fwrite( &wr->hdr, sizeof(wr->hdr), 1, wr->fp ) != 1) )
+		error = -1;
+	if( error )
+		err = errno;
+
+	if( fclose( wr->fp ) != 0 && !error ){
+		err = errno;
+		error = -1;
+	}
+	wr->fp = NULL;
+	FreeWriter( wr );
+	if( error )
+		errno = err;
+	return error;
+}
+
+/******************************* Z147COL_Open *******************************/
+/** Map a column file
+ *
+ *  \param name       \IN  file name
+ *  \return           file or NULL on error
+ */
+Z147COL_FILE* Z147COL_Open( const char *name )
+{
+	Z147COL_FILE *col;
+	const Z147COL_HDR *hdr;
+	struct stat st;
+	void *base;
+	u_int64 end;
+	u_int32 i, l;
+	int fd, err;
+
+	if( (fd = open( name, O_RDONLY )) < 0 )
+		return NULL;
+	if( fstat( fd, &st ) != 0 ){
+		err = errno;
+		close( fd );
+		errno = err;
+		return NULL;
+	}
+	if( st.st_size < Z147COL_HDR_SIZE ){
+		close( fd );
+		errno = EINVAL;
+		return NULL;
+	}
+	base = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	err = errno;
+	close( fd );
+	if( base == MAP_FAILED ){
+		errno = err;
+		return NULL;
+	}
+	/* queries jump to their pages, don't read ahead */
+	madvise( base, (size_t)st.st_size, MADV_RANDOM );
+
+	hdr = (const Z147COL_HDR*)base;
+	end = hdr->zoneOff + (u_int64)hdr->pages * sizeof(Z147COL_ZONE);
+	if( hdr->sumOff ){
+		if( hdr->sumOff != end )
+			end = 0;
+		for( l = 0; l < Z147COL_SUM_LEVELS; l++ )
+			end += (u_int64)hdr->sumNum[l] * sizeof(Z147COL_SUM);
+	}
+	if( memcmp( hdr->magic, Z147COL_MAGIC, sizeof(Z147COL_MAGIC) ) != 0 ||
+		hdr->version != Z147COL_VERSION || hdr->pageSamples == 0 ||
+		hdr->zoneOff < Z147COL_HDR_SIZE || hdr->zoneOff % 8 ||
+		end != (u_int64)st.st_size ){
+		munmap( base, (size_t)st.st_size );
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if( (col = (Z147COL_FILE*)calloc( 1, sizeof(*col) )) == NULL ){
+		munmap( base, (size_t)st.st_size );
+		return NULL;
+	}
+	col->base = (const u_int8*)base;
+	col->size = (size_t)st.st_size;
+	col->hdr  = hdr;
+	col->zone = (const Z147COL_ZONE*)(col->base + hdr->zoneOff);
+	if( hdr->sumOff ){
+		col->sum[0] = (const Z147COL_SUM*)(col->base + hdr->sumOff);
+		for( l = 1; l < Z147COL_SUM_LEVELS; l++ )
+			col->sum[l] = col->sum[l - 1] + hdr->sumNum[l - 1];
+	}
+
+	for( i = 0; i < hdr->pages; i++ )
+		if( col->zone[i].off + col->zone[i].size > hdr->zoneOff ||
+			col->zone[i].num > hdr->pageSamples ){
+			Z147COL_Close( col );
+			errno = EINVAL;
+			return NULL;
+		}
+	return col;
+}
+
+/******************************* Z147COL_Close ******************************/
+/** Unmap a column file
+ *
+ *  \param col        \IN  file
+ */
+void Z147COL_Close( Z147COL_FILE *col )
+{
+	if( col == NULL )
+		return;
+	munmap( (void*)col->base, col->size );
+	free( col );
+}
+
+/******************************* Z147COL_Seek *******************************/
+/** First page with samples at or after a time
+ *
+ *  Binary search over the zone map.
+ *
+ *  \param col        \IN  file
+ *  \param tsNs       \IN  time
+ *  \return           page index, hdr->pages if none
+ */
+u_int32 Z147COL_Seek( const Z147COL_FILE *col, int64 tsNs )
+{
+	u_int32 lo = 0, hi = col->hdr->pages, mid;
+
+	while( lo < hi ){
+		mid = lo + (hi - lo) / 2;
+		if( col->zone[mid].lastNs < tsNs )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/******************************* Z147COL_Page *******************************/
+/** Decode a page
+ *
+ *  \param col        \IN  file
+ *  \param page       \IN  page index
+ *  \param ts         \OUT times (hdr->pageSamples)
+ *  \param val        \OUT values (hdr->pageSamples)
+ *  \return           samples or -1 on error
+ */
+int32 Z147COL_Page( Z147COL_FILE *col, u_int32 page, int64 *ts,
+					double *val )
+{
+	const Z147COL_ZONE *z;
+	const u_int8 *p;
+
+	if( page >= col->hdr->pages ){
+		errno = EINVAL;
+		return -1;
+	}
+	z = &col->zone[page];
+	p = col->base + z->off;
+	col->pagesRead++;
+
+	if( col->hdr->flags & Z147COL_FL_COMPRESS )
+		return DecodePage( p, z->size, z->num, ts, val );
+
+	if( z->size != z->num * (sizeof(int64) + sizeof(double)) ){
+		errno = EINVAL;
+		return -1;
+	}
+	memcpy( ts, p, z->num * sizeof(int64) );
+	memcpy( val, p + z->num * sizeof(int64), z->num * sizeof(double) );
+	return (int32)z->num;
+}
+
+/******************************* Z147COL_Query ******************************/
+/** Visit the samples of a time and value range
+ *
+ *  Pages whose zone is outside of both ranges are not read.
+ *
+ *  \param col        \IN  file
+ *  \param fromNs     \IN  first time
+ *  \param toNs       \IN  last time
+ *  \param min        \IN  smallest value
+ *  \param max        \IN  largest value
+ *  \param visit      \IN  called for every sample in the ranges
+ *  \param arg        \IN  argument of visit
+ *  \return           visited samples or -1 on error
+ */
+int64 Z147COL_Query( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+					 double min, double max, Z147COL_VISIT visit,
+					 void *arg )
+{
+	const Z147COL_ZONE *z;
+	u_int32 page;
+	int64 *ts, count = 0;
+	double *val;
+	int32 n, i;
+
+	ts  = (int64*)malloc( col->hdr->pageSamples * sizeof(int64) );
+	val = (double*)malloc( col->hdr->pageSamples * sizeof(double) );
+	if( ts == NULL || val == NULL ){
+		free( ts );
+		free( val );
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for( page = Z147COL_Seek( col, fromNs ); page < col->hdr->pages;
+		 page++ ){
+		z = &col->zone[page];
+		if( z->firstNs > toNs )
+			break;
+		if( z->max < min || z->min > max )
+			continue;
+		if( (n = Z147COL_Page( col, page, ts, val )) < 0 ){
+			count = -1;
+			break;
+		}
+		for( i = 0; i < n; i++ ){
+			if( ts[i] < fromNs || ts[i] > toNs ||
+				val[i] < min || val[i] > max )
+				continue;
+			count++;
+			if( visit && visit( arg, ts[i], val[i] ) != 0 ){
+				page = col->hdr->pages;
+				break;
+			}
+		}
+	}
+
+	free( ts );
+	free( val );
+	return count;
+}
+
+/******************************* Z147COL_Aggregate **************************/
+/** Count, min, max and sum of the samples of a time window
+ *
+ *  The whole seconds, minutes and hours of the window come from the
+ *  summaries, only the partial seconds (or the intervals of the finest
+ *  level written) at its edges are decoded.
+ *
+ *  \param col        \IN  file
+ *  \param fromNs     \IN  first time
+ *  \param toNs       \IN  last time
+ *  \param agg        \OUT aggregate (num 0: no samples, min/max undefined)
+ *  \return           0 or -1 on error
+ */
+int32 Z147COL_Aggregate( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+						 Z147COL_AGG *agg )
+{
+	int64 period, first, end;
+	u_int32 l;
+
+	memset( agg, 0, sizeof(*agg) );
+	if( col->hdr->samples == 0 )
+		return 0;
+	if( fromNs < col->hdr->firstNs )
+		fromNs = col->hdr->firstNs;
+	if( toNs > col->hdr->lastNs )
+		toNs = col->hdr->lastNs;
+	if( fromNs > toNs )
+		return 0;
+	/* finest level written */
+	for( l = 0; l < Z147COL_SUM_LEVELS && col->sum[l] != NULL &&
+			 col->hdr->sumNum[l] == 0; l++ )
+		;
+	if( l == Z147COL_SUM_LEVELS || col->sum[l] == NULL )
+		return AggRaw( col, fromNs, toNs, agg );
+
+	/* whole intervals [first, end) */
+	period = Z147COL_SUM_NS(l);
+	first  = -Floor( -fromNs, period );
+	end    = Floor( toNs + 1, period );
+	if( first >= end )
+		return AggRaw( col, fromNs, toNs, agg );
+
+	if( (fromNs < first && AggRaw( col, fromNs, first - 1, agg ) != 0) ||
+		(end <= toNs && AggRaw( col, end, toNs, agg ) != 0) )
+		return -1;
+	AggLevel( col, l, first, end, agg );
+	return 0;
+}
+
+/**********************************************************************/
+/** Add the intervals of level l within [fromNs, toNs)
+ *
+ *  Both ends are multiples of the level interval. The part made of whole
+ *  intervals of the next level is taken from there.
+ */
+static void AggLevel( Z147COL_FILE *col, u_int32 l, int64 fromNs,
+					  int64 toNs, Z147COL_AGG *agg )
+{
+	int64 period, first, end;
+
+	if( l + 1 < Z147COL_SUM_LEVELS ){
+		period = Z147COL_SUM_NS(l + 1);
+		first  = -Floor( -fromNs, period );
+		end    = Floor( toNs, period );
+		if( first < end ){
+			AggSums( col, l, fromNs, first, agg );
+			AggLevel( col, l + 1, first, end, agg );
+			AggSums( col, l, end, toNs, agg );
+			return;
+		}
+	}
+	AggSums( col, l, fromNs, toNs, agg );
+}
+
+/**********************************************************************/
+/** Add the summaries of level l starting in [fromNs, toNs) */
+static void AggSums( Z147COL_FILE *col, u_int32 l, int64 fromNs,
+					 int64 toNs, Z147COL_AGG *agg )
+{
+	const Z147COL_SUM *s = col->sum[l];
+	u_int32 lo = 0, hi = col->hdr->sumNum[l], mid;
+
+	while( lo < hi ){
+		mid = lo + (hi - lo) / 2;
+		if( s[mid].startNs < fromNs )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for( ; lo < col->hdr->sumNum[l] && s[lo].startNs < toNs; lo++ ){
+		if( agg->num == 0 || s[lo].min < agg->min )
+			agg->min = s[lo].min;
+		if( agg->num == 0 || s[lo].max > agg->max )
+			agg->max = s[lo].max;
+		agg->num += s[lo].num;
+		agg->sum += s[lo].sum;
+		col->sumsRead++;
+	}
+}
+
+/**********************************************************************/
+/** Add the samples of [fromNs, toNs] from the pages */
+static int32 AggRaw( Z147COL_FILE *col, int64 fromNs, int64 toNs,
+					 Z147COL_AGG *agg )
+{
+	return Z147COL_Query( col, fromNs, toNs, -DBL_MAX, DBL_MAX, AggVisit,
+						  agg ) < 0 ? -1 : 0;
+}
+
+/**********************************************************************/
+/** Add a sample to an aggregate */
+static int32 AggVisit( void *arg, int64 tsNs, double value )
+{
+	Z147COL_AGG *agg = (Z147COL_AGG*)arg;
+
+	if( agg->num == 0 || value < agg->min )
+		agg->min = value;
+	if( agg->num == 0 || value > agg->max )
+		agg->max = value;
+	agg->num++;
+	agg->sum += value;
+	return 0;
+}
+
+/**********************************************************************/
+/** Start of the interval of length period containing t */
+static int64 Floor( int64 t, int64 period )
+{
+	int64 q = t / period;
+
+	if( t % period < 0 )
+		q--;
+	return q * period;
+}
+
+/**********************************************************************/
+/** Add samples to the second summaries */
+static int32 Summarize( Z147COL_WRITER *wr, const int64 *ts,
+						const double *val, u_int32 n )
+{
+	Z147COL_SUM *s = &wr->cur[0];
+	const int64 sec = Z147COL_SUM_NS(0);
+	u_int32 i;
+
+	for( i = 0; i < n; i++ ){
+		/* a sample out of order stays in the open second */
+		if( s->num && ts[i] - s->startNs >= sec && CloseSum( wr, 0 ) != 0 )
+			return -1;
+		AddSum( s, Floor( ts[i], sec ), 1, val[i], val[i], val[i] );
+	}
+	return 0;
+}
+
+/**********************************************************************/
+/** Store the open interval of level l and merge it into the next level */
+static int32 CloseSum( Z147COL_WRITER *wr, u_int32 l )
+{
+	Z147COL_SUM *s = &wr->cur[l], *next, *p;
+	int64 start;
+
+	if( wr->hdr.sumNum[l] == wr->sumMax[l] ){
+		p = (Z147COL_SUM*)realloc( wr->sum[l], (wr->sumMax[l] + SUM_GROW) *
+								   sizeof(Z147COL_SUM) );
+		if( p == NULL )
+			return -1;
+		wr->sum[l] = p;
+		wr->sumMax[l] += SUM_GROW;
+	}
+	wr->sum[l][wr->hdr.sumNum[l]++] = *s;
+
+	if( l + 1 < Z147COL_SUM_LEVELS ){
+		next  = &wr->cur[l + 1];
+		start = Floor( s->startNs, Z147COL_SUM_NS(l + 1) );
+		if( next->num && next->startNs != start && CloseSum( wr, l + 1 ) != 0 )
+			return -1;
+		AddSum( next, start, s->num, s->min, s->max, s->sum );
+	}
+	memset( s, 0, sizeof(*s) );
+	return 0;
+}
+
+/**********************************************************************/
+/** Add to an open interval */
+static void AddSum( Z147COL_SUM *s, int64 startNs, u_int32 num, double min,
+					double max, double sum )
+{
+	if( s->num == 0 ){
+		s->startNs = startNs;
+		s->min     = min;
+		s->max     = max;
+	}
+	if( min < s->min )
+		s->min = min;
+	if( max > s->max )
+		s->max = max;
+	s->num += num;
+	s->sum += sum;
+}
+
+/**********************************************************************/
+/** Code the collected page, write it and add its zone */
+static int32 WritePage( Z147COL_WRITER *wr )
+{
+	Z147COL_ZONE *z, *p;
+	u_int32 i, size;
+
+	if( wr->hdr.pages == wr->zoneMax ){
+		p = (Z147COL_ZONE*)realloc( wr->zone, (wr->zoneMax + ZONE_GROW) *
+									sizeof(Z147COL_ZONE) );
+		if( p == NULL )
+			return -1;
+		wr->zone = p;
+		wr->zoneMax += ZONE_GROW;
+	}
+
+	z = &wr->zone[wr->hdr.pages];
+	z->firstNs = wr->ts[0];
+	z->lastNs  = wr->ts[wr->num - 1];
+	z->min     = wr->val[0];
+	z->max     = wr->val[0];
+	for( i = 1; i < wr->num; i++ ){
+		if( wr->val[i] < z->min )
+			z->min = wr->val[i];
+		if( wr->val[i] > z->max )
+			z->max = wr->val[i];
+	}
+
+	if( wr->hdr.flags & Z147COL_FL_COMPRESS ){
+		size = EncodePage( wr->ts, wr->val, wr->num, wr->buf );
+	}else{
+		size = wr->num * (u_int32)(sizeof(int64) + sizeof(double));
+		memcpy( wr->buf, wr->ts, wr->num * sizeof(int64) );
+		memcpy( wr->buf + wr->num * sizeof(int64), wr->val,
+				wr->num * sizeof(double) );
+	}
+	if( fwrite( wr->buf, 1, size, wr->fp ) != size )
+		return -1;
+
+	z->off  = wr->off;
+	z->size = size;
+	z->num  = wr->num;
+
+	if( wr->hdr.pages == 0 ){
+		wr->hdr.firstNs = z->firstNs;
+		wr->hdr.min     = z->min;
+		wr->hdr.max     = z->max;
+	}
+	wr->hdr.lastNs = z->lastNs;
+	if( z->min < wr->hdr.min )
+		wr->hdr.min = z->min;
+	if( z->max > wr->hdr.max )
+		wr->hdr.max = z->max;
+	wr->hdr.pages++;
+	wr->hdr.samples  += wr->num;
+	wr->hdr.rawBytes += wr->num * (sizeof(int64) + sizeof(double));
+	wr->off += size;
+	wr->num  = 0;
+	return 0;
+}
+
+/**********************************************************************/
+/** Code a page (format see z147_col.h)
+ *
+ *  \return           bytes, max. Z147COL_MAX_PAGE(n)
+ */
+static u_int32 EncodePage( const int64 *ts, const double *val, u_int32 n,
+						   u_int8 *out )
+{
+	u_int8 *p = out + 4;
+	u_int64 x, prev = 0;
+	int64 delta = 0, d, last = 0;
+	u_int32 i, run = 0, tsBytes, lz, tz, k;
+
+	/* times: delta of delta, runs of unchanged deltas */
+	for( i = 0; i < n; i++ ){
+		d = (int64)((u_int64)ts[i] - (u_int64)last);
+		last = ts[i];
+		if( d == delta && i ){
+			if( ++run == MAX_RUN ){
+				*p++ = (u_int8)(run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if( run ){
+			*p++ = (u_int8)(run - 1);
+			run = 0;
+		}
+		x = (u_int64)(d - delta);
+		*p++ = 0x80;
+		p += PutVar( p, (x << 1) ^ (u_int64)((int64)x >> 63) );
+		delta = d;
+	}
+	if( run )
+		*p++ = (u_int8)(run - 1);
+	tsBytes = (u_int32)(p - out - 4);
+	memcpy( out, &tsBytes, 4 );
+
+	/* values: XOR with the previous value, runs of unchanged values */
+	run = 0;
+	for( i = 0; i < n; i++ ){
+		memcpy( &x, &val[i], 8 );
+		x ^= prev;
+		prev ^= x;
+		if( x == 0 ){
+			if( ++run == MAX_RUN ){
+				*p++ = (u_int8)(run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if( run ){
+			*p++ = (u_int8)(run - 1);
+			run = 0;
+		}
+		lz = (u_int32)__builtin_clzll( x ) / 8;
+		tz = (u_int32)__builtin_ctzll( x ) / 8;
+		*p++ = (u_int8)(0x80 | lz << 3 | tz);
+		for( k = tz; k < 8 - lz; k++ )
+			*p++ = (u_int8)(x >> (8 * k));
+	}
+	if( run )
+		*p++ = (u_int8)(run - 1);
+	return (u_int32)(p - out);
+}
+
+/**********************************************************************/
+/** Decode a compressed page
+ *
+ *  \return           samples or -1 on a corrupt page
+ */
+static int32 DecodePage( const u_int8 *in, u_int32 size, u_int32 n,
+						 int64 *ts, double *val )
+{
+	const u_int8 *p = in + 4, *end = in + size, *tsEnd;
+	u_int64 x, prev = 0;
+	int64 delta = 0, last = 0;
+	u_int32 i = 0, tsBytes, c, lz, tz, k, len;
+
+	if( size < 4 )
+		goto CORRUPT;
+	memcpy( &tsBytes, in, 4 );
+	if( tsBytes > size - 4 )
+		goto CORRUPT;
+	tsEnd = p + tsBytes;
+
+	while( i < n ){
+		if( p >= tsEnd )
+			goto CORRUPT;
+		c = *p++;
+		if( c < 0x80 ){
+			for( c++; c && i < n; c--, i++ )
+				ts[i] = last = last + delta;
+			if( c )
+				goto CORRUPT;
+			continue;
+		}
+		if( c != 0x80 || (len = GetVar( p, tsEnd, &x )) == 0 )
+			goto CORRUPT;
+		p += len;
+		delta += (int64)((x >> 1) ^ (0 - (x & 1)));
+		ts[i++] = last = last + delta;
+	}
+	if( p != tsEnd )
+		goto CORRUPT;
+
+	for( i = 0; i < n; ){
+		if( p >= end )
+			goto CORRUPT;
+		c = *p++;
+		if( c < 0x80 ){
+			for( c++; c && i < n; c--, i++ )
+				memcpy( &val[i], &prev, 8 );
+			if( c )
+				goto CORRUPT;
+			continue;
+		}
+		lz = (c >> 3) & 7;
+		tz = c & 7;
+		if( c > 0xbf || lz + tz > 7 || p + (8 - lz - tz) > end )
+			goto CORRUPT;
+		for( x = 0, k = tz; k < 8 - lz; k++ )
+			x |= (u_int64)*p++ << (8 * k);
+		prev ^= x;
+		memcpy( &val[i++], &prev, 8 );
+	}
+	if( p != end )
+		goto CORRUPT;
+	return (int32)n;
+
+CORRUPT:
+	errno = EINVAL;
+	return -1;
+}
+
+/**********************************************************************/
+/** LEB128 coding, 7 bits per byte, lsb first */
+static u_int32 PutVar( u_int8 *p, u_int64 v )
+{
+	u_int32 n = 0;
+
+	while( v >= 0x80 ){
+		p[n++] = (u_int8)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (u_int8)v;
+	return n;
+}
+
+/**********************************************************************/
+/** LEB128 decoding
+ *
+ *  \return           bytes used or 0 on error
+ */
+static u_int32 GetVar( const u_int8 *p, const u_int8 *end, u_int64 *v )
+{
+	u_int32 n = 0, shift = 0;
+
+	*v = 0;
+	while( p + n < end && shift < 64 ){
+		*v |= (u_int64)(p[n] & 0x7f) << shift;
+		shift += 7;
+		if( !(p[n++] & 0x80) )
+			return n;
+	}
+	return 0;
+}
+
+/**********************************************************************/
+/** Free the writer */
+static void FreeWriter( Z147COL_WRITER *wr )
+{
+	u_int32 l;
+
+	free( wr->ts );
+	free( wr->val );
+	free( wr->buf );
+	free( wr->zone );
+	for( l = 0; l < Z147COL_SUM_LEVELS; l++ )
+		free( wr->sum[l] );
+	free( wr );
+}
@@ -0,0 +1,23 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile descriptor file for the Z147 indexed frame file
+#                 library
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: library.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_frm
+
+MAK_INCL=$(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/z147_frm.h	\
+
+MAK_INP1=z147_frm$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1)
@@ -0,0 +1,499 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_frm.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Reader and writer of indexed Z147 frame files
+ *
+ *               Format see z147_frm.h. The writer appends fixed size
+ *               frames with buffered I/O and collects the time and
+ *               superframe index in memory, Z147FRM_Finish() appends them
+ *               with the trailer. The reader maps the whole file and only
+ *               touches the pages it needs.
+ *
+ *               Functions return -1 or NULL on error with errno set
+ *               (EINVAL: not a frame file).
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_frm.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_frm.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define IDX_GROW        1024            /**< index entries per realloc */
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** writer state */
+struct Z147FRM_WRITER {
+	FILE            *fp;            /**< output file */
+	Z147FRM_HDR     hdr;            /**< file header */
+	u_int32         frames;         /**< frames written */
+	u_int32         tIdxStep;       /**< frames per time index entry */
+	int64           lastKey;        /**< last time index key */
+	int64           firstNs;        /**< time of the first frame */
+	int64           lastNs;         /**< time of the last frame */
+	u_int32         sfShift;        /**< shift of hdr.sfMask */
+	u_int32         sfPrev;         /**< last counter (frame number) */
+	int             sfValid;        /**< sfPrev valid */
+	u_int32         sfErrNum;       /**< repeated counters */
+
+	Z147FRM_TIDX    *tIdx;          /**< time index */
+	u_int32         tIdxNum;
+	u_int32         tIdxMax;
+	Z147FRM_SFIDX   *sfIdx;         /**< superframe index */
+	u_int32         sfIdxNum;
+	u_int32         sfIdxMax;
+};
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static int32 Grow( void **arr, u_int32 num, u_int32 *max, size_t size );
+static int32 SfCounter( Z147FRM_WRITER *wr, const Z147FRM_FRAME *frm,
+						const u_int16 *data, u_int32 words, u_int32 *cntP );
+static void FreeWriter( Z147FRM_WRITER *wr );
+
+/******************************* Z147FRM_Create *****************************/
+/** Create a frame file
+ *
+ *  The caller fills rate, syncCfg, modeCfg, the superframe counter
+ *  location, createdNs and name of \a hdr, the other fields are set here.
+ *
+ *  \param name       \IN  file name (replaced if existing)
+ *  \param hdr        \IN  file header
+ *  \param tIdxStep   \IN  frames per time index entry (0 = default)
+ *  \return           writer or NULL on error
+ */
+Z147FRM_WRITER* Z147FRM_Create( const char *name, const Z147FRM_HDR *hdr,
+								u_int32 tIdxStep )
+{
+	Z147FRM_WRITER *wr;
+	u_int8 pad[Z147FRM_HDR_SIZE];
+
+	if( hdr->rate > 7 || hdr->sfSub > 4 ||
+		(hdr->sfSub && (hdr->sfWord == 0 || hdr->sfMask == 0 ||
+						hdr->sfWord >= (64u << hdr->rate))) ){
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if( (wr = (Z147FRM_WRITER*)calloc( 1, sizeof(*wr) )) == NULL )
+		return NULL;
+
+	wr->hdr = *hdr;
+	memcpy( wr->hdr.magic, Z147FRM_MAGIC, sizeof(Z147FRM_MAGIC) );
+	wr->hdr.version    = Z147FRM_VERSION;
+	wr->hdr.hdrSize    = Z147FRM_HDR_SIZE;
+	wr->hdr.recSize    = Z147FRM_REC_SIZE( hdr->rate );
+	wr->hdr.frameWords = Z147FRM_FRAME_WORDS( hdr->rate );
+	wr->hdr.name[Z147FRM_NAME_LEN-1] = '\0';
+	wr->tIdxStep = tIdxStep ? tIdxStep : Z147FRM_TIDX_STEP;
+	if( hdr->sfSub )
+		while( !(hdr->sfMask & (1u << wr->sfShift)) )
+			wr->sfShift++;
+
+	if( (wr->fp = fopen( name, "wb" )) == NULL ){
+		free( wr );
+		return NULL;
+	}
+
+	memset( pad, 0, sizeof(pad) );
+	memcpy( pad, &wr->hdr, sizeof(wr->hdr) );
+	if( fwrite( pad, sizeof(pad), 1, wr->fp ) != 1 ){
+		fclose( wr->fp );
+		free( wr );
+		return NULL;
+	}
+	return wr;
+}
+
+/******************************* Z147FRM_Append *****************************/
+/** Append a frame
+ *
+ *  Missing words are filled with 0 and the frame is marked
+ *  #Z147FRM_ST_SHORT, surplus words are dropped.
+ *
+ *  \param wr         \IN  writer
+ *  \param frm        \IN  frame header (time, seq, status, lost)
+ *  \param data       \IN  frame words as read by M_getblock()
+ *  \param words      \IN  number of words in \a data
+ *  \return           0 or -1 on error
+ */
+int32 Z147FRM_Append( Z147FRM_WRITER *wr, const Z147FRM_FRAME *frm,
+					  const u_int16 *data, u_int32 words )
+{
+	static const u_int16 zero[256];
+	Z147FRM_FRAME fh = *frm;
+	u_int32 n, fill, cnt;
+	int64 key;
+
+	if( words < wr->hdr.frameWords )
+		fh.status |= Z147FRM_ST_SHORT;
+	else
+		words = wr->hdr.frameWords;
+
+	/* time index: keys must not go backwards for the binary search */
+	if( wr->frames % wr->tIdxStep == 0 ){
+		if( Grow( (void**)&wr->tIdx, wr->tIdxNum, &wr->tIdxMax,
+				  sizeof(Z147FRM_TIDX) ) != 0 )
+			return -1;
+		key = wr->tIdxNum && fh.tsNs < wr->lastKey ? wr->lastKey : fh.tsNs;
+		wr->tIdx[wr->tIdxNum].tsNs     = key;
+		wr->tIdx[wr->tIdxNum].frame    = wr->frames;
+		wr->tIdx[wr->tIdxNum].reserved = 0;
+		wr->tIdxNum++;
+		wr->lastKey = key;
+	}
+
+	/* superframe index: first frame and every counter wrap */
+	if( SfCounter( wr, &fh, data, words, &cnt ) ){
+		if( Grow( (void**)&wr->sfIdx, wr->sfIdxNum, &wr->sfIdxMax,
+				  sizeof(Z147FRM_SFIDX) ) != 0 )
+			return -1;
+		wr->sfIdx[wr->sfIdxNum].frame   = wr->frames;
+		wr->sfIdx[wr->sfIdxNum].counter = cnt;
+		wr->sfIdxNum++;
+	}
+
+	if( fwrite( &fh, sizeof(fh), 1, wr->fp ) != 1 ||
+		(words && fwrite( data, 2, words, wr->fp ) != words) )
+		return -1;
+	for( n = wr->hdr.frameWords - words; n; n -= fill ){
+		fill = n < 256 ? n : 256;
+		if( fwrite( zero, 2, fill, wr->fp ) != fill )
+			return -1;
+	}
+
+	if( wr->frames == 0 )
+		wr->firstNs = fh.tsNs;
+	wr->lastNs = fh.tsNs;
+	wr->frames++;
+	return 0;
+}
+
+/******************************* Z147FRM_Finish *****************************/
+/** Write the index footer, close the file and free the writer
+ *
+ *  \param wr         \IN  writer
+ *  \return           0 or -1 on error
+ */
+int32 Z147FRM_Finish( Z147FRM_WRITER *wr )
+{
+	Z147FRM_TRAILER trl;
+	int32 error = 0;
+
+	memset( &trl, 0, sizeof(trl) );
+	memcpy( trl.magic, Z147FRM_IDX_MAGIC, sizeof(Z147FRM_IDX_MAGIC) );
+	trl.frames   = wr->frames;
+	trl.tIdxStep = wr->tIdxStep;
+	trl.tIdxOff  = (int64)wr->hdr.hdrSize +
+				   (int64)wr->frames * wr->hdr.recSize;
+	trl.tIdxNum  = wr->tIdxNum;
+	trl.sfIdxOff = trl.tIdxOff + (int64)wr->tIdxNum * sizeof(Z147FRM_TIDX);
+	trl.sfIdxNum = wr->sfIdxNum;
+	trl.firstNs  = wr->firstNs;
+	trl.lastNs   = wr->lastNs;
+	trl.sfErrNum = wr->sfErrNum;
+
+	if( (wr->tIdxNum &&
+		 fwrite( wr->tIdx, sizeof(Z147FRM_TIDX), wr->tIdxNum, wr->fp ) !=
+		 wr->tIdxNum) ||
+		(wr->sfIdxNum &&
+		 fwrite( wr->sfIdx, sizeof(Z147FRM_SFIDX), wr->sfIdxNum, wr->fp ) !=
+		 wr->sfIdxNum) ||
+		fwrite( &trl, sizeof(trl), 1, wr->fp ) != 1 )
+		error = -1;
+
+	if( fclose( wr->fp ) != 0 )
+		error = -1;
+	wr->fp = NULL;
+	FreeWriter( wr );
+	return error;
+}
+
+/******************************* Z147FRM_Open *******************************/
+/** Map a frame file
+ *
+ *  \param name       \IN  file name
+ *  \return           file or NULL on error
+ */
+Z147FRM_FILE* Z147FRM_Open( const char *name )
+{
+	Z147FRM_FILE *fp;
+	const Z147FRM_HDR *hdr;
+	const Z147FRM_TRAILER *trl;
+	struct stat st;
+	void *base;
+	int64 end;
+	int fd, err;
+
+	if( (fd = open( name, O_RDONLY )) < 0 )
+		return NULL;
+	if( fstat( fd, &st ) != 0 ){
+		err = errno;
+		close( fd );
+		errno = err;
+		return NULL;
+	}
+	if( st.st_size < Z147FRM_HDR_SIZE ){
+		close( fd );
+		errno = EINVAL;
+		return NULL;
+	}
+	base = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	err = errno;
+	close( fd );
+	if( base == MAP_FAILED ){
+		errno = err;
+		return NULL;
+	}
+	/* accesses jump around, don't read ahead */
+	madvise( base, (size_t)st.st_size, MADV_RANDOM );
+
+	hdr = (const Z147FRM_HDR*)base;
+	if( memcmp( hdr->magic, Z147FRM_MAGIC, sizeof(Z147FRM_MAGIC) ) != 0 ||
+		hdr->version != Z147FRM_VERSION || hdr->rate > 7 ||
+		hdr->hdrSize < sizeof(Z147FRM_HDR) ||
+		hdr->hdrSize > (u_int64)st.st_size ||
+		hdr->recSize != Z147FRM_REC_SIZE( hdr->rate ) ||
+		hdr->frameWords != Z147FRM_FRAME_WORDS( hdr->rate ) ){
+		munmap( base, (size_t)st.st_size );
+		errno = EINVAL;
+		return NULL;
+	}
+
+	if( (fp = (Z147FRM_FILE*)calloc( 1, sizeof(*fp) )) == NULL ){
+		munmap( base, (size_t)st.st_size );
+		return NULL;
+	}
+	fp->base = (const u_int8*)base;
+	fp->size = (size_t)st.st_size;
+	fp->hdr  = hdr;
+
+	/* finished file: take frames and index from the trailer */
+	end = (int64)st.st_size - (int64)sizeof(Z147FRM_TRAILER);
+	trl = (const Z147FRM_TRAILER*)(fp->base + end);
+	if( end >= hdr->hdrSize &&
+		memcmp( trl->magic, Z147FRM_IDX_MAGIC,
+				sizeof(Z147FRM_IDX_MAGIC) ) == 0 &&
+		trl->tIdxOff == hdr->hdrSize + (int64)trl->frames * hdr->recSize &&
+		trl->sfIdxOff == trl->tIdxOff +
+						 (int64)trl->tIdxNum * sizeof(Z147FRM_TIDX) &&
+		trl->sfIdxOff + (int64)trl->sfIdxNum * sizeof(Z147FRM_SFIDX) == end ){
+		fp->frames   = trl->frames;
+		fp->tIdxNum  = trl->tIdxNum;
+		fp->sfIdxNum = trl->sfIdxNum;
+		fp->sfErrNum = trl->sfErrNum;
+		if( fp->tIdxNum )
+			fp->tIdx = (const Z147FRM_TIDX*)(fp->base + trl->tIdxOff);
+		if( fp->sfIdxNum )
+			fp->sfIdx = (const Z147FRM_SFIDX*)(fp->base + trl->sfIdxOff);
+	}else{
+		/* not finished: all complete frames, no index */
+		fp->frames = (u_int32)((fp->size - hdr->hdrSize) / hdr->recSize);
+	}
+	return fp;
+}
+
+/******************************* Z147FRM_Close ******************************/
+/** Unmap a frame file
+ *
+ *  \param fp         \IN  file
+ */
+void Z147FRM_Close( Z147FRM_FILE *fp )
+{
+	if( fp == NULL )
+		return;
+	munmap( (void*)fp->base, fp->size );
+	free( fp );
+}
+
+/******************************* Z147FRM_Frame ******************************/
+/** Get a frame
+ *
+ *  \param fp         \IN  file
+ *  \param idx        \IN  frame index
+ *  \return           frame header (words see Z147FRM_DATA()) or NULL
+ */
+const Z147FRM_FRAME* Z147FRM_Frame( const Z147FRM_FILE *fp, u_int32 idx )
+{
+	if( idx >= fp->frames )
+		return NULL;
+	return (const Z147FRM_FRAME*)(fp->base + fp->hdr->hdrSize +
+								  (size_t)idx * fp->hdr->recSize);
+}
+
+/******************************* Z147FRM_SeekTime ***************************/
+/** Find the first frame received at or after a time
+ *
+ *  \param fp         \IN  file
+ *  \param tsNs       \IN  time (UTC, ns since 1970)
+ *  \return           frame index, number of frames if none
+ */
+u_int32 Z147FRM_SeekTime( const Z147FRM_FILE *fp, int64 tsNs )
+{
+	u_int32 lo = 0, hi = fp->frames, mid, k, n;
+
+	/* narrow the range with the time index */
+	if( fp->tIdx ){
+		k = 0;
+		n = fp->tIdxNum;
+		while( k < n ){
+			mid = k + (n - k) / 2;
+			if( fp->tIdx[mid].tsNs < tsNs )
+				k = mid + 1;
+			else
+				n = mid;
+		}
+		if( k > 0 )
+			lo = fp->tIdx[k-1].frame;
+		if( k < fp->tIdxNum )
+			hi = fp->tIdx[k].frame;
+	}
+
+	/* then the frames in the range */
+	while( lo < hi ){
+		mid = lo + (hi - lo) / 2;
+		if( Z147FRM_Frame( fp, mid )->tsNs < tsNs )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/******************************* Z147FRM_SeekSuperframe *********************/
+/** Find the first frame of a superframe
+ *
+ *  Superframe 0 starts with the first frame of the file and may be
+ *  incomplete (see Z147FRM_SFIDX.counter).
+ *
+ *  \param fp         \IN  file
+ *  \param sf         \IN  superframe number in the file
+ *  \return           frame index or -1 (no such superframe or no index)
+ */
+int32 Z147FRM_SeekSuperframe( const Z147FRM_FILE *fp, u_int32 sf )
+{
+	if( fp->sfIdx == NULL || sf >= fp->sfIdxNum ){
+		errno = ENOENT;
+		return -1;
+	}
+	return (int32)fp->sfIdx[sf].frame;
+}
+
+/******************************* Z147FRM_Superframe *************************/
+/** Get the superframe of a frame
+ *
+ *  \param fp         \IN  file
+ *  \param idx        \IN  frame index
+ *  \return           superframe number or -1 (no such frame or no index)
+ */
+int32 Z147FRM_Superframe( const Z147FRM_FILE *fp, u_int32 idx )
+{
+	u_int32 lo = 0, hi, mid;
+
+	if( fp->sfIdx == NULL || idx >= fp->frames ){
+		errno = ENOENT;
+		return -1;
+	}
+
+	/* last entry starting at or before idx */
+	hi = fp->sfIdxNum;
+	while( lo < hi ){
+		mid = lo + (hi - lo) / 2;
+		if( fp->sfIdx[mid].frame <= idx )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (int32)lo - 1;
+}
+
+/**********************************************************************/
+/** Make room for one more index entry */
+static int32 Grow( void **arr, u_int32 num, u_int32 *max, size_t size )
+{
+	void *p;
+
+	if( num < *max )
+		return 0;
+	if( (p = realloc( *arr, (size_t)(*max + IDX_GROW) * size )) == NULL )
+		return -1;
+	*arr = p;
+	*max += IDX_GROW;
+	return 0;
+}
+
+/**********************************************************************/
+/** Superframe counter of a frame
+ *
+ *  Without counter word (sfSub = 0) a superframe is 16 frame numbers.
+ *  Frames out of sync don't start a superframe, their counter is garbage.
+ *  Only a counter going backwards is a wrap; a repeated counter is
+ *  counted as an error.
+ *
+ *  \return           1 if the frame starts a superframe
+ */
+static int32 SfCounter( Z147FRM_WRITER *wr, const Z147FRM_FRAME *frm,
+						const u_int16 *data, u_int32 words, u_int32 *cntP )
+{
+	u_int32 pos, cnt;
+	int32 start;
+
+	if( wr->hdr.sfSub == 0 ){
+		/* sfPrev holds the last frame number here */
+		cnt = frm->seq % Z147FRM_SF_FRAMES;
+		start = wr->frames == 0 ||
+				frm->seq / Z147FRM_SF_FRAMES !=
+				wr->sfPrev / Z147FRM_SF_FRAMES;
+		wr->sfPrev  = frm->seq;
+		wr->sfValid = 1;
+		*cntP = cnt;
+		return start;
+	}
+
+	pos = (wr->hdr.sfSub - 1) * (64u << wr->hdr.rate) + wr->hdr.sfWord;
+	if( pos >= words || !(frm->status & Z147FRM_ST_INSYNC) ){
+		*cntP = 0;
+		return wr->frames == 0;
+	}
+
+	cnt = (data[pos] & wr->hdr.sfMask) >> wr->sfShift;
+	if( wr->sfValid && cnt == wr->sfPrev )
+		wr->sfErrNum++;
+	start = wr->frames == 0 || (wr->sfValid && cnt < wr->sfPrev);
+	wr->sfPrev  = cnt;
+	wr->sfValid = 1;
+	*cntP = cnt;
+	return start;
+}
+
+/**********************************************************************/
+/** Free the writer */
+static void FreeWriter( Z147FRM_WRITER *wr )
+{
+	free( wr->tIdx );
+	free( wr->sfIdx );
+	free( wr );
+}
@@ -0,0 +1,25 @@
+#***************************  M a k e f i l e  *******************************
+#
+#         Author: ap
+#
+#    Description: Makefile descriptor file for the Z147 frame map
+#                 library
+#
+#---------------------------------[ History ]---------------------------------
+#
+#   $Log: library.mak,v $
+#
+#-----------------------------------------------------------------------------
+#   (c) Copyright 2016 by MEN mikro elektronik GmbH, Nuernberg, Germany
+#*****************************************************************************
+
+MAK_NAME=z147_map
+
+MAK_INCL=$(MEN_INC_DIR)/men_typs.h	\
+         $(MEN_INC_DIR)/z147_map.h	\
+
+MAK_INP1=z147_map$(INP_SUFFIX)
+MAK_INP2=z147_map_conv$(INP_SUFFIX)
+
+MAK_INP=$(MAK_INP1) \
+        $(MAK_INP2)
@@ -0,0 +1,775 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_map.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Z147 frame map compiler and parameter decoder
+ *
+ *               Map format see z147_map.h. The compiler parses the map
+ *               into a Z147MAP_PARAM table, Z147MAP_Build() expands it to
+ *               one instruction per parameter and subframe and sorts the
+ *               instructions by encoding and word offset. The decoder runs
+ *               one tight loop per encoding group. Instructions with a
+ *               value table (Z147MAP_LutBuild()) form a group of their own.
+ *
+ *               Functions return -1 or NULL on error with errno set
+ *               (EINVAL: syntax or layout error).
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_map.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_map.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define LINE_MAX_LEN    256             /**< max. map line length */
+#define MAX_TOKENS      16              /**< max. tokens per line */
+#define PARAM_GROW      256             /**< params per realloc */
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static const char *G_encName[Z147MAP_ENC_NUM] = {
+	"BNR", "BCD", "DIS", "PACK" };
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static int32 ParseParam( char **tok, int32 n, Z147MAP_PARAM *p );
+static int32 ParseRange( const char *s, u_int32 *a, u_int32 *b );
+static int32 RateCode( u_int32 wordsPerSec );
+static void Regroup( Z147MAP_PLAN *plan );
+static int CmpInsn( const void *a, const void *b );
+static int32 SameTable( const Z147MAP_PARAM *a, const Z147MAP_PARAM *b );
+static double Value( u_int32 enc, u_int32 raw, u_int32 bits, double res,
+					 double ofs );
+static u_int32 Extract( const u_int16 *frame, const Z147MAP_INSN *in );
+static u_int32 Bcd( u_int32 raw );
+
+/******************************* Z147MAP_Compile ****************************/
+/** Compile a frame map
+ *
+ *  \param text       \IN  map text (format see z147_map.h)
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx or -1 for the rate line
+ *                         of the map
+ *  \param errLine    \OUT line of a syntax or layout error, 0 if the
+ *                         error is not in a line (may be NULL)
+ *  \return           plan or NULL on error
+ */
+Z147MAP_PLAN* Z147MAP_Compile( const char *text, int32 rate,
+							   u_int32 *errLine )
+{
+	Z147MAP_PARAM *param = NULL, *p;
+	Z147MAP_PLAN *plan = NULL;
+	u_int32 num = 0, max = 0, line = 0, sfSub = 0, sfWord = 0, sfMask = 0;
+	u_int32 i, len, wps;
+	int32 mapRate = -1, n;
+	char buf[LINE_MAX_LEN], *tok[MAX_TOKENS], *s, *save;
+	const char *end;
+
+	if( errLine )
+		*errLine = 0;
+
+	while( *text ){
+		line++;
+		end = strchr( text, '\n' );
+		len = end ? (u_int32)(end - text) : (u_int32)strlen( text );
+		if( len >= sizeof(buf) )
+			goto SYNTAX;
+		memcpy( buf, text, len );
+		buf[len] = '\0';
+		text += end ? len + 1 : len;
+
+		if( (s = strchr( buf, '#' )) != NULL )
+			*s = '\0';
+		for( n = 0, s = strtok_r( buf, " \t\r", &save );
+			 s && n < MAX_TOKENS; s = strtok_r( NULL, " \t\r", &save ) )
+			tok[n++] = s;
+		if( n == 0 )
+			continue;
+		if( s )
+			goto SYNTAX;
+
+		if( strcasecmp( tok[0], "rate" ) == 0 ){
+			if( n != 2 || sscanf( tok[1], "%u", &wps ) != 1 ||
+				(mapRate = RateCode( wps )) < 0 )
+				goto SYNTAX;
+		}
+		else if( strcasecmp( tok[0], "superframe" ) == 0 ){
+			if( n != 4 || sscanf( tok[1], "%u", &sfSub ) != 1 ||
+				sscanf( tok[2], "%u", &sfWord ) != 1 ||
+				sscanf( tok[3], "%i", (int*)&sfMask ) != 1 ||
+				sfSub < 1 || sfSub > 4 || sfMask == 0 || sfMask > 0xffff )
+				goto SYNTAX;
+		}
+		else{
+			if( num == max ){
+				if( max == Z147MAP_MAX_PARAMS )
+					goto SYNTAX;
+				max += PARAM_GROW;
+				p = (Z147MAP_PARAM*)realloc( param, max * sizeof(*p) );
+				if( p == NULL )
+					goto CLEANUP;
+				param = p;
+			}
+			if( ParseParam( tok, n, &param[num] ) != 0 )
+				goto SYNTAX;
+			for( i = 0; i < num; i++ )
+				if( strcmp( param[i].name, param[num].name ) == 0 )
+					goto SYNTAX;
+			num++;
+		}
+	}
+	line = 0;
+
+	/* the rate of the map must match the data */
+	if( rate < 0 )
+		rate = mapRate;
+	if( rate < 0 || rate > 7 || (mapRate >= 0 && mapRate != rate) ||
+		(sfSub && sfWord >= (64u << rate)) ){
+		errno = EINVAL;
+		goto CLEANUP;
+	}
+
+	plan = Z147MAP_Build( param, num, (u_int32)rate );
+	if( plan == NULL ){
+		/* Build() checks the word positions against the rate */
+		goto CLEANUP;
+	}
+	plan->sfSub  = sfSub;
+	plan->sfWord = sfWord;
+	plan->sfMask = sfMask;
+	free( param );
+	return plan;
+
+SYNTAX:
+	errno = EINVAL;
+CLEANUP:
+	if( errLine )
+		*errLine = line;
+	free( param );
+	return NULL;
+}
+
+/******************************* Z147MAP_Load *******************************/
+/** Read and compile a frame map file
+ *
+ *  \param name       \IN  file name
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx or -1 (see Z147MAP_Compile())
+ *  \param errLine    \OUT line of an error, 0 if not in a line (may be NULL)
+ *  \return           plan or NULL on error
+ */
+Z147MAP_PLAN* Z147MAP_Load( const char *name, int32 rate, u_int32 *errLine )
+{
+	Z147MAP_PLAN *plan;
+	FILE *fp;
+	char *text;
+	long size;
+	int err;
+
+	if( errLine )
+		*errLine = 0;
+	if( (fp = fopen( name, "r" )) == NULL )
+		return NULL;
+	if( fseek( fp, 0, SEEK_END ) != 0 || (size = ftell( fp )) < 0 ||
+		fseek( fp, 0, SEEK_SET ) != 0 ||
+		(text = (char*)malloc( (size_t)size + 1 )) == NULL ){
+		err = errno;
+		fclose( fp );
+		errno = err;
+		return NULL;
+	}
+	if( fread( text, 1, (size_t)size, fp ) != (size_t)size ){
+		fclose( fp );
+		free( text );
+		errno = EIO;
+		return NULL;
+	}
+	fclose( fp );
+	text[size] = '\0';
+
+	plan = Z147MAP_Compile( text, rate, errLine );
+	err = errno;
+	free( text );
+	errno = err;
+	return plan;
+}
+
+/******************************* Z147MAP_Build ******************************/
+/** Build a decoding plan from a parameter table
+ *
+ *  The superframe counter of the plan is not set (sfSub = 0).
+ *
+ *  \param param      \IN  parameters
+ *  \param num        \IN  number of parameters
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \return           plan or NULL on error
+ */
+Z147MAP_PLAN* Z147MAP_Build( const Z147MAP_PARAM *param, u_int32 num,
+							 u_int32 rate )
+{
+	Z147MAP_PLAN *plan;
+	Z147MAP_INSN *in;
+	const Z147MAP_PARAM *p;
+	u_int32 sfs = 64u << (rate & 7), i, s, nInsn = 0;
+
+	if( rate > 7 || num > Z147MAP_MAX_PARAMS ){
+		errno = EINVAL;
+		return NULL;
+	}
+	for( i = 0; i < num; i++ ){
+		p = &param[i];
+		if( p->enc >= Z147MAP_ENC_NUM || p->sub > 4 ||
+			p->words == 0 || p->words > Z147MAP_MAX_WORDS ||
+			p->word + p->words > sfs || p->lsb < 1 || p->msb > 12 ||
+			p->lsb > p->msb || p->words * (p->msb - p->lsb + 1) > 32 ||
+			(p->sf != Z147MAP_SF_ANY && p->sf >= Z147MAP_SF_FRAMES) ){
+			errno = EINVAL;
+			return NULL;
+		}
+		nInsn += p->sub ? 1 : 4;
+	}
+
+	if( (plan = (Z147MAP_PLAN*)calloc( 1, sizeof(*plan) )) == NULL )
+		return NULL;
+	plan->param = (Z147MAP_PARAM*)malloc( (num ? num : 1) * sizeof(*p) );
+	plan->insn  = (Z147MAP_INSN*)calloc( nInsn ? nInsn : 1, sizeof(*in) );
+	if( plan->param == NULL || plan->insn == NULL ){
+		Z147MAP_Free( plan );
+		return NULL;
+	}
+	memcpy( plan->param, param, num * sizeof(*p) );
+	plan->numParams  = num;
+	plan->numInsn    = nInsn;
+	plan->rate       = rate;
+	plan->frameWords = 4 * sfs;
+
+	/* one instruction per parameter and subframe */
+	in = plan->insn;
+	for( i = 0; i < num; i++ ){
+		p = &param[i];
+		for( s = p->sub ? p->sub : 1; s <= (p->sub ? p->sub : 4u); s++ ){
+			in->off   = (s - 1) * sfs + p->word;
+			in->param = (u_int16)i;
+			in->shift = (u_int8)(p->lsb - 1);
+			in->bits  = (u_int8)(p->msb - p->lsb + 1);
+			in->mask  = (u_int16)((1u << in->bits) - 1);
+			in->words = p->words;
+			in->sf    = p->sf;
+			in->enc   = p->enc;
+			in->res   = p->enc == Z147MAP_ENC_DIS ? 1.0 : p->res;
+			in->ofs   = p->enc == Z147MAP_ENC_DIS ? 0.0 : p->ofs;
+			in->lut   = Z147MAP_NO_LUT;
+			in++;
+		}
+	}
+
+	Regroup( plan );
+	return plan;
+}
+
+/******************************* Z147MAP_Free *******************************/
+/** Free a decoding plan
+ *
+ *  \param plan       \IN  plan (may be NULL)
+ */
+void Z147MAP_Free( Z147MAP_PLAN *plan )
+{
+	if( plan == NULL )
+		return;
+	free( plan->param );
+	free( plan->insn );
+	free( (void*)plan->lut );
+	free( plan->lutMem );
+	free( plan );
+}
+
+/******************************* Z147MAP_Find *******************************/
+/** Find a parameter by name
+ *
+ *  \param plan       \IN  plan
+ *  \param name       \IN  parameter name
+ *  \return           parameter index or -1
+ */
+int32 Z147MAP_Find( const Z147MAP_PLAN *plan, const char *name )
+{
+	u_int32 i;
+
+	for( i = 0; i < plan->numParams; i++ )
+		if( strcmp( plan->param[i].name, name ) == 0 )
+			return (int32)i;
+	errno = ENOENT;
+	return -1;
+}
+
+/******************************* Z147MAP_SfFrame ****************************/
+/** Get the frame of the superframe from the superframe counter
+ *
+ *  \param plan       \IN  plan
+ *  \param frame      \IN  frame (plan->frameWords words)
+ *  \return           frame of the superframe 0..15 or -1 (no counter)
+ */
+int32 Z147MAP_SfFrame( const Z147MAP_PLAN *plan, const u_int16 *frame )
+{
+	u_int32 cnt, mask = plan->sfMask;
+
+	if( plan->sfSub == 0 )
+		return -1;
+	cnt = frame[(plan->sfSub - 1) * (plan->frameWords / 4) + plan->sfWord] &
+		  mask;
+	while( !(mask & 1) ){
+		mask >>= 1;
+		cnt  >>= 1;
+	}
+	return (int32)(cnt % Z147MAP_SF_FRAMES);
+}
+
+/******************************* Z147MAP_Decode *****************************/
+/** Decode the parameters of a frame
+ *
+ *  Values are emitted in plan order (by encoding, then word offset).
+ *  Parameters of other frames of the superframe are skipped.
+ *
+ *  \param plan       \IN  plan
+ *  \param frame      \IN  frame (plan->frameWords words)
+ *  \param sfFrame    \IN  frame of the superframe 0..15 or -1 to take it
+ *                         from the superframe counter of the plan;
+ *                         without counter, parameters with sf are skipped
+ *  \param out        \OUT values, room for plan->numInsn entries
+ *  \return           number of values
+ */
+int32 Z147MAP_Decode( const Z147MAP_PLAN *plan, const u_int16 *frame,
+					  int32 sfFrame, Z147MAP_VAL *out )
+{
+	const Z147MAP_INSN *in, *end;
+	Z147MAP_VAL *o = out;
+	u_int32 g, raw, sign;
+	u_int8 sf;
+
+	if( sfFrame < 0 )
+		sfFrame = Z147MAP_SfFrame( plan, frame );
+	/* unknown: no superframe parameter matches */
+	sf = sfFrame < 0 ? Z147MAP_SF_FRAMES : (u_int8)sfFrame;
+
+	for( g = 0; g < plan->numGroups; g++ ){
+		in  = plan->insn + plan->group[g].first;
+		end = in + plan->group[g].num;
+
+		switch( plan->group[g].enc ){
+		case Z147MAP_GRP_LUT:
+			for( ; in < end; in++ ){
+				if( in->sf != Z147MAP_SF_ANY && in->sf != sf )
+					continue;
+				raw = frame[in->off];
+				o->param = in->param;
+				o->raw   = (raw >> in->shift) & in->mask;
+				o->value = plan->lut[in->lut][raw & (Z147MAP_LUT_SIZE - 1)];
+				o++;
+			}
+			break;
+		case Z147MAP_ENC_BNR:
+			for( ; in < end; in++ ){
+				if( in->sf != Z147MAP_SF_ANY && in->sf != sf )
+					continue;
+				raw  = Extract( frame, in );
+				sign = 1u << (in->bits * in->words - 1);
+				o->param = in->param;
+				o->raw   = raw;
+				/* sign extension, also for 32 bit fields */
+				o->value = (double)(int32)((raw ^ sign) - sign) * in->res +
+						   in->ofs;
+				o++;
+			}
+			break;
+		case Z147MAP_ENC_BCD:
+			for( ; in < end; in++ ){
+				if( in->sf != Z147MAP_SF_ANY && in->sf != sf )
+					continue;
+				raw = Extract( frame, in );
+				o->param = in->param;
+				o->raw   = raw;
+				o->value = (double)Bcd( raw ) * in->res + in->ofs;
+				o++;
+			}
+			break;
+		default:
+			/* DIS and PACK, DIS has res 1 and ofs 0 */
+			for( ; in < end; in++ ){
+				if( in->sf != Z147MAP_SF_ANY && in->sf != sf )
+					continue;
+				raw = Extract( frame, in );
+				o->param = in->param;
+				o->raw   = raw;
+				o->value = (double)raw * in->res + in->ofs;
+				o++;
+			}
+			break;
+		}
+	}
+	return (int32)(o - out);
+}
+
+/******************************* Z147MAP_LutBuild **************************/
+/** Decode single word parameters with value tables
+ *
+ *  Parameters with the same encoding, bit range and scaling share a
+ *  table. Tables are assigned in parameter order; parameters beyond
+ *  maxTables tables and multi word parameters keep the arithmetic
+ *  decoding. A previous call is undone.
+ *
+ *  \param plan       \IN  plan
+ *  \param maxTables  \IN  max. tables (memory: 32 KB per table),
+ *                         0 = arithmetic decoding only
+ *  \param tables     \IN  precomputed tables (written by
+ *                         Z147MAP_LutWrite() for the same map) or NULL
+ *                         to compute them, must live as long as the plan
+ *  \return           number of tables or -1 on error
+ */
+int32 Z147MAP_LutBuild( Z147MAP_PLAN *plan, u_int32 maxTables,
+						const double * const *tables )
+{
+	const Z147MAP_PARAM *p;
+	u_int32 *def = NULL, num = 0, i, j, w;
+	u_int16 *tab = NULL;
+	double *t;
+
+	free( (void*)plan->lut );
+	free( plan->lutMem );
+	plan->lut     = NULL;
+	plan->lutMem  = NULL;
+	plan->numLuts = 0;
+	if( maxTables >= Z147MAP_NO_LUT )
+		maxTables = Z147MAP_NO_LUT - 1;
+
+	def = (u_int32*)malloc( (maxTables + 1) * sizeof(*def) );
+	tab = (u_int16*)malloc( (plan->numParams + 1) * sizeof(*tab) );
+	if( def == NULL || tab == NULL )
+		goto ERROR;
+
+	/* table of every parameter, shared if the conversion is the same */
+	for( i = 0; i < plan->numParams; i++ ){
+		p = &plan->param[i];
+		tab[i] = Z147MAP_NO_LUT;
+		if( p->words != 1 )
+			continue;
+		for( j = 0; j < num; j++ )
+			if( SameTable( &plan->param[def[j]], p ) )
+				break;
+		if( j == num ){
+			if( num == maxTables )
+				continue;
+			def[num++] = i;
+		}
+		tab[i] = (u_int16)j;
+	}
+
+	if( num ){
+		plan->lut = (const double**)malloc( num * sizeof(double*) );
+		if( plan->lut == NULL )
+			goto ERROR;
+		if( tables ){
+			for( j = 0; j < num; j++ )
+				plan->lut[j] = tables[j];
+		}else{
+			plan->lutMem = (double*)malloc( (size_t)num * Z147MAP_LUT_SIZE *
+											sizeof(double) );
+			if( plan->lutMem == NULL )
+				goto ERROR;
+			for( j = 0; j < num; j++ ){
+				p = &plan->param[def[j]];
+				t = plan->lutMem + (size_t)j * Z147MAP_LUT_SIZE;
+				for( w = 0; w < Z147MAP_LUT_SIZE; w++ )
+					t[w] = Value( p->enc,
+								  (w >> (p->lsb - 1)) &
+								  ((1u << (p->msb - p->lsb + 1)) - 1),
+								  p->msb - p->lsb + 1, p->res, p->ofs );
+				plan->lut[j] = t;
+			}
+		}
+	}
+	plan->numLuts = num;
+
+	for( i = 0; i < plan->numInsn; i++ )
+		plan->insn[i].lut = tab[plan->insn[i].param];
+	Regroup( plan );
+
+	free( def );
+	free( tab );
+	return (int32)num;
+
+ERROR:
+	/* arithmetic decoding only, the old tables are gone */
+	free( (void*)plan->lut );
+	plan->lut = NULL;
+	for( i = 0; i < plan->numInsn; i++ )
+		plan->insn[i].lut = Z147MAP_NO_LUT;
+	Regroup( plan );
+	free( def );
+	free( tab );
+	return -1;
+}
+
+/******************************* Z147MAP_LutWrite **************************/
+/** Write parameters and value tables of a plan as C source
+ *
+ *  The file defines (static const) \<prefix\>_rate, \<prefix\>_sfCounter
+ *  (sub, word, mask), \<prefix\>_numParams, \<prefix\>_param,
+ *  \<prefix\>_numLuts and \<prefix\>_lut. A program with this layout
+ *  builds its plan with
+ *
+ *  \code
+ *  plan = Z147MAP_Build( <prefix>_param, <prefix>_numParams, <prefix>_rate );
+ *  Z147MAP_LutBuild( plan, <prefix>_numLuts, <prefix>_lut );
+ *  \endcode
+ *
+ *  \param plan       \IN  plan after Z147MAP_LutBuild()
+ *  \param name       \IN  output file
+ *  \param prefix     \IN  prefix of the C identifiers
+ *  \return           0 or -1 on error
+ */
+int32 Z147MAP_LutWrite( const Z147MAP_PLAN *plan, const char *name,
+						const char *prefix )
+{
+	const Z147MAP_PARAM *p;
+	FILE *fp;
+	u_int32 i, w;
+	int err;
+
+	if( (fp = fopen( name, "w" )) == NULL )
+		return -1;
+
+	fprintf( fp, "/* Z147 frame map tables, written by Z147MAP_LutWrite()"
+			 " */\n\n" );
+	fprintf( fp, "static const u_int32 %s_rate = %u;\n", prefix,
+			 plan->rate );
+	fprintf( fp, "static const u_int32 %s_sfCounter[3] = { %u, %u, 0x%x };\n",
+			 prefix, plan->sfSub, plan->sfWord, plan->sfMask );
+	fprintf( fp, "static const u_int32 %s_numParams = %u;\n", prefix,
+			 plan->numParams );
+	fprintf( fp, "static const u_int32 %s_numLuts = %u;\n\n", prefix,
+			 plan->numLuts );
+
+	fprintf( fp, "static const Z147MAP_PARAM %s_param[] = {\n", prefix );
+	for( i = 0; i < plan->numParams; i++ ){
+		p = &plan->param[i];
+		fprintf( fp, "\t{ \"%s\", %u, %u, %u, %u, %u, %u, %u, %.17g, %.17g },"
+				 "\n", p->name, p->enc, p->sub, p->sf, p->words, p->word,
+				 p->msb, p->lsb, p->res, p->ofs );
+	}
+	if( plan->numParams == 0 )
+		fprintf( fp, "\t{ \"\" }\n" );
+	fprintf( fp, "};\n" );
+
+	for( i = 0; i < plan->numLuts; i++ ){
+		fprintf( fp, "\nstatic const double %s_lut%u[%u] = {", prefix, i,
+				 Z147MAP_LUT_SIZE );
+		for( w = 0; w < Z147MAP_LUT_SIZE; w++ )
+			fprintf( fp, "%s%.17g,", w % 4 ? " " : "\n\t",
+					 plan->lut[i][w] );
+		fprintf( fp, "\n};\n" );
+	}
+
+	fprintf( fp, "\nstatic const double * const %s_lut[] = {", prefix );
+	for( i = 0; i < plan->numLuts; i++ )
+		fprintf( fp, "%s%s_lut%u,", i % 4 ? " " : "\n\t", prefix, i );
+	fprintf( fp, "%s\n};\n", plan->numLuts ? "" : "\n\tNULL" );
+
+	if( ferror( fp ) ){
+		err = errno;
+		fclose( fp );
+		errno = err;
+		return -1;
+	}
+	return fclose( fp ) == 0 ? 0 : -1;
+}
+
+/**********************************************************************/
+/** Parse a parameter line: name sub word bits enc [res=] [ofs=] [sf=] */
+static int32 ParseParam( char **tok, int32 n, Z147MAP_PARAM *p )
+{
+	u_int32 hi, lo, sf;
+	int32 i;
+	char *end;
+
+	if( n < 5 || strlen( tok[0] ) >= Z147MAP_NAME_LEN )
+		return -1;
+	memset( p, 0, sizeof(*p) );
+	strcpy( p->name, tok[0] );
+	p->res = 1.0;
+	p->sf  = Z147MAP_SF_ANY;
+
+	if( strcmp( tok[1], "*" ) == 0 )
+		p->sub = 0;
+	else if( sscanf( tok[1], "%u", &hi ) == 1 && hi <= 4 )
+		p->sub = (u_int8)hi;
+	else
+		return -1;
+
+	/* word range lo-hi, ascending */
+	if( ParseRange( tok[2], &lo, &hi ) != 0 || hi < lo ||
+		hi - lo >= Z147MAP_MAX_WORDS || hi > 0xffff )
+		return -1;
+	p->word  = (u_int16)lo;
+	p->words = (u_int8)(hi - lo + 1);
+
+	/* bit range msb-lsb, descending */
+	if( ParseRange( tok[3], &hi, &lo ) != 0 || lo < 1 || hi > 12 || lo > hi )
+		return -1;
+	p->msb = (u_int8)hi;
+	p->lsb = (u_int8)lo;
+
+	for( i = 0; i < Z147MAP_ENC_NUM; i++ )
+		if( strcasecmp( tok[4], G_encName[i] ) == 0 )
+			break;
+	if( i == Z147MAP_ENC_NUM )
+		return -1;
+	p->enc = (u_int8)i;
+
+	for( i = 5; i < n; i++ ){
+		if( strncmp( tok[i], "res=", 4 ) == 0 ){
+			p->res = strtod( tok[i] + 4, &end );
+		}else if( strncmp( tok[i], "ofs=", 4 ) == 0 ){
+			p->ofs = strtod( tok[i] + 4, &end );
+		}else if( strncmp( tok[i], "sf=", 3 ) == 0 ){
+			sf  = (u_int32)strtoul( tok[i] + 3, &end, 10 );
+			if( sf >= Z147MAP_SF_FRAMES )
+				return -1;
+			p->sf = (u_int8)sf;
+		}else
+			return -1;
+		if( *end != '\0' )
+			return -1;
+	}
+	return 0;
+}
+
+/**********************************************************************/
+/** Parse "a-b" or "a" (a = b) */
+static int32 ParseRange( const char *s, u_int32 *a, u_int32 *b )
+{
+	char c;
+
+	if( sscanf( s, "%u-%u%c", a, b, &c ) == 2 )
+		return 0;
+	if( sscanf( s, "%u%c", a, &c ) == 1 ){
+		*b = *a;
+		return 0;
+	}
+	return -1;
+}
+
+/**********************************************************************/
+/** Z147_RX_DATA_RATE_xx of a word rate or -1 */
+static int32 RateCode( u_int32 wordsPerSec )
+{
+	int32 rate;
+
+	for( rate = 0; rate < 8; rate++ )
+		if( (64u << rate) == wordsPerSec )
+			return rate;
+	return -1;
+}
+
+/**********************************************************************/
+/** Sort the instructions into groups, frame order within a group */
+static void Regroup( Z147MAP_PLAN *plan )
+{
+	Z147MAP_INSN *in = plan->insn;
+	u_int32 i, grp, last = 0;
+
+	qsort( in, plan->numInsn, sizeof(*in), CmpInsn );
+	memset( plan->group, 0, sizeof(plan->group) );
+	plan->numGroups = 0;
+	for( i = 0; i < plan->numInsn; i++ ){
+		grp = in[i].lut != Z147MAP_NO_LUT ? Z147MAP_GRP_LUT : in[i].enc;
+		if( i == 0 || grp != last ){
+			plan->group[plan->numGroups].enc   = grp;
+			plan->group[plan->numGroups].first = i;
+			plan->numGroups++;
+			last = grp;
+		}
+		plan->group[plan->numGroups - 1].num++;
+	}
+}
+
+/**********************************************************************/
+/** qsort compare: group, word offset, parameter */
+static int CmpInsn( const void *a, const void *b )
+{
+	const Z147MAP_INSN *x = (const Z147MAP_INSN*)a;
+	const Z147MAP_INSN *y = (const Z147MAP_INSN*)b;
+	u_int32 gx = x->lut != Z147MAP_NO_LUT ? Z147MAP_GRP_LUT : x->enc;
+	u_int32 gy = y->lut != Z147MAP_NO_LUT ? Z147MAP_GRP_LUT : y->enc;
+
+	if( gx != gy )
+		return gx < gy ? -1 : 1;
+	if( x->off != y->off )
+		return x->off < y->off ? -1 : 1;
+	return x->param < y->param ? -1 : x->param > y->param;
+}
+
+/**********************************************************************/
+/** Check if two single word parameters convert the same way */
+static int32 SameTable( const Z147MAP_PARAM *a, const Z147MAP_PARAM *b )
+{
+	if( a->enc != b->enc || a->msb != b->msb || a->lsb != b->lsb )
+		return 0;
+	return a->enc == Z147MAP_ENC_DIS || (a->res == b->res && a->ofs == b->ofs);
+}
+
+/**********************************************************************/
+/** Value of a raw field, same arithmetic as Z147MAP_Decode() */
+static double Value( u_int32 enc, u_int32 raw, u_int32 bits, double res,
+					 double ofs )
+{
+	u_int32 sign = 1u << (bits - 1);
+
+	switch( enc ){
+	case Z147MAP_ENC_BNR:
+		return (double)(int32)((raw ^ sign) - sign) * res + ofs;
+	case Z147MAP_ENC_BCD:
+		return (double)Bcd( raw ) * res + ofs;
+	case Z147MAP_ENC_DIS:
+		return (double)raw * 1.0 + 0.0;
+	default:
+		return (double)raw * res + ofs;
+	}
+}
+
+/**********************************************************************/
+/** Concatenate the bit fields of the words of an instruction */
+static u_int32 Extract( const u_int16 *frame, const Z147MAP_INSN *in )
+{
+	const u_int16 *w = frame + in->off;
+	u_int32 raw = (w[0] >> in->shift) & in->mask, i;
+
+	for( i = 1; i < in->words; i++ )
+		raw = (raw << in->bits) | ((w[i] >> in->shift) & in->mask);
+	return raw;
+}
+
+/**********************************************************************/
+/** Value of 4 bit BCD digits */
+static u_int32 Bcd( u_int32 raw )
+{
+	u_int32 val = 0, mul = 1;
+
+	for( ; raw; raw >>= 4, mul *= 10 )
+		val += (raw & 0xf) * mul;
+	return val;
+}
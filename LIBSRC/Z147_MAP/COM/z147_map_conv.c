@@ -0,0 +1,371 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_map_conv.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Bulk conversion of Z147 parameter columns with SIMD kernels
+ *
+ *               A column holds one word slot of consecutive frames.
+ *               Z147MAP_Convert() converts the columns of an instruction
+ *               to engineering values, 8 samples per step:
+ *
+ *               - shift and mask the 16 bit words of every column,
+ *                 widen them to 32 bit and concatenate the columns
+ *               - BNR: sign extension with (raw ^ sign) - sign
+ *                 BCD: Horner over the 4 bit digits (v * 10 as shifts,
+ *                 SSE2 has no 32 bit multiply)
+ *               - convert to double, multiply by res and add ofs
+ *
+ *               The arithmetic is the same as in Z147MAP_Decode(), so
+ *               all kernels give bit identical results. Unsigned 32 bit
+ *               fields (DIS/PACK over 32 bits) do not fit the signed
+ *               conversion and use the scalar code. The AVX2 kernel hands
+ *               the rest of a column to the SSE2 kernel, SSE2 to the
+ *               scalar code.
+ *
+ *     \switches Z147MAP_NO_SIMD  scalar code only
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_map_conv.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <MEN/men_typs.h>
+#include <MEN/z147_map.h>
+
+#if !defined(Z147MAP_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+# define Z147MAP_X86
+# include <immintrin.h>
+#endif
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+typedef void CONV_FUNC( const Z147MAP_INSN *in, const u_int16 * const *col,
+						u_int32 first, u_int32 n, double *out );
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static void ConvScalar( const Z147MAP_INSN *in, const u_int16 * const *col,
+						u_int32 first, u_int32 n, double *out );
+static void ConvAuto( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out );
+#ifdef Z147MAP_X86
+static void ConvSse2( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out );
+static void ConvAvx2( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out );
+#endif
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static CONV_FUNC *G_conv = ConvAuto;
+
+static const char *G_name[Z147MAP_KRN_NUM] = { "scalar", "sse2", "avx2" };
+
+/******************************* Z147MAP_Column *****************************/
+/** Collect one word slot of consecutive frames
+ *
+ *  \param frames     \IN  first frame
+ *  \param stride     \IN  words from frame to frame (e.g. recSize / 2 of a
+ *                         frame file)
+ *  \param off        \IN  word offset in the frame (Z147MAP_INSN.off + w)
+ *  \param n          \IN  number of frames
+ *  \param col        \OUT n words
+ */
+void Z147MAP_Column( const u_int16 *frames, u_int32 stride, u_int32 off,
+					 u_int32 n, u_int16 *col )
+{
+	u_int32 i;
+
+	frames += off;
+	for( i = 0; i < n; i++, frames += stride )
+		col[i] = *frames;
+}
+
+/******************************* Z147MAP_Convert ****************************/
+/** Convert columns to engineering values
+ *
+ *  The superframe position of the instruction is not checked, the
+ *  columns only hold frames containing the parameter.
+ *
+ *  \param in         \IN  instruction
+ *  \param col        \IN  in->words columns of n words, col[0] holds the
+ *                         most significant word
+ *  \param n          \IN  number of samples
+ *  \param out        \OUT n values
+ */
+void Z147MAP_Convert( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 n, double *out )
+{
+	G_conv( in, col, 0, n, out );
+}
+
+/******************************* Z147MAP_ConvSupported **********************/
+/** Check if the CPU supports a conversion kernel
+ *
+ *  \param kernel     \IN  Z147MAP_KRN_xx
+ *  \return           1 if supported
+ */
+int32 Z147MAP_ConvSupported( int32 kernel )
+{
+	switch( kernel ){
+	case Z147MAP_KRN_SCALAR:
+		return 1;
+#ifdef Z147MAP_X86
+	case Z147MAP_KRN_SSE2:
+		return __builtin_cpu_supports( "sse2" ) ? 1 : 0;
+	case Z147MAP_KRN_AVX2:
+		return __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+/******************************* Z147MAP_ConvSelect *************************/
+/** Select the kernel used by Z147MAP_Convert()
+ *
+ *  \param kernel     \IN  Z147MAP_KRN_xx or Z147MAP_KRN_AUTO
+ *  \return           selected kernel or -1 if not supported
+ */
+int32 Z147MAP_ConvSelect( int32 kernel )
+{
+	if( kernel == Z147MAP_KRN_AUTO ){
+		for( kernel = Z147MAP_KRN_NUM - 1; kernel > Z147MAP_KRN_SCALAR;
+			 kernel-- )
+			if( Z147MAP_ConvSupported( kernel ) )
+				break;
+	}else if( !Z147MAP_ConvSupported( kernel ) ){
+		return -1;
+	}
+
+	switch( kernel ){
+#ifdef Z147MAP_X86
+	case Z147MAP_KRN_SSE2:
+		G_conv = ConvSse2;
+		break;
+	case Z147MAP_KRN_AVX2:
+		G_conv = ConvAvx2;
+		break;
+#endif
+	default:
+		G_conv = ConvScalar;
+		break;
+	}
+	return kernel;
+}
+
+/******************************* Z147MAP_ConvName ***************************/
+/** Name of a conversion kernel
+ *
+ *  \param kernel     \IN  Z147MAP_KRN_xx
+ *  \return           name
+ */
+const char* Z147MAP_ConvName( int32 kernel )
+{
+	if( kernel < 0 || kernel >= Z147MAP_KRN_NUM )
+		return "?";
+	return G_name[kernel];
+}
+
+/**********************************************************************/
+/** First call: select the best kernel and convert */
+static void ConvAuto( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out )
+{
+	Z147MAP_ConvSelect( Z147MAP_KRN_AUTO );
+	G_conv( in, col, first, n, out );
+}
+
+/**********************************************************************/
+/** Portable conversion of samples first..n-1 */
+static void ConvScalar( const Z147MAP_INSN *in, const u_int16 * const *col,
+						u_int32 first, u_int32 n, double *out )
+{
+	u_int32 i, w, raw, val, mul;
+	u_int32 sign = 1u << (in->bits * in->words - 1);
+
+	for( i = first; i < n; i++ ){
+		raw = 0;
+		for( w = 0; w < in->words; w++ )
+			raw = (raw << in->bits) | ((col[w][i] >> in->shift) & in->mask);
+
+		switch( in->enc ){
+		case Z147MAP_ENC_BNR:
+			out[i] = (double)(int32)((raw ^ sign) - sign) * in->res +
+					 in->ofs;
+			break;
+		case Z147MAP_ENC_BCD:
+			for( val = 0, mul = 1; raw; raw >>= 4, mul *= 10 )
+				val += (raw & 0xf) * mul;
+			out[i] = (double)val * in->res + in->ofs;
+			break;
+		default:
+			out[i] = (double)raw * in->res + in->ofs;
+			break;
+		}
+	}
+}
+
+#ifdef Z147MAP_X86
+/**********************************************************************/
+/** SSE2: raw 32 bit fields to signed integers (see file header) */
+__attribute__((target("sse2")))
+static inline __m128i ToIntSse2( __m128i raw, u_int32 enc, __m128i sign,
+								 u_int32 digits )
+{
+	const __m128i m4 = _mm_set1_epi32( 0xf );
+	__m128i v = _mm_setzero_si128();
+
+	if( enc == Z147MAP_ENC_BNR )
+		return _mm_sub_epi32( _mm_xor_si128( raw, sign ), sign );
+	if( enc != Z147MAP_ENC_BCD )
+		return raw;
+
+	while( digits-- )
+		v = _mm_add_epi32( _mm_add_epi32( _mm_slli_epi32( v, 3 ),
+										  _mm_slli_epi32( v, 1 ) ),
+						   _mm_and_si128( _mm_srl_epi32( raw,
+								_mm_cvtsi32_si128( (int)(4 * digits) ) ),
+										  m4 ) );
+	return v;
+}
+
+/**********************************************************************/
+/** SSE2 conversion, 8 samples per step */
+__attribute__((target("sse2")))
+static void ConvSse2( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out )
+{
+	const u_int32 total = (u_int32)in->bits * in->words;
+	const u_int32 digits = (total + 3) / 4;
+	const __m128i zero  = _mm_setzero_si128();
+	const __m128i mask  = _mm_set1_epi16( (short)in->mask );
+	const __m128i shift = _mm_cvtsi32_si128( in->shift );
+	const __m128i bits  = _mm_cvtsi32_si128( in->bits );
+	const __m128i sign  = _mm_set1_epi32( (int)(1u << (total - 1)) );
+	const __m128d res   = _mm_set1_pd( in->res );
+	const __m128d ofs   = _mm_set1_pd( in->ofs );
+	__m128i v, lo, hi;
+	u_int32 i, w;
+
+	if( total == 32 && in->enc != Z147MAP_ENC_BNR &&
+		in->enc != Z147MAP_ENC_BCD ){
+		ConvScalar( in, col, first, n, out );
+		return;
+	}
+
+	for( i = first; i + 8 <= n; i += 8 ){
+		lo = hi = zero;
+		for( w = 0; w < in->words; w++ ){
+			v  = _mm_and_si128( _mm_srl_epi16(
+					_mm_loadu_si128( (const __m128i*)(col[w] + i) ), shift ),
+								mask );
+			lo = _mm_or_si128( _mm_sll_epi32( lo, bits ),
+							   _mm_unpacklo_epi16( v, zero ) );
+			hi = _mm_or_si128( _mm_sll_epi32( hi, bits ),
+							   _mm_unpackhi_epi16( v, zero ) );
+		}
+		lo = ToIntSse2( lo, in->enc, sign, digits );
+		hi = ToIntSse2( hi, in->enc, sign, digits );
+
+		_mm_storeu_pd( out + i, _mm_add_pd( _mm_mul_pd(
+						   _mm_cvtepi32_pd( lo ), res ), ofs ) );
+		_mm_storeu_pd( out + i + 2, _mm_add_pd( _mm_mul_pd(
+						   _mm_cvtepi32_pd( _mm_shuffle_epi32( lo, 0xee ) ),
+						   res ), ofs ) );
+		_mm_storeu_pd( out + i + 4, _mm_add_pd( _mm_mul_pd(
+						   _mm_cvtepi32_pd( hi ), res ), ofs ) );
+		_mm_storeu_pd( out + i + 6, _mm_add_pd( _mm_mul_pd(
+						   _mm_cvtepi32_pd( _mm_shuffle_epi32( hi, 0xee ) ),
+						   res ), ofs ) );
+	}
+	ConvScalar( in, col, i, n, out );
+}
+
+/**********************************************************************/
+/** AVX2: raw 32 bit fields to signed integers (see file header) */
+__attribute__((target("avx2")))
+static inline __m256i ToIntAvx2( __m256i raw, u_int32 enc, __m256i sign,
+								 u_int32 digits )
+{
+	const __m256i m4 = _mm256_set1_epi32( 0xf );
+	__m256i v = _mm256_setzero_si256();
+
+	if( enc == Z147MAP_ENC_BNR )
+		return _mm256_sub_epi32( _mm256_xor_si256( raw, sign ), sign );
+	if( enc != Z147MAP_ENC_BCD )
+		return raw;
+
+	while( digits-- )
+		v = _mm256_add_epi32( _mm256_mullo_epi32( v,
+											_mm256_set1_epi32( 10 ) ),
+							  _mm256_and_si256( _mm256_srl_epi32( raw,
+								_mm_cvtsi32_si128( (int)(4 * digits) ) ),
+												m4 ) );
+	return v;
+}
+
+/**********************************************************************/
+/** AVX2 conversion, 16 samples per step */
+__attribute__((target("avx2")))
+static void ConvAvx2( const Z147MAP_INSN *in, const u_int16 * const *col,
+					  u_int32 first, u_int32 n, double *out )
+{
+	const u_int32 total = (u_int32)in->bits * in->words;
+	const u_int32 digits = (total + 3) / 4;
+	const __m128i mask  = _mm_set1_epi16( (short)in->mask );
+	const __m128i shift = _mm_cvtsi32_si128( in->shift );
+	const __m128i bits  = _mm_cvtsi32_si128( in->bits );
+	const __m256i sign  = _mm256_set1_epi32( (int)(1u << (total - 1)) );
+	const __m256d res   = _mm256_set1_pd( in->res );
+	const __m256d ofs   = _mm256_set1_pd( in->ofs );
+	__m256i a, b;
+	u_int32 i, w;
+
+	if( total == 32 && in->enc != Z147MAP_ENC_BNR &&
+		in->enc != Z147MAP_ENC_BCD ){
+		ConvScalar( in, col, first, n, out );
+		return;
+	}
+
+	for( i = first; i + 16 <= n; i += 16 ){
+		a = b = _mm256_setzero_si256();
+		for( w = 0; w < in->words; w++ ){
+			a = _mm256_or_si256( _mm256_sll_epi32( a, bits ),
+					_mm256_cvtepu16_epi32( _mm_and_si128( _mm_srl_epi16(
+						_mm_loadu_si128( (const __m128i*)(col[w] + i) ),
+						shift ), mask ) ) );
+			b = _mm256_or_si256( _mm256_sll_epi32( b, bits ),
+					_mm256_cvtepu16_epi32( _mm_and_si128( _mm_srl_epi16(
+						_mm_loadu_si128( (const __m128i*)(col[w] + i + 8) ),
+						shift ), mask ) ) );
+		}
+		a = ToIntAvx2( a, in->enc, sign, digits );
+		b = ToIntAvx2( b, in->enc, sign, digits );
+
+		_mm256_storeu_pd( out + i, _mm256_add_pd( _mm256_mul_pd(
+			_mm256_cvtepi32_pd( _mm256_castsi256_si128( a ) ), res ), ofs ) );
+		_mm256_storeu_pd( out + i + 4, _mm256_add_pd( _mm256_mul_pd(
+			_mm256_cvtepi32_pd( _mm256_extracti128_si256( a, 1 ) ), res ),
+			ofs ) );
+		_mm256_storeu_pd( out + i + 8, _mm256_add_pd( _mm256_mul_pd(
+			_mm256_cvtepi32_pd( _mm256_castsi256_si128( b ) ), res ), ofs ) );
+		_mm256_storeu_pd( out + i + 12, _mm256_add_pd( _mm256_mul_pd(
+			_mm256_cvtepi32_pd( _mm256_extracti128_si256( b, 1 ) ), res ),
+			ofs ) );
+	}
+
+	/* no SSE/AVX transition penalty in the SSE2 code */
+	_mm256_zeroupper();
+	ConvSse2( in, col, i, n, out );
+}
+#endif /* Z147MAP_X86 */
@@ -0,0 +1,317 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_pack.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Pack/unpack of 12 bit ARINC 717 words with SIMD kernels
+ *
+ *               Format see z147_drv.h (#Z147_RX_PACKED). Two words form
+ *               a 24 bit group w0 | w1 << 12, stored as 3 bytes.
+ *
+ *               SSE2 (8 words per step): the 16 bit lanes are combined
+ *               to 24 bit groups in 32 bit lanes, two groups to 48 bits
+ *               in each 64 bit lane, and both lanes are stored with two
+ *               overlapping 8 byte stores. AVX2 (16 words per step)
+ *               builds the same groups, compacts them with a byte shuffle
+ *               per 128 bit lane and a lane permute and stores 32 bytes.
+ *               Unpacking runs the same steps backwards.
+ *
+ *               The kernels store (pack) or load (unpack) up to 8 bytes
+ *               behind the current step, so the last steps of a frame
+ *               are done by the next narrower kernel.
+ *
+ *     \switches Z147PK_NO_SIMD  scalar code only
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_pack.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <MEN/men_typs.h>
+#include <MEN/z147_pack.h>
+
+#if !defined(Z147PK_NO_SIMD) && defined(__GNUC__) && \
+	(defined(__x86_64__) || defined(__i386__))
+# define Z147PK_X86
+# include <immintrin.h>
+#endif
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+typedef void PACK_FUNC( const u_int16 *src, u_int8 *dst, u_int32 words );
+typedef void UNPACK_FUNC( const u_int8 *src, u_int16 *dst, u_int32 words );
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static void PackScalar( const u_int16 *src, u_int8 *dst, u_int32 words );
+static void UnpackScalar( const u_int8 *src, u_int16 *dst, u_int32 words );
+static void PackAuto( const u_int16 *src, u_int8 *dst, u_int32 words );
+static void UnpackAuto( const u_int8 *src, u_int16 *dst, u_int32 words );
+#ifdef Z147PK_X86
+static void PackSse2( const u_int16 *src, u_int8 *dst, u_int32 words );
+static void UnpackSse2( const u_int8 *src, u_int16 *dst, u_int32 words );
+static void PackAvx2( const u_int16 *src, u_int8 *dst, u_int32 words );
+static void UnpackAvx2( const u_int8 *src, u_int16 *dst, u_int32 words );
+#endif
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static PACK_FUNC   *G_pack   = PackAuto;
+static UNPACK_FUNC *G_unpack = UnpackAuto;
+
+static const char *G_name[Z147PK_NUM] = { "scalar", "sse2", "avx2" };
+
+/******************************* Z147PK_Pack ********************************/
+/** Pack words to 12 bit
+ *
+ *  \param src        \IN  words
+ *  \param dst        \OUT Z147PK_SIZE(words) bytes
+ *  \param words      \IN  number of words
+ */
+void Z147PK_Pack( const u_int16 *src, u_int8 *dst, u_int32 words )
+{
+	G_pack( src, dst, words );
+}
+
+/******************************* Z147PK_Unpack ******************************/
+/** Unpack 12 bit words
+ *
+ *  \param src        \IN  Z147PK_SIZE(words) bytes
+ *  \param dst        \OUT words
+ *  \param words      \IN  number of words
+ */
+void Z147PK_Unpack( const u_int8 *src, u_int16 *dst, u_int32 words )
+{
+	G_unpack( src, dst, words );
+}
+
+/******************************* Z147PK_Supported ***************************/
+/** Check if the CPU supports a kernel
+ *
+ *  \param kernel     \IN  Z147PK_xx
+ *  \return           1 if supported
+ */
+int32 Z147PK_Supported( int32 kernel )
+{
+	switch( kernel ){
+	case Z147PK_SCALAR:
+		return 1;
+#ifdef Z147PK_X86
+	case Z147PK_SSE2:
+		return __builtin_cpu_supports( "sse2" ) ? 1 : 0;
+	case Z147PK_AVX2:
+		return __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
+/******************************* Z147PK_Select ******************************/
+/** Select the kernel used by Z147PK_Pack() and Z147PK_Unpack()
+ *
+ *  \param kernel     \IN  Z147PK_xx or Z147PK_AUTO
+ *  \return           selected kernel or -1 if not supported
+ */
+int32 Z147PK_Select( int32 kernel )
+{
+	if( kernel == Z147PK_AUTO ){
+		for( kernel = Z147PK_NUM - 1; kernel > Z147PK_SCALAR; kernel-- )
+			if( Z147PK_Supported( kernel ) )
+				break;
+	}else if( !Z147PK_Supported( kernel ) ){
+		return -1;
+	}
+
+	switch( kernel ){
+#ifdef Z147PK_X86
+	case Z147PK_SSE2:
+		G_pack   = PackSse2;
+		G_unpack = UnpackSse2;
+		break;
+	case Z147PK_AVX2:
+		G_pack   = PackAvx2;
+		G_unpack = UnpackAvx2;
+		break;
+#endif
+	default:
+		G_pack   = PackScalar;
+		G_unpack = UnpackScalar;
+		break;
+	}
+	return kernel;
+}
+
+/******************************* Z147PK_Name ********************************/
+/** Name of a kernel
+ *
+ *  \param kernel     \IN  Z147PK_xx
+ *  \return           name
+ */
+const char* Z147PK_Name( int32 kernel )
+{
+	if( kernel < 0 || kernel >= Z147PK_NUM )
+		return "?";
+	return G_name[kernel];
+}
+
+/**********************************************************************/
+/** First call: select the best kernel and pack */
+static void PackAuto( const u_int16 *src, u_int8 *dst, u_int32 words )
+{
+	Z147PK_Select( Z147PK_AUTO );
+	G_pack( src, dst, words );
+}
+
+/**********************************************************************/
+/** First call: select the best kernel and unpack */
+static void UnpackAuto( const u_int8 *src, u_int16 *dst, u_int32 words )
+{
+	Z147PK_Select( Z147PK_AUTO );
+	G_unpack( src, dst, words );
+}
+
+/**********************************************************************/
+/** Portable pack */
+static void PackScalar( const u_int16 *src, u_int8 *dst, u_int32 words )
+{
+	u_int32 i;
+
+	for( i = 0; i + 1 < words; i += 2, dst += 3 ){
+		dst[0] = (u_int8)src[i];
+		dst[1] = (u_int8)(((src[i] >> 8) & 0x0f) | (src[i+1] << 4));
+		dst[2] = (u_int8)(src[i+1] >> 4);
+	}
+	if( i < words ){
+		dst[0] = (u_int8)src[i];
+		dst[1] = (u_int8)((src[i] >> 8) & 0x0f);
+	}
+}
+
+/**********************************************************************/
+/** Portable unpack */
+static void UnpackScalar( const u_int8 *src, u_int16 *dst, u_int32 words )
+{
+	u_int32 i;
+
+	for( i = 0; i + 1 < words; i += 2, src += 3 ){
+		dst[i]   = (u_int16)(src[0] | ((src[1] & 0x0f) << 8));
+		dst[i+1] = (u_int16)((src[1] >> 4) | (src[2] << 4));
+	}
+	if( i < words )
+		dst[i] = (u_int16)(src[0] | ((src[1] & 0x0f) << 8));
+}
+
+#ifdef Z147PK_X86
+/**********************************************************************/
+/** SSE2 pack, 8 words per step */
+__attribute__((target("sse2")))
+static void PackSse2( const u_int16 *src, u_int8 *dst, u_int32 words )
+{
+	const __m128i m12  = _mm_set1_epi16( 0x0fff );
+	const __m128i m16  = _mm_set1_epi32( 0x0000ffff );
+	const __m128i lo24 = _mm_set1_epi64x( 0x0000000000ffffffLL );
+	const __m128i hi24 = _mm_set1_epi64x( 0x0000ffffff000000LL );
+	__m128i v, x, y;
+	u_int32 i;
+
+	for( i = 0; i + 16 <= words; i += 8, dst += 12 ){
+		v = _mm_and_si128( _mm_loadu_si128( (const __m128i*)(src + i) ), m12 );
+		/* w0 | w1 << 12 in each 32 bit lane */
+		x = _mm_or_si128( _mm_and_si128( v, m16 ),
+						  _mm_slli_epi32( _mm_srli_epi32( v, 16 ), 12 ) );
+		/* two 24 bit groups in the low 48 bits of each 64 bit lane */
+		y = _mm_or_si128( _mm_and_si128( x, lo24 ),
+						  _mm_and_si128( _mm_srli_epi64( x, 8 ), hi24 ) );
+		_mm_storel_epi64( (__m128i*)dst, y );
+		_mm_storel_epi64( (__m128i*)(dst + 6), _mm_srli_si128( y, 8 ) );
+	}
+	PackScalar( src + i, dst, words - i );
+}
+
+/**********************************************************************/
+/** SSE2 unpack, 8 words per step */
+__attribute__((target("sse2")))
+static void UnpackSse2( const u_int8 *src, u_int16 *dst, u_int32 words )
+{
+	const __m128i m12  = _mm_set1_epi32( 0x00000fff );
+	const __m128i lo24 = _mm_set1_epi64x( 0x0000000000ffffffLL );
+	const __m128i hi24 = _mm_set1_epi64x( 0x00ffffff00000000LL );
+	__m128i y, x, w;
+	u_int32 i;
+
+	for( i = 0; i + 16 <= words; i += 8, src += 12 ){
+		y = _mm_unpacklo_epi64( _mm_loadl_epi64( (const __m128i*)src ),
+								_mm_loadl_epi64( (const __m128i*)(src + 6) ) );
+		/* one 24 bit group in each 32 bit lane */
+		x = _mm_or_si128( _mm_and_si128( y, lo24 ),
+						  _mm_and_si128( _mm_slli_epi64( y, 8 ), hi24 ) );
+		w = _mm_or_si128( _mm_and_si128( x, m12 ),
+						  _mm_slli_epi32( _mm_srli_epi32( x, 12 ), 16 ) );
+		_mm_storeu_si128( (__m128i*)(dst + i), w );
+	}
+	UnpackScalar( src, dst + i, words - i );
+}
+
+/**********************************************************************/
+/** AVX2 pack, 16 words per step */
+__attribute__((target("avx2")))
+static void PackAvx2( const u_int16 *src, u_int8 *dst, u_int32 words )
+{
+	const __m256i m12 = _mm256_set1_epi16( 0x0fff );
+	const __m256i m16 = _mm256_set1_epi32( 0x0000ffff );
+	const __m256i shuf = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1 );
+	const __m256i perm = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+	__m256i v, x;
+	u_int32 i;
+
+	for( i = 0; i + 32 <= words; i += 16, dst += 24 ){
+		v = _mm256_and_si256(
+				_mm256_loadu_si256( (const __m256i*)(src + i) ), m12 );
+		x = _mm256_or_si256( _mm256_and_si256( v, m16 ),
+				_mm256_slli_epi32( _mm256_srli_epi32( v, 16 ), 12 ) );
+		/* 12 bytes per 128 bit lane, then both lanes together */
+		x = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( x, shuf ),
+										 perm );
+		_mm256_storeu_si256( (__m256i*)dst, x );
+	}
+	/* avoid the AVX/SSE transition penalty in the SSE2 tail */
+	_mm256_zeroupper();
+	PackSse2( src + i, dst, words - i );
+}
+
+/**********************************************************************/
+/** AVX2 unpack, 16 words per step */
+__attribute__((target("avx2")))
+static void UnpackAvx2( const u_int8 *src, u_int16 *dst, u_int32 words )
+{
+	const __m256i m12 = _mm256_set1_epi32( 0x00000fff );
+	const __m256i shuf = _mm256_setr_epi8(
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+		0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 );
+	const __m256i perm = _mm256_setr_epi32( 0, 1, 2, 3, 3, 4, 5, 6 );
+	__m256i x, w;
+	u_int32 i;
+
+	for( i = 0; i + 32 <= words; i += 16, src += 24 ){
+		/* bytes 0..11 to the low lane, 12..23 to the high lane */
+		x = _mm256_permutevar8x32_epi32(
+				_mm256_loadu_si256( (const __m256i*)src ), perm );
+		x = _mm256_shuffle_epi8( x, shuf );
+		w = _mm256_or_si256( _mm256_and_si256( x, m12 ),
+				_mm256_slli_epi32( _mm256_srli_epi32( x, 12 ), 16 ) );
+		_mm256_storeu_si256( (__m256i*)(dst + i), w );
+	}
+	_mm256_zeroupper();
+	UnpackSse2( src, dst + i, words - i );
+}
+#endif /* Z147PK_X86 */
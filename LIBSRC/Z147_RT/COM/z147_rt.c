@@ -0,0 +1,310 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_rt.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Receive runtime of the Z147 tools: signal, reader thread
+ *               and frame queue
+ *
+ *               The signal handler only counts, takes a time stamp and
+ *               posts the reader semaphore (async signal safe). The reader
+ *               thread reads the frame into the next free queue slot and
+ *               publishes it. The queue is a ring with one producer (reader
+ *               thread) and one consumer (application thread), the indices
+ *               are only written by their owner, so no lock is needed; the
+ *               consumer sleeps on a semaphore. If the application does not
+ *               keep up, frames are dropped and counted, the reader never
+ *               blocks.
+ *
+ *     Required: pthread
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_rt.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <MEN/men_typs.h>
+#include <MEN/mdis_api.h>
+#include <MEN/mdis_err.h>
+#include <MEN/usr_oss.h>
+#include <MEN/z147_drv.h>
+#include <MEN/z147_rt.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define SIG_RING        64              /**< pending signal time stamps */
+
+/** memory barrier between queue slot data and index */
+#define Z147RT_MB()     __sync_synchronize()
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** runtime state */
+typedef struct {
+	MDIS_PATH       path;           /**< receive path */
+	pthread_t       reader;         /**< reader thread */
+	sem_t           sigSem;         /**< signal -> reader */
+	sem_t           dataSem;        /**< reader -> application */
+	volatile int    stop;           /**< stop reader thread */
+
+	/* signal handler -> reader */
+	int64           sigTs[SIG_RING];    /**< signal time stamps */
+	volatile u_int32 sigHead;       /**< written by signal handler */
+	volatile u_int32 sigTail;       /**< written by reader */
+
+	/* reader -> application */
+	Z147RT_FRAME    *slot;          /**< queue slots */
+	u_int32         slots;          /**< number of slots */
+	u_int32         frameLen;       /**< words per slot */
+	volatile u_int32 head;          /**< written by reader */
+	volatile u_int32 tail;          /**< written by application */
+
+	Z147RT_STATS    stats;          /**< statistics */
+} Z147RT;
+
+/*-----------------------------------------+
+|  GLOBALS                                 |
++-----------------------------------------*/
+static Z147RT G_rt;
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static void __MAPILIB SigHandler( u_int32 sig );
+static void *ReaderThread( void *arg );
+static void FreeSlots( void );
+
+/******************************* Z147RT_Start *******************************/
+/** Install the receive signals and start the reader thread
+ *
+ *  \param path       \IN  receive path
+ *  \param slots      \IN  queue slots (frames in flight), >= 2
+ *  \param frameLen   \IN  max. frame length in words (0 = 8192 words/s)
+ *  \return           0 or error code
+ */
+int32 Z147RT_Start( MDIS_PATH path, u_int32 slots, u_int32 frameLen )
+{
+	u_int32 i;
+	int32 error;
+
+	memset( &G_rt, 0, sizeof(G_rt) );
+	G_rt.path     = path;
+	G_rt.slots    = slots < 2 ? 2 : slots;
+	G_rt.frameLen = frameLen ? frameLen : Z147RT_MAX_FRAME_LEN;
+
+	/* all buffers before the first signal */
+	G_rt.slot = (Z147RT_FRAME*)calloc( G_rt.slots, sizeof(Z147RT_FRAME) );
+	if( G_rt.slot == NULL )
+		return ERR_OSS_MEM_ALLOC;
+	for( i=0; i<G_rt.slots; i++ ){
+		G_rt.slot[i].data = (u_int16*)malloc( G_rt.frameLen * 2 );
+		if( G_rt.slot[i].data == NULL ){
+			FreeSlots();
+			return ERR_OSS_MEM_ALLOC;
+		}
+	}
+
+	sem_init( &G_rt.sigSem, 0, 0 );
+	sem_init( &G_rt.dataSem, 0, 0 );
+
+	if( pthread_create(&G_rt.reader, NULL, ReaderThread, NULL) != 0 ){
+		error = ERR_OSS_MEM_ALLOC;
+		goto ERR_EXIT;
+	}
+
+	UOS_SigInit( SigHandler );
+	UOS_SigInstall( Z147RT_SIG_DATA );
+	UOS_SigInstall( Z147RT_SIG_ERR );
+
+	if( M_setstat(path, Z147_SET_SIGNAL, Z147RT_SIG_DATA) < 0 ||
+		M_setstat(path, Z147_SET_ERR_SIGNAL, Z147RT_SIG_ERR) < 0 ){
+		error = UOS_ErrnoGet();
+		Z147RT_Stop();
+		return error;
+	}
+	return 0;
+
+ERR_EXIT:
+	sem_destroy( &G_rt.sigSem );
+	sem_destroy( &G_rt.dataSem );
+	FreeSlots();
+	return error;
+}
+
+/******************************* Z147RT_Stop ********************************/
+/** Remove the signals, stop the reader thread and free the buffers
+ *
+ *  Frames not returned with Z147RT_Put() are invalid afterwards.
+ */
+void Z147RT_Stop( void )
+{
+	M_setstat( G_rt.path, Z147_CLR_SIGNAL, 0 );
+	M_setstat( G_rt.path, Z147_CLR_ERR_SIGNAL, 0 );
+	UOS_SigRemove( Z147RT_SIG_DATA );
+	UOS_SigRemove( Z147RT_SIG_ERR );
+	UOS_SigExit();
+
+	G_rt.stop = 1;
+	sem_post( &G_rt.sigSem );
+	pthread_join( G_rt.reader, NULL );
+
+	sem_destroy( &G_rt.sigSem );
+	sem_destroy( &G_rt.dataSem );
+	FreeSlots();
+}
+
+/******************************* Z147RT_Get *********************************/
+/** Get the oldest received frame
+ *
+ *  \param timeoutMs  \IN  max. wait time in ms (0 = don't wait)
+ *  \return           frame or NULL on timeout
+ */
+Z147RT_FRAME* Z147RT_Get( u_int32 timeoutMs )
+{
+	struct timespec ts;
+	int rv;
+
+	if( timeoutMs == 0 ){
+		rv = sem_trywait( &G_rt.dataSem );
+	}else{
+		clock_gettime( CLOCK_REALTIME, &ts );
+		ts.tv_sec  += timeoutMs / 1000;
+		ts.tv_nsec += (long)(timeoutMs % 1000) * 1000000L;
+		if( ts.tv_nsec >= 1000000000L ){
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+		while( (rv = sem_timedwait(&G_rt.dataSem, &ts)) != 0 &&
+			   errno == EINTR )
+			;
+	}
+	if( rv != 0 )
+		return NULL;
+
+	Z147RT_MB();
+	return &G_rt.slot[G_rt.tail % G_rt.slots];
+}
+
+/******************************* Z147RT_Put *********************************/
+/** Return a frame got with Z147RT_Get() to the reader
+ *
+ *  \param frm        \IN  frame (the oldest one)
+ */
+void Z147RT_Put( Z147RT_FRAME *frm )
+{
+	Z147RT_MB();
+	G_rt.tail++;
+}
+
+/******************************* Z147RT_Stats *******************************/
+/** Runtime statistics
+ *
+ *  \return           statistics
+ */
+Z147RT_STATS* Z147RT_Stats( void )
+{
+	return &G_rt.stats;
+}
+
+/******************************* Z147RT_NowUs *******************************/
+/** Monotonic time in us (async signal safe)
+ *
+ *  \return           time in us
+ */
+int64 Z147RT_NowUs( void )
+{
+	struct timespec ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (int64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**********************************************************************/
+/** Reader thread: read a frame for every receive signal */
+static void *ReaderThread( void *arg )
+{
+	Z147RT_FRAME *frm;
+	int64 sigUs;
+
+	while( 1 ){
+		while( sem_wait(&G_rt.sigSem) != 0 && errno == EINTR )
+			;
+		if( G_rt.stop )
+			break;
+
+		sigUs = G_rt.sigTs[G_rt.sigTail % SIG_RING];
+		G_rt.sigTail++;
+
+		/* queue full: the application is too slow, drop this frame */
+		if( G_rt.head - G_rt.tail >= G_rt.slots ){
+			G_rt.stats.dropped++;
+			continue;
+		}
+		Z147RT_MB();
+
+		frm = &G_rt.slot[G_rt.head % G_rt.slots];
+		frm->seq     = G_rt.stats.frames;
+		frm->errSigs = G_rt.stats.errSigs;
+		frm->sigUs   = sigUs;
+		frm->len     = M_getblock( G_rt.path, (u_int8*)frm->data,
+								   G_rt.frameLen * 2 );
+		frm->readUs  = Z147RT_NowUs();
+		frm->error   = frm->len < 0 ? (int32)UOS_ErrnoGet() : 0;
+		if( frm->len < 0 )
+			G_rt.stats.readErrs++;
+
+		Z147RT_MB();
+		G_rt.head++;
+		G_rt.stats.frames++;
+		sem_post( &G_rt.dataSem );
+	}
+	return NULL;
+}
+
+/**********************************************************************/
+/** Signal handler: time stamp and wake up the reader, nothing else */
+static void __MAPILIB SigHandler( u_int32 sig )
+{
+	u_int32 head = G_rt.sigHead;
+
+	if( sig == Z147RT_SIG_DATA ){
+		G_rt.stats.sigs++;
+		if( head - G_rt.sigTail < SIG_RING ){
+			G_rt.sigTs[head % SIG_RING] = Z147RT_NowUs();
+			G_rt.sigHead = head + 1;
+			sem_post( &G_rt.sigSem );
+		}else{
+			G_rt.stats.sigLost++;
+		}
+	}else if( sig == Z147RT_SIG_ERR ){
+		G_rt.stats.errSigs++;
+	}
+}
+
+/**********************************************************************/
+/** Free the queue slots */
+static void FreeSlots( void )
+{
+	u_int32 i;
+
+	if( G_rt.slot == NULL )
+		return;
+	for( i=0; i<G_rt.slots; i++ )
+		free( G_rt.slot[i].data );
+	free( G_rt.slot );
+	G_rt.slot = NULL;
+}
@@ -0,0 +1,346 @@
+/*********************  P r o g r a m  -  M o d u l e ***********************/
+/*!
+ *        \file  z147_sf.c
+ *
+ *      \author  APatil
+ *
+ *      \brief   Superframe assembler for Z147 receive frames
+ *
+ *               Description see z147_sf.h. Every superframe owns the
+ *               buffers of its 16 frames, the assembler one spare buffer
+ *               handed out by Z147SF_Slot(). Z147SF_Push() swaps the spare
+ *               buffer with the buffer of the frame position, so all
+ *               buffers are allocated once and frames are never copied.
+ *
+ *               Functions return -1 or NULL on error with errno set.
+ *
+ *     \switches -
+ */
+/*-------------------------------[ History ]--------------------------------
+ *
+ * $Log: z147_sf.c,v $
+ *
+ *---------------------------------------------------------------------------
+ * (c) Copyright 2016 by MEN Mikro Elektronik GmbH, Nuernberg, Germany
+ ****************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <MEN/men_typs.h>
+#include <MEN/z147_sf.h>
+
+/*-----------------------------------------+
+|  DEFINES                                 |
++-----------------------------------------*/
+#define MAX_RATE        7               /**< Z147_RX_DATA_RATE_8192 */
+
+/** \name superframe states */
+/**@{*/
+#define SF_FREE         0               /**< unused */
+#define SF_CUR          1               /**< being assembled */
+#define SF_DONE         2               /**< queued for Z147SF_Get() */
+#define SF_APP          3               /**< owned by the application */
+/**@}*/
+
+/*-----------------------------------------+
+|  TYPEDEFS                                |
++-----------------------------------------*/
+/** assembler state */
+struct Z147SF_ASM {
+	u_int32         frameWords;     /**< words per frame */
+	u_int32         cntPos;         /**< counter word in the frame */
+	u_int32         cntMask;        /**< counter bits of the word */
+	u_int32         cntShift;       /**< shift of cntMask */
+	u_int32         range;          /**< counter values - 1 */
+	Z147SF_NOTIFY   notify;         /**< notify function or NULL */
+	void            *arg;           /**< notify argument */
+
+	u_int32         num;            /**< superframes */
+	Z147SF_SUPER    *sf;            /**< superframes */
+	u_int8          *state;         /**< SF_xx of every superframe */
+	u_int32         *queue;         /**< ring of finished superframes */
+	u_int32         qHead;          /**< next to get */
+	u_int32         qNum;           /**< queued */
+	Z147SF_SUPER    *cur;           /**< being assembled or NULL */
+	u_int16         *spare;         /**< buffer of Z147SF_Slot() */
+	u_int16         *mem;           /**< all frame buffers */
+
+	u_int32         last;           /**< counter of the last frame */
+	u_int32         lastPos;        /**< position of the last frame */
+	int             valid;          /**< last valid */
+	u_int32         seq;            /**< frames pushed */
+	u_int32         number;         /**< superframes started */
+	Z147SF_STATS    stats;          /**< statistics */
+};
+
+/*-----------------------------------------+
+|  PROTOTYPES                              |
++-----------------------------------------*/
+static u_int32 Finish( Z147SF_ASM *sa );
+static Z147SF_SUPER* Start( Z147SF_ASM *sa, u_int32 cnt, u_int32 pos );
+
+/******************************* Z147SF_Init ********************************/
+/** Create a superframe assembler
+ *
+ *  \param rate       \IN  Z147_RX_DATA_RATE_xx
+ *  \param sfSub      \IN  counter subframe 1..4, 0 = no counter word, the
+ *                         caller passes the counter to Z147SF_Push()
+ *  \param sfWord     \IN  counter word in the subframe (0 = sync word)
+ *  \param sfMask     \IN  counter bits of the word (contiguous)
+ *  \param hold       \IN  superframes the application may hold, >= 1
+ *  \param notify     \IN  notify function or NULL (queue for Z147SF_Get())
+ *  \param arg        \IN  argument of notify
+ *  \return           assembler or NULL on error
+ */
+Z147SF_ASM* Z147SF_Init( u_int32 rate, u_int32 sfSub, u_int32 sfWord,
+						 u_int32 sfMask, u_int32 hold,
+						 Z147SF_NOTIFY notify, void *arg )
+{
+	Z147SF_ASM *sa;
+	u_int32 sfs = 64u << rate, i, k;
+
+	if( rate > MAX_RATE || sfSub > 4 || hold == 0 || hold > 1024 ||
+		(sfSub && (sfWord >= sfs || (sfMask & 0xfff) == 0)) ){
+		errno = EINVAL;
+		return NULL;
+	}
+	if( (sa = (Z147SF_ASM*)calloc( 1, sizeof(*sa) )) == NULL )
+		return NULL;
+
+	sa->frameWords = 4 * sfs;
+	sa->notify     = notify;
+	sa->arg        = arg;
+	sa->num        = hold + 1;
+	if( sfSub ){
+		sa->cntPos  = (sfSub - 1) * sfs + sfWord;
+		sa->cntMask = sfMask & 0xfff;
+		while( !(sa->cntMask & (1u << sa->cntShift)) )
+			sa->cntShift++;
+		sa->range = sa->cntMask >> sa->cntShift;
+	}else{
+		sa->range = 0xffffffff;
+	}
+
+	sa->sf    = (Z147SF_SUPER*)calloc( sa->num, sizeof(*sa->sf) );
+	sa->state = (u_int8*)calloc( sa->num, sizeof(*sa->state) );
+	sa->queue = (u_int32*)calloc( sa->num, sizeof(*sa->queue) );
+	sa->mem   = (u_int16*)calloc( (size_t)sa->num * Z147SF_FRAMES + 1,
+									sa->frameWords * sizeof(u_int16) );
+	if( sa->sf == NULL || sa->state == NULL || sa->queue == NULL ||
+		sa->mem == NULL ){
+		Z147SF_Exit( sa );
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	for( i = 0; i < sa->num; i++ ){
+		sa->sf[i].frameWords = sa->frameWords;
+		for( k = 0; k < Z147SF_FRAMES; k++ )
+			sa->sf[i].frame[k] = sa->mem + ((size_t)i * Z147SF_FRAMES + k) *
+								 sa->frameWords;
+	}
+	sa->spare = sa->mem + (size_t)sa->num * Z147SF_FRAMES * sa->frameWords;
+	return sa;
+}
+
+/******************************* Z147SF_Exit ********************************/
+/** Free the assembler and all its superframes
+ *
+ *  \param sa         \IN  assembler
+ */
+void Z147SF_Exit( Z147SF_ASM *sa )
+{
+	if( sa == NULL )
+		return;
+	free( sa->sf );
+	free( sa->state );
+	free( sa->queue );
+	free( sa->mem );
+	free( sa );
+}
+
+/******************************* Z147SF_Slot ********************************/
+/** Buffer for the next frame
+ *
+ *  The buffer holds frameWords words and stays valid until the next
+ *  Z147SF_Push().
+ *
+ *  \param sa         \IN  assembler
+ *  \return           buffer
+ */
+u_int16* Z147SF_Slot( Z147SF_ASM *sa )
+{
+	return sa->spare;
+}
+
+/******************************* Z147SF_Push ********************************/
+/** Add the frame in the Z147SF_Slot() buffer
+ *
+ *  \param sa         \IN  assembler
+ *  \param counter    \IN  superframe counter of the frame or -1 to read
+ *                         the counter word (no counter word: frames are
+ *                         counted)
+ *  \return           Z147SF_EV_xx
+ */
+u_int32 Z147SF_Push( Z147SF_ASM *sa, int32 counter )
+{
+	u_int32 cnt, pos, delta = 1, ev = 0;
+	u_int16 *buf;
+
+	if( counter >= 0 )
+		cnt = (u_int32)counter & sa->range;
+	else if( sa->cntMask )
+		cnt = (sa->spare[sa->cntPos] & sa->cntMask) >> sa->cntShift;
+	else
+		cnt = sa->seq;
+	sa->seq++;
+	pos = cnt % Z147SF_FRAMES;
+
+	if( sa->valid ){
+		delta = (cnt - sa->last) & sa->range;
+		if( delta == 0 ){
+			sa->stats.dups++;
+			return Z147SF_EV_DUP;
+		}
+		if( sa->range > Z147SF_FRAMES - 1 && delta > sa->range / 2 ){
+			/* restart, the gap is unknown */
+			sa->stats.back++;
+			ev |= Z147SF_EV_BACK;
+		}else if( delta > 1 ){
+			sa->stats.lost += delta - 1;
+			ev |= Z147SF_EV_GAP;
+		}
+	}
+	sa->last    = cnt;
+	sa->valid   = 1;
+
+	/* the frame belongs to the next superframe */
+	if( sa->cur &&
+		(pos <= sa->lastPos || (ev & Z147SF_EV_BACK) ||
+		 delta >= Z147SF_FRAMES) )
+		ev |= Finish( sa );
+	sa->lastPos = pos;
+
+	if( sa->cur == NULL && Start( sa, cnt, pos ) == NULL ){
+		sa->stats.dropped++;
+		return ev | Z147SF_EV_DROP;
+	}
+
+	/* swap the buffers */
+	buf = sa->cur->frame[pos];
+	sa->cur->frame[pos] = sa->spare;
+	sa->spare = buf;
+	sa->cur->present |= 1u << pos;
+	sa->cur->frames++;
+	sa->stats.frames++;
+	ev |= Z147SF_EV_FRAME;
+
+	if( pos == Z147SF_FRAMES - 1 )
+		ev |= Finish( sa );
+	return ev;
+}
+
+/******************************* Z147SF_Flush *******************************/
+/** Finish the superframe being assembled (end of the frames)
+ *
+ *  \param sa         \IN  assembler
+ *  \return           Z147SF_EV_DONE or 0
+ */
+u_int32 Z147SF_Flush( Z147SF_ASM *sa )
+{
+	return sa->cur ? Finish( sa ) : 0;
+}
+
+/******************************* Z147SF_Get *********************************/
+/** Get the oldest finished superframe
+ *
+ *  \param sa         \IN  assembler
+ *  \return           superframe or NULL if none
+ */
+Z147SF_SUPER* Z147SF_Get( Z147SF_ASM *sa )
+{
+	u_int32 i;
+
+	if( sa->qNum == 0 )
+		return NULL;
+	i = sa->queue[sa->qHead];
+	sa->qHead = (sa->qHead + 1) % sa->num;
+	sa->qNum--;
+	sa->state[i] = SF_APP;
+	return &sa->sf[i];
+}
+
+/******************************* Z147SF_Put *********************************/
+/** Return a superframe to the assembler
+ *
+ *  \param sa         \IN  assembler
+ *  \param sf         \IN  superframe of Z147SF_Get() or the notify function
+ */
+void Z147SF_Put( Z147SF_ASM *sa, Z147SF_SUPER *sf )
+{
+	sa->state[sf - sa->sf] = SF_FREE;
+}
+
+/******************************* Z147SF_Stats *******************************/
+/** Statistics
+ *
+ *  \param sa         \IN  assembler
+ *  \return           statistics
+ */
+const Z147SF_STATS* Z147SF_Stats( const Z147SF_ASM *sa )
+{
+	return &sa->stats;
+}
+
+/**********************************************************************/
+/** Finish the current superframe and pass it to the application
+ *
+ *  \return           Z147SF_EV_DONE
+ */
+static u_int32 Finish( Z147SF_ASM *sa )
+{
+	Z147SF_SUPER *sf = sa->cur;
+	u_int32 i = (u_int32)(sf - sa->sf);
+
+	sa->cur = NULL;
+	sa->stats.superframes++;
+	if( sf->present == Z147SF_COMPLETE )
+		sa->stats.complete++;
+
+	if( sa->notify ){
+		sa->state[i] = SF_APP;
+		sa->notify( sa->arg, sf );
+	}else{
+		sa->state[i] = SF_DONE;
+		sa->queue[(sa->qHead + sa->qNum) % sa->num] = i;
+		sa->qNum++;
+	}
+	return Z147SF_EV_DONE;
+}
+
+/**********************************************************************/
+/** Start a superframe with a free buffer
+ *
+ *  \return           superframe or NULL if all are in use
+ */
+static Z147SF_SUPER* Start( Z147SF_ASM *sa, u_int32 cnt, u_int32 pos )
+{
+	Z147SF_SUPER *sf;
+	u_int32 i;
+
+	for( i = 0; i < sa->num; i++ )
+		if( sa->state[i] == SF_FREE )
+			break;
+	if( i == sa->num )
+		return NULL;
+
+	sf = &sa->sf[i];
+	sa->state[i] = SF_CUR;
+	sf->number   = sa->number++;
+	sf->counter  = (cnt - pos) & sa->range;
+	sf->present  = 0;
+	sf->frames   = 0;
+	sa->cur      = sf;
+	return sf;
+}